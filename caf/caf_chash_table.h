@@ -0,0 +1,276 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_CHASH_TABLE_H
+#define CAF_CHASH_TABLE_H 1
+/**
+ * @defgroup      caf_chash_table    Concurrent Hash Table Functions
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_chash_table
+ * @{
+ *
+ * @brief     Concurrent Hash Table Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Concurrent Hash Table Functions. The key space is split across
+ * a power of two number of segments, each one being a plain
+ * <b>caf_hash_table_t</b> guarded by its own <b>pth_rwlock_t</b>,
+ * so threads working on different segments do not contend, and
+ * lookups on the same segment run in parallel.
+ *
+ */
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <caf/caf_hash_str.h>
+#include <caf/caf_hash_table.h>
+#include <caf/caf_thread_rwlock.h>
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Concurrent hash table structure size @see caf_chash_table_t */
+#define CAF_CHASH_TABLE_SZ          (sizeof (caf_chash_table_t))
+/** Concurrent hash table segment size @see caf_chash_seg_t */
+#define CAF_CHASH_SEG_SZ            (sizeof (caf_chash_seg_t))
+/** Default number of segments */
+#define CAF_CHASH_TABLE_SEGMENTS    16
+/** Maximum number of segments */
+#define CAF_CHASH_TABLE_SEGMENTS_MAX    65536
+
+/**
+ * @brief Concurrent Hash Table Segment Type.
+ *
+ * Concurrent Hash Table segment type.
+ *
+ * @see caf_chash_seg_s
+ */
+typedef struct caf_chash_seg_s caf_chash_seg_t;
+
+/**
+ * @brief Concurrent Hash Table Segment Structure
+ *
+ * Holds one shard of the key space and the lock guarding it.
+ *
+ * @see caf_chash_seg_t
+ */
+struct caf_chash_seg_s {
+	/** Segment Lock */
+	pth_rwlock_t *lock;
+	/** Segment Hash Table */
+	caf_hash_table_t *table;
+};
+
+/**
+ * @brief Concurrent Hash Table Structure Type.
+ *
+ * Concurrent Hash Table structure type.
+ *
+ * @see caf_chash_table_s
+ */
+typedef struct caf_chash_table_s caf_chash_table_t;
+
+/**
+ * @brief Concurrent Hash Table Structure
+ *
+ * Concurrent Hash Table Structure. The members are not modified
+ * after creation, only the segments are.
+ *
+ * @see caf_chash_table_t
+ */
+struct caf_chash_table_s {
+	/** Hash Table Identifier */
+	int id;
+	/** First Hash Callback Function */
+	CAF_HASH_STR_FUNCTION(f1);
+	/** Second Hash Callback Function */
+	CAF_HASH_STR_FUNCTION(f2);
+	/** Segment Array */
+	caf_chash_seg_t *segs;
+	/** Number of Segments, power of two */
+	size_t count;
+	/** Shift selecting the segment from the first hash */
+	int shift;
+};
+
+/**
+ * @brief Creates a new empty concurrent hash table.
+ *
+ * Creates a new empty concurrent hash table split in <b>segments</b>
+ * segments, rounded up to a power of two; zero selects
+ * CAF_CHASH_TABLE_SEGMENTS. A few segments per worker thread keeps
+ * the lock contention low. The callbacks <b>f1</b> and <b>f2</b> are
+ * used as in <b>caf_hash_table_new</b>, and every key is hashed only
+ * once per operation.
+ *
+ * @param id[in]						Hash Table Identifier
+ * @param segments[in]					Number of Segments
+ * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 1
+ * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 2
+ *
+ * @return caf_chash_table_t			a new allocated table
+ *
+ * @see caf_chash_table_t
+ * @see caf_hash_table_t
+ */
+caf_chash_table_t *caf_chash_table_new (const int id, const size_t segments,
+                                        CAF_HASH_STR_FUNCTION(f1),
+                                        CAF_HASH_STR_FUNCTION(f2));
+
+/**
+ * @brief Deallocates a Concurrent Hash Table
+ *
+ * Deallocates the given concurrent hash table <b>table</b>, its
+ * segments and locks. The table must not be in use by other
+ * threads. Does not deallocate the keys and data pointers.
+ *
+ * @param table[in]		table to deallocate
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_chash_table_delete (caf_chash_table_t *table);
+
+/**
+ * @brief Adds a hash to the given concurrent table
+ *
+ * Adds the <b>key</b> and <b>data</b> pair to the given table
+ * <b>table</b>, holding the write lock of the key segment. An
+ * existing key gets its data replaced.
+ *
+ * @param table[in]		table to add the hash
+ * @param key[in]		key pointer
+ * @param ksz[in]		key size
+ * @param data[in]		data pointer
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_chash_table_add (caf_chash_table_t *table, const void *key,
+                         const size_t ksz, const void *data);
+
+/**
+ * @brief Removes an element from the given concurrent table
+ *
+ * Removes the element identified by <b>key</b> of size <b>ksz</b>,
+ * holding the write lock of the key segment. Does not deallocate
+ * the data and key pointers.
+ *
+ * @param table[in]		table from where to remove the item
+ * @param key[in]		item key
+ * @param ksz[in]		key size
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_chash_table_remove (caf_chash_table_t *table, const void *key,
+                            const size_t ksz);
+
+/**
+ * @brief Obtains the data from the given concurrent table
+ *
+ * Obtains the data pointer for the key <b>key</b> of size
+ * <b>ksz</b>, holding the read lock of the key segment, so lookups
+ * run in parallel with other lookups. The data itself is not
+ * protected once the lock is released.
+ *
+ * @param table[in]		hash table where to search the node
+ * @param key[in]		key to search
+ * @param ksz[in]		key size of the given key
+ *
+ * @return void *		data pointer on success, NULL on failure
+ */
+void *caf_chash_table_get (caf_chash_table_t *table, const void *key,
+                           const size_t ksz);
+
+/**
+ * @brief Replaces the data pointer for the given key
+ *
+ * Replaces the data for the existing key <b>key</b> of size
+ * <b>ksz</b>, holding the write lock of the key segment. If the
+ * key isn't found, the interface fails.
+ *
+ * @param table[in]		hash table
+ * @param key[in]		key to search
+ * @param ksz[in]		key size
+ * @param data[in]		data to replace for
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_chash_table_set (caf_chash_table_t *table, const void *key,
+                         const size_t ksz, void *data);
+
+/**
+ * @brief Obtains the data for a key, adding it if missing
+ *
+ * Atomically looks up the key <b>key</b> of size <b>ksz</b> and,
+ * if it is not present, adds it with the data <b>data</b>. The
+ * lookup runs under the segment read lock first, so existing keys
+ * do not take the write lock. When several threads race to add
+ * the same key, only one of them inserts and all of them get the
+ * same data pointer back; the caller knows it won the race when
+ * the returned pointer is <b>data</b>.
+ *
+ * @param table[in]		hash table
+ * @param key[in]		key to search or add
+ * @param ksz[in]		key size
+ * @param data[in]		data to add if the key is missing
+ *
+ * @return void *		stored data pointer, NULL on failure
+ */
+void *caf_chash_table_get_or_add (caf_chash_table_t *table, const void *key,
+                                  const size_t ksz, const void *data);
+
+/**
+ * @brief Counts the entries of the given concurrent table
+ *
+ * Returns the number of entries in the table <b>table</b>, taking
+ * the segment read locks one at a time, so the result is only a
+ * snapshot when other threads modify the table.
+ *
+ * @param table[in]		hash table
+ *
+ * @return size_t		number of entries
+ */
+size_t caf_chash_table_count (caf_chash_table_t *table);
+
+/**
+ * @brief Dumps the concurrent hash table contents to the given output
+ *
+ * Dumps every segment of the given table <b>table</b> to the given
+ * FILE output, in the <b>caf_hash_table_dump</b> format.
+ *
+ * @param out[in]		file to write
+ * @param table[in]		table to dump
+ */
+void caf_chash_table_dump (FILE *out, caf_chash_table_t *table);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_CHASH_TABLE_H */
+/* caf_chash_table.h ends here */
+
@@ -0,0 +1,196 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more denexts.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_DATA_ARENA_H
+#define CAF_DATA_ARENA_H 1
+
+#include <stdio.h>
+
+/**
+ * @defgroup      caf_arena    Arena
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_arena
+ * @{
+ *
+ * @brief     Caffeine Arena Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Bump allocator for temporaries that share a lifetime. Allocations
+ * are carved from large chunks by moving an offset, they are never
+ * released one by one, and caf_arena_reset() releases all of them in
+ * one step. The chunks are kept across resets, so a request that fits
+ * in the memory of the previous ones does not call malloc(3) at all.
+ * An arena is not locked, each thread uses its own one.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Computes the arena structure size */
+#define CAF_ARENA_SZ                   (sizeof(caf_arena_t))
+/** Default chunk size in bytes */
+#define CAF_ARENA_CHUNK                65536
+/** Alignment of every allocation */
+#define CAF_ARENA_ALIGN                16
+
+/**
+ *
+ * @brief    Caffeine arena chunk type.
+ *
+ * @see      caf_arena_chunk_s
+ */
+typedef struct caf_arena_chunk_s caf_arena_chunk_t;
+
+/**
+ *
+ * @brief    Caffeine arena chunk structure.
+ *
+ * The chunk header, the chunk memory follows it.
+ *
+ * @see      caf_arena_chunk_t
+ */
+struct caf_arena_chunk_s {
+	/** Next chunk */
+	caf_arena_chunk_t *next;
+	/** Chunk memory size */
+	size_t sz;
+	/** Chunk memory handed out */
+	size_t used;
+};
+
+/**
+ *
+ * @brief    Caffeine arena type.
+ *
+ * @see      caf_arena_s
+ */
+typedef struct caf_arena_s caf_arena_t;
+
+/**
+ *
+ * @brief    Caffeine arena structure.
+ *
+ * Stores the chunk list, the chunk being filled and the counters.
+ * Allocations larger than the chunk size get a chunk of their own.
+ *
+ * @see      caf_arena_t
+ */
+struct caf_arena_s {
+	/** Chunk list, in allocation order */
+	caf_arena_chunk_t *chunks;
+	/** Chunk being filled */
+	caf_arena_chunk_t *cur;
+	/** Chunk size */
+	size_t chunk_sz;
+	/** Bytes handed out since the last reset */
+	size_t used;
+	/** Number of allocated chunks */
+	size_t chunk_count;
+	/** Allocations */
+	unsigned long allocs;
+	/** Resets */
+	unsigned long resets;
+};
+
+/**
+ *
+ * @brief    Creates a new arena.
+ *
+ * @param[in]    chunk_sz       chunk size, zero takes CAF_ARENA_CHUNK.
+ * @return       caf_arena_t *  the new arena, NULL on failure.
+ */
+caf_arena_t *caf_arena_new (const size_t chunk_sz);
+
+/**
+ *
+ * @brief    Deletes an arena.
+ *
+ * Releases every chunk, the memory handed out becomes invalid.
+ *
+ * @param[in]    arena   the arena to delete.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_arena_delete (caf_arena_t *arena);
+
+/**
+ *
+ * @brief    Allocates memory from the arena.
+ *
+ * @param[in]    arena      the arena.
+ * @param[in]    sz         size in bytes.
+ * @return       void *     the memory, aligned to CAF_ARENA_ALIGN and
+ *                          not initialized, NULL on failure.
+ */
+void *caf_arena_alloc (caf_arena_t *arena, const size_t sz);
+
+/**
+ *
+ * @brief    Copies a string into the arena.
+ *
+ * @param[in]    arena      the arena.
+ * @param[in]    str        the string.
+ * @return       char *     the copy, NULL on failure.
+ */
+char *caf_arena_strdup (caf_arena_t *arena, const char *str);
+
+/**
+ *
+ * @brief    Releases every allocation of the arena.
+ *
+ * Rewinds all the chunks, keeping them for the next allocations.
+ *
+ * @param[in]    arena   the arena.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_arena_reset (caf_arena_t *arena);
+
+/**
+ *
+ * @brief    Counts the bytes handed out since the last reset.
+ *
+ * @param[in]    arena      the arena.
+ * @return       size_t     the bytes, including the alignment.
+ */
+size_t caf_arena_used (caf_arena_t *arena);
+
+/**
+ *
+ * @brief    Dumps the arena counters.
+ *
+ * @param[in]    out     FILE output stream.
+ * @param[in]    arena   the arena to dump.
+ */
+void caf_arena_dump (FILE *out, caf_arena_t *arena);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_DATA_ARENA_H */
+/* caf_data_arena.h ends here */
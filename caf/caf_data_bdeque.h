@@ -0,0 +1,347 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more denexts.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_DATA_BDEQUE_H
+#define CAF_DATA_BDEQUE_H 1
+
+#include <stdio.h>
+#include <caf/caf_data_deque.h>
+
+/**
+ * @defgroup      caf_blk_deque    Block Deque
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_blk_deque
+ * @{
+ *
+ * @brief     Caffeine Block Deque Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Block deque management functions. A block deque stores its data
+ * pointers in fixed size blocks, reached through a ring of block
+ * pointers, so pushing and popping at both ends and positional access
+ * are O(1) and no memory is allocated per element. Callbacks written
+ * for the Double Linked List work unchanged.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Computes the block deque structure size */
+#define CAF_BDEQUE_SZ                  (sizeof(bdeque_t))
+/** Number of data pointers per block, a power of two */
+#define CAF_BDEQUE_BLOCK               64
+/** Initial number of blocks in the block ring, a power of two */
+#define CAF_BDEQUE_MAP_MIN             4
+
+/**
+ *
+ * @brief    Caffeine block deque type.
+ *
+ * The type of a block deque.
+ *
+ * @see      caf_bdeque_s
+ */
+typedef struct caf_bdeque_s bdeque_t;
+
+/**
+ *
+ * @brief    Caffeine block deque structure.
+ *
+ * The block deque stores a ring of block pointers, the ring index
+ * of the first element and the number of elements. Element i lives
+ * in the ring position (first + i) modulo the ring capacity. Blocks
+ * are allocated when an element first reaches them and are kept
+ * until the deque is deleted.
+ *
+ * @see      bdeque_t
+ */
+struct caf_bdeque_s {
+	/** Ring of block pointers */
+	void ***map;
+	/** Number of blocks in the ring, a power of two */
+	size_t map_sz;
+	/** Ring position of the first element */
+	size_t first;
+	/** Number of elements */
+	size_t size;
+};
+
+/**
+ *
+ * @brief    Creates a new empty Caffeine Block Deque.
+ *
+ * @return       bdeque_t *     the allocated deque.
+ *
+ * @see      bdeque_t
+ */
+bdeque_t *bdeque_create (void);
+
+/**
+ *
+ * @brief    Deletes a Caffeine Block Deque.
+ *
+ * Frees the deque and its blocks, calling the callback function
+ * <b>del</b> over every element. If the callback fails the deletion
+ * stops and the failed element becomes the first one.
+ *
+ * @param[in]    dq     the Caffeine Block Deque.
+ * @param[in]    del    the callback function to free the elements.
+ * @return       int    CAF_OK on success, the number of deleted
+ *                      elements if the callback fails.
+ *
+ * @see      bdeque_t
+ */
+int bdeque_delete (bdeque_t *dq, CAF_CAF_DEQUENODE_CBDEL(del));
+
+/**
+ *
+ * @brief    Deletes a Caffeine Block Deque without its elements.
+ *
+ * @param[in]    dq     the Caffeine Block Deque.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      bdeque_t
+ */
+int bdeque_delete_nocb (bdeque_t *dq);
+
+/**
+ *
+ * @brief    Returns the number of elements in the deque.
+ *
+ * @param[in]    dq     the Caffeine Block Deque.
+ * @return       int    the number of elements.
+ *
+ * @see      bdeque_t
+ */
+int bdeque_length (bdeque_t *dq);
+
+/**
+ *
+ * @brief    Appends an element at the tail of the deque.
+ *
+ * @param[in]    dq             the deque to push an element.
+ * @param[in]    data           the data to store.
+ * @return       bdeque_t *     the deque, NULL on failure.
+ *
+ * @see      bdeque_pop
+ * @see      bdeque_prepend
+ */
+bdeque_t *bdeque_push (bdeque_t *dq, void *data);
+
+/**
+ *
+ * @brief    Inserts an element at the head of the deque.
+ *
+ * @param[in]    dq             the deque to insert an element.
+ * @param[in]    data           the data to store.
+ * @return       bdeque_t *     the deque, NULL on failure.
+ *
+ * @see      bdeque_first
+ * @see      bdeque_push
+ */
+bdeque_t *bdeque_prepend (bdeque_t *dq, void *data);
+
+/**
+ *
+ * @brief    Gets and removes the tail element of the deque.
+ *
+ * @param[in]    dq         the deque to pop an element.
+ * @return       void *     the element data, NULL if the deque is
+ *                          empty.
+ *
+ * @see      bdeque_push
+ */
+void *bdeque_pop (bdeque_t *dq);
+
+/**
+ *
+ * @brief    Gets and removes the head element of the deque.
+ *
+ * @param[in]    dq         the deque to get the first element.
+ * @return       void *     the element data, NULL if the deque is
+ *                          empty.
+ *
+ * @see      bdeque_prepend
+ */
+void *bdeque_first (bdeque_t *dq);
+
+/**
+ *
+ * @brief    Gets the element at the given position.
+ *
+ * Positions start at zero.
+ *
+ * @param[in]    dq         the deque.
+ * @param[in]    pos        element position.
+ * @return       void *     the element data, NULL if out of range.
+ *
+ * @see      bdeque_set
+ */
+void *bdeque_get (bdeque_t *dq, int pos);
+
+/**
+ *
+ * @brief    Replaces the element at the given position.
+ *
+ * @param[in]    dq     the deque.
+ * @param[in]    pos    element position.
+ * @param[in]    data   new element data.
+ * @return       int    the position, CAF_ERROR_SUB if out of range.
+ *
+ * @see      bdeque_get
+ */
+int bdeque_set (bdeque_t *dq, int pos, void *data);
+
+/**
+ *
+ * @brief    Inserts an element at the given position.
+ *
+ * Moves the elements on the shorter side of <b>pos</b> by one place,
+ * so inserting near either end is cheap. A position equal to the
+ * length appends the element.
+ *
+ * @param[in]    dq     the deque.
+ * @param[in]    pos    element position.
+ * @param[in]    data   element data.
+ * @return       int    the position, CAF_ERROR_SUB on failure.
+ *
+ * @see      bdeque_remove
+ */
+int bdeque_insert (bdeque_t *dq, int pos, void *data);
+
+/**
+ *
+ * @brief    Removes the element at the given position.
+ *
+ * Moves the elements on the shorter side of <b>pos</b> by one place.
+ *
+ * @param[in]    dq         the deque.
+ * @param[in]    pos        element position.
+ * @return       void *     the removed element data, NULL if out of
+ *                          range.
+ *
+ * @see      bdeque_insert
+ */
+void *bdeque_remove (bdeque_t *dq, int pos);
+
+/**
+ *
+ * @brief    Apply a function to the deque elements.
+ *
+ * Takes the same callbacks as <b>deque_map</b>.
+ *
+ * @param[in]    dq         the deque to walk.
+ * @param[in]    step       the function to apply.
+ * @return       int        the number of afected elements.
+ *
+ * @see      deque_map
+ */
+int bdeque_map (bdeque_t *dq, CAF_CAF_DEQUENODE_CBMAP(step));
+
+/**
+ *
+ * @brief    Apply a function to the deque elements until it fails.
+ *
+ * Takes the same callbacks as <b>deque_map_checked</b>.
+ *
+ * @param[in]    dq         the deque to walk.
+ * @param[in]    step       the function to apply.
+ * @return       int        the number of afected elements.
+ *
+ * @see      deque_map_checked
+ */
+int bdeque_map_checked (bdeque_t *dq, CAF_CAF_DEQUENODE_CBMAP(step));
+
+/**
+ *
+ * @brief    Searches for an element using a callback function.
+ *
+ * Takes the same callbacks as <b>deque_search</b>.
+ *
+ * @param[in]    dq         the deque to search.
+ * @param[in]    data       the data to search.
+ * @param[in]    srch       the comparision callback.
+ * @return       void *     the found element data, NULL if not found.
+ *
+ * @see      deque_search
+ */
+void *bdeque_search (bdeque_t *dq, void *data,
+                     CAF_CAF_DEQUENODE_CBSRCH(srch));
+
+/**
+ *
+ * @brief    Creates a block deque from a Double Linked List.
+ *
+ * Copies the data pointers of <b>lst</b>, in order, into a new block
+ * deque, so lists returned by functions like <b>cbuf_split</b> can
+ * be used through the block deque. The list is left untouched.
+ *
+ * @param[in]    lst            the list to copy.
+ * @return       bdeque_t *     the new deque, NULL on failure.
+ *
+ * @see      bdeque_to_deque
+ */
+bdeque_t *bdeque_from_deque (deque_t *lst);
+
+/**
+ *
+ * @brief    Creates a Double Linked List from a block deque.
+ *
+ * Copies the data pointers of <b>dq</b>, in order, into a new
+ * Double Linked List, for functions like <b>cbuf_join</b> that take
+ * one. The deque is left untouched.
+ *
+ * @param[in]    dq             the deque to copy.
+ * @return       deque_t *      the new list, NULL on failure.
+ *
+ * @see      bdeque_from_deque
+ */
+deque_t *bdeque_to_deque (bdeque_t *dq);
+
+/**
+ *
+ * @brief    Caffeine Block Deque Dumper.
+ *
+ * Dumps every element of the deque through the dumper callback
+ * <b>dmp</b>, as <b>deque_dump</b> does.
+ *
+ * @param[in]    out        FILE output stream.
+ * @param[in]    dq         bdeque_t pointer to dump.
+ * @param[in]    dmp        element callback dumper.
+ *
+ * @see      deque_dump_str_cb
+ */
+void bdeque_dump (FILE *out, bdeque_t *dq, CAF_CAF_DEQUENODE_CBDUMP(dmp));
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_DATA_BDEQUE_H */
+/* caf_data_bdeque.h ends here */
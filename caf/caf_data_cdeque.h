@@ -26,6 +26,7 @@
 #define CAF_DATA_CDEQUE_H 1
 
 #include <stdio.h>
+#include <caf/caf_data_slab.h>
 
 /**
  * @defgroup      caf_dlnkc_list    Double Linked Circular List
@@ -99,16 +100,22 @@ typedef struct caf_cdeque_s cdeque_t;
  * @brief    Caffeine double linked list structure.
  *
  * The double linked list node structure stores a pointer to the
- * first list node, a pointer to de second list node and an integer
- * with the list size.
+ * first list node, a pointer to de second list node, an integer
+ * with the list size, the optional node slab and a finger that
+ * caches the last node reached by position, so sequential
+ * positional access does not restart from the head.
  *
  * @see      caf_cdequen_t
  * @see      cdeque_t
+ * @see      cdeque_slab_set
  */
 struct caf_cdeque_s {
 	caf_cdequen_t *head;
 	caf_cdequen_t *tail;
 	int size;
+	caf_slab_t *slab;
+	caf_cdequen_t *finger;
+	int finger_pos;
 };
 
 /**
@@ -174,6 +181,41 @@ int cdeque_delete (cdeque_t *lst, CAF_LSTDLCNODE_CBDEL(del));
  */
 int cdeque_delete_nocb (cdeque_t *lst);
 
+/**
+ *
+ * @brief    Makes the list allocate its nodes from a slab.
+ *
+ * Makes the empty list take its nodes from the slab <b>slab</b>
+ * and release them there, instead of calling xmalloc() and xfree()
+ * per node. The nodes returned by cdeque_pop() and cdeque_first()
+ * must then be released with cdeque_node_free(). A NULL slab goes
+ * back to xmalloc().
+ *
+ * @param[in]    lst     the empty list.
+ * @param[in]    slab    a slab of CAF_LSTDLCNODE_SZ objects.
+ * @return       int     CAF_OK on success, CAF_ERROR if the list is
+ *                       not empty.
+ *
+ * @see      caf_slab_new
+ * @see      cdeque_node_free
+ */
+int cdeque_slab_set (cdeque_t *lst, caf_slab_t *slab);
+
+/**
+ *
+ * @brief    Releases a node taken out of the list.
+ *
+ * Releases a node returned by cdeque_pop() or cdeque_first(), to
+ * the list slab if it has one, or through xfree() otherwise.
+ *
+ * @param[in]    lst    the list the node was taken from.
+ * @param[in]    n      the node.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      cdeque_slab_set
+ */
+int cdeque_node_free (cdeque_t *lst, caf_cdequen_t *n);
+
 /**
  *
  * @brief    Deletes a node from the given Caffeine dobule linked list.
@@ -239,7 +281,8 @@ int cdeque_oneitem_list (cdeque_t *lst);
  *
  * @brief    Returns the len of the given list.
  *
- * This function crosses the given list and returns his length.
+ * This function returns the list length, kept up to date by every
+ * list operation, in O(1) time.
  *
  * @param[in]    lst    The list to get length
  *
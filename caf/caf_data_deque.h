@@ -26,6 +26,7 @@
 #define CAF_DATA_DEQUE_H 1
 
 #include <stdio.h>
+#include <caf/caf_data_slab.h>
 
 /**
  * @defgroup      caf_dlnk_list    Double Linked List
@@ -99,16 +100,22 @@ typedef struct caf_deque_s deque_t;
  * @brief    Caffeine double linked list structure.
  *
  * The double linked list node structure stores a pointer to the
- * first list node, a pointer to de second list node and an integer
- * with the list size.
+ * first list node, a pointer to de second list node, an integer
+ * with the list size and the optional node slab. The finger is the
+ * last node reached by position, so positional walks start from the
+ * closest of the head, the tail and the finger.
  *
  * @see      caf_dequen_t
  * @see      deque_t
+ * @see      deque_slab_set
  */
 struct caf_deque_s {
 	caf_dequen_t *head;
 	caf_dequen_t *tail;
 	int size;
+	caf_slab_t *slab;
+	caf_dequen_t *finger;
+	int finger_pos;
 };
 
 /**
@@ -174,6 +181,42 @@ int deque_delete (deque_t *lst, CAF_CAF_DEQUENODE_CBDEL(del));
  */
 int deque_delete_nocb (deque_t *lst);
 
+/**
+ *
+ * @brief    Makes the list allocate its nodes from a slab.
+ *
+ * Makes the empty list take its nodes from the slab <b>slab</b>
+ * and release them there, instead of calling xmalloc() and xfree()
+ * per node. A slab may be shared by several lists used from the
+ * same thread, or from many threads if it is locked. The nodes
+ * returned by deque_pop() and deque_first() must then be released
+ * with deque_node_free(). A NULL slab goes back to xmalloc().
+ *
+ * @param[in]    lst     the empty list.
+ * @param[in]    slab    a slab of CAF_CAF_DEQUENODE_SZ objects.
+ * @return       int     CAF_OK on success, CAF_ERROR if the list is
+ *                       not empty.
+ *
+ * @see      caf_slab_new
+ * @see      deque_node_free
+ */
+int deque_slab_set (deque_t *lst, caf_slab_t *slab);
+
+/**
+ *
+ * @brief    Releases a node taken out of the list.
+ *
+ * Releases a node returned by deque_pop() or deque_first(), to the
+ * list slab if it has one, or through xfree() otherwise.
+ *
+ * @param[in]    lst    the list the node was taken from.
+ * @param[in]    n      the node.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      deque_slab_set
+ */
+int deque_node_free (deque_t *lst, caf_dequen_t *n);
+
 /**
  *
  * @brief    Deletes a node from the given Caffeine dobule linked list.
@@ -241,7 +284,8 @@ int deque_oneitem_list (deque_t *lst);
  *
  * @brief    Returns the len of the given list.
  *
- * This function crosses the given list and returns his length.
+ * This function returns the list length, kept up to date by every
+ * list operation, in O(1) time.
  *
  * @param[in]    lst    The list to get length
  *
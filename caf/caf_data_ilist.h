@@ -0,0 +1,512 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more denexts.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_DATA_ILIST_H
+#define CAF_DATA_ILIST_H 1
+
+#include <stdio.h>
+#include <stddef.h>
+#include <caf/caf_tool_macro.h>
+#include <caf/caf_data_deque.h>
+
+/**
+ * @defgroup      caf_intrusive_list    Intrusive Lists
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_intrusive_list
+ * @{
+ *
+ * @brief     Caffeine Intrusive Deque and Circular List Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Intrusive list management functions. The list links live inside
+ * the user structure as a <b>caf_ilink_t</b> member, so linking an
+ * object allocates nothing and an object is unlinked in O(1) time.
+ * A list knows the offset of the link member in the user structure,
+ * so its functions take and return object pointers, and the
+ * callbacks written for the Double Linked List work unchanged. An
+ * object may be in as many lists as it has links, but each link may
+ * be in one list at a time.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Computes the intrusive deque structure size */
+#define CAF_IDEQUE_SZ                  (sizeof(ideque_t))
+/** Computes the intrusive circular list structure size */
+#define CAF_ILSTC_SZ                   (sizeof(ilstc_t))
+/** Object holding the link l, of type t and link member m */
+#define CAF_ILINK_ENTRY(l, t, m)       CAF_CONTAINER_OF(l, t, m)
+/** Object holding the link l in the list lst */
+#define CAF_ILINK_OBJ(lst, l)          ((void *)((char *)(l) - (lst)->offset))
+/** Link of the object o in the list lst */
+#define CAF_ILINK_OF(lst, o)           ((caf_ilink_t *)((char *)(o) + \
+                                                         (lst)->offset))
+
+/**
+ *
+ * @brief    Caffeine intrusive list link type.
+ *
+ * @see      caf_ilink_s
+ */
+typedef struct caf_ilink_s caf_ilink_t;
+
+/**
+ *
+ * @brief    Caffeine intrusive list link structure.
+ *
+ * The link embedded in the user structure, with the previous and
+ * the next link in the list, as in <b>caf_dequen_t</b>.
+ *
+ * @see      caf_ilink_t
+ */
+struct caf_ilink_s {
+	/** Pointer to the previous link in the list */
+	caf_ilink_t *prev;
+	/** Pointer to the next link in the list */
+	caf_ilink_t *next;
+};
+
+/**
+ *
+ * @brief    Caffeine intrusive deque type.
+ *
+ * @see      caf_ideque_s
+ */
+typedef struct caf_ideque_s ideque_t;
+
+/**
+ *
+ * @brief    Caffeine intrusive deque structure.
+ *
+ * Stores the first and the last link, the number of linked objects
+ * and the offset of the link member in the objects.
+ *
+ * @see      ideque_t
+ */
+struct caf_ideque_s {
+	/** First link, NULL if empty */
+	caf_ilink_t *head;
+	/** Last link, NULL if empty */
+	caf_ilink_t *tail;
+	/** Number of linked objects */
+	int size;
+	/** Offset of the link member in the objects */
+	size_t offset;
+};
+
+/**
+ *
+ * @brief    Caffeine intrusive circular list type.
+ *
+ * @see      caf_ilstc_s
+ */
+typedef struct caf_ilstc_s ilstc_t;
+
+/**
+ *
+ * @brief    Caffeine intrusive circular list structure.
+ *
+ * Stores a sentinel link closing the circle, the number of linked
+ * objects and the offset of the link member in the objects. The
+ * sentinel is skipped when walking the circle.
+ *
+ * @see      ilstc_t
+ */
+struct caf_ilstc_s {
+	/** Sentinel link, its next is the first object link */
+	caf_ilink_t ring;
+	/** Number of linked objects */
+	int size;
+	/** Offset of the link member in the objects */
+	size_t offset;
+};
+
+/**
+ *
+ * @brief    Creates a new intrusive deque.
+ *
+ * @param[in]    offset         offset of the <b>caf_ilink_t</b> member
+ *                              in the objects, from offsetof().
+ * @return       ideque_t *     the allocated deque.
+ *
+ * @see      ideque_init
+ */
+ideque_t *ideque_create (const size_t offset);
+
+/**
+ *
+ * @brief    Initializes an intrusive deque embedded in a structure.
+ *
+ * @param[in]    dq         the deque to initialize.
+ * @param[in]    offset     offset of the link member in the objects.
+ * @return       int        CAF_OK on success, CAF_ERROR on failure.
+ */
+int ideque_init (ideque_t *dq, const size_t offset);
+
+/**
+ *
+ * @brief    Deletes an intrusive deque.
+ *
+ * Unlinks every object and gives it to the callback <b>del</b>,
+ * which may free it, then frees the deque. If the callback fails
+ * the deletion stops and the failed object stays as the first one.
+ *
+ * @param[in]    dq     the deque, from ideque_create().
+ * @param[in]    del    the object deletion callback.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ideque_delete (ideque_t *dq, CAF_CAF_DEQUENODE_CBDEL(del));
+
+/**
+ *
+ * @brief    Deletes an intrusive deque, leaving its objects alone.
+ *
+ * @param[in]    dq     the deque, from ideque_create().
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ideque_delete_nocb (ideque_t *dq);
+
+/**
+ *
+ * @brief    Returns the number of linked objects, in O(1) time.
+ *
+ * @param[in]    dq     the deque.
+ * @return       int    the number of linked objects.
+ */
+int ideque_length (ideque_t *dq);
+
+/**
+ *
+ * @brief    Links an object at the tail of the deque.
+ *
+ * @param[in]    dq             the deque.
+ * @param[in]    obj            the object, with an unlinked link.
+ * @return       ideque_t *     the deque, NULL on failure.
+ */
+ideque_t *ideque_push (ideque_t *dq, void *obj);
+
+/**
+ *
+ * @brief    Links an object at the head of the deque.
+ *
+ * @param[in]    dq             the deque.
+ * @param[in]    obj            the object, with an unlinked link.
+ * @return       ideque_t *     the deque, NULL on failure.
+ */
+ideque_t *ideque_prepend (ideque_t *dq, void *obj);
+
+/**
+ *
+ * @brief    Links an object after another linked object.
+ *
+ * @param[in]    dq     the deque.
+ * @param[in]    pos    an object linked in the deque.
+ * @param[in]    obj    the object, with an unlinked link.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ideque_insert_after (ideque_t *dq, void *pos, void *obj);
+
+/**
+ *
+ * @brief    Links an object before another linked object.
+ *
+ * @param[in]    dq     the deque.
+ * @param[in]    pos    an object linked in the deque.
+ * @param[in]    obj    the object, with an unlinked link.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ideque_insert_before (ideque_t *dq, void *pos, void *obj);
+
+/**
+ *
+ * @brief    Unlinks and returns the tail object.
+ *
+ * @param[in]    dq         the deque.
+ * @return       void *     the object, NULL if the deque is empty.
+ */
+void *ideque_pop (ideque_t *dq);
+
+/**
+ *
+ * @brief    Unlinks and returns the head object.
+ *
+ * @param[in]    dq         the deque.
+ * @return       void *     the object, NULL if the deque is empty.
+ */
+void *ideque_first (ideque_t *dq);
+
+/**
+ *
+ * @brief    Unlinks an object from the deque in O(1) time.
+ *
+ * The object must be linked in <b>dq</b>; its link is cleared. An
+ * object that is not linked, such as one already removed, is
+ * rejected and leaves the deque untouched.
+ *
+ * @param[in]    dq     the deque.
+ * @param[in]    obj    the linked object.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ideque_remove (ideque_t *dq, void *obj);
+
+/**
+ *
+ * @brief    Returns the head object, leaving it linked.
+ *
+ * @param[in]    dq         the deque.
+ * @return       void *     the object, NULL if the deque is empty.
+ */
+void *ideque_head (ideque_t *dq);
+
+/**
+ *
+ * @brief    Returns the tail object, leaving it linked.
+ *
+ * @param[in]    dq         the deque.
+ * @return       void *     the object, NULL if the deque is empty.
+ */
+void *ideque_tail (ideque_t *dq);
+
+/**
+ *
+ * @brief    Returns the object following a linked object.
+ *
+ * @param[in]    dq         the deque.
+ * @param[in]    obj        the linked object.
+ * @return       void *     the next object, NULL at the tail.
+ */
+void *ideque_next (ideque_t *dq, void *obj);
+
+/**
+ *
+ * @brief    Returns the object preceding a linked object.
+ *
+ * @param[in]    dq         the deque.
+ * @param[in]    obj        the linked object.
+ * @return       void *     the previous object, NULL at the head.
+ */
+void *ideque_prev (ideque_t *dq, void *obj);
+
+/**
+ *
+ * @brief    Apply a function to the linked objects.
+ *
+ * Takes the same callbacks as <b>deque_map</b>.
+ *
+ * @param[in]    dq         the deque to walk.
+ * @param[in]    step       the function to apply.
+ * @return       int        the number of afected objects.
+ */
+int ideque_map (ideque_t *dq, CAF_CAF_DEQUENODE_CBMAP(step));
+
+/**
+ *
+ * @brief    Searches for an object using a callback function.
+ *
+ * Takes the same callbacks as <b>deque_search</b>.
+ *
+ * @param[in]    dq         the deque to search.
+ * @param[in]    data       the data to search.
+ * @param[in]    srch       the comparision callback.
+ * @return       void *     the found object, NULL if not found.
+ */
+void *ideque_search (ideque_t *dq, void *data,
+                     CAF_CAF_DEQUENODE_CBSRCH(srch));
+
+/**
+ *
+ * @brief    Creates a new intrusive circular list.
+ *
+ * @param[in]    offset         offset of the <b>caf_ilink_t</b> member
+ *                              in the objects, from offsetof().
+ * @return       ilstc_t *      the allocated list.
+ *
+ * @see      ilstc_init
+ */
+ilstc_t *ilstc_create (const size_t offset);
+
+/**
+ *
+ * @brief    Initializes an intrusive circular list embedded in a
+ *           structure.
+ *
+ * @param[in]    lst        the list to initialize.
+ * @param[in]    offset     offset of the link member in the objects.
+ * @return       int        CAF_OK on success, CAF_ERROR on failure.
+ */
+int ilstc_init (ilstc_t *lst, const size_t offset);
+
+/**
+ *
+ * @brief    Deletes an intrusive circular list.
+ *
+ * Unlinks every object and gives it to the callback <b>del</b>,
+ * which may free it, then frees the list. If the callback fails
+ * the deletion stops and the failed object stays as the first one.
+ *
+ * @param[in]    lst    the list, from ilstc_create().
+ * @param[in]    del    the object deletion callback.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ilstc_delete (ilstc_t *lst, CAF_CAF_DEQUENODE_CBDEL(del));
+
+/**
+ *
+ * @brief    Deletes an intrusive circular list, leaving its objects
+ *           alone.
+ *
+ * @param[in]    lst    the list, from ilstc_create().
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ilstc_delete_nocb (ilstc_t *lst);
+
+/**
+ *
+ * @brief    Returns the number of linked objects, in O(1) time.
+ *
+ * @param[in]    lst    the list.
+ * @return       int    the number of linked objects.
+ */
+int ilstc_length (ilstc_t *lst);
+
+/**
+ *
+ * @brief    Links an object at the end of the circle, right before
+ *           the first object.
+ *
+ * @param[in]    lst            the list.
+ * @param[in]    obj            the object, with an unlinked link.
+ * @return       ilstc_t *      the list, NULL on failure.
+ */
+ilstc_t *ilstc_push (ilstc_t *lst, void *obj);
+
+/**
+ *
+ * @brief    Links an object as the first one of the circle.
+ *
+ * @param[in]    lst            the list.
+ * @param[in]    obj            the object, with an unlinked link.
+ * @return       ilstc_t *      the list, NULL on failure.
+ */
+ilstc_t *ilstc_prepend (ilstc_t *lst, void *obj);
+
+/**
+ *
+ * @brief    Unlinks and returns the last object of the circle.
+ *
+ * @param[in]    lst        the list.
+ * @return       void *     the object, NULL if the list is empty.
+ */
+void *ilstc_pop (ilstc_t *lst);
+
+/**
+ *
+ * @brief    Unlinks and returns the first object of the circle.
+ *
+ * @param[in]    lst        the list.
+ * @return       void *     the object, NULL if the list is empty.
+ */
+void *ilstc_first (ilstc_t *lst);
+
+/**
+ *
+ * @brief    Unlinks an object from the circle in O(1) time.
+ *
+ * The object must be linked in <b>lst</b>; its link is cleared. An
+ * object whose link is cleared is rejected.
+ *
+ * @param[in]    lst    the list.
+ * @param[in]    obj    the linked object.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ */
+int ilstc_remove (ilstc_t *lst, void *obj);
+
+/**
+ *
+ * @brief    Moves the first object to the end of the circle.
+ *
+ * Useful for round robin over the linked objects.
+ *
+ * @param[in]    lst        the list.
+ * @return       void *     the object moved, NULL if the list is
+ *                          empty.
+ */
+void *ilstc_rotate (ilstc_t *lst);
+
+/**
+ *
+ * @brief    Returns the first object, leaving it linked.
+ *
+ * @param[in]    lst        the list.
+ * @return       void *     the object, NULL if the list is empty.
+ */
+void *ilstc_head (ilstc_t *lst);
+
+/**
+ *
+ * @brief    Returns the object following a linked object.
+ *
+ * The circle wraps around, so the last object is followed by the
+ * first one.
+ *
+ * @param[in]    lst        the list.
+ * @param[in]    obj        the linked object.
+ * @return       void *     the next object.
+ */
+void *ilstc_next (ilstc_t *lst, void *obj);
+
+/**
+ *
+ * @brief    Apply a function to the linked objects, once each.
+ *
+ * @param[in]    lst        the list to walk.
+ * @param[in]    step       the function to apply.
+ * @return       int        the number of afected objects.
+ */
+int ilstc_map (ilstc_t *lst, CAF_CAF_DEQUENODE_CBMAP(step));
+
+/**
+ *
+ * @brief    Searches for an object using a callback function.
+ *
+ * @param[in]    lst        the list to search.
+ * @param[in]    data       the data to search.
+ * @param[in]    srch       the comparision callback.
+ * @return       void *     the found object, NULL if not found.
+ */
+void *ilstc_search (ilstc_t *lst, void *data,
+                    CAF_CAF_DEQUENODE_CBSRCH(srch));
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_DATA_ILIST_H */
+/* caf_data_ilist.h ends here */
@@ -24,6 +24,9 @@
 */
 #ifndef CAF_DATA_LSTC_H
 #define CAF_DATA_LSTC_H 1
+
+#include <caf/caf_data_slab.h>
+
 /**
  * @defgroup      caf_circular_list    Circular List
  * @ingroup       caf_data_struct
@@ -124,6 +127,43 @@ lstcn_t *lstc_create (void);
  */
 int lstc_delete (lstcn_t *lst, CAF_LSTCNODE_CBDEL(del));
 
+/**
+ *
+ * @brief    Makes every circular list allocate its nodes from a slab.
+ *
+ * Circular lists have no container to hold a slab, so the slab is
+ * shared by every list in the process. It can be set only once, and
+ * only before the first circular list node is created: the first
+ * node allocated without a slab makes every later call fail, so
+ * nodes from xmalloc() and from the slab are never mixed. The slab
+ * must be kept for the rest of the process, and it must be a
+ * CAF_SLAB_LOCKED slab if lists are used from several threads.
+ * The nodes returned by lstc_pop() must then be released with
+ * lstc_node_free().
+ *
+ * @param[in]    slab           a slab of CAF_LSTC_SZ objects.
+ * @return       int            CAF_OK on success, CAF_ERROR if a slab
+ *                              is already set or nodes exist.
+ *
+ * @see      caf_slab_new
+ * @see      lstc_node_free
+ */
+int lstc_slab_set (caf_slab_t *slab);
+
+/**
+ *
+ * @brief    Releases a node taken out of a circular list.
+ *
+ * Releases a node returned by lstc_pop(), to the circular list slab
+ * if one is set, or through xfree() otherwise.
+ *
+ * @param[in]    n      the node.
+ * @return       int    CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      lstc_slab_set
+ */
+int lstc_node_free (lstcn_t *n);
+
 /**
  *
  * @brief    Deletes a node from the given Caffeine Circular List.
@@ -0,0 +1,265 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more denexts.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_DATA_RING_H
+#define CAF_DATA_RING_H 1
+
+#include <stdio.h>
+
+/**
+ * @defgroup      caf_ring    SPSC Ring
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_ring
+ * @{
+ *
+ * @brief     Caffeine Single Producer Single Consumer Ring Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Bounded lock free ring to hand items from exactly one producer
+ * thread to exactly one consumer thread. The capacity is a power of
+ * two, the producer and consumer indexes live on separate cache
+ * lines, and each side publishes its index with release semantics
+ * and reads the other one with acquire semantics. Slots hold either
+ * void pointers or fixed size records copied inline, and both sides
+ * can move many items with a single index update.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Computes the ring structure size */
+#define CAF_RING_SZ                    (sizeof(caf_ring_t))
+/** Cache line size used to keep the ring indexes apart */
+#define CAF_RING_CACHELINE             64
+/** Minimum ring capacity */
+#define CAF_RING_MIN                   2
+
+/**
+ *
+ * @brief    Caffeine SPSC ring type.
+ *
+ * @see      caf_ring_s
+ */
+typedef struct caf_ring_s caf_ring_t;
+
+/**
+ *
+ * @brief    Caffeine SPSC ring structure.
+ *
+ * The indexes run freely and are masked on every slot access, so
+ * the ring is empty when both are equal and full when they are one
+ * capacity apart. Each side keeps a cached copy of the other side
+ * index and only reloads it when the cached copy says the ring is
+ * full or empty.
+ *
+ * @see      caf_ring_t
+ */
+struct caf_ring_s {
+	/** Keeps the consumer line away from preceding memory */
+	char pad0[CAF_RING_CACHELINE];
+	/** Consumer index, written by the consumer only */
+	size_t head;
+	/** Producer index as last seen by the consumer */
+	size_t tail_cache;
+	/** Keeps the producer line away from the consumer line */
+	char pad1[CAF_RING_CACHELINE - 2 * sizeof (size_t)];
+	/** Producer index, written by the producer only */
+	size_t tail;
+	/** Consumer index as last seen by the producer */
+	size_t head_cache;
+	/** Keeps the read only fields away from the producer line */
+	char pad2[CAF_RING_CACHELINE - 2 * sizeof (size_t)];
+	/** Capacity minus one */
+	size_t mask;
+	/** Slot size in bytes */
+	size_t rec_sz;
+	/** Slot storage */
+	char *slots;
+};
+
+/**
+ *
+ * @brief    Creates a new ring of void pointers.
+ *
+ * @param[in]    cnt            minimum capacity, rounded up to a
+ *                              power of two.
+ * @return       caf_ring_t *   the new ring, NULL on failure.
+ */
+caf_ring_t *caf_ring_new (const size_t cnt);
+
+/**
+ *
+ * @brief    Creates a new ring of fixed size inline records.
+ *
+ * @param[in]    cnt            minimum capacity, rounded up to a
+ *                              power of two.
+ * @param[in]    rec_sz         record size in bytes.
+ * @return       caf_ring_t *   the new ring, NULL on failure.
+ */
+caf_ring_t *caf_ring_new_rec (const size_t cnt, const size_t rec_sz);
+
+/**
+ *
+ * @brief    Deletes a ring.
+ *
+ * Items still queued are dropped, pointed data is not released.
+ *
+ * @param[in]    r       the ring to delete.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_ring_delete (caf_ring_t *r);
+
+/**
+ *
+ * @brief    Enqueues a pointer, producer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[in]    data    the pointer to enqueue.
+ * @return       int     CAF_OK on success, CAF_ERROR if the ring is
+ *                       full or does not hold pointers.
+ */
+int caf_ring_push (caf_ring_t *r, void *data);
+
+/**
+ *
+ * @brief    Dequeues a pointer, consumer side.
+ *
+ * A queued NULL pointer is indistinguishable from an empty ring,
+ * use caf_ring_pop_batch() to queue NULL pointers.
+ *
+ * @param[in]    r       the ring.
+ * @return       void *  the oldest pointer, NULL if the ring is
+ *                       empty.
+ */
+void *caf_ring_pop (caf_ring_t *r);
+
+/**
+ *
+ * @brief    Enqueues many pointers, producer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[in]    data    the pointers to enqueue.
+ * @param[in]    cnt     number of pointers.
+ * @return       size_t  number of pointers enqueued, less than cnt
+ *                       when the ring fills up.
+ */
+size_t caf_ring_push_batch (caf_ring_t *r, void **data, const size_t cnt);
+
+/**
+ *
+ * @brief    Dequeues many pointers, consumer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[out]   data    the dequeued pointers.
+ * @param[in]    cnt     maximum number of pointers.
+ * @return       size_t  number of pointers dequeued.
+ */
+size_t caf_ring_pop_batch (caf_ring_t *r, void **data, const size_t cnt);
+
+/**
+ *
+ * @brief    Copies a record into the ring, producer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[in]    rec     the record, rec_sz bytes long.
+ * @return       int     CAF_OK on success, CAF_ERROR if the ring is
+ *                       full.
+ */
+int caf_ring_write (caf_ring_t *r, const void *rec);
+
+/**
+ *
+ * @brief    Copies a record out of the ring, consumer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[out]   rec     the record buffer, rec_sz bytes long.
+ * @return       int     CAF_OK on success, CAF_ERROR if the ring is
+ *                       empty.
+ */
+int caf_ring_read (caf_ring_t *r, void *rec);
+
+/**
+ *
+ * @brief    Copies an array of records into the ring, producer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[in]    recs    the records, cnt times rec_sz bytes long.
+ * @param[in]    cnt     number of records.
+ * @return       size_t  number of records enqueued.
+ */
+size_t caf_ring_write_batch (caf_ring_t *r, const void *recs,
+                             const size_t cnt);
+
+/**
+ *
+ * @brief    Copies records out of the ring, consumer side.
+ *
+ * @param[in]    r       the ring.
+ * @param[out]   recs    the record buffer, cnt times rec_sz bytes.
+ * @param[in]    cnt     maximum number of records.
+ * @return       size_t  number of records dequeued.
+ */
+size_t caf_ring_read_batch (caf_ring_t *r, void *recs, const size_t cnt);
+
+/**
+ *
+ * @brief    Returns the number of queued items.
+ *
+ * The value is exact from either side and a snapshot from any
+ * other thread.
+ *
+ * @param[in]    r       the ring.
+ * @return       size_t  the number of queued items.
+ */
+size_t caf_ring_length (caf_ring_t *r);
+
+/**
+ *
+ * @brief    Returns the ring capacity.
+ *
+ * @param[in]    r       the ring.
+ * @return       size_t  the ring capacity.
+ */
+size_t caf_ring_capacity (caf_ring_t *r);
+
+/**
+ *
+ * @brief    Dumps the ring indexes.
+ *
+ * @param[in]    out     FILE output stream.
+ * @param[in]    r       the ring to dump.
+ */
+void caf_ring_dump (FILE *out, caf_ring_t *r);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_DATA_RING_H */
+/* caf_data_ring.h ends here */
@@ -0,0 +1,169 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more denexts.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_DATA_SLAB_H
+#define CAF_DATA_SLAB_H 1
+
+#include <stdio.h>
+
+/**
+ * @defgroup      caf_slab    Node Slab
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_slab
+ * @{
+ *
+ * @brief     Caffeine Node Slab Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Fixed size object allocator. Objects are carved from large chunks
+ * and released objects are kept in a free list, so allocating and
+ * releasing a list node is a pointer pop or push instead of a
+ * malloc(3) or free(3) call.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Computes the slab structure size */
+#define CAF_SLAB_SZ                    (sizeof(caf_slab_t))
+/** Default number of objects per chunk */
+#define CAF_SLAB_CHUNK                 256
+/** The slab is used from a single thread */
+#define CAF_SLAB_UNLOCKED              0
+/** The slab is shared between threads and takes a spin lock */
+#define CAF_SLAB_LOCKED                1
+
+/**
+ *
+ * @brief    Caffeine node slab type.
+ *
+ * @see      caf_slab_s
+ */
+typedef struct caf_slab_s caf_slab_t;
+
+/**
+ *
+ * @brief    Caffeine node slab structure.
+ *
+ * Stores the chunk list, the free list and the allocation counters.
+ * An allocation served from the free list counts as a hit and an
+ * allocation served from fresh chunk memory counts as a miss.
+ *
+ * @see      caf_slab_t
+ */
+struct caf_slab_s {
+	/** Object size, rounded up to a pointer size */
+	size_t obj_sz;
+	/** Number of objects per chunk */
+	size_t per_chunk;
+	/** Released objects, linked through their first word */
+	void *free_list;
+	/** Allocated chunks, linked through their first word */
+	void *chunks;
+	/** Unused objects left in the newest chunk */
+	size_t left;
+	/** Number of allocated chunks */
+	size_t chunk_count;
+	/** Non zero if the slab takes its spin lock */
+	int locked;
+	/** Spin lock flag */
+	volatile char lock;
+	/** Allocations served from the free list */
+	unsigned long hits;
+	/** Allocations served from fresh chunk memory */
+	unsigned long misses;
+	/** Released objects */
+	unsigned long frees;
+};
+
+/**
+ *
+ * @brief    Creates a new node slab.
+ *
+ * @param[in]    obj_sz         object size.
+ * @param[in]    per_chunk      objects per chunk, zero takes
+ *                              CAF_SLAB_CHUNK.
+ * @param[in]    locked         CAF_SLAB_LOCKED to share the slab
+ *                              between threads, CAF_SLAB_UNLOCKED
+ *                              otherwise. Locked slabs need the GCC
+ *                              atomic builtins, other compilers get
+ *                              NULL.
+ * @return       caf_slab_t *   the new slab, NULL on failure.
+ */
+caf_slab_t *caf_slab_new (const size_t obj_sz, const size_t per_chunk,
+                          const int locked);
+
+/**
+ *
+ * @brief    Deletes a node slab.
+ *
+ * Releases every chunk of the slab. Objects still in use by a
+ * container become invalid, so the containers using the slab must
+ * be deleted first.
+ *
+ * @param[in]    slab    the slab to delete.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_slab_delete (caf_slab_t *slab);
+
+/**
+ *
+ * @brief    Allocates an object from the slab.
+ *
+ * @param[in]    slab       the slab.
+ * @return       void *     the object, not initialized, NULL on
+ *                          failure.
+ */
+void *caf_slab_alloc (caf_slab_t *slab);
+
+/**
+ *
+ * @brief    Releases an object to the slab free list.
+ *
+ * @param[in]    slab    the slab the object was allocated from.
+ * @param[in]    ptr     the object.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_slab_free (caf_slab_t *slab, void *ptr);
+
+/**
+ *
+ * @brief    Dumps the slab counters.
+ *
+ * @param[in]    out     FILE output stream.
+ * @param[in]    slab    the slab to dump.
+ */
+void caf_slab_dump (FILE *out, caf_slab_t *slab);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_DATA_SLAB_H */
+/* caf_data_slab.h ends here */
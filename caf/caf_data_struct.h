@@ -29,10 +29,18 @@
  * @ingroup       caf
  */
 
+#include <caf/caf_data_slab.h>
 #include <caf/caf_data_lstc.h>
 #include <caf/caf_data_deque.h>
+#include <caf/caf_data_bdeque.h>
 #include <caf/caf_data_cdeque.h>
+#include <caf/caf_data_ilist.h>
+#include <caf/caf_data_ring.h>
+#include <caf/caf_data_arena.h>
+#include <caf/caf_data_wheel.h>
 #include <caf/caf_hash_table.h>
+#include <caf/caf_chash_table.h>
+#include <caf/caf_rhash_table.h>
 
 #endif /* !CAF_DATA_STRUCT_H */
 /* caf_data_struct.h ends here */
@@ -0,0 +1,249 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more denexts.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_DATA_WHEEL_H
+#define CAF_DATA_WHEEL_H 1
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @defgroup      caf_wheel    Timer Wheel
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_wheel
+ * @{
+ *
+ * @brief     Caffeine Timer Wheel Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Hashed hierarchical timing wheel. Time is counted in ticks since the
+ * wheel was created, a timer lands in the slot of the level that fits
+ * its distance to the current tick, and the slots of the upper levels
+ * are cascaded down as the lower ones wrap. Adding and canceling a
+ * timer are constant time, and the timers are embedded in the caller
+ * structures, so the wheel allocates nothing once created. A wheel is
+ * not locked, it belongs to the thread running its event loop.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Computes the timer wheel structure size */
+#define CAF_WHEEL_SZ                   (sizeof(caf_wheel_t))
+/** Bits of the slot index on each level */
+#define CAF_WHEEL_BITS                 6
+/** Slots on each level */
+#define CAF_WHEEL_SLOTS                (1 << CAF_WHEEL_BITS)
+/** Number of levels, they span 2^30 ticks */
+#define CAF_WHEEL_LEVELS               5
+/** Default tick length in nanoseconds */
+#define CAF_WHEEL_TICK                 1000000L
+/** Timer callback prototype */
+#define CAF_WHEEL_RTN(rtn)             void (*rtn)(caf_wheel_timer_t *t,  \
+                                                   void *arg)
+
+/**
+ *
+ * @brief    Caffeine timer type.
+ *
+ * @see      caf_wheel_timer_s
+ */
+typedef struct caf_wheel_timer_s caf_wheel_timer_t;
+
+/**
+ *
+ * @brief    Caffeine timer structure.
+ *
+ * Embedded in the structure that owns the timer, it must be set up
+ * with caf_wheel_timer_init() before the first use.
+ *
+ * @see      caf_wheel_timer_t
+ */
+struct caf_wheel_timer_s {
+	/** Next timer in the slot */
+	caf_wheel_timer_t *next;
+	/** Link pointing to this timer, NULL when not pending */
+	caf_wheel_timer_t **pprev;
+	/** Expiration tick */
+	unsigned long long expires;
+	/** Level holding the timer */
+	int level;
+	/** Slot holding the timer */
+	int slot;
+	/** Expiration callback */
+	CAF_WHEEL_RTN(rtn);
+	/** Callback argument */
+	void *arg;
+};
+
+/**
+ *
+ * @brief    Caffeine timer wheel type.
+ *
+ * @see      caf_wheel_s
+ */
+typedef struct caf_wheel_s caf_wheel_t;
+
+/**
+ *
+ * @brief    Caffeine timer wheel structure.
+ *
+ * Each level keeps a bitmap of its busy slots, so the next deadline
+ * is found without walking the slots.
+ *
+ * @see      caf_wheel_t
+ */
+struct caf_wheel_s {
+	/** Slot lists */
+	caf_wheel_timer_t *slots[CAF_WHEEL_LEVELS][CAF_WHEEL_SLOTS];
+	/** Busy slots of each level */
+	unsigned long long busy[CAF_WHEEL_LEVELS];
+	/** Next tick to process */
+	unsigned long long tick;
+	/** Tick length in nanoseconds */
+	long tick_ns;
+	/** Monotonic time of tick zero */
+	struct timespec origin;
+	/** Pending timers */
+	size_t count;
+	/** Fired timers */
+	unsigned long fired;
+	/** Timers moved down a level */
+	unsigned long cascaded;
+};
+
+/**
+ *
+ * @brief    Creates a new timer wheel.
+ *
+ * @param[in]    tick_ns        tick length in nanoseconds, zero takes
+ *                              CAF_WHEEL_TICK.
+ * @return       caf_wheel_t *  the new wheel, NULL on failure.
+ */
+caf_wheel_t *caf_wheel_new (const long tick_ns);
+
+/**
+ *
+ * @brief    Deletes a timer wheel.
+ *
+ * The pending timers are unlinked without running their callbacks.
+ *
+ * @param[in]    w       the wheel to delete.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_wheel_delete (caf_wheel_t *w);
+
+/**
+ *
+ * @brief    Sets up a timer.
+ *
+ * @param[in]    t       the timer.
+ * @param[in]    rtn     callback run on expiration.
+ * @param[in]    arg     callback argument.
+ */
+void caf_wheel_timer_init (caf_wheel_timer_t *t, CAF_WHEEL_RTN(rtn),
+                           void *arg);
+
+/**
+ *
+ * @brief    Arms a timer.
+ *
+ * A pending timer is moved to the new deadline, which makes idle
+ * timers cheap to push back. Timeouts beyond the span of the wheel
+ * are clamped to it.
+ *
+ * @param[in]    w       the wheel.
+ * @param[in]    t       the timer.
+ * @param[in]    tm      timeout, relative to now.
+ * @return       int     CAF_OK on success, CAF_ERROR on failure.
+ */
+int caf_wheel_add (caf_wheel_t *w, caf_wheel_timer_t *t,
+                   const struct timespec *tm);
+
+/**
+ *
+ * @brief    Cancels a timer.
+ *
+ * @param[in]    w       the wheel.
+ * @param[in]    t       the timer.
+ * @return       int     CAF_OK if it was pending, CAF_ERROR if not.
+ */
+int caf_wheel_cancel (caf_wheel_t *w, caf_wheel_timer_t *t);
+
+/**
+ *
+ * @brief    Checks if a timer is pending.
+ *
+ * @param[in]    t       the timer.
+ * @return       int     CAF_OK if pending, CAF_ERROR if not.
+ */
+int caf_wheel_pending (caf_wheel_timer_t *t);
+
+/**
+ *
+ * @brief    Runs the expired timers.
+ *
+ * Processes every tick up to now, skipping the ones with nothing to
+ * fire or cascade. A callback may arm or cancel any timer, itself
+ * included.
+ *
+ * @param[in]    w       the wheel.
+ * @return       int     the number of fired timers.
+ */
+int caf_wheel_advance (caf_wheel_t *w);
+
+/**
+ *
+ * @brief    Computes the time left to the next deadline.
+ *
+ * The deadline is never later than the next expiration, it may be
+ * earlier when a far timer has to be cascaded first.
+ *
+ * @param[in]    w       the wheel.
+ * @param[out]   tm      time left, zero when already due.
+ * @return       int     CAF_OK on success, CAF_ERROR if no timer is
+ *                       pending.
+ */
+int caf_wheel_next (caf_wheel_t *w, struct timespec *tm);
+
+/**
+ *
+ * @brief    Dumps the wheel counters.
+ *
+ * @param[in]    out     FILE output stream.
+ * @param[in]    w       the wheel to dump.
+ */
+void caf_wheel_dump (FILE *out, caf_wheel_t *w);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_DATA_WHEEL_H */
+/* caf_data_wheel.h ends here */
@@ -55,6 +55,7 @@
 
 #ifdef LINUX_SYSTEM
 #include <sys/epoll.h>
+#include <caf/caf_data_wheel.h>
 #endif /* !LINUX_SYSTEM */
 
 #define IO_EVENT_DATA_POOL_SELECT_SZ     (sizeof (io_evt_pool_poll_t))
@@ -67,6 +68,7 @@
 #ifdef LINUX_SYSTEM
 #define IO_EVENT_DATA_POOL_EPOLL_SZ      (sizeof (io_evt_pool_epoll_t))
 #define IO_EVENT_DATA_EPOLLS_SZ          (sizeof (struct epoll_event))
+#define IO_EVENT_DATA_EPOLL_SLOTS_SZ     (sizeof (io_evt_pool_epoll_slot_t))
 #endif /* !LINUX_SYSTEM */
 
 #include <caf/caf_evt_nio.h>
@@ -107,14 +109,52 @@ struct io_evt_pool_kevent_s {
 
 
 #ifdef LINUX_SYSTEM
+/**
+ * A registered descriptor. The kernel hands back the slot index in the
+ * event data, so a ready event finds its slot without a search.
+ */
+typedef struct io_evt_pool_epoll_slot_s io_evt_pool_epoll_slot_t;
+struct io_evt_pool_epoll_slot_s {
+	/** Descriptor, -1 when the slot is free */
+	int fd;
+	/** Position in repoll, valid when gen matches the pool */
+	int pos;
+	/** Generation of the last handle reporting the descriptor */
+	unsigned int gen;
+	/** User data */
+	void *data;
+};
+
+
 typedef struct io_evt_pool_epoll_s io_evt_pool_epoll_t;
 struct io_evt_pool_epoll_s {
 	int epoll_count;
 	int efd;
 	size_t epoll_sz;
+	/** Registered events, by slot */
 	struct epoll_event *epoll;
+	/** Ready events of the last handle */
 	struct epoll_event *repoll;
 	struct timespec timeout;
+	/** Slots, by slot index */
+	io_evt_pool_epoll_slot_t *slots;
+	/** Free slot stack */
+	int *free_slots;
+	/** Free slots */
+	int free_count;
+	/** Slot index of each descriptor, -1 when not registered */
+	int *fdmap;
+	/** Descriptors covered by fdmap */
+	int fdmap_sz;
+	/** Ready events of the last handle */
+	int ready;
+	/** Handle generation, zero is never used */
+	unsigned int gen;
+	/**
+	 * Connection and retry timers. io_evt_pool_epoll_handle() waits
+	 * until the next deadline at most, and fires the expired timers.
+	 */
+	caf_wheel_t *wheel;
 };
 #endif /* !LINUX_SYSTEM */
 
@@ -174,6 +214,31 @@ int CALL_EVT_FP(io_evt_pool,handle) (EVT_FP_T *e);
 #define caf_io_evt_pool_etype            CALL_EVT_FP(io_evt_pool,etype)
 #define caf_io_evt_pool_handle           CALL_EVT_FP(io_evt_pool,handle)
 
+#ifdef LINUX_SYSTEM
+/**
+ * Registers a descriptor with user data, returned by
+ * io_evt_pool_epoll_next().
+ */
+int io_evt_pool_epoll_add_data (int fd, io_evt_pool_epoll_t *e, int ef,
+                                void *data);
+/**
+ * Changes the events of a registered descriptor.
+ */
+int io_evt_pool_epoll_modify (int fd, io_evt_pool_epoll_t *e, int ef);
+/**
+ * Unregisters a descriptor, freeing its slot. Its pending ready event,
+ * if any, is skipped by io_evt_pool_epoll_next().
+ */
+int io_evt_pool_epoll_remove (int fd, io_evt_pool_epoll_t *e);
+/**
+ * Iterates the ready events of the last handle call. <b>pos</b> starts
+ * at zero; <b>fd</b>, <b>ev</b> and <b>data</b> may be NULL. Returns
+ * CAF_ERROR once all the events were visited.
+ */
+int io_evt_pool_epoll_next (io_evt_pool_epoll_t *e, int *pos, int *fd,
+                            int *ev, void **data);
+#endif /* !LINUX_SYSTEM */
+
 #ifdef __cplusplus
 CAF_END_C_EXTERNS
 #endif /* !__cplusplus */
@@ -49,6 +49,10 @@ CAF_BEGIN_C_EXTERNS
 #define CAF_HASH_STR_FUNCTION(f)    \
     u_int32_t (*f) (const char *str, const u_int32_t len)
 
+/** Seeded 64 bits string hashing function (interface) define */
+#define CAF_HASH_STR64_FUNCTION(f)  \
+    u_int64_t (*f) (const char *str, const size_t len, const u_int64_t seed)
+
 /**
  * Computes the RS Hash for the given string (str) with
  * the given length (len).
@@ -159,6 +163,104 @@ u_int32_t caf_shash_bp (const char *str, const u_int32_t len);
  */
 u_int32_t caf_shash_fnv (const char *str, const u_int32_t len);
 
+/**
+ * Computes the 64 bits WY Hash, a word at a time hash of the
+ * wyhash family built on 64x64 to 128 bits multiplications, for
+ * the given string (str) with the given length (len) and seed
+ * (seed). Words are read in native byte order, so the values are
+ * only portable across machines of the same endianness.
+ *
+ * @param str			input string
+ * @param len			string length
+ * @param seed			hash seed
+ *
+ * @return Computed hash.
+ */
+u_int64_t caf_shash64_wy (const char *str, const size_t len,
+                          const u_int64_t seed);
+
+/**
+ * Computes the 64 bits XX Hash, the word at a time XXH64 hash
+ * processing 32 bytes stripes in four lanes, for the given string
+ * (str) with the given length (len) and seed (seed). Words are
+ * read in native byte order.
+ *
+ * @param str			input string
+ * @param len			string length
+ * @param seed			hash seed
+ *
+ * @return Computed hash.
+ */
+u_int64_t caf_shash64_xx (const char *str, const size_t len,
+                          const u_int64_t seed);
+
+/**
+ * Computes the WY Hash for the given string (str) with the given
+ * length (len), folded to 32 bits and seeded with the process
+ * seed. Use it with <b>caf_shash_xx</b> as the hash table
+ * callbacks.
+ *
+ * @param str			input string
+ * @param len			string length
+ *
+ * @return Computed hash.
+ *
+ * @see caf_shash_seed_init
+ */
+u_int32_t caf_shash_wy (const char *str, const u_int32_t len);
+
+/**
+ * Computes the XX Hash for the given string (str) with the given
+ * length (len), folded to 32 bits and seeded with the process
+ * seed.
+ *
+ * @param str			input string
+ * @param len			string length
+ *
+ * @return Computed hash.
+ *
+ * @see caf_shash_seed_init
+ */
+u_int32_t caf_shash_xx (const char *str, const u_int32_t len);
+
+/**
+ * Draws a random process seed for <b>caf_shash_wy</b> and
+ * <b>caf_shash_xx</b> from /dev/urandom, falling back to the
+ * time and process id, so hash values can't be predicted from
+ * outside. The seed is zero until this function or
+ * <b>caf_shash_seed_set</b> is called. It must be set before
+ * any table using those callbacks is filled, since changing it
+ * changes every hash value.
+ *
+ * @return u_int64_t	the new process seed.
+ */
+u_int64_t caf_shash_seed_init (void);
+
+/**
+ * Draws a new random seed the same way <b>caf_shash_seed_init</b>
+ * does, without changing the process seed. Used for per table
+ * seeds, see <b>caf_hash_table_new_seeded</b>.
+ *
+ * @return u_int64_t	a non zero random seed.
+ */
+u_int64_t caf_shash_seed_random (void);
+
+/**
+ * Sets the process seed used by <b>caf_shash_wy</b> and
+ * <b>caf_shash_xx</b>, to reproduce hash values between runs.
+ *
+ * @param seed			new process seed
+ */
+void caf_shash_seed_set (const u_int64_t seed);
+
+/**
+ * Obtains the process seed used by <b>caf_shash_wy</b> and
+ * <b>caf_shash_xx</b>.
+ *
+ * @return u_int64_t	the process seed.
+ */
+u_int64_t caf_shash_seed_get (void);
+
 #ifdef __cplusplus
 CAF_END_C_EXTERNS
 #endif /* !__cplusplus */
@@ -39,8 +39,9 @@
  *
  */
 
+#include <stdio.h>
 #include <sys/types.h>
-#include <caf/caf_data_cdeque.h>
+#include <caf/caf_hash_str.h>
 
 #ifdef __cplusplus
 CAF_BEGIN_C_EXTERNS
@@ -50,6 +51,22 @@ CAF_BEGIN_C_EXTERNS
 #define CAF_HASH_SZ                 (sizeof (caf_hash_t))
 /** Hash table structure size @see caf_hash_table_t */
 #define CAF_HASH_TABLE_SZ           (sizeof (caf_hash_table_t))
+/** Initial (and minimum) number of slots in a hash table */
+#define CAF_HASH_TABLE_MINSZ        16
+/** Maximum load factor, in percent, before the slot array grows */
+#define CAF_HASH_TABLE_LOAD_MAX     75
+/** Minimum load factor, in percent, before the slot array shrinks */
+#define CAF_HASH_TABLE_LOAD_MIN     20
+/** Keys hashed and prefetched together by caf_hash_table_get_many */
+#define CAF_HASH_TABLE_BATCH        16
+/** Slots whose fingerprints are probed together */
+#define CAF_HASH_TABLE_GROUP        8
+/** Suggested inline key size @see caf_hash_table_inline */
+#define CAF_HASH_TABLE_INLINE_SZ    24
+/** Maximum inline key size @see caf_hash_table_inline */
+#define CAF_HASH_TABLE_INLINE_MAX   64
+/** Default probed groups that trigger a reseed of a seeded table */
+#define CAF_HASH_TABLE_PROBE_MAX    8
 
 /**
  * @brief		Double Hash Structure Type.
@@ -103,8 +120,46 @@ struct caf_hash_table_s {
 	CAF_HASH_STR_FUNCTION(f1);
 	/** Second Hash Callback Function */
 	CAF_HASH_STR_FUNCTION(f2);
-	/** Hash List */
-	cdeque_t *hashes;
+	/** Slot Array, power of two sized */
+	caf_hash_t *slots;
+	/** Slot Fingerprints, stored after the slot entries */
+	u_int8_t *fps;
+	/** Number of Slots */
+	size_t size;
+	/** Number of Live Entries */
+	size_t count;
+	/** Number of Live and Deleted Entries */
+	size_t used;
+	/** Largest Key Size copied into the slots, zero copies none */
+	size_t key_inline;
+	/** Slot Entry Size, including the inline key storage */
+	size_t stride;
+	/** Previous Slot Array, while an incremental rehash is running */
+	caf_hash_t *old_slots;
+	/** Previous Slot Fingerprints */
+	u_int8_t *old_fps;
+	/** Number of Slots in the Previous Slot Array */
+	size_t old_size;
+	/** Next Slot to Migrate from the Previous Slot Array */
+	size_t old_pos;
+	/** Live Entries left in the Previous Slot Array */
+	size_t old_count;
+	/** Slots Migrated per Operation, zero rehashes at once */
+	size_t rehash_steps;
+	/** Entries Migrated by Incremental Rehashing */
+	unsigned long rehash_count;
+	/** Table Hash Seed, zero uses the f1 and f2 callbacks */
+	u_int64_t seed;
+	/** Probed Groups that trigger a Reseed, zero never reseeds */
+	size_t probe_max;
+	/** Longest Insertion Probe Sequence seen, in groups */
+	size_t probe_peak;
+	/** Entries Added since the last Reseed */
+	size_t reseed_adds;
+	/** Number of Reseeds */
+	unsigned long reseed_count;
+	/** Reseeds that could not allocate their Slot Array */
+	unsigned long reseed_fails;
 };
 
 /**
@@ -163,11 +218,15 @@ int caf_hash_delete (caf_hash_t *hash);
 /**
  * @brief Creates a new empty hash table.
  *
- * Creates a new empty hash table. The hash table implementation
- * it's <b>caf_cdeque_t</b> based. This means that search algorithms
- * are linear, and using the <b>Circular Linked List</b> sequence.
- * Future implementations will include fater search methods and
- * faster data type structures.
+ * Creates a new empty hash table. The hash table uses open
+ * addressing over a power of two sized slot array, where <b>f1</b>
+ * gives the initial slot and <b>f2</b> gives the probe step
+ * (double hashing). Every slot has a fingerprint byte taken from
+ * <b>f1</b>, and the fingerprints of CAF_HASH_TABLE_GROUP slots
+ * are tested at once, so only slots with a matching fingerprint
+ * are read. The slot array grows when the load factor reaches
+ * CAF_HASH_TABLE_LOAD_MAX and shrinks when it falls under
+ * CAF_HASH_TABLE_LOAD_MIN.
  *
  * @param id[in]						Hash Table Identifier
  * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 1
@@ -175,7 +234,6 @@ int caf_hash_delete (caf_hash_t *hash);
  *
  * @return caf_hash_table_t				a new allocated table
  *
- * @see cdeque_t
  * @see caf_hash_table_t
  * @see caf_hash_t
  */
@@ -195,6 +253,113 @@ caf_hash_table_t *caf_hash_table_new (const int id,
  */
 int caf_hash_table_delete (caf_hash_table_t *table);
 
+/**
+ * @brief Creates a new empty seeded hash table.
+ *
+ * Creates a new empty hash table like <b>caf_hash_table_new</b>,
+ * but with a random seed drawn by <b>caf_shash_seed_random</b>.
+ * Both hashes of a seeded table are the halves of the keyed
+ * <b>caf_shash64_wy</b> hash of the key, so colliding keys can't be
+ * crafted without knowing the seed; <b>f1</b> and <b>f2</b> are
+ * kept but not used. When an insertion probes more than
+ * <b>probe_max</b> slot groups, the table draws a new seed and
+ * rehashes every entry, at most once per quarter of the entries
+ * added since the previous reseed. Only <b>caf_hash_table_add</b>
+ * reseeds; a reseed that can not allocate is counted in
+ * <b>reseed_fails</b> and tried again on the next long probe.
+ *
+ * @param id[in]						Hash Table Identifier
+ * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 1
+ * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 2
+ * @param probe_max[in]					probed groups that trigger a
+ *										reseed, zero never reseeds,
+ *										CAF_HASH_TABLE_PROBE_MAX is a
+ *										sane default
+ *
+ * @return caf_hash_table_t				a new allocated table
+ *
+ * @see caf_hash_table_hash
+ */
+caf_hash_table_t *caf_hash_table_new_seeded (const int id,
+                                             CAF_HASH_STR_FUNCTION(f1),
+                                             CAF_HASH_STR_FUNCTION(f2),
+                                             const size_t probe_max);
+
+/**
+ * @brief Computes the hashes of a key as the table does
+ *
+ * Computes the hashes that the table <b>table</b> uses for the key
+ * <b>key</b> of <b>ksz</b> bytes, through its callbacks or its seed.
+ * Callers of the <b>_hashed</b> functions on a seeded table must
+ * obtain the hashes here, and compute them again after any
+ * <b>caf_hash_table_add</b>, which may reseed the table. The
+ * <b>_hashed</b> functions never reseed.
+ *
+ * @param table[in]		hash table
+ * @param key[in]		key pointer
+ * @param ksz[in]		key size
+ * @param h1[out]		first hash
+ * @param h2[out]		second hash
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_hash_table_hash (caf_hash_table_t *table, const void *key,
+                         const size_t ksz, u_int32_t *h1, u_int32_t *h2);
+
+/**
+ * @brief Stores small keys inside the table slots
+ *
+ * Makes the empty table <b>table</b> copy every key of up to
+ * <b>ksz</b> bytes into its slot, right after the <b>caf_hash_t</b>
+ * entry, so comparing those keys does not touch the caller memory
+ * and the caller does not need to keep them alive. Longer keys are
+ * still referenced by pointer. A <b>ksz</b> of zero turns the mode
+ * off. CAF_HASH_TABLE_INLINE_SZ covers most short string keys.
+ *
+ * @param table[in]		empty hash table
+ * @param ksz[in]		largest key size to copy, up to
+ *						CAF_HASH_TABLE_INLINE_MAX
+ *
+ * @return int			CAF_OK on success, CAF_ERROR if the table is
+ *						not empty or <b>ksz</b> is too large
+ */
+int caf_hash_table_inline (caf_hash_table_t *table, const size_t ksz);
+
+/**
+ * @brief Sets the incremental rehashing budget
+ *
+ * Sets the number of slots that every add, get, set and remove
+ * operation migrates from the previous slot array while the table
+ * <b>table</b> is being resized. With a <b>steps</b> budget of zero
+ * (the default) the table is rehashed at once inside the operation
+ * that triggers the resize, and any pending migration is finished.
+ * Otherwise the old and new slot arrays coexist until every entry
+ * was moved, and the <b>rehash_count</b> member counts the moved
+ * entries.
+ *
+ * @param table[in]		hash table
+ * @param steps[in]		slots migrated per operation
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_hash_table_incremental (caf_hash_table_t *table, const size_t steps);
+
+/**
+ * @brief Runs a pending incremental rehash
+ *
+ * Migrates up to <b>steps</b> slots from the previous slot array of
+ * the given table <b>table</b>, or all the remaining slots if
+ * <b>steps</b> is zero. Useful to drive the migration from idle
+ * periods of an event loop.
+ *
+ * @param table[in]		hash table
+ * @param steps[in]		slots to migrate, zero for all
+ *
+ * @return int			CAF_OK if no migration is pending, CAF_ERROR
+ *						otherwise
+ */
+int caf_hash_table_migrate (caf_hash_table_t *table, const size_t steps);
+
 /**
  * @brief Adds a hash to the given table
  *
@@ -214,13 +379,34 @@ int caf_hash_table_delete (caf_hash_table_t *table);
 int caf_hash_table_add (caf_hash_table_t *table, const void *key,
                         const size_t ksz, const void *data);
 
+/**
+ * @brief Adds an already hashed key to the given table
+ *
+ * Works as <b>caf_hash_table_add</b>, but takes the double hash
+ * values <b>h1</b> and <b>h2</b> computed with the table callbacks
+ * instead of computing them. It never reseeds a seeded table, so the
+ * hashes the caller computed for other keys stay valid.
+ *
+ * @param table[in]		table to add the hash
+ * @param key[in]		key pointer
+ * @param ksz[in]		key size pointer
+ * @param data[in]		data pointer
+ * @param h1[in]		key hash computed by the table f1 callback
+ * @param h2[in]		key hash computed by the table f2 callback
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_hash_table_add_hashed (caf_hash_table_t *table, const void *key,
+                               const size_t ksz, const void *data,
+                               const u_int32_t h1, const u_int32_t h2);
+
 /**
  * @brief Removes an element from the given Hash Table
  *
  * Removes the element identified by the hash key <b>key</b> of size
- * <b>ksz</b> from the given hash table <b>table</b>. This deallocates
- * the <b>caf_hash_t</b> pointer and removes the list node, but does
- * not deallocates the data and key pointers.
+ * <b>ksz</b> from the given hash table <b>table</b>. This releases
+ * the table slot, but does not deallocates the data and key
+ * pointers.
  *
  * @param table[in]		table from where to remove the item
  * @param key[in]		item key <b>data</b> string
@@ -231,6 +417,25 @@ int caf_hash_table_add (caf_hash_table_t *table, const void *key,
 int caf_hash_table_remove (caf_hash_table_t *table, const void *key,
                            const size_t ksz);
 
+/**
+ * @brief Removes an already hashed key from the given Hash Table
+ *
+ * Works as <b>caf_hash_table_remove</b>, but takes the double hash
+ * values <b>h1</b> and <b>h2</b> computed with the table callbacks
+ * instead of computing them.
+ *
+ * @param table[in]		table from where to remove the item
+ * @param key[in]		item key <b>data</b> string
+ * @param ksz[in]		key size
+ * @param h1[in]		key hash computed by the table f1 callback
+ * @param h2[in]		key hash computed by the table f2 callback
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_hash_table_remove_hashed (caf_hash_table_t *table, const void *key,
+                                  const size_t ksz, const u_int32_t h1,
+                                  const u_int32_t h2);
+
 /**
  * @brief Obtains a the data from the given hash table
  *
@@ -239,6 +444,8 @@ int caf_hash_table_remove (caf_hash_table_t *table, const void *key,
  * to locate the the key in the given hash table <b>table</b>
  * using the hash table callback to calculate the hash
  * values of the double hashing <b>caf_hash_t</b> member.
+ * Both hashes and the key size are compared before the key
+ * contents, and the lookup does not allocate memory.
  *
  * @param table[in]		hash table where to search the node
  * @param key[in]		key to search
@@ -249,6 +456,49 @@ int caf_hash_table_remove (caf_hash_table_t *table, const void *key,
 void *caf_hash_table_get (caf_hash_table_t *table, const void *key,
                           const size_t ksz);
 
+/**
+ * @brief Obtains the data for an already hashed key
+ *
+ * Works as <b>caf_hash_table_get</b>, but takes the double hash
+ * values <b>h1</b> and <b>h2</b> of the key <b>key</b> instead of
+ * computing them, so callers that already hashed the key using the
+ * table callbacks <b>f1</b> and <b>f2</b> skip the rehashing. The
+ * key is still compared to confirm the match.
+ *
+ * @param table[in]		hash table where to search the node
+ * @param key[in]		key to search
+ * @param ksz[in]		key size of the given key
+ * @param h1[in]		key hash computed by the table f1 callback
+ * @param h2[in]		key hash computed by the table f2 callback
+ *
+ * @return void *		data pointer on success, NULL on failure
+ */
+void *caf_hash_table_get_hashed (caf_hash_table_t *table, const void *key,
+                                 const size_t ksz, const u_int32_t h1,
+                                 const u_int32_t h2);
+
+/**
+ * @brief Obtains the data for several keys at once
+ *
+ * Looks up the <b>n</b> keys <b>keys</b>, of sizes <b>sizes</b>,
+ * storing each data pointer, or NULL when the key is missing, in
+ * <b>out</b>. Keys are processed in batches of CAF_HASH_TABLE_BATCH:
+ * the whole batch is hashed and its slots are prefetched before
+ * probing, so the cache misses of a batch overlap instead of being
+ * paid one after the other as in a <b>caf_hash_table_get</b> loop.
+ *
+ * @param table[in]		hash table where to search the nodes
+ * @param keys[in]		keys to search
+ * @param sizes[in]		key sizes of the given keys
+ * @param n[in]			number of keys
+ * @param out[out]		data pointers found, NULL for missing keys
+ *
+ * @return size_t		number of keys found
+ */
+size_t caf_hash_table_get_many (caf_hash_table_t *table, const void **keys,
+                                const size_t *sizes, const size_t n,
+                                void **out);
+
 /**
  * @brief Replaces the data pointer for the given key
  *
@@ -266,6 +516,26 @@ void *caf_hash_table_get (caf_hash_table_t *table, const void *key,
 int caf_hash_table_set (caf_hash_table_t *table, const void *key,
                         const size_t ksz, void *data);
 
+/**
+ * @brief Replaces the data pointer for an already hashed key
+ *
+ * Works as <b>caf_hash_table_set</b>, but takes the double hash
+ * values <b>h1</b> and <b>h2</b> computed with the table callbacks
+ * instead of computing them.
+ *
+ * @param table[in]		hash table
+ * @param key[in]		key to search
+ * @param ksz[in]		key size
+ * @param data[in]		data to replace for
+ * @param h1[in]		key hash computed by the table f1 callback
+ * @param h2[in]		key hash computed by the table f2 callback
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_hash_table_set_hashed (caf_hash_table_t *table, const void *key,
+                               const size_t ksz, void *data,
+                               const u_int32_t h1, const u_int32_t h2);
+
 /**
  * @brief Dumps the hash table contents to the given output
  *
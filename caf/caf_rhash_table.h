@@ -0,0 +1,431 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_RHASH_TABLE_H
+#define CAF_RHASH_TABLE_H 1
+/**
+ * @defgroup      caf_rhash_table    Read-Mostly Hash Table Functions
+ * @ingroup       caf_data_struct
+ * @addtogroup    caf_rhash_table
+ * @{
+ *
+ * @brief     Read-Mostly Hash Table Functions.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Read-Mostly Hash Table Functions. Lookups take no locks and do
+ * no atomic read-modify-write operations, they only load the
+ * bucket array and the node chains with acquire semantics. Writers
+ * are serialized by a mutex, publish new nodes and bucket arrays
+ * with release stores and never modify a published node in place,
+ * instead they retire it. Retired memory is released through
+ * quiescent state based reclamation: every reader thread registers
+ * a <b>caf_rhash_reader_t</b> and calls
+ * <b>caf_rhash_reader_quiescent</b> when it holds no pointer
+ * obtained from the table, and retired memory is freed once every
+ * online reader went through a quiescent state.
+ *
+ */
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <caf/caf_hash_str.h>
+#include <caf/caf_thread_mutex.h>
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Read-mostly hash table structure size @see caf_rhash_table_t */
+#define CAF_RHASH_TABLE_SZ          (sizeof (caf_rhash_table_t))
+/** Read-mostly hash node structure size @see caf_rhash_node_t */
+#define CAF_RHASH_NODE_SZ           (sizeof (caf_rhash_node_t))
+/** Reader structure size @see caf_rhash_reader_t */
+#define CAF_RHASH_READER_SZ         (sizeof (caf_rhash_reader_t))
+/** Initial number of buckets */
+#define CAF_RHASH_TABLE_MINSZ       16
+/** Cache line size used to pad reader states */
+#define CAF_RHASH_CACHE_LINE        64
+/** Reader epoch of an offline reader */
+#define CAF_RHASH_OFFLINE           0UL
+
+/**
+ * @brief Read-Mostly Hash Node Type.
+ *
+ * Read-Mostly Hash node type.
+ *
+ * @see caf_rhash_node_s
+ */
+typedef struct caf_rhash_node_s caf_rhash_node_t;
+
+/**
+ * @brief Read-Mostly Hash Node Structure
+ *
+ * Chained hash node. Only the <b>next</b> member changes once the
+ * node was published.
+ *
+ * @see caf_rhash_node_t
+ */
+struct caf_rhash_node_s {
+	/** First Hash of the Double Hash Structure */
+	u_int32_t hash1;
+	/** Second Hash of the Double Hash Structure */
+	u_int32_t hash2;
+	/** Key Size */
+	size_t key_sz;
+	/** Key Pointer */
+	void *key;
+	/** Data Pointer */
+	void *data;
+	/** Next Node in the Bucket */
+	caf_rhash_node_t *next;
+};
+
+/**
+ * @brief Read-Mostly Hash Bucket Array Type.
+ *
+ * Read-Mostly Hash bucket array type.
+ *
+ * @see caf_rhash_buckets_s
+ */
+typedef struct caf_rhash_buckets_s caf_rhash_buckets_t;
+
+/**
+ * @brief Read-Mostly Hash Bucket Array Structure
+ *
+ * Power of two sized bucket array, replaced as a whole when the
+ * table grows.
+ *
+ * @see caf_rhash_buckets_t
+ */
+struct caf_rhash_buckets_s {
+	/** Number of Buckets */
+	size_t size;
+	/** Bucket Heads */
+	caf_rhash_node_t *heads[];
+};
+
+/**
+ * @brief Read-Mostly Hash Retired Memory Type.
+ *
+ * Read-Mostly Hash retired memory type.
+ *
+ * @see caf_rhash_retired_s
+ */
+typedef struct caf_rhash_retired_s caf_rhash_retired_t;
+
+/**
+ * @brief Read-Mostly Hash Retired Memory Structure
+ *
+ * Memory unlinked from the table that readers may still access.
+ *
+ * @see caf_rhash_retired_t
+ */
+struct caf_rhash_retired_s {
+	/** Retired Pointer */
+	void *ptr;
+	/** Non zero for a bucket array, whose chains are released too */
+	int array;
+	/** Epoch in which the Pointer was unlinked */
+	unsigned long epoch;
+	/** Next Retired Pointer */
+	caf_rhash_retired_t *next;
+};
+
+/**
+ * @brief Read-Mostly Hash Table Structure Type.
+ *
+ * Read-Mostly Hash Table structure type.
+ *
+ * @see caf_rhash_table_s
+ */
+typedef struct caf_rhash_table_s caf_rhash_table_t;
+
+/**
+ * @brief Read-Mostly Hash Reader Type.
+ *
+ * Read-Mostly Hash reader type.
+ *
+ * @see caf_rhash_reader_s
+ */
+typedef struct caf_rhash_reader_s caf_rhash_reader_t;
+
+/**
+ * @brief Read-Mostly Hash Reader Structure
+ *
+ * Reader thread state. It is padded to its own cache line, since
+ * each reader writes its epoch while the writers only read it.
+ *
+ * @see caf_rhash_reader_t
+ */
+struct caf_rhash_reader_s {
+	/** Last Epoch observed in a Quiescent State */
+	unsigned long epoch;
+	/** Table of the Reader */
+	caf_rhash_table_t *table;
+	/** Next Registered Reader */
+	caf_rhash_reader_t *next;
+	/** Padding up to the cache line size */
+	char pad[CAF_RHASH_CACHE_LINE - sizeof (unsigned long) -
+	         2 * sizeof (void *)];
+};
+
+/**
+ * @brief Read-Mostly Hash Table Structure
+ *
+ * Read-Mostly Hash Table Structure.
+ *
+ * @see caf_rhash_table_t
+ */
+struct caf_rhash_table_s {
+	/** Hash Table Identifier */
+	int id;
+	/** First Hash Callback Function */
+	CAF_HASH_STR_FUNCTION(f1);
+	/** Second Hash Callback Function */
+	CAF_HASH_STR_FUNCTION(f2);
+	/** Current Bucket Array */
+	caf_rhash_buckets_t *buckets;
+	/** Number of Entries */
+	size_t count;
+	/** Global Epoch */
+	unsigned long epoch;
+	/** Writers Mutex */
+	pth_mutex_t *lock;
+	/** Registered Readers */
+	caf_rhash_reader_t *readers;
+	/** Retired Memory, newest first */
+	caf_rhash_retired_t *retired;
+	/** Number of Retired Pointers not yet released */
+	size_t retired_count;
+	/** Bucket Array grows that could not allocate */
+	unsigned long grow_fails;
+	/** Retired Pointers leaked because they could not be queued */
+	unsigned long retire_fails;
+};
+
+/**
+ * @brief Creates a new empty read-mostly hash table.
+ *
+ * Creates a new empty read-mostly hash table using the callbacks
+ * <b>f1</b> to select the bucket and <b>f2</b> to filter the key
+ * comparisons; <b>f2</b> may be NULL.
+ *
+ * @param id[in]						Hash Table Identifier
+ * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 1
+ * @param CAF_HASH_STR_FUNCTION[in]		Hash Callback 2
+ *
+ * @return caf_rhash_table_t			a new allocated table
+ */
+caf_rhash_table_t *caf_rhash_table_new (const int id,
+                                        CAF_HASH_STR_FUNCTION(f1),
+                                        CAF_HASH_STR_FUNCTION(f2));
+
+/**
+ * @brief Deallocates a Read-Mostly Hash Table
+ *
+ * Deallocates the table <b>table</b>, its nodes, the retired memory
+ * and the registered readers. No other thread may use the table
+ * anymore. Keys and data are not deallocated.
+ *
+ * @param table[in]		table to deallocate
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_rhash_table_delete (caf_rhash_table_t *table);
+
+/**
+ * @brief Registers a reader thread
+ *
+ * Registers the calling thread as a reader of <b>table</b>. The
+ * reader starts online. Every thread calling
+ * <b>caf_rhash_table_get</b> must own a reader.
+ *
+ * @param table[in]				hash table
+ *
+ * @return caf_rhash_reader_t	the reader state, NULL on failure
+ */
+caf_rhash_reader_t *caf_rhash_reader_new (caf_rhash_table_t *table);
+
+/**
+ * @brief Unregisters a reader thread
+ *
+ * Unregisters and deallocates the reader <b>reader</b>. The thread
+ * must not hold pointers obtained from the table anymore.
+ *
+ * @param reader[in]	reader state
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_rhash_reader_delete (caf_rhash_reader_t *reader);
+
+/**
+ * @brief Announces a quiescent state
+ *
+ * Tells the writers that the thread owning <b>reader</b> holds no
+ * pointer obtained from the table, typically once per event loop
+ * iteration or processed request. It costs one load and one store.
+ *
+ * @param reader[in]	reader state
+ */
+void caf_rhash_reader_quiescent (caf_rhash_reader_t *reader);
+
+/**
+ * @brief Marks a reader offline
+ *
+ * Marks the reader <b>reader</b> as not reading the table, so
+ * writers do not wait for it while its thread blocks or sleeps.
+ *
+ * @param reader[in]	reader state
+ */
+void caf_rhash_reader_offline (caf_rhash_reader_t *reader);
+
+/**
+ * @brief Marks a reader online
+ *
+ * Marks the reader <b>reader</b> as reading the table again, after
+ * <b>caf_rhash_reader_offline</b>.
+ *
+ * @param reader[in]	reader state
+ */
+void caf_rhash_reader_online (caf_rhash_reader_t *reader);
+
+/**
+ * @brief Adds a hash to the given table
+ *
+ * Adds the <b>key</b> and <b>data</b> pair to the table
+ * <b>table</b>, replacing the data of an existing key. The bucket
+ * array doubles when the table holds more entries than buckets.
+ * Once the entry is published the interface succeeds: a grow that
+ * can not allocate is counted in <b>grow_fails</b> and retried by
+ * the next addition, and a replaced node that can not be retired
+ * is leaked and counted in <b>retire_fails</b>.
+ *
+ * @param table[in]		table to add the hash
+ * @param key[in]		key pointer
+ * @param ksz[in]		key size
+ * @param data[in]		data pointer
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_rhash_table_add (caf_rhash_table_t *table, const void *key,
+                         const size_t ksz, const void *data);
+
+/**
+ * @brief Removes an element from the given table
+ *
+ * Unlinks the element identified by <b>key</b> of size <b>ksz</b>
+ * and retires its node. Keys and data are not deallocated, and
+ * readers may still hold the data pointer until their next
+ * quiescent state.
+ *
+ * @param table[in]		table from where to remove the item
+ * @param key[in]		item key
+ * @param ksz[in]		key size
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_rhash_table_remove (caf_rhash_table_t *table, const void *key,
+                            const size_t ksz);
+
+/**
+ * @brief Replaces the data pointer for the given key
+ *
+ * Replaces the data for the existing key <b>key</b> of size
+ * <b>ksz</b> by publishing a new node. If the key isn't found, the
+ * interface fails.
+ *
+ * @param table[in]		hash table
+ * @param key[in]		key to search
+ * @param ksz[in]		key size
+ * @param data[in]		data to replace for
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_rhash_table_set (caf_rhash_table_t *table, const void *key,
+                         const size_t ksz, void *data);
+
+/**
+ * @brief Obtains the data from the given table
+ *
+ * Obtains the data pointer for the key <b>key</b> of size
+ * <b>ksz</b> without taking locks. The calling thread must own an
+ * online reader of <b>table</b>.
+ *
+ * @param table[in]		hash table where to search the node
+ * @param key[in]		key to search
+ * @param ksz[in]		key size of the given key
+ *
+ * @return void *		data pointer on success, NULL on failure
+ */
+void *caf_rhash_table_get (caf_rhash_table_t *table, const void *key,
+                           const size_t ksz);
+
+/**
+ * @brief Releases retired memory
+ *
+ * Frees the retired memory that every online reader can no longer
+ * reach. Writers call it after each modification, so it is only
+ * needed to release memory when writes stop.
+ *
+ * @param table[in]		hash table
+ *
+ * @return int			CAF_OK if nothing remains retired, CAF_ERROR
+ *						otherwise
+ */
+int caf_rhash_table_reclaim (caf_rhash_table_t *table);
+
+/**
+ * @brief Waits until all the retired memory is released
+ *
+ * Waits until every online reader went through a quiescent state
+ * and releases the retired memory. Must not be called from a
+ * thread owning an online reader of <b>table</b>.
+ *
+ * @param table[in]		hash table
+ *
+ * @return int			CAF_OK on success, CAF_ERROR on failure
+ */
+int caf_rhash_table_synchronize (caf_rhash_table_t *table);
+
+/**
+ * @brief Dumps the table contents to the given output
+ *
+ * Dumps the given hash table <b>table</b> contents to the given
+ * FILE output. Takes the writers mutex.
+ *
+ * @param out[in]		file to write
+ * @param table[in]		table to dump
+ */
+void caf_rhash_table_dump (FILE *out, caf_rhash_table_t *table);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_RHASH_TABLE_H */
+/* caf_rhash_table.h ends here */
+
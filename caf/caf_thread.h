@@ -35,6 +35,9 @@
 #include <caf/caf_thread_cond.h>
 #include <caf/caf_thread_once.h>
 #include <caf/caf_thread_pool.h>
+#include <caf/caf_thread_queue.h>
+#include <caf/caf_thread_map.h>
+#include <caf/caf_thread_future.h>
 #include <caf/caf_thread_rwlock.h>
 
 #endif /* !CAF_THREAD_H */
@@ -44,6 +44,11 @@
  * diferences between implementations, this module should work for the
  * Caffeine Threads Layer.
  *
+ * On Linux the attributes also place threads on CPUs: a fixed CPU set,
+ * the CPUs of a NUMA node read from /sys, and a one thread per core
+ * round robin over those CPUs. Threads placed on one node allocate
+ * their memory there too, under the default first touch policy.
+ *
  */
 
 #ifdef __cplusplus
@@ -76,7 +81,13 @@ typedef enum {
 	/** pthread_attr_(set|get)schedpolicy */
 	PTH_ATTR_SCHEDPOLICY = 0000100,
 	/** pthread_attr_(set|get)scope */
-	PTH_ATTR_SCOPE = 0000200
+	PTH_ATTR_SCOPE = 0000200,
+	/** pthread_attr_(set|get)affinity_np, a cpu_set_t */
+	PTH_ATTR_CPUSET = 0000400,
+	/** the CPUs of a NUMA node, an int node number */
+	PTH_ATTR_NUMANODE = 0001000,
+	/** one thread per core, placed by pth_attri_place() */
+	PTH_ATTR_PERCORE = 0002000
 } pth_attr_types_t;
 
 /**
@@ -98,6 +109,14 @@ struct pth_attri_s {
 	int at;
 	/** Thread Attributes */
 	pthread_attr_t attr;
+	/** Placement CPUs, one CPU per core first */
+	int *cpus;
+	/** Placement CPU Count */
+	int ncpu;
+	/** Next Placement, round robin */
+	int next;
+	/** NUMA Node, -1 if not set */
+	int node;
 };
 
 /**
@@ -222,6 +241,39 @@ int pth_attri_set (pth_attri_t *attri, pth_attr_types_t t, void *data);
  */
 int pth_attri_get (pth_attri_t *attri, pth_attr_types_t t, void *data);
 
+/**
+ *
+ * @brief    Prepares the attributes of the next thread.
+ *
+ * Initializes <b>attr</b> with the settings of <b>attri</b>, for one
+ * pthread_create() call. With PTH_ATTR_PERCORE set, the copy is
+ * restricted to the next placement CPU, so the thread starts there and
+ * threads created in a row land on different cores before they share
+ * one. The caller destroys <b>attr</b> with pthread_attr_destroy()
+ * once the thread is created.
+ *
+ * @param[in]    attri           pth_attri_t pointer.
+ * @param[out]   attr            the attributes to create the thread.
+ * @return       int             zero on success, an error number
+ *                               otherwise, with attr left destroyed.
+ *
+ * @see      pth_attri_set
+ */
+int pth_attri_place (pth_attri_t *attri, pthread_attr_t *attr);
+
+/**
+ *
+ * @brief    Counts the NUMA nodes.
+ *
+ * Reads the online nodes from /sys.
+ *
+ * @return       int             the number of nodes, one if the system
+ *                               does not report them.
+ *
+ * @see      pth_attri_set
+ */
+int pth_attri_nodes (void);
+
 #ifdef __cplusplus
 CAF_END_C_EXTERNS
 #endif /* !__cplusplus */
@@ -0,0 +1,286 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_THREAD_FUTURE_H
+#define CAF_THREAD_FUTURE_H 1
+
+#include <time.h>
+#include <pthread.h>
+#include <caf/caf_thread_attr.h>
+#include <caf/caf_thread_pool.h>
+
+/**
+ * @defgroup      caf_thread_future    Futures
+ * @ingroup       caf_thread
+ * @addtogroup    caf_thread_future
+ * @{
+ *
+ * @brief     Futures and Continuations.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * A future holds a value that will be ready later. The producer side
+ * resolves or fails it once, and the consumer side waits for it, with
+ * or without a timeout, or chains a continuation that runs when it
+ * settles. Continuations run on the thread that settles the future,
+ * or as tasks of an executor pool, so a pipeline of stages does not
+ * keep a thread blocked per pending operation. Futures are reference
+ * counted, every function returning a future gives a reference to
+ * the caller.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Defines the pth_future_t size */
+#define PTH_FUTURE_SZ              sizeof(pth_future_t)
+/** Defines the continuation prototype */
+#define PTH_FUTURE_THEN(rtn)       void *(*rtn)(void *value, void *arg)
+
+/** The future has no value yet */
+#define PTH_FUTURE_PENDING         0
+/** The future holds a value */
+#define PTH_FUTURE_READY           1
+/** The future holds an error */
+#define PTH_FUTURE_FAILED          2
+
+/**
+ *
+ * @brief    Caffeine Future Listener Type.
+ * @see      pth_future_cb_s
+ */
+typedef struct pth_future_cb_s pth_future_cb_t;
+
+/**
+ *
+ * @brief    Caffeine Future Type.
+ * @see      pth_future_s
+ */
+typedef struct pth_future_s pth_future_t;
+
+/**
+ *
+ * @brief    Caffeine Future Listener Structure.
+ * A routine to run when the future settles.
+ */
+struct pth_future_cb_s {
+	/** Next Listener */
+	pth_future_cb_t *next;
+	/** Listener Routine */
+	void (*rtn)(pth_future_t *f, void *arg);
+	/** Listener Routine Argument */
+	void *arg;
+};
+
+/**
+ *
+ * @brief    Caffeine Future Structure.
+ * The state is a futex word, waiters sleep on it. The lock orders
+ * the settlement against the listeners being added.
+ */
+struct pth_future_s {
+	/** Guards the state and the listener list */
+	pthread_mutex_t lock;
+	/** Future State, a futex word */
+	int state;
+	/** Future Value */
+	void *value;
+	/** Future Error */
+	int error;
+	/** Listeners, newest first */
+	pth_future_cb_t *cbs;
+	/** Threads waiting for the future */
+	int waiters;
+	/** References to the future */
+	int refs;
+};
+
+
+/**
+ *
+ * @brief    Creates a new pending Future.
+ *
+ * @return       pth_future_t *  the new future, NULL on failure.
+ *
+ * @see      pth_future_resolve
+ * @see      pth_future_fail
+ */
+pth_future_t *pth_future_new (void);
+
+/**
+ *
+ * @brief    Takes a reference to a Future.
+ *
+ * @param[in]    f               the future.
+ * @return       pth_future_t *  the same future.
+ *
+ * @see      pth_future_release
+ */
+pth_future_t *pth_future_retain (pth_future_t *f);
+
+/**
+ *
+ * @brief    Releases a reference to a Future.
+ *
+ * The future is deleted with its last reference.
+ *
+ * @param[in]    f               the future.
+ *
+ * @see      pth_future_retain
+ */
+void pth_future_release (pth_future_t *f);
+
+/**
+ *
+ * @brief    Resolves a Future with a value.
+ *
+ * Wakes the waiters and runs the listeners.
+ *
+ * @param[in]    f               the future.
+ * @param[in]    value           the value.
+ * @return       int             CAF_OK on success, CAF_ERROR if the
+ *                               future was already settled.
+ */
+int pth_future_resolve (pth_future_t *f, void *value);
+
+/**
+ *
+ * @brief    Fails a Future with an error.
+ *
+ * Wakes the waiters and runs the listeners.
+ *
+ * @param[in]    f               the future.
+ * @param[in]    error           the error, such as an errno value.
+ * @return       int             CAF_OK on success, CAF_ERROR if the
+ *                               future was already settled.
+ */
+int pth_future_fail (pth_future_t *f, int error);
+
+/**
+ *
+ * @brief    Polls a Future.
+ *
+ * @param[in]    f               the future.
+ * @return       int             PTH_FUTURE_PENDING, PTH_FUTURE_READY or
+ *                               PTH_FUTURE_FAILED.
+ */
+int pth_future_state (pth_future_t *f);
+
+/**
+ *
+ * @brief    Gets the error of a failed Future.
+ *
+ * @param[in]    f               the future.
+ * @return       int             the error, zero if it did not fail.
+ */
+int pth_future_error (pth_future_t *f);
+
+/**
+ *
+ * @brief    Waits for a Future to settle.
+ *
+ * @param[in]    f               the future.
+ * @param[in]    tm              relative timeout, NULL to wait forever.
+ * @param[out]   value           the value, or NULL.
+ * @return       int             CAF_OK if resolved, CAF_ERROR if failed,
+ *                               CAF_ERROR_SUB if the timeout expired.
+ */
+int pth_future_wait (pth_future_t *f, const struct timespec *tm,
+                     void **value);
+
+/**
+ *
+ * @brief    Chains a continuation to a Future.
+ *
+ * The continuation gets the value once the future resolves, and the
+ * returned future resolves with the continuation result. A failure
+ * skips the continuation and fails the returned future with the same
+ * error.
+ *
+ * @param[in]    f               the future.
+ * @param[in]    pool            executor pool to run the continuation
+ *                               on, NULL runs it on the thread that
+ *                               resolves the future.
+ * @param[in]    rtn             continuation routine.
+ * @param[in]    arg             continuation routine argument.
+ * @return       pth_future_t *  the continuation future, NULL on
+ *                               failure.
+ */
+pth_future_t *pth_future_then (pth_future_t *f, pth_pool_t *pool,
+                               PTH_FUTURE_THEN(rtn), void *arg);
+
+/**
+ *
+ * @brief    Combines Futures into one that settles when all do.
+ *
+ * The combined future resolves with a NULL value once every future
+ * resolved, or fails with the error of the first future that failed.
+ *
+ * @param[in]    fs              the futures.
+ * @param[in]    cnt             number of futures.
+ * @return       pth_future_t *  the combined future, NULL on failure.
+ */
+pth_future_t *pth_future_when_all (pth_future_t **fs, int cnt);
+
+/**
+ *
+ * @brief    Combines Futures into one that settles when any does.
+ *
+ * The combined future resolves with the first future that settled,
+ * resolved or failed, as its value. The caller keeps references to
+ * the futures it reads the winner from.
+ *
+ * @param[in]    fs              the futures.
+ * @param[in]    cnt             number of futures.
+ * @return       pth_future_t *  the combined future, NULL on failure.
+ */
+pth_future_t *pth_future_when_any (pth_future_t **fs, int cnt);
+
+/**
+ *
+ * @brief    Runs a routine on an Executor Pool.
+ *
+ * The returned future resolves with the routine result. A task that
+ * a shutdown without drain cancels never runs, and its future stays
+ * pending, so drain the pool before dropping such futures.
+ *
+ * @param[in]    pool            Caffeine Executor Pool.
+ * @param[in]    rtn             routine.
+ * @param[in]    arg             routine argument.
+ * @return       pth_future_t *  the future, NULL if the pool does not
+ *                               accept tasks.
+ */
+pth_future_t *pth_future_async (pth_pool_t *pool, CAF_PT_PROTOTYPE(rtn),
+                                void *arg);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_THREAD_FUTURE_H */
+/* caf_thread_future.h ends here */
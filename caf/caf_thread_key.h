@@ -27,6 +27,7 @@
 
 #include <pthread.h>
 #include <caf/caf_data_deque.h>
+#include <caf/caf_data_arena.h>
 
 /**
  * @defgroup      caf_thread_key    Thread Key
@@ -44,6 +45,10 @@
  * release callback is set, the normal pthread behavior does the
  * TSD release.
  *
+ * An arena key gives every thread its own caf_arena_t, created on the
+ * first use and deleted when the thread exits, so hot path temporaries
+ * are allocated without taking the malloc(3) locks.
+ *
  */
 
 #ifdef __cplusplus
@@ -287,6 +292,47 @@ void pth_kpool_remove_by_id (pth_kpool_t *pool, int id);
  */
 int pth_kpool_remove_callback (void *k);
 
+/**
+ *
+ * @brief    Creates a new Thread Arena Key.
+ *
+ * Creates a key whose thread specific data is a caf_arena_t. The
+ * arena of a thread is deleted when the thread exits.
+ *
+ * @param[in]    id             key identifier.
+ * @param[in]    chunk_sz       arena chunk size, zero takes
+ *                              CAF_ARENA_CHUNK.
+ * @return       pth_key_t *    the allocated pth_key_t structure.
+ *
+ * @see      pth_key_get_arena
+ */
+pth_key_t *pth_key_arena (int id, size_t chunk_sz);
+
+/**
+ *
+ * @brief    Gets the arena of the running thread.
+ *
+ * Creates the arena on the first call from each thread.
+ *
+ * @param[in]    key            Thread Arena Key.
+ * @return       caf_arena_t *  the thread arena, NULL on error.
+ *
+ * @see      pth_key_arena
+ */
+caf_arena_t *pth_key_get_arena (pth_key_t *key);
+
+/**
+ *
+ * @brief    Gets the arena of the running thread from a key pool.
+ *
+ * @param[in]    pool           Thread Key Pool.
+ * @param[in]    id             Arena Key identifier.
+ * @return       caf_arena_t *  the thread arena, NULL on error.
+ *
+ * @see      pth_key_get_arena
+ */
+caf_arena_t *pth_kpool_get_arena (pth_kpool_t *pool, int id);
+
 #ifdef __cplusplus
 CAF_END_C_EXTERNS
 #endif /* !__cplusplus */
@@ -0,0 +1,169 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_THREAD_MAP_H
+#define CAF_THREAD_MAP_H 1
+
+#include <caf/caf_data_deque.h>
+#include <caf/caf_data_cdeque.h>
+#include <caf/caf_thread_attr.h>
+#include <caf/caf_thread_pool.h>
+
+/**
+ * @defgroup      caf_thread_map    Parallel Map
+ * @ingroup       caf_thread
+ * @addtogroup    caf_thread_map
+ * @{
+ *
+ * @brief     Parallel Map and Reduce.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Applies a routine to every element of a deque_t or cdeque_t on the
+ * workers of an executor pool. The list is split into chunks of grain
+ * elements, every chunk runs as one task, and the calling thread runs
+ * the chunks no worker has taken yet instead of only waiting, so a pool
+ * worker can call these functions too. The list must not change while
+ * the routine runs, and the routine must be safe to run concurrently.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Defines the parallel map routine, returns the element result */
+#define PTH_MAP_RTN(rtn)           void *(*rtn)(void *data)
+/** Defines the reduce routine, folds data into the accumulator */
+#define PTH_REDUCE_RTN(rtn)        void *(*rtn)(void *acc, void *data)
+/** Chunks per worker when the grain size is zero */
+#define PTH_MAP_CHUNKS             4
+
+/** Results follow the list order */
+#define PTH_MAP_ORDERED            1
+/** Results follow the chunk completion order */
+#define PTH_MAP_UNORDERED          0
+
+
+/**
+ *
+ * @brief    Maps a routine over a deque in parallel.
+ *
+ * @param[in]    pool            Caffeine Executor Pool, NULL runs the
+ *                               chunks on the calling thread.
+ * @param[in]    lst             the list to map.
+ * @param[in]    step            map routine.
+ * @param[in]    grain           elements per chunk, zero splits the
+ *                               list in PTH_MAP_CHUNKS per worker.
+ * @param[in]    order           PTH_MAP_ORDERED or PTH_MAP_UNORDERED.
+ * @param[out]   results         list to push the results to, or NULL.
+ * @return       int             the number of mapped elements,
+ *                               CAF_ERROR_SUB on failure.
+ *
+ * @see      deque_map
+ */
+int deque_map_parallel (pth_pool_t *pool, deque_t *lst, PTH_MAP_RTN(step),
+                        size_t grain, int order, deque_t *results);
+
+/**
+ *
+ * @brief    Reduces a deque in parallel.
+ *
+ * Every chunk folds its elements into an accumulator starting from
+ * init, so init must be the identity of the reduction. The chunk
+ * accumulators are then combined on the calling thread.
+ *
+ * @param[in]    pool            Caffeine Executor Pool, NULL runs the
+ *                               chunks on the calling thread.
+ * @param[in]    lst             the list to reduce.
+ * @param[in]    fold            folds an element into an accumulator.
+ * @param[in]    combine         combines two accumulators.
+ * @param[in]    init            initial accumulator of every chunk.
+ * @param[in]    grain           elements per chunk, zero splits the
+ *                               list in PTH_MAP_CHUNKS per worker.
+ * @param[in]    order           PTH_MAP_ORDERED combines in list order,
+ *                               PTH_MAP_UNORDERED in completion order.
+ * @param[out]   result          the reduction, init for an empty list.
+ * @return       int             CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      deque_map_parallel
+ */
+int deque_reduce_parallel (pth_pool_t *pool, deque_t *lst,
+                           PTH_REDUCE_RTN(fold), PTH_REDUCE_RTN(combine),
+                           void *init, size_t grain, int order,
+                           void **result);
+
+/**
+ *
+ * @brief    Maps a routine over a circular deque in parallel.
+ *
+ * @param[in]    pool            Caffeine Executor Pool, NULL runs the
+ *                               chunks on the calling thread.
+ * @param[in]    lst             the list to map.
+ * @param[in]    step            map routine.
+ * @param[in]    grain           elements per chunk, zero splits the
+ *                               list in PTH_MAP_CHUNKS per worker.
+ * @param[in]    order           PTH_MAP_ORDERED or PTH_MAP_UNORDERED.
+ * @param[out]   results         list to push the results to, or NULL.
+ * @return       int             the number of mapped elements,
+ *                               CAF_ERROR_SUB on failure.
+ *
+ * @see      cdeque_map
+ */
+int cdeque_map_parallel (pth_pool_t *pool, cdeque_t *lst,
+                         PTH_MAP_RTN(step), size_t grain, int order,
+                         cdeque_t *results);
+
+/**
+ *
+ * @brief    Reduces a circular deque in parallel.
+ *
+ * @param[in]    pool            Caffeine Executor Pool, NULL runs the
+ *                               chunks on the calling thread.
+ * @param[in]    lst             the list to reduce.
+ * @param[in]    fold            folds an element into an accumulator.
+ * @param[in]    combine         combines two accumulators.
+ * @param[in]    init            initial accumulator of every chunk.
+ * @param[in]    grain           elements per chunk, zero splits the
+ *                               list in PTH_MAP_CHUNKS per worker.
+ * @param[in]    order           PTH_MAP_ORDERED combines in list order,
+ *                               PTH_MAP_UNORDERED in completion order.
+ * @param[out]   result          the reduction, init for an empty list.
+ * @return       int             CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      deque_reduce_parallel
+ */
+int cdeque_reduce_parallel (pth_pool_t *pool, cdeque_t *lst,
+                            PTH_REDUCE_RTN(fold), PTH_REDUCE_RTN(combine),
+                            void *init, size_t grain, int order,
+                            void **result);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_THREAD_MAP_H */
+/* caf_thread_map.h ends here */
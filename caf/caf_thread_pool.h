@@ -25,8 +25,10 @@
 #ifndef CAF_THREAD_POOL_H
 #define CAF_THREAD_POOL_H 1
 
+#include <stdio.h>
 #include <pthread.h>
 #include <caf/caf_data_deque.h>
+#include <caf/caf_thread_queue.h>
 
 /**
  * @defgroup      caf_thread_pool    Thread Pool Manager
@@ -41,7 +43,13 @@
  *
  * Thread Pool Manager is the set of functions to manage a thread pool.
  * A Thread Pool is a DLL of threads that shares the same attributes,
- * locks and conditions.
+ * locks and conditions. An executor pool runs a worker routine on
+ * every thread instead, and the workers take the submitted tasks from
+ * a shared work queue. A work stealing pool gives every worker its own
+ * deque: tasks submitted by a worker stay on its deque, and idle
+ * workers steal from random victims before they park. An elastic pool
+ * adds workers while queued tasks wait longer than a target latency and
+ * retires the workers that stay idle, between a minimum and a maximum.
  *
  */
 
@@ -53,6 +61,32 @@ CAF_BEGIN_C_EXTERNS
 #define CAF_PT_POOL_SZ             sizeof(pth_pool_t)
 /** Defines the thread routin prototype */
 #define CAF_PT_PROTOTYPE(rtn)      void *(*rtn)(void *)
+/** Defines the pth_task_t size */
+#define CAF_PT_TASK_SZ             sizeof(pth_task_t)
+/** Default executor work queue size */
+#define CAF_PT_QUEUE               1024
+/** Initial work stealing deque size */
+#define CAF_PT_WSDEQUE             256
+/** Defines the pth_worker_t size */
+#define CAF_PT_WORKER_SZ           sizeof(pth_worker_t)
+/** Defines the pth_pool_policy_t size */
+#define CAF_PT_POLICY_SZ           sizeof(pth_pool_policy_t)
+
+/** The executor accepts tasks */
+#define PTH_POOL_RUNNING           0
+/** The executor runs the queued tasks and refuses new ones */
+#define PTH_POOL_DRAINING          1
+/** The executor cancels the queued tasks and refuses new ones */
+#define PTH_POOL_STOPPING          2
+
+/** The task waits in the work queue */
+#define PTH_TASK_QUEUED            0
+/** A worker runs the task */
+#define PTH_TASK_RUNNING           1
+/** The task routine returned */
+#define PTH_TASK_DONE              2
+/** The task was canceled before it ran */
+#define PTH_TASK_CANCELED          3
 
 /**
  *
@@ -61,6 +95,34 @@ CAF_BEGIN_C_EXTERNS
  * @see      pth_pool
  */
 typedef struct pth_pool_s pth_pool_t;
+/**
+ *
+ * @brief    Caffeine Work Stealing Worker Type.
+ * @see      pth_worker_s
+ */
+typedef struct pth_worker_s pth_worker_t;
+/**
+ *
+ * @brief    Caffeine Elastic Pool Policy Type.
+ * @see      pth_pool_policy_s
+ */
+typedef struct pth_pool_policy_s pth_pool_policy_t;
+/**
+ *
+ * @brief    Caffeine Elastic Pool Policy Structure.
+ * The bounds and timings an elastic pool scales with. At most one
+ * worker is added per target latency period.
+ */
+struct pth_pool_policy_s {
+	/** Minimum Workers, at least one */
+	int min;
+	/** Maximum Workers */
+	int max;
+	/** Target Queue Latency, tasks waiting longer add a worker */
+	struct timespec latency;
+	/** Idle Timeout, workers idle for longer retire */
+	struct timespec idle;
+};
 /**
  *
  * @brief    Caffeine Thread Pool Structure.
@@ -77,6 +139,112 @@ struct pth_pool_s {
 	deque_t *threads;
 	/** Thread Routine */
 	CAF_PT_PROTOTYPE(rtn);
+	/** Executor Work Queue, NULL for plain pools */
+	pth_queue_t *tasks;
+	/** Executor State */
+	int state;
+	/** Running Executor Workers, a futex word */
+	int live;
+	/** Work Stealing Workers, NULL for shared queue executors */
+	pth_worker_t *workers;
+	/** Key to find the Worker of the running thread */
+	pthread_key_t self;
+	/** Work Arrival Counter, parked workers sleep on it */
+	int park_ev;
+	/** Parked Workers */
+	int parked;
+	/** Elastic Pool Policy, NULL for fixed size pools */
+	pth_pool_policy_t *policy;
+	/** Guards the thread list while an elastic pool scales */
+	pthread_mutex_t lock;
+	/** Idle Elastic Workers */
+	int idle;
+	/** Monotonic time of the last task taken, in nanoseconds */
+	long long last_pop;
+	/** Monotonic time of the last worker added, in nanoseconds */
+	long long grown_at;
+};
+
+/**
+ *
+ * @brief    Caffeine Work Stealing Worker Structure.
+ * The deque of a worker and the counters used to tune the pool. Only
+ * the owner thread updates the counters.
+ */
+struct pth_worker_s {
+	/** Worker Pool */
+	pth_pool_t *pool;
+	/** Worker Deque */
+	pth_wsdeque_t *deque;
+	/** Worker Index */
+	int id;
+	/** Victim Selection State */
+	unsigned int seed;
+	/** Tasks Run */
+	unsigned long runs;
+	/** Tasks Stolen */
+	unsigned long steals;
+	/** Steal Attempts that found nothing */
+	unsigned long steal_fails;
+	/** Times Parked */
+	unsigned long parks;
+	/** Keeps neighbour workers off this cache line */
+	char pad[PTH_QUEUE_CACHELINE];
+};
+
+/**
+ *
+ * @brief    Caffeine Thread Pool Statistics Type.
+ * @see      pth_pool_stats_s
+ */
+typedef struct pth_pool_stats_s pth_pool_stats_t;
+/**
+ *
+ * @brief    Caffeine Thread Pool Statistics Structure.
+ * The worker counters summed over the pool.
+ */
+struct pth_pool_stats_s {
+	/** Tasks Run */
+	unsigned long runs;
+	/** Tasks Stolen */
+	unsigned long steals;
+	/** Steal Attempts that found nothing */
+	unsigned long steal_fails;
+	/** Times Parked */
+	unsigned long parks;
+};
+
+/**
+ *
+ * @brief    Caffeine Thread Pool Task Type.
+ * The completion handle of a submitted task.
+ * @see      pth_task_s
+ */
+typedef struct pth_task_s pth_task_t;
+/**
+ *
+ * @brief    Caffeine Thread Pool Task Structure.
+ * Holds the task routine, its argument and result. The handle is
+ * shared by the submitter and the worker, and it is released when
+ * both are done with it.
+ */
+struct pth_task_s {
+	/** Task Routine */
+	CAF_PT_PROTOTYPE(fn);
+	/** Task Routine Argument */
+	void *arg;
+	/** Task Routine Result */
+	void *result;
+	/** Task State, a futex word */
+	int state;
+	/** Threads waiting for the task */
+	int waiters;
+	/** References to the handle */
+	int refs;
+	/** Monotonic time the task was queued, in nanoseconds */
+	long long queued;
+	/** Pool the task was submitted to */
+	pth_pool_t *pool;
 };
 
 
@@ -196,6 +364,209 @@ int pth_pool_detach (pth_pool_t *pool);
  */
 int pth_pool_cancel (pth_pool_t *pool);
 
+/**
+ *
+ * @brief    Creates a new Executor Pool.
+ *
+ * Launches the given number of workers. Every worker takes tasks from
+ * a shared work queue and runs them until the pool is shut down. The
+ * attributes are made joinable, since the workers are always joined
+ * by pth_pool_shutdown(); this holds for every executor pool.
+ *
+ * @param[in]    attrs           Caffeine Thread Attributes.
+ * @param[in]    cnt             number of workers to launch.
+ * @param[in]    qsz             work queue size, zero takes CAF_PT_QUEUE.
+ * @return       pth_pool_t *    the allocated and working pool.
+ *
+ * @see      pth_pool_t
+ */
+pth_pool_t *pth_pool_executor (pth_attri_t *attrs, int cnt, size_t qsz);
+
+/**
+ *
+ * @brief    Creates a new Work Stealing Executor Pool.
+ *
+ * Launches the given number of workers, each one owning a Chase-Lev
+ * deque. Tasks submitted from a worker go to its own deque, tasks
+ * submitted from other threads go to the shared work queue.
+ *
+ * @param[in]    attrs           Caffeine Thread Attributes.
+ * @param[in]    cnt             number of workers to launch.
+ * @param[in]    qsz             shared work queue size, zero takes
+ *                               CAF_PT_QUEUE.
+ * @return       pth_pool_t *    the allocated and working pool.
+ *
+ * @see      pth_pool_t
+ */
+pth_pool_t *pth_pool_stealing (pth_attri_t *attrs, int cnt, size_t qsz);
+
+/**
+ *
+ * @brief    Creates a new Elastic Executor Pool.
+ *
+ * Launches the policy minimum of workers sharing a work queue. A
+ * worker is added when a queued task waits longer than the target
+ * latency, and a worker idle for the idle timeout retires while the
+ * pool runs more than the minimum.
+ *
+ * @param[in]    attrs           Caffeine Thread Attributes.
+ * @param[in]    policy          the scaling policy, copied.
+ * @param[in]    qsz             work queue size, zero takes CAF_PT_QUEUE.
+ * @return       pth_pool_t *    the allocated and working pool.
+ *
+ * @see      pth_pool_policy_t
+ */
+pth_pool_t *pth_pool_elastic (pth_attri_t *attrs,
+                              const pth_pool_policy_t *policy, size_t qsz);
+
+/**
+ *
+ * @brief    Counts the running Workers of an Executor Pool.
+ *
+ * @param[in]    pool            Caffeine Executor Pool.
+ * @return       int             the number of running workers.
+ *
+ * @see      pth_pool_t
+ */
+int pth_pool_size (pth_pool_t *pool);
+
+/**
+ *
+ * @brief    Submits a Task to an Executor Pool.
+ *
+ * Queues the task, waiting while the work queue is full. The returned
+ * handle must be released with pth_task_release(). While a work
+ * stealing pool drains, its workers may still submit tasks.
+ *
+ * @param[in]    pool            Caffeine Executor Pool.
+ * @param[in]    fn              task routine.
+ * @param[in]    arg             task routine argument.
+ * @return       pth_task_t *    the task handle, NULL if the pool does
+ *                               not accept tasks.
+ *
+ * @see      pth_task_t
+ */
+pth_task_t *pth_pool_submit (pth_pool_t *pool, CAF_PT_PROTOTYPE(fn),
+                             void *arg);
+
+/**
+ *
+ * @brief    Submits many Tasks to an Executor Pool.
+ *
+ * Queues one task per argument, all of them running the same routine.
+ * When tasks is NULL the handles are released at once and the tasks
+ * run detached.
+ *
+ * @param[in]    pool            Caffeine Executor Pool.
+ * @param[in]    fn              task routine.
+ * @param[in]    args            task routine arguments.
+ * @param[in]    cnt             number of tasks.
+ * @param[out]   tasks           the task handles, or NULL.
+ * @return       int             number of tasks submitted.
+ *
+ * @see      pth_task_t
+ */
+int pth_pool_submit_batch (pth_pool_t *pool, CAF_PT_PROTOTYPE(fn),
+                           void **args, int cnt, pth_task_t **tasks);
+
+/**
+ *
+ * @brief    Shuts an Executor Pool down.
+ *
+ * Stops accepting tasks and waits for every worker to exit. With
+ * drain set the queued tasks run first, otherwise they are canceled.
+ * The workers are joined before it returns, so nothing runs on the
+ * pool afterwards and pth_pool_delete() may free it. It must not be
+ * called from a worker of the same pool.
+ *
+ * @param[in]    pool            Caffeine Executor Pool.
+ * @param[in]    drain           non zero to run the queued tasks.
+ * @return       int             CAF_OK on success, CAF_ERROR if the pool
+ *                               is not a running executor.
+ *
+ * @see      pth_pool_t
+ */
+int pth_pool_shutdown (pth_pool_t *pool, int drain);
+
+/**
+ *
+ * @brief    Sums the Work Stealing Counters.
+ *
+ * @param[in]    pool            Caffeine Executor Pool.
+ * @param[out]   stats           the summed counters.
+ * @return       int             CAF_OK on success, CAF_ERROR if the pool
+ *                               does not steal work.
+ *
+ * @see      pth_pool_stats_t
+ */
+int pth_pool_stats (pth_pool_t *pool, pth_pool_stats_t *stats);
+
+/**
+ *
+ * @brief    Dumps the Work Stealing Counters of every Worker.
+ *
+ * @param[in]    out             FILE output stream.
+ * @param[in]    pool            Caffeine Executor Pool.
+ *
+ * @see      pth_worker_t
+ */
+void pth_pool_stats_dump (FILE *out, pth_pool_t *pool);
+
+/**
+ *
+ * @brief    Waits for a Task.
+ *
+ * A worker of a work stealing pool does not sleep while it waits: it
+ * runs the tasks of its own deque and steals others until the task is
+ * done, so a task may join the sub tasks it submitted even when every
+ * worker is waiting. Other threads sleep until the task is done.
+ *
+ * @param[in]    task            the task handle.
+ * @param[out]   result          the task routine result, or NULL.
+ * @return       int             CAF_OK if the task ran, CAF_ERROR if it
+ *                               was canceled.
+ *
+ * @see      pth_task_t
+ */
+int pth_task_wait (pth_task_t *task, void **result);
+
+/**
+ *
+ * @brief    Polls a Task.
+ *
+ * @param[in]    task            the task handle.
+ * @return       int             the task state, PTH_TASK_QUEUED,
+ *                               PTH_TASK_RUNNING, PTH_TASK_DONE or
+ *                               PTH_TASK_CANCELED.
+ *
+ * @see      pth_task_t
+ */
+int pth_task_poll (pth_task_t *task);
+
+/**
+ *
+ * @brief    Cancels a Task.
+ *
+ * Only a task still waiting in the work queue can be canceled.
+ *
+ * @param[in]    task            the task handle.
+ * @return       int             CAF_OK if the task will not run,
+ *                               CAF_ERROR if it already runs or ran.
+ *
+ * @see      pth_task_t
+ */
+int pth_task_cancel (pth_task_t *task);
+
+/**
+ *
+ * @brief    Releases a Task handle.
+ *
+ * @param[in]    task            the task handle.
+ *
+ * @see      pth_task_t
+ */
+void pth_task_release (pth_task_t *task);
+
 #ifdef __cplusplus
 CAF_END_C_EXTERNS
 #endif /* !__cplusplus */
@@ -0,0 +1,418 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+
+  $Id$
+*/
+#ifndef CAF_THREAD_QUEUE_H
+#define CAF_THREAD_QUEUE_H 1
+
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * @defgroup      caf_thread_queue    Thread Work Queue
+ * @ingroup       caf_thread
+ * @addtogroup    caf_thread_queue
+ * @{
+ *
+ * @brief     Thread Work Queue.
+ * @date      $Date$
+ * @version   $Revision$
+ * @author    Daniel Molina Wegener <dmw@coder.cl>
+ *
+ * Bounded lock free queue to hand work between many producer and
+ * many consumer threads, like the workers of a thread pool. Every
+ * slot carries a sequence number that tells producers and consumers
+ * whether the slot is free for the current lap, so each operation
+ * is one compare and swap on the queue index. The try functions
+ * never block, the blocking functions sleep on a futex when the
+ * queue is full or empty, so idle workers do not burn CPU.
+ *
+ * The work stealing deque is a Chase-Lev deque. Its owner thread
+ * pushes and pops at the bottom without locks, and any other thread
+ * steals from the top with a single compare and swap.
+ *
+ */
+
+#ifdef __cplusplus
+CAF_BEGIN_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** Defines the pth_queue_t size */
+#define PTH_QUEUE_SZ                   (sizeof (pth_queue_t))
+/** Defines the pth_queue_slot_t size */
+#define PTH_QUEUE_SLOT_SZ              (sizeof (pth_queue_slot_t))
+/** Cache line size used to keep the queue indexes apart */
+#define PTH_QUEUE_CACHELINE            64
+/** Minimum queue capacity */
+#define PTH_QUEUE_MIN                  2
+/** Defines the pth_wsdeque_t size */
+#define PTH_WSDEQUE_SZ                 (sizeof (pth_wsdeque_t))
+/** Defines the pth_wsarray_t size without its slots */
+#define PTH_WSARRAY_SZ                 (sizeof (pth_wsarray_t))
+
+/**
+ *
+ * @brief    Caffeine Thread Work Queue Slot Type.
+ * @see      pth_queue_slot_s
+ */
+typedef struct pth_queue_slot_s pth_queue_slot_t;
+/**
+ *
+ * @brief    Caffeine Thread Work Queue Slot Structure.
+ * A slot is free for the producer of position p when its sequence is
+ * p, and holds the item for the consumer of position p when its
+ * sequence is p + 1.
+ */
+struct pth_queue_slot_s {
+	/** Slot sequence number */
+	size_t seq;
+	/** Slot item */
+	void *data;
+};
+
+/**
+ *
+ * @brief    Caffeine Thread Work Queue Type.
+ * @see      pth_queue_s
+ */
+typedef struct pth_queue_s pth_queue_t;
+/**
+ *
+ * @brief    Caffeine Thread Work Queue Structure.
+ * The producer index, the consumer index and the futex words live on
+ * separate cache lines. The futex words count the pushes and pops,
+ * and sleepers are counted so the fast paths skip the wake up system
+ * call when nobody sleeps. Only one wake up per side is in flight at
+ * a time, the woken thread passes it on while work remains.
+ */
+struct pth_queue_s {
+	/** Keeps the producer line away from preceding memory */
+	char pad0[PTH_QUEUE_CACHELINE];
+	/** Producer index */
+	size_t enq;
+	/** Keeps the consumer line away from the producer line */
+	char pad1[PTH_QUEUE_CACHELINE - sizeof (size_t)];
+	/** Consumer index */
+	size_t deq;
+	/** Keeps the futex line away from the consumer line */
+	char pad2[PTH_QUEUE_CACHELINE - sizeof (size_t)];
+	/** Push counter, consumers sleep on it */
+	int push_ev;
+	/** Pop counter, producers sleep on it */
+	int pop_ev;
+	/** Sleeping consumers */
+	int push_waiters;
+	/** Sleeping producers */
+	int pop_waiters;
+	/** Non zero while a consumer wake up is in flight */
+	int push_pending;
+	/** Non zero while a producer wake up is in flight */
+	int pop_pending;
+	/** Non zero once the queue is closed */
+	int closed;
+	/** Keeps the read only fields away from the futex line */
+	char pad3[PTH_QUEUE_CACHELINE - 7 * sizeof (int)];
+	/** Capacity minus one */
+	size_t mask;
+	/** Slot array */
+	pth_queue_slot_t *slots;
+};
+
+/**
+ *
+ * @brief    Caffeine Work Stealing Deque Array Type.
+ * @see      pth_wsarray_s
+ */
+typedef struct pth_wsarray_s pth_wsarray_t;
+/**
+ *
+ * @brief    Caffeine Work Stealing Deque Array Structure.
+ * A circular slot array. A grown deque keeps its older arrays linked
+ * until the deque is deleted, since a thief may still read them.
+ */
+struct pth_wsarray_s {
+	/** Capacity minus one */
+	long mask;
+	/** Previous, smaller array */
+	pth_wsarray_t *prev;
+	/** Slots */
+	void *slots[1];
+};
+
+/**
+ *
+ * @brief    Caffeine Work Stealing Deque Type.
+ * @see      pth_wsdeque_s
+ */
+typedef struct pth_wsdeque_s pth_wsdeque_t;
+/**
+ *
+ * @brief    Caffeine Work Stealing Deque Structure.
+ * The owner moves the bottom index and the thieves move the top
+ * index, each on its own cache line.
+ */
+struct pth_wsdeque_s {
+	/** Keeps the thief line away from preceding memory */
+	char pad0[PTH_QUEUE_CACHELINE];
+	/** Steal index */
+	long top;
+	/** Keeps the owner line away from the thief line */
+	char pad1[PTH_QUEUE_CACHELINE - sizeof (long)];
+	/** Owner index */
+	long bottom;
+	/** Current slot array */
+	pth_wsarray_t *array;
+	/** Keeps following memory away from the owner line */
+	char pad2[PTH_QUEUE_CACHELINE - sizeof (long) - sizeof (void *)];
+};
+
+/**
+ *
+ * @brief    Allocates a new Caffeine Thread Work Queue.
+ *
+ * @param[in]    cnt             minimum capacity, rounded up to a power
+ *                               of two.
+ * @return       pth_queue_t *   the new queue, NULL on failure.
+ *
+ * @see      pth_queue_t
+ */
+pth_queue_t *pth_queue_new (const size_t cnt);
+
+/**
+ *
+ * @brief    Deletes a Caffeine Thread Work Queue.
+ *
+ * No thread may use the queue anymore. Queued items are dropped.
+ *
+ * @param[in]    q               the queue to delete.
+ * @return       int             CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_delete (pth_queue_t *q);
+
+/**
+ *
+ * @brief    Enqueues an item without blocking.
+ *
+ * @param[in]    q               the queue.
+ * @param[in]    data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the queue
+ *                               is full or closed.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_trypush (pth_queue_t *q, void *data);
+
+/**
+ *
+ * @brief    Dequeues an item without blocking.
+ *
+ * @param[in]    q               the queue.
+ * @param[out]   data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the queue
+ *                               is empty.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_trypop (pth_queue_t *q, void **data);
+
+/**
+ *
+ * @brief    Enqueues an item, sleeping while the queue is full.
+ *
+ * @param[in]    q               the queue.
+ * @param[in]    data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the queue
+ *                               is closed.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_push (pth_queue_t *q, void *data);
+
+/**
+ *
+ * @brief    Dequeues an item, sleeping while the queue is empty.
+ *
+ * Items queued before pth_queue_close() are still delivered.
+ *
+ * @param[in]    q               the queue.
+ * @param[out]   data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the queue
+ *                               is closed and drained.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_pop (pth_queue_t *q, void **data);
+
+/**
+ *
+ * @brief    Dequeues an item, sleeping up to a timeout.
+ *
+ * @param[in]    q               the queue.
+ * @param[out]   data            the item.
+ * @param[in]    tm              relative timeout.
+ * @return       int             CAF_OK on success, CAF_ERROR if the
+ *                               timeout expired or the queue is closed
+ *                               and drained.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_timedpop (pth_queue_t *q, void **data,
+                        const struct timespec *tm);
+
+/**
+ *
+ * @brief    Closes the queue.
+ *
+ * Further pushes fail and every sleeping thread is woken up, popping
+ * threads drain the remaining items and then fail.
+ *
+ * @param[in]    q               the queue.
+ * @return       int             CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      pth_queue_t
+ */
+int pth_queue_close (pth_queue_t *q);
+
+/**
+ *
+ * @brief    Returns the number of queued items.
+ *
+ * The value is a snapshot while other threads use the queue.
+ *
+ * @param[in]    q               the queue.
+ * @return       size_t          the number of queued items.
+ *
+ * @see      pth_queue_t
+ */
+size_t pth_queue_length (pth_queue_t *q);
+
+/**
+ *
+ * @brief    Allocates a new Work Stealing Deque.
+ *
+ * @param[in]    cnt             initial capacity, rounded up to a power
+ *                               of two. The deque grows when full.
+ * @return       pth_wsdeque_t * the new deque, NULL on failure.
+ *
+ * @see      pth_wsdeque_t
+ */
+pth_wsdeque_t *pth_wsdeque_new (const size_t cnt);
+
+/**
+ *
+ * @brief    Deletes a Work Stealing Deque.
+ *
+ * @param[in]    d               the deque to delete.
+ * @return       int             CAF_OK on success, CAF_ERROR on failure.
+ *
+ * @see      pth_wsdeque_t
+ */
+int pth_wsdeque_delete (pth_wsdeque_t *d);
+
+/**
+ *
+ * @brief    Pushes an item at the bottom, owner thread only.
+ *
+ * @param[in]    d               the deque.
+ * @param[in]    data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the deque
+ *                               could not grow.
+ *
+ * @see      pth_wsdeque_t
+ */
+int pth_wsdeque_push (pth_wsdeque_t *d, void *data);
+
+/**
+ *
+ * @brief    Pops the newest item from the bottom, owner thread only.
+ *
+ * @param[in]    d               the deque.
+ * @param[out]   data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the deque
+ *                               is empty.
+ *
+ * @see      pth_wsdeque_t
+ */
+int pth_wsdeque_pop (pth_wsdeque_t *d, void **data);
+
+/**
+ *
+ * @brief    Steals the oldest item from the top, any thread.
+ *
+ * @param[in]    d               the deque.
+ * @param[out]   data            the item.
+ * @return       int             CAF_OK on success, CAF_ERROR if the deque
+ *                               is empty, CAF_ERROR_SUB if another
+ *                               thread took the item first.
+ *
+ * @see      pth_wsdeque_t
+ */
+int pth_wsdeque_steal (pth_wsdeque_t *d, void **data);
+
+/**
+ *
+ * @brief    Returns the number of items in the deque.
+ *
+ * @param[in]    d               the deque.
+ * @return       size_t          a snapshot of the number of items.
+ *
+ * @see      pth_wsdeque_t
+ */
+size_t pth_wsdeque_length (pth_wsdeque_t *d);
+
+/**
+ *
+ * @brief    Sleeps while a word keeps a value.
+ *
+ * Returns at once if the word does not hold the given value, and may
+ * return spuriously, so callers wait in a loop. This is a futex wait
+ * on Linux and a short sleep elsewhere.
+ *
+ * @param[in]    word            the word to wait on.
+ * @param[in]    seen            the value last read from the word.
+ * @param[in]    tm              relative timeout, NULL to wait forever.
+ *
+ * @see      pth_word_wake
+ */
+void pth_word_wait (int *word, const int seen, const struct timespec *tm);
+
+/**
+ *
+ * @brief    Wakes threads sleeping on a word.
+ *
+ * @param[in]    word            the word threads wait on.
+ * @param[in]    cnt             maximum number of threads to wake.
+ *
+ * @see      pth_word_wait
+ */
+void pth_word_wake (int *word, const int cnt);
+
+#ifdef __cplusplus
+CAF_END_C_EXTERNS
+#endif /* !__cplusplus */
+
+/** }@ */
+#endif /* !CAF_THREAD_QUEUE_H */
+/* caf_thread_queue.h ends here */
@@ -35,6 +35,9 @@
 #define CAF_NULL_T(t)        ((t)NULL)
 #define CAF_ISNULL(t,x)      (CAF_NULL_T(t) == x)
 
+#define CAF_CONTAINER_OF(p,t,m)                             \
+    ((t *)((char *)(p) - offsetof (t, m)))
+
 #ifndef CAF_BEGIN_C_EXTERNS
 #define CAF_BEGIN_C_EXTERNS				extern "C" {
 #endif /* !CAF_BEGIN_C_EXTERNS */
@@ -0,0 +1,303 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_hash_str.h"
+#include "caf/caf_hash_table.h"
+#include "caf/caf_thread_rwlock.h"
+#include "caf/caf_chash_table.h"
+
+
+/** Golden ratio multiplier, spreads the first hash before sharding */
+#define CAF_CHASH_MIX               2654435761U
+
+/*
+ * The segment locks are taken on the pthread rwlock itself: the
+ * pth_rwl_* wrappers store the lock state in pth_rwlock_t.at on every
+ * acquire and release, so concurrent readers would race on that word
+ * and bounce its cache line.
+ */
+/** Takes the segment read lock */
+#define CAF_CHASH_RDLOCK(seg)       pthread_rwlock_rdlock (           \
+                                    &((seg)->lock->rwlock))
+/** Takes the segment write lock */
+#define CAF_CHASH_WRLOCK(seg)       pthread_rwlock_wrlock (           \
+                                    &((seg)->lock->rwlock))
+/** Releases the segment lock */
+#define CAF_CHASH_UNLOCK(seg)       pthread_rwlock_unlock (           \
+                                    &((seg)->lock->rwlock))
+
+static caf_chash_seg_t *caf_chash_table_seg (caf_chash_table_t *table,
+                                             const u_int32_t h1);
+
+
+caf_chash_table_t *
+caf_chash_table_new (const int id, const size_t segments,
+                     CAF_HASH_STR_FUNCTION(f1),
+                     CAF_HASH_STR_FUNCTION(f2)) {
+	caf_chash_table_t *r = (caf_chash_table_t *)NULL;
+	caf_chash_seg_t *seg;
+	size_t sz, i;
+	int bits;
+	if (id > 0 && f1 != NULL && segments <= CAF_CHASH_TABLE_SEGMENTS_MAX) {
+		sz = 1;
+		bits = 0;
+		while (sz < (segments > 0 ? segments : CAF_CHASH_TABLE_SEGMENTS)) {
+			sz <<= 1;
+			bits++;
+		}
+		r = (caf_chash_table_t *)xmalloc (CAF_CHASH_TABLE_SZ);
+		if (r == (caf_chash_table_t *)NULL) {
+			return r;
+		}
+		r->segs = (caf_chash_seg_t *)xmalloc (sz * CAF_CHASH_SEG_SZ);
+		if (r->segs == (caf_chash_seg_t *)NULL) {
+			xfree (r);
+			return (caf_chash_table_t *)NULL;
+		}
+		r->id = id;
+		r->f1 = f1;
+		r->f2 = f2;
+		r->count = 0;
+		r->shift = 32 - bits;
+		for (i = 0; i < sz; i++) {
+			seg = &(r->segs[i]);
+			seg->table = caf_hash_table_new (id, f1, f2);
+			seg->lock = pth_rwl_new (id);
+			if (seg->table == (caf_hash_table_t *)NULL ||
+				seg->lock == (pth_rwlock_t *)NULL ||
+				pth_rwlattr_init (seg->lock) != 0 ||
+				pth_rwl_init (seg->lock) != 0) {
+				if (seg->table != (caf_hash_table_t *)NULL) {
+					caf_hash_table_delete (seg->table);
+				}
+				if (seg->lock != (pth_rwlock_t *)NULL) {
+					pth_rwl_delete (seg->lock);
+				}
+				caf_chash_table_delete (r);
+				return (caf_chash_table_t *)NULL;
+			}
+			r->count++;
+		}
+	}
+	return r;
+}
+
+
+int
+caf_chash_table_delete (caf_chash_table_t *table) {
+	caf_chash_seg_t *seg;
+	size_t i;
+	if (table != (caf_chash_table_t *)NULL) {
+		for (i = 0; i < table->count; i++) {
+			seg = &(table->segs[i]);
+			caf_hash_table_delete (seg->table);
+			pth_rwl_destroy (seg->lock);
+			pth_rwlattr_destroy (seg->lock);
+			pth_rwl_delete (seg->lock);
+		}
+		xfree (table->segs);
+		xfree (table);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_chash_table_add (caf_chash_table_t *table, const void *key,
+                     const size_t ksz, const void *data) {
+	caf_chash_seg_t *seg;
+	u_int32_t h1, h2;
+	int r = CAF_ERROR;
+	if (table != (caf_chash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0 && data != (const void *)NULL) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		seg = caf_chash_table_seg (table, h1);
+		if (CAF_CHASH_WRLOCK(seg) == 0) {
+			r = caf_hash_table_add_hashed (seg->table, key, ksz, data,
+			                               h1, h2);
+			CAF_CHASH_UNLOCK(seg);
+		}
+	}
+	return r;
+}
+
+
+int
+caf_chash_table_remove (caf_chash_table_t *table, const void *key,
+                        const size_t ksz) {
+	caf_chash_seg_t *seg;
+	u_int32_t h1, h2;
+	int r = CAF_ERROR;
+	if (table != (caf_chash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		seg = caf_chash_table_seg (table, h1);
+		if (CAF_CHASH_WRLOCK(seg) == 0) {
+			r = caf_hash_table_remove_hashed (seg->table, key, ksz, h1, h2);
+			CAF_CHASH_UNLOCK(seg);
+		}
+	}
+	return r;
+}
+
+
+void *
+caf_chash_table_get (caf_chash_table_t *table, const void *key,
+                     const size_t ksz) {
+	caf_chash_seg_t *seg;
+	u_int32_t h1, h2;
+	void *r = (void *)NULL;
+	if (table != (caf_chash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		seg = caf_chash_table_seg (table, h1);
+		/* segments never rehash incrementally, lookups are read only */
+		if (CAF_CHASH_RDLOCK(seg) == 0) {
+			r = caf_hash_table_get_hashed (seg->table, key, ksz, h1, h2);
+			CAF_CHASH_UNLOCK(seg);
+		}
+	}
+	return r;
+}
+
+
+int
+caf_chash_table_set (caf_chash_table_t *table, const void *key,
+                     const size_t ksz, void *data) {
+	caf_chash_seg_t *seg;
+	u_int32_t h1, h2;
+	int r = CAF_ERROR;
+	if (table != (caf_chash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		seg = caf_chash_table_seg (table, h1);
+		if (CAF_CHASH_WRLOCK(seg) == 0) {
+			r = caf_hash_table_set_hashed (seg->table, key, ksz, data,
+			                               h1, h2);
+			CAF_CHASH_UNLOCK(seg);
+		}
+	}
+	return r;
+}
+
+
+void *
+caf_chash_table_get_or_add (caf_chash_table_t *table, const void *key,
+                            const size_t ksz, const void *data) {
+	caf_chash_seg_t *seg;
+	u_int32_t h1, h2;
+	void *r = (void *)NULL;
+	if (table != (caf_chash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0 && data != (const void *)NULL) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		seg = caf_chash_table_seg (table, h1);
+		if (CAF_CHASH_RDLOCK(seg) == 0) {
+			r = caf_hash_table_get_hashed (seg->table, key, ksz, h1, h2);
+			CAF_CHASH_UNLOCK(seg);
+		}
+		if (r != (void *)NULL) {
+			return r;
+		}
+		/* another thread may add the key between both locks */
+		if (CAF_CHASH_WRLOCK(seg) == 0) {
+			r = caf_hash_table_get_hashed (seg->table, key, ksz, h1, h2);
+			if (r == (void *)NULL &&
+				caf_hash_table_add_hashed (seg->table, key, ksz, data,
+				                           h1, h2) == CAF_OK) {
+				r = (void *)data;
+			}
+			CAF_CHASH_UNLOCK(seg);
+		}
+	}
+	return r;
+}
+
+
+size_t
+caf_chash_table_count (caf_chash_table_t *table) {
+	caf_chash_seg_t *seg;
+	size_t i, r = 0;
+	if (table != (caf_chash_table_t *)NULL) {
+		for (i = 0; i < table->count; i++) {
+			seg = &(table->segs[i]);
+			if (CAF_CHASH_RDLOCK(seg) == 0) {
+				r += seg->table->count;
+				CAF_CHASH_UNLOCK(seg);
+			}
+		}
+	}
+	return r;
+}
+
+
+void
+caf_chash_table_dump (FILE *out, caf_chash_table_t *table) {
+	caf_chash_seg_t *seg;
+	size_t i;
+	if (table != (caf_chash_table_t *)NULL) {
+		fprintf (out, "[%p] Concurrent Hash Table: %lu segments\n",
+		         (void *)table, (unsigned long)table->count);
+		for (i = 0; i < table->count; i++) {
+			seg = &(table->segs[i]);
+			if (CAF_CHASH_RDLOCK(seg) == 0) {
+				caf_hash_table_dump (out, seg->table);
+				CAF_CHASH_UNLOCK(seg);
+			}
+		}
+	}
+}
+
+
+static caf_chash_seg_t *
+caf_chash_table_seg (caf_chash_table_t *table, const u_int32_t h1) {
+	/*
+	 * segment tables index slots with the low bits of h1, so the
+	 * segment is taken from the high bits of the mixed hash
+	 */
+	if (table->shift >= 32) {
+		return table->segs;
+	}
+	return &(table->segs[(u_int32_t)(h1 * CAF_CHASH_MIX) >> table->shift]);
+}
+
+/* caf_chash_table.c ends here */
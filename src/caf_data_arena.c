@@ -0,0 +1,195 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_arena.h"
+
+
+/** Rounds a size up to the arena alignment */
+#define CAF_ARENA_ROUND(sz)     (((sz) + CAF_ARENA_ALIGN - 1) \
+                                 & ~((size_t)CAF_ARENA_ALIGN - 1))
+/** Chunk header size, keeps the chunk memory aligned */
+#define CAF_ARENA_HDR           CAF_ARENA_ROUND(sizeof(caf_arena_chunk_t))
+/** Start of the chunk memory */
+#define CAF_ARENA_MEM(c)        ((char *)(c) + CAF_ARENA_HDR)
+
+static caf_arena_chunk_t *caf_arena_grow (caf_arena_t *arena,
+                                          const size_t sz);
+
+
+caf_arena_t *
+caf_arena_new (const size_t chunk_sz) {
+	caf_arena_t *arena = (caf_arena_t *)NULL;
+	arena = (caf_arena_t *)xmalloc (CAF_ARENA_SZ);
+	if (arena != (caf_arena_t *)NULL) {
+		arena->chunks = (caf_arena_chunk_t *)NULL;
+		arena->cur = (caf_arena_chunk_t *)NULL;
+		arena->chunk_sz = CAF_ARENA_ROUND(chunk_sz > 0 ? chunk_sz
+		                                  : CAF_ARENA_CHUNK);
+		arena->used = 0;
+		arena->chunk_count = 0;
+		arena->allocs = 0;
+		arena->resets = 0;
+	}
+	return arena;
+}
+
+
+int
+caf_arena_delete (caf_arena_t *arena) {
+	caf_arena_chunk_t *c, *next;
+	if (arena != (caf_arena_t *)NULL) {
+		c = arena->chunks;
+		while (c != (caf_arena_chunk_t *)NULL) {
+			next = c->next;
+			xfree (c);
+			c = next;
+		}
+		xfree (arena);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void *
+caf_arena_alloc (caf_arena_t *arena, const size_t sz) {
+	caf_arena_chunk_t *c;
+	size_t rsz;
+	void *ptr;
+	if (arena == (caf_arena_t *)NULL || sz == 0) {
+		return (void *)NULL;
+	}
+	rsz = CAF_ARENA_ROUND(sz);
+	c = arena->cur;
+	/* chunks kept from before the last reset are filled in order */
+	while (c != (caf_arena_chunk_t *)NULL && c->sz - c->used < rsz) {
+		c = c->next;
+	}
+	if (c == (caf_arena_chunk_t *)NULL) {
+		c = caf_arena_grow (arena, rsz);
+		if (c == (caf_arena_chunk_t *)NULL) {
+			return (void *)NULL;
+		}
+	}
+	arena->cur = c;
+	ptr = (void *)(CAF_ARENA_MEM(c) + c->used);
+	c->used += rsz;
+	arena->used += rsz;
+	arena->allocs++;
+	return ptr;
+}
+
+
+char *
+caf_arena_strdup (caf_arena_t *arena, const char *str) {
+	char *dup = (char *)NULL;
+	size_t sz;
+	if (str != (const char *)NULL) {
+		sz = strlen (str) + 1;
+		dup = (char *)caf_arena_alloc (arena, sz);
+		if (dup != (char *)NULL) {
+			memcpy (dup, str, sz);
+		}
+	}
+	return dup;
+}
+
+
+int
+caf_arena_reset (caf_arena_t *arena) {
+	caf_arena_chunk_t *c;
+	if (arena != (caf_arena_t *)NULL) {
+		c = arena->chunks;
+		while (c != (caf_arena_chunk_t *)NULL) {
+			c->used = 0;
+			c = c->next;
+		}
+		arena->cur = arena->chunks;
+		arena->used = 0;
+		arena->resets++;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+size_t
+caf_arena_used (caf_arena_t *arena) {
+	if (arena != (caf_arena_t *)NULL) {
+		return arena->used;
+	}
+	return 0;
+}
+
+
+void
+caf_arena_dump (FILE *out, caf_arena_t *arena) {
+	if (arena != (caf_arena_t *)NULL && out != (FILE *)NULL) {
+		fprintf (out, "[%p] Arena: %lu bytes used, %lu chunks of %lu\n",
+		         (void *)arena, (unsigned long)arena->used,
+		         (unsigned long)arena->chunk_count,
+		         (unsigned long)arena->chunk_sz);
+		fprintf (out, "     allocs: %lu; resets: %lu\n",
+		         arena->allocs, arena->resets);
+	}
+}
+
+
+static caf_arena_chunk_t *
+caf_arena_grow (caf_arena_t *arena, const size_t sz) {
+	caf_arena_chunk_t *c, *last;
+	size_t csz = sz > arena->chunk_sz ? sz : arena->chunk_sz;
+	c = (caf_arena_chunk_t *)xmalloc (CAF_ARENA_HDR + csz);
+	if (c != (caf_arena_chunk_t *)NULL) {
+		c->next = (caf_arena_chunk_t *)NULL;
+		c->sz = csz;
+		c->used = 0;
+		/* the new chunk goes last, after every chunk in use */
+		last = arena->cur;
+		if (last == (caf_arena_chunk_t *)NULL) {
+			arena->chunks = c;
+		} else {
+			while (last->next != (caf_arena_chunk_t *)NULL) {
+				last = last->next;
+			}
+			last->next = c;
+		}
+		arena->chunk_count++;
+	}
+	return c;
+}
+
+/* caf_data_arena.c ends here */
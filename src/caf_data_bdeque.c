@@ -0,0 +1,390 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_deque.h"
+#include "caf/caf_data_bdeque.h"
+
+
+/** Slot of the element at position i, its block must exist */
+#define CAF_BDEQUE_AT(dq, i)    (caf_bdeque_slot ((dq), ((dq)->first + (i)) & \
+                                                  ((dq)->map_sz * \
+                                                   CAF_BDEQUE_BLOCK - 1)))
+
+static void **caf_bdeque_slot (bdeque_t *dq, size_t p);
+static void **caf_bdeque_alloc (bdeque_t *dq, size_t p);
+static int caf_bdeque_reserve (bdeque_t *dq);
+
+
+bdeque_t *
+bdeque_create (void) {
+	bdeque_t *dq;
+	dq = (bdeque_t *)xmalloc (CAF_BDEQUE_SZ);
+	if (dq != (bdeque_t *)NULL) {
+		dq->map = (void ***)xmalloc (CAF_BDEQUE_MAP_MIN * sizeof (void **));
+		if (dq->map == (void ***)NULL) {
+			xfree (dq);
+			return (bdeque_t *)NULL;
+		}
+		memset (dq->map, 0, CAF_BDEQUE_MAP_MIN * sizeof (void **));
+		dq->map_sz = CAF_BDEQUE_MAP_MIN;
+		dq->first = 0;
+		dq->size = 0;
+	}
+	return dq;
+}
+
+
+int
+bdeque_delete (bdeque_t *dq, CAF_CAF_DEQUENODE_CBDEL(del)) {
+	int cnt = 0;
+	if (dq != (bdeque_t *)NULL) {
+		while (dq->size > 0) {
+			if ((del (*CAF_BDEQUE_AT(dq, 0))) != CAF_OK) {
+				return cnt;
+			}
+			dq->first = (dq->first + 1) & (dq->map_sz * CAF_BDEQUE_BLOCK - 1);
+			dq->size--;
+			cnt++;
+		}
+		return bdeque_delete_nocb (dq);
+	}
+	return CAF_ERROR_SUB;
+}
+
+
+int
+bdeque_delete_nocb (bdeque_t *dq) {
+	size_t i;
+	if (dq != (bdeque_t *)NULL) {
+		for (i = 0; i < dq->map_sz; i++) {
+			if (dq->map[i] != (void **)NULL) {
+				xfree (dq->map[i]);
+			}
+		}
+		xfree (dq->map);
+		xfree (dq);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+bdeque_length (bdeque_t *dq) {
+	if (dq != (bdeque_t *)NULL) {
+		return (int)dq->size;
+	}
+	return 0;
+}
+
+
+bdeque_t *
+bdeque_push (bdeque_t *dq, void *data) {
+	void **slot;
+	if (dq != (bdeque_t *)NULL && caf_bdeque_reserve (dq) == CAF_OK) {
+		slot = caf_bdeque_alloc (dq, (dq->first + dq->size) &
+		                         (dq->map_sz * CAF_BDEQUE_BLOCK - 1));
+		if (slot != (void **)NULL) {
+			*slot = data;
+			dq->size++;
+			return dq;
+		}
+	}
+	return (bdeque_t *)NULL;
+}
+
+
+bdeque_t *
+bdeque_prepend (bdeque_t *dq, void *data) {
+	void **slot;
+	size_t p;
+	if (dq != (bdeque_t *)NULL && caf_bdeque_reserve (dq) == CAF_OK) {
+		p = (dq->first - 1) & (dq->map_sz * CAF_BDEQUE_BLOCK - 1);
+		slot = caf_bdeque_alloc (dq, p);
+		if (slot != (void **)NULL) {
+			*slot = data;
+			dq->first = p;
+			dq->size++;
+			return dq;
+		}
+	}
+	return (bdeque_t *)NULL;
+}
+
+
+void *
+bdeque_pop (bdeque_t *dq) {
+	if (dq != (bdeque_t *)NULL && dq->size > 0) {
+		dq->size--;
+		return *CAF_BDEQUE_AT(dq, dq->size);
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bdeque_first (bdeque_t *dq) {
+	void *data;
+	if (dq != (bdeque_t *)NULL && dq->size > 0) {
+		data = *CAF_BDEQUE_AT(dq, 0);
+		dq->first = (dq->first + 1) & (dq->map_sz * CAF_BDEQUE_BLOCK - 1);
+		dq->size--;
+		return data;
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bdeque_get (bdeque_t *dq, int pos) {
+	if (dq != (bdeque_t *)NULL && pos >= 0 && (size_t)pos < dq->size) {
+		return *CAF_BDEQUE_AT(dq, (size_t)pos);
+	}
+	return (void *)NULL;
+}
+
+
+int
+bdeque_set (bdeque_t *dq, int pos, void *data) {
+	if (dq != (bdeque_t *)NULL && pos >= 0 && (size_t)pos < dq->size) {
+		*CAF_BDEQUE_AT(dq, (size_t)pos) = data;
+		return pos;
+	}
+	return CAF_ERROR_SUB;
+}
+
+
+int
+bdeque_insert (bdeque_t *dq, int pos, void *data) {
+	size_t i, p, mask;
+	if (dq == (bdeque_t *)NULL || pos < 0 || (size_t)pos > dq->size ||
+		caf_bdeque_reserve (dq) != CAF_OK) {
+		return CAF_ERROR_SUB;
+	}
+	mask = dq->map_sz * CAF_BDEQUE_BLOCK - 1;
+	if ((size_t)pos < dq->size - (size_t)pos) {
+		/* the head side is shorter, it moves one place back */
+		p = (dq->first - 1) & mask;
+		if (caf_bdeque_alloc (dq, p) == (void **)NULL) {
+			return CAF_ERROR_SUB;
+		}
+		dq->first = p;
+		dq->size++;
+		for (i = 0; i < (size_t)pos; i++) {
+			*CAF_BDEQUE_AT(dq, i) = *CAF_BDEQUE_AT(dq, i + 1);
+		}
+	} else {
+		p = (dq->first + dq->size) & mask;
+		if (caf_bdeque_alloc (dq, p) == (void **)NULL) {
+			return CAF_ERROR_SUB;
+		}
+		dq->size++;
+		for (i = dq->size - 1; i > (size_t)pos; i--) {
+			*CAF_BDEQUE_AT(dq, i) = *CAF_BDEQUE_AT(dq, i - 1);
+		}
+	}
+	*CAF_BDEQUE_AT(dq, (size_t)pos) = data;
+	return pos;
+}
+
+
+void *
+bdeque_remove (bdeque_t *dq, int pos) {
+	void *data;
+	size_t i;
+	if (dq == (bdeque_t *)NULL || pos < 0 || (size_t)pos >= dq->size) {
+		return (void *)NULL;
+	}
+	data = *CAF_BDEQUE_AT(dq, (size_t)pos);
+	if ((size_t)pos < dq->size - 1 - (size_t)pos) {
+		for (i = (size_t)pos; i > 0; i--) {
+			*CAF_BDEQUE_AT(dq, i) = *CAF_BDEQUE_AT(dq, i - 1);
+		}
+		dq->first = (dq->first + 1) & (dq->map_sz * CAF_BDEQUE_BLOCK - 1);
+	} else {
+		for (i = (size_t)pos; i + 1 < dq->size; i++) {
+			*CAF_BDEQUE_AT(dq, i) = *CAF_BDEQUE_AT(dq, i + 1);
+		}
+	}
+	dq->size--;
+	return data;
+}
+
+
+int
+bdeque_map (bdeque_t *dq, CAF_CAF_DEQUENODE_CBMAP(step)) {
+	size_t i;
+	int c = 0;
+	if (dq != (bdeque_t *)NULL) {
+		for (i = 0; i < dq->size; i++) {
+			step (*CAF_BDEQUE_AT(dq, i));
+			c++;
+		}
+	}
+	return c;
+}
+
+
+int
+bdeque_map_checked (bdeque_t *dq, CAF_CAF_DEQUENODE_CBMAP(step)) {
+	size_t i;
+	int c = 0;
+	if (dq != (bdeque_t *)NULL) {
+		for (i = 0; i < dq->size; i++) {
+			if ((step (*CAF_BDEQUE_AT(dq, i))) != CAF_OK) {
+				return c;
+			}
+			c++;
+		}
+	}
+	return c;
+}
+
+
+void *
+bdeque_search (bdeque_t *dq, void *data, CAF_CAF_DEQUENODE_CBSRCH(srch)) {
+	void *cur;
+	size_t i;
+	if (dq != (bdeque_t *)NULL) {
+		for (i = 0; i < dq->size; i++) {
+			cur = *CAF_BDEQUE_AT(dq, i);
+			if ((srch (cur, data)) == CAF_OK) {
+				return cur;
+			}
+		}
+	}
+	return (void *)NULL;
+}
+
+
+bdeque_t *
+bdeque_from_deque (deque_t *lst) {
+	bdeque_t *dq;
+	caf_dequen_t *n;
+	if (lst == (deque_t *)NULL) {
+		return (bdeque_t *)NULL;
+	}
+	dq = bdeque_create ();
+	if (dq != (bdeque_t *)NULL) {
+		for (n = lst->head; n != (caf_dequen_t *)NULL; n = n->next) {
+			if (bdeque_push (dq, n->data) == (bdeque_t *)NULL) {
+				bdeque_delete_nocb (dq);
+				return (bdeque_t *)NULL;
+			}
+		}
+	}
+	return dq;
+}
+
+
+deque_t *
+bdeque_to_deque (bdeque_t *dq) {
+	deque_t *lst;
+	size_t i;
+	if (dq == (bdeque_t *)NULL) {
+		return (deque_t *)NULL;
+	}
+	lst = deque_create ();
+	if (lst != (deque_t *)NULL) {
+		for (i = 0; i < dq->size; i++) {
+			if (deque_push (lst, *CAF_BDEQUE_AT(dq, i)) == (deque_t *)NULL) {
+				deque_delete_nocb (lst);
+				return (deque_t *)NULL;
+			}
+		}
+	}
+	return lst;
+}
+
+
+void
+bdeque_dump (FILE *out, bdeque_t *dq, CAF_CAF_DEQUENODE_CBDUMP(dmp)) {
+	size_t i;
+	if (dq != (bdeque_t *)NULL) {
+		for (i = 0; i < dq->size; i++) {
+			dmp (out, *CAF_BDEQUE_AT(dq, i));
+		}
+	}
+}
+
+
+static void **
+caf_bdeque_slot (bdeque_t *dq, size_t p) {
+	return &(dq->map[p / CAF_BDEQUE_BLOCK][p & (CAF_BDEQUE_BLOCK - 1)]);
+}
+
+
+static void **
+caf_bdeque_alloc (bdeque_t *dq, size_t p) {
+	void ***blk = &(dq->map[p / CAF_BDEQUE_BLOCK]);
+	if (*blk == (void **)NULL) {
+		*blk = (void **)xmalloc (CAF_BDEQUE_BLOCK * sizeof (void *));
+		if (*blk == (void **)NULL) {
+			return (void **)NULL;
+		}
+	}
+	return caf_bdeque_slot (dq, p);
+}
+
+
+static int
+caf_bdeque_reserve (bdeque_t *dq) {
+	void ***map;
+	size_t i, fb;
+	/*
+	 * one block is always left free, so the tail never reaches the
+	 * block holding the head, and growing only rotates the ring
+	 */
+	if (dq->size + 1 <= (dq->map_sz - 1) * CAF_BDEQUE_BLOCK) {
+		return CAF_OK;
+	}
+	map = (void ***)xmalloc (dq->map_sz * 2 * sizeof (void **));
+	if (map == (void ***)NULL) {
+		return CAF_ERROR;
+	}
+	memset (map, 0, dq->map_sz * 2 * sizeof (void **));
+	fb = dq->first / CAF_BDEQUE_BLOCK;
+	for (i = 0; i < dq->map_sz; i++) {
+		map[i] = dq->map[(fb + i) & (dq->map_sz - 1)];
+	}
+	xfree (dq->map);
+	dq->map = map;
+	dq->map_sz *= 2;
+	dq->first &= CAF_BDEQUE_BLOCK - 1;
+	return CAF_OK;
+}
+
+/* caf_data_bdeque.c ends here */
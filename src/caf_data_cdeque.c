@@ -36,6 +36,9 @@ static char Id[] = "$Id: caf_data_lstdl.c 8 2007-05-03 00:50:25Z damowe $";
 #include "caf/caf_data_mem.h"
 #include "caf/caf_data_cdeque.h"
 
+static caf_cdequen_t *cdeque_node_new (cdeque_t *lst);
+static caf_cdequen_t *cdeque_node_at (cdeque_t *lst, int pos);
+static void cdeque_node_unlink (cdeque_t *lst, caf_cdequen_t *n);
 
 cdeque_t *
 cdeque_new (void *data) {
@@ -43,7 +46,8 @@ cdeque_new (void *data) {
 	caf_cdequen_t *n;
 	lst = (cdeque_t *)xmalloc (CAF_CDEQUE_SZ);
 	if (lst != NULL) {
-		n = (caf_cdequen_t *)xmalloc (CAF_LSTDLCNODE_SZ);
+		lst->slab = (caf_slab_t *)NULL;
+		n = cdeque_node_new (lst);
 		if (n != (caf_cdequen_t *)NULL) {
 			if (data != (void *)NULL) {
 				n->data = data;
@@ -53,6 +57,8 @@ cdeque_new (void *data) {
 			lst->head = n;
 			lst->tail = n;
 			lst->size = 1;
+			lst->finger = (caf_cdequen_t *)NULL;
+			lst->finger_pos = 0;
 		} else {
 			free (lst);
 			lst = (cdeque_t *)NULL;
@@ -71,6 +77,9 @@ cdeque_create (void) {
 		lst->head = (caf_cdequen_t *)NULL;
 		lst->tail = (caf_cdequen_t *)NULL;
 		lst->size = 0;
+		lst->slab = (caf_slab_t *)NULL;
+		lst->finger = (caf_cdequen_t *)NULL;
+		lst->finger_pos = 0;
 	}
 	return lst;
 }
@@ -87,7 +96,7 @@ cdeque_delete (cdeque_t *lst, CAF_LSTDLCNODE_CBDEL(del)) {
 				return CAF_OK;
 			} else if (cdeque_oneitem_list (lst) == CAF_OK) {
 				if (del (lst->head->data) == CAF_OK) {
-					xfree (lst->head);
+					cdeque_node_free (lst, lst->head);
 					xfree (lst);
 					return CAF_OK;
 				}
@@ -97,14 +106,14 @@ cdeque_delete (cdeque_t *lst, CAF_LSTDLCNODE_CBDEL(del)) {
 					if ((del (cur->data)) == CAF_OK) {
 						destroy = cur;
 						cur = cur->next;
-						xfree(destroy);
+						cdeque_node_free (lst, destroy);
 					} else {
 						lst->head = cur;
 						return CAF_ERROR;
 					}
 				} while (cur != lst->tail);
 				if (del (lst->tail->data) == CAF_OK) {
-					xfree (lst->tail);
+					cdeque_node_free (lst, lst->tail);
 				}
 				xfree(lst);
 				lst = (cdeque_t *)NULL;
@@ -128,7 +137,7 @@ cdeque_delete_nocb (cdeque_t *lst) {
 				xfree (lst);
 				return CAF_OK;
 			} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-				xfree (lst->head);
+				cdeque_node_free (lst, lst->head);
 				xfree (lst);
 				return CAF_OK;
 			} else {
@@ -136,9 +145,9 @@ cdeque_delete_nocb (cdeque_t *lst) {
 				do {
 					destroy = cur;
 					cur = cur->next;
-					xfree(destroy);
+					cdeque_node_free (lst, destroy);
 				} while (cur != lst->tail);
-				xfree (lst->tail);
+				cdeque_node_free (lst, lst->tail);
 				xfree (lst);
 				return CAF_OK;
 			}
@@ -150,63 +159,45 @@ cdeque_delete_nocb (cdeque_t *lst) {
 }
 
 
+int
+cdeque_slab_set (cdeque_t *lst, caf_slab_t *slab) {
+	if (lst != (cdeque_t *)NULL && lst->head == (caf_cdequen_t *)NULL) {
+		lst->slab = slab;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+cdeque_node_free (cdeque_t *lst, caf_cdequen_t *n) {
+	if (lst != (cdeque_t *)NULL && n != (caf_cdequen_t *)NULL) {
+		if (lst->slab != (caf_slab_t *)NULL) {
+			return caf_slab_free (lst->slab, n);
+		}
+		xfree (n);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
 int
 cdeque_node_delete (cdeque_t *lst, caf_cdequen_t *n, CAF_LSTDLCNODE_CBDEL(del)) {
 	caf_cdequen_t *nr;
-	caf_cdequen_t *prev;
-	caf_cdequen_t *next;
+	int c;
 	if (lst != (cdeque_t *)NULL && n != (void *)NULL && del != NULL) {
 		nr = lst->head;
-		if (nr != (caf_cdequen_t *)NULL) {
-			if (cdeque_empty_list (lst) == CAF_OK) {
-				return CAF_ERROR;
-			} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-				if ((del (lst->head->data)) == CAF_OK) {
-					xfree (lst->head);
-					lst->head = (caf_cdequen_t *)NULL;
-					lst->tail = (caf_cdequen_t *)NULL;
+		for (c = 0; c < lst->size; c++) {
+			if (nr == n) {
+				if ((del (nr->data)) == CAF_OK) {
+					cdeque_node_unlink (lst, nr);
+					cdeque_node_free (lst, nr);
 					return CAF_OK;
 				}
-			} else {
-				if (nr == n) {
-					if ((del (nr->data)) == CAF_OK) {
-						prev = nr->prev;
-						next = nr->next;
-						prev->next = next;
-						next->prev = prev;
-						xfree (nr);
-						lst->size--;
-						lst->head = next;
-						return CAF_OK;
-					}
-				} else if (lst->tail == n) {
-					if ((del (nr->data)) == CAF_OK) {
-						prev = nr->prev;
-						next = nr->next;
-						prev->next = next;
-						next->prev = prev;
-						xfree (nr);
-						lst->size--;
-						lst->tail = prev;
-						return CAF_OK;
-					}
-				} else {
-					do {
-						if (nr == n) {
-							if ((del (nr->data)) == CAF_OK) {
-								prev = nr->prev;
-								next = nr->next;
-								prev->next = next;
-								next->prev = prev;
-								xfree (nr);
-								lst->size--;
-								return CAF_OK;
-							}
-						}
-						nr = nr->next;
-					} while (nr != lst->tail);
-				}
+				return CAF_ERROR;
 			}
+			nr = nr->next;
 		}
 	}
 	return CAF_ERROR;
@@ -217,60 +208,19 @@ int
 cdeque_node_delete_by_data (cdeque_t *lst, void *n,
 							CAF_LSTDLCNODE_CBDEL(del)) {
 	caf_cdequen_t *nr;
-	caf_cdequen_t *prev;
-	caf_cdequen_t *next;
+	int c;
 	if (lst != (cdeque_t *)NULL && n != (void *)NULL && del != NULL) {
 		nr = lst->head;
-		if (nr != (caf_cdequen_t *)NULL) {
-			if (cdeque_empty_list (lst) == CAF_OK) {
-				return CAF_ERROR;
-			} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-				if ((del (lst->head->data)) == CAF_OK) {
-					xfree (lst->head);
-					lst->head = (caf_cdequen_t *)NULL;
-					lst->tail = (caf_cdequen_t *)NULL;
+		for (c = 0; c < lst->size; c++) {
+			if (nr->data == n) {
+				if ((del (nr->data)) == CAF_OK) {
+					cdeque_node_unlink (lst, nr);
+					cdeque_node_free (lst, nr);
 					return CAF_OK;
 				}
-			} else {
-				if (nr->data == n) {
-					if ((del (nr->data)) == CAF_OK) {
-						prev = nr->prev;
-						next = nr->next;
-						prev->next = next;
-						next->prev = prev;
-						xfree (nr);
-						lst->size--;
-						lst->head = next;
-						return CAF_OK;
-					}
-				} else if (lst->tail->data == n) {
-					if ((del (nr->data)) == CAF_OK) {
-						prev = nr->prev;
-						next = nr->next;
-						prev->next = next;
-						next->prev = prev;
-						xfree (nr);
-						lst->size--;
-						lst->tail = prev;
-						return CAF_OK;
-					}
-				} else {
-					do {
-						if (nr->data == n) {
-							if ((del (nr->data)) == CAF_OK) {
-								prev = nr->prev;
-								next = nr->next;
-								prev->next = next;
-								next->prev = prev;
-								xfree (nr);
-								lst->size--;
-								return CAF_OK;
-							}
-						}
-						nr = nr->next;
-					} while (nr != lst->tail);
-				}
+				return CAF_ERROR;
 			}
+			nr = nr->next;
 		}
 	}
 	return CAF_ERROR;
@@ -299,19 +249,8 @@ cdeque_oneitem_list (cdeque_t *lst) {
 
 int
 cdeque_length (cdeque_t *lst) {
-	int c;
-	caf_cdequen_t *cur;
 	if (lst != (cdeque_t *)NULL) {
-		if (lst->head != (caf_cdequen_t *)NULL
-			&& lst->tail != (caf_cdequen_t *)NULL) {
-			cur = lst->head;
-			c = 0;
-			do {
-				cur = cur->next;
-				c++;
-			} while (cur != lst->tail);
-			return c;
-		}
+		return lst->size;
 	}
 	return 0;
 }
@@ -322,7 +261,7 @@ cdeque_push (cdeque_t *lst, void *data) {
 	caf_cdequen_t *tail = (caf_cdequen_t *)NULL, *head = (caf_cdequen_t *)NULL;
 	caf_cdequen_t *xnew = (caf_cdequen_t *)NULL;
 	if (lst != (cdeque_t *)NULL) {
-		xnew = (caf_cdequen_t *)xmalloc (CAF_LSTDLCNODE_SZ);
+		xnew = cdeque_node_new (lst);
 		if (xnew != (caf_cdequen_t *)NULL) {
 			xnew->data = data;
 			if (cdeque_empty_list (lst) == CAF_OK) {
@@ -331,6 +270,7 @@ cdeque_push (cdeque_t *lst, void *data) {
 				lst->tail = xnew;
 				lst->head = xnew;
 				lst->size++;
+				return lst;
 			} else {
 				tail = lst->tail;
 				head = lst->head;
@@ -352,27 +292,12 @@ cdeque_push (cdeque_t *lst, void *data) {
 caf_cdequen_t *
 cdeque_pop (cdeque_t *lst) {
 	caf_cdequen_t *ret = (caf_cdequen_t *)NULL;
-	caf_cdequen_t *ex = (caf_cdequen_t *)NULL;
-	;
 	if (lst != (cdeque_t *)NULL) {
 		if (cdeque_empty_list (lst) == CAF_OK) {
 			return ret;
-		} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-			ret = lst->tail;
-			lst->head = (caf_cdequen_t *)NULL;
-			lst->tail = (caf_cdequen_t *)NULL;
-			ret->next = (void *)NULL;
-			ret->prev = (void *)NULL;
-			lst->size--;
-		} else {
-			ex = lst->tail->prev;
-			ret = lst->tail;
-			ret->next = (void *)NULL;
-			ret->prev = (void *)NULL;
-			ex->next = lst->head;
-			lst->tail = ex;
-			lst->size--;
 		}
+		ret = lst->tail;
+		cdeque_node_unlink (lst, ret);
 	}
 	return ret;
 }
@@ -381,26 +306,12 @@ cdeque_pop (cdeque_t *lst) {
 caf_cdequen_t *
 cdeque_first (cdeque_t *lst) {
 	caf_cdequen_t *ret = (caf_cdequen_t *)NULL;
-	caf_cdequen_t *ex;
 	if (lst != (cdeque_t *)NULL) {
 		if (cdeque_empty_list (lst) == CAF_OK) {
 			return ret;
-		} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-			ret = lst->head;
-			lst->head = (caf_cdequen_t *)NULL;
-			lst->tail = (caf_cdequen_t *)NULL;
-			ret->next = (void *)NULL;
-			ret->prev = (void *)NULL;
-			lst->size--;
-		} else {
-			ret = lst->head;
-			ex = ret->next;
-			ret->next = (void *)NULL;
-			ret->prev = (void *)NULL;
-			ex->prev = (void *)NULL;
-			lst->head = ex;
-			lst->size--;
 		}
+		ret = lst->head;
+		cdeque_node_unlink (lst, ret);
 	}
 	return ret;
 }
@@ -409,30 +320,11 @@ cdeque_first (cdeque_t *lst) {
 int
 cdeque_set (cdeque_t *lst, int pos, void *data) {
 	caf_cdequen_t *pn;
-	int c;
 	if (lst != (cdeque_t *)NULL) {
-		if (cdeque_empty_list (lst) == CAF_OK) {
-			return CAF_ERROR_SUB;
-		} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-			if (pos == 0) {
-				lst->head->data = data;
-				return 0;
-			}
-			return CAF_ERROR_SUB;
-		} else {
-			c = 0;
-			pn = lst->head;
-			do {
-				if (pos == c) {
-					pn->data = data;
-					return pos;
-				}
-				pn = pn->next;
-				c++;
-			} while (pn != lst->tail);
-			if (pos == c) {
-				lst->tail->data = data;
-			}
+		pn = cdeque_node_at (lst, pos);
+		if (pn != (caf_cdequen_t *)NULL) {
+			pn->data = data;
+			return pos;
 		}
 	}
 	return CAF_ERROR_SUB;
@@ -442,43 +334,32 @@ cdeque_set (cdeque_t *lst, int pos, void *data) {
 int
 cdeque_insert (cdeque_t *lst, int pos, void *data) {
 	caf_cdequen_t *pn; caf_cdequen_t *nn;
-	int c;
 	if (lst != (cdeque_t *)NULL) {
 		if (cdeque_empty_list (lst) == CAF_OK) {
 			return CAF_ERROR_SUB;
-		} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-			if (pos == 0) {
-				nn = (caf_cdequen_t *)xmalloc (CAF_LSTDLCNODE_SZ);
-				nn->data = data;
-				nn->next = lst->head;
-				lst->head->prev = nn;
-				lst->head = nn;
-				return 0;
+		} else if (pos == lst->size) {
+			/* one past the tail appends the data */
+			return ((cdeque_push (lst, data) != (cdeque_t *)NULL)
+			        ? pos : CAF_ERROR_SUB);
+		}
+		pn = cdeque_node_at (lst, pos);
+		if (pn != (caf_cdequen_t *)NULL) {
+			nn = cdeque_node_new (lst);
+			if (nn == (caf_cdequen_t *)NULL) {
+				return CAF_ERROR_SUB;
 			}
-			return CAF_ERROR_SUB;
-		} else {
-			c = 0;
-			pn = lst->head;
-			do {
-				if (pos == c) {
-					nn = (caf_cdequen_t *)xmalloc (CAF_LSTDLCNODE_SZ);
-					nn->data = data;
-					nn->next = pn;
-					nn = pn->prev;
-					return pos;
-				}
-				pn = pn->next;
-				c++;
-			} while (pn != lst->tail);
-			if (pos == c) {
-				nn = (caf_cdequen_t *)xmalloc (CAF_LSTDLCNODE_SZ);
-				nn->data = data;
-				nn->next = lst->head;
-				nn->prev = lst->tail;
-				lst->tail->next = nn;
-				lst->head->prev = nn;
-				lst->tail = nn;
+			nn->data = data;
+			nn->next = pn;
+			nn->prev = pn->prev;
+			pn->prev->next = nn;
+			pn->prev = nn;
+			if (pn == lst->head) {
+				lst->head = nn;
 			}
+			lst->size++;
+			/* the new node now holds the position of the finger */
+			lst->finger = nn;
+			return pos;
 		}
 	}
 	return CAF_ERROR_SUB;
@@ -488,23 +369,10 @@ cdeque_insert (cdeque_t *lst, int pos, void *data) {
 void *
 cdeque_get (cdeque_t *lst, int pos) {
 	caf_cdequen_t *pn;
-	int c = 0;
 	if (lst != (cdeque_t *)NULL) {
-		if ((cdeque_empty_list (lst) == CAF_OK)) {
-			return (void *)NULL;
-		} else if (cdeque_oneitem_list (lst) == CAF_OK) {
-			return ((c == 0) ? lst->head->data : (void *)NULL);
-		} else {
-			c = 0;
-			pn = lst->head;
-			do {
-				if (pos == c) {
-					return pn->data;
-				}
-				pn = pn->next;
-				c++;
-			} while (pn != lst->tail);
-			return ((pos == c) ? lst->tail->data : (void *)NULL);
+		pn = cdeque_node_at (lst, pos);
+		if (pn != (caf_cdequen_t *)NULL) {
+			return pn->data;
 		}
 	}
 	return (void *)NULL;
@@ -689,5 +557,77 @@ cdeque_dump_str_cb (FILE *o, void *data) {
 	}
 }
 
+
+static caf_cdequen_t *
+cdeque_node_new (cdeque_t *lst) {
+	if (lst->slab != (caf_slab_t *)NULL) {
+		return (caf_cdequen_t *)caf_slab_alloc (lst->slab);
+	}
+	return (caf_cdequen_t *)xmalloc (CAF_LSTDLCNODE_SZ);
+}
+
+
+static caf_cdequen_t *
+cdeque_node_at (cdeque_t *lst, int pos) {
+	caf_cdequen_t *n;
+	int c;
+	if (pos < 0 || pos >= lst->size) {
+		return (caf_cdequen_t *)NULL;
+	}
+	/* the walk starts from the closest of the head, tail and finger */
+	if (pos < lst->size - 1 - pos) {
+		n = lst->head;
+		c = 0;
+	} else {
+		n = lst->tail;
+		c = lst->size - 1;
+	}
+	if (lst->finger != (caf_cdequen_t *)NULL &&
+		abs (pos - lst->finger_pos) < abs (pos - c)) {
+		n = lst->finger;
+		c = lst->finger_pos;
+	}
+	while (c < pos) {
+		n = n->next;
+		c++;
+	}
+	while (c > pos) {
+		n = n->prev;
+		c--;
+	}
+	lst->finger = n;
+	lst->finger_pos = pos;
+	return n;
+}
+
+
+static void
+cdeque_node_unlink (cdeque_t *lst, caf_cdequen_t *n) {
+	int first = n == lst->head;
+	int last = n == lst->tail;
+	if (first && last) {
+		lst->head = (caf_cdequen_t *)NULL;
+		lst->tail = (caf_cdequen_t *)NULL;
+	} else {
+		n->prev->next = n->next;
+		n->next->prev = n->prev;
+		if (first) {
+			lst->head = n->next;
+		}
+		if (last) {
+			lst->tail = n->prev;
+		}
+	}
+	/* the finger survives removals at both ends of the list */
+	if (lst->finger == n || (!first && !last)) {
+		lst->finger = (caf_cdequen_t *)NULL;
+	} else if (first) {
+		lst->finger_pos--;
+	}
+	n->prev = (caf_cdequen_t *)NULL;
+	n->next = (caf_cdequen_t *)NULL;
+	lst->size--;
+}
+
 /* caf_data_cdeque.c ends here */
 
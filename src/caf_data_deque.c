@@ -36,6 +36,9 @@ static char Id[] = "$Id$";
 #include "caf/caf_data_mem.h"
 #include "caf/caf_data_deque.h"
 
+static caf_dequen_t *deque_node_new (deque_t *lst);
+static caf_dequen_t *deque_node_at (deque_t *lst, int pos);
+static void deque_node_unlink (deque_t *lst, caf_dequen_t *n);
 
 deque_t *
 deque_new (void *data) {
@@ -43,7 +46,8 @@ deque_new (void *data) {
 	caf_dequen_t *n;
 	lst = (deque_t *)xmalloc (CAF_DEQUE_SZ);
 	if (lst != NULL) {
-		n = (caf_dequen_t *)xmalloc (CAF_CAF_DEQUENODE_SZ);
+		lst->slab = (caf_slab_t *)NULL;
+		n = deque_node_new (lst);
 		if (n != (caf_dequen_t *)NULL) {
 			if (data != (void *)NULL) {
 				n->data = data;
@@ -53,6 +57,8 @@ deque_new (void *data) {
 			lst->head = n;
 			lst->tail = n;
 			lst->size = 1;
+			lst->finger = (caf_dequen_t *)NULL;
+			lst->finger_pos = 0;
 		} else {
 			free (lst);
 			lst = (deque_t *)NULL;
@@ -71,6 +77,9 @@ deque_create (void) {
 		lst->head = (caf_dequen_t *)NULL;
 		lst->tail = (caf_dequen_t *)NULL;
 		lst->size = 0;
+		lst->slab = (caf_slab_t *)NULL;
+		lst->finger = (caf_dequen_t *)NULL;
+		lst->finger_pos = 0;
 	}
 	return lst;
 }
@@ -86,7 +95,7 @@ deque_delete (deque_t *lst, CAF_CAF_DEQUENODE_CBDEL(del)) {
 			destroy = cur;
 			cur = cur->next;
 			if ((del (destroy->data)) == CAF_OK) {
-				xfree(destroy);
+				deque_node_free (lst, destroy);
 				cnt++;
 			} else {
 				lst->head = destroy;
@@ -95,7 +104,7 @@ deque_delete (deque_t *lst, CAF_CAF_DEQUENODE_CBDEL(del)) {
 		}
 		if (cur != (caf_dequen_t *)NULL) {
 			if ((del (cur->data)) == CAF_OK) {
-				xfree (cur);
+				deque_node_free (lst, cur);
 				cnt++;
 			} else {
 				lst->head = cur;
@@ -120,11 +129,11 @@ deque_delete_nocb (deque_t *lst) {
 			cnt++;
 			destroy = cur;
 			cur = cur->next;
-			xfree(destroy);
+			deque_node_free (lst, destroy);
 		}
 		if (cur != (caf_dequen_t *)NULL) {
 			cnt++;
-			xfree (cur);
+			deque_node_free (lst, cur);
 		}
 		xfree(lst);
 		return CAF_OK;
@@ -133,11 +142,32 @@ deque_delete_nocb (deque_t *lst) {
 }
 
 
+int
+deque_slab_set (deque_t *lst, caf_slab_t *slab) {
+	if (lst != (deque_t *)NULL && lst->head == (caf_dequen_t *)NULL) {
+		lst->slab = slab;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+deque_node_free (deque_t *lst, caf_dequen_t *n) {
+	if (lst != (deque_t *)NULL && n != (caf_dequen_t *)NULL) {
+		if (lst->slab != (caf_slab_t *)NULL) {
+			return caf_slab_free (lst->slab, n);
+		}
+		xfree (n);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
 int
 deque_node_delete (deque_t *lst, caf_dequen_t *n, CAF_CAF_DEQUENODE_CBDEL(del)) {
 	caf_dequen_t *nr;
-	caf_dequen_t *prev;
-	caf_dequen_t *next;
 	if (lst != (deque_t *)NULL && n != (void *)NULL && del != NULL) {
 		nr = lst->head;
 		if (nr != (caf_dequen_t *)NULL) {
@@ -145,20 +175,8 @@ deque_node_delete (deque_t *lst, caf_dequen_t *n, CAF_CAF_DEQUENODE_CBDEL(del))
 				if (nr != (caf_dequen_t *)NULL) {
 					if (nr == n) {
 						if ((del (nr->data)) == CAF_OK) {
-							prev = nr->prev;
-							next = nr->next;
-							if (prev != (caf_dequen_t *)NULL &&
-								next != (caf_dequen_t *)NULL) {
-								prev->next = next;
-								next->prev = prev;
-							} else if (prev != (caf_dequen_t *)NULL &&
-							           next == (caf_dequen_t *)NULL) {
-								prev->next = next;
-							} else {
-								next->prev = prev;
-							}
-							xfree (nr);
-							lst->size--;
+							deque_node_unlink (lst, nr);
+							deque_node_free (lst, nr);
 							return CAF_OK;
 						}
 					}
@@ -174,8 +192,6 @@ deque_node_delete (deque_t *lst, caf_dequen_t *n, CAF_CAF_DEQUENODE_CBDEL(del))
 int
 deque_node_delete_by_data (deque_t *lst, void *n, CAF_CAF_DEQUENODE_CBDEL(del)) {
 	caf_dequen_t *nr;
-	caf_dequen_t *prev;
-	caf_dequen_t *next;
 	if (lst != (deque_t *)NULL && n != (void *)NULL && del != NULL) {
 		nr = lst->head;
 		if (nr != (caf_dequen_t *)NULL) {
@@ -183,20 +199,8 @@ deque_node_delete_by_data (deque_t *lst, void *n, CAF_CAF_DEQUENODE_CBDEL(del))
 				if (nr != (caf_dequen_t *)NULL) {
 					if (nr->data == n) {
 						if ((del (nr->data)) == CAF_OK) {
-							prev = nr->prev;
-							next = nr->next;
-							if (prev != (caf_dequen_t *)NULL &&
-								next != (caf_dequen_t *)NULL) {
-								prev->next = next;
-								next->prev = prev;
-							} else if (prev != (caf_dequen_t *)NULL &&
-							           next == (caf_dequen_t *)NULL) {
-								prev->next = next;
-							} else {
-								next->prev = prev;
-							}
-							xfree (nr);
-							lst->size--;
+							deque_node_unlink (lst, nr);
+							deque_node_free (lst, nr);
 							return CAF_OK;
 						}
 					}
@@ -231,16 +235,8 @@ deque_oneitem_list (deque_t *lst) {
 
 int
 deque_length (deque_t *lst) {
-	int c;
-	caf_dequen_t *cur;
 	if (lst != (deque_t *)NULL) {
-		cur = lst->head;
-		c = 0;
-		while (cur != (caf_dequen_t *)NULL) {
-			cur = cur->next;
-			c++;
-		}
-		return c;
+		return lst->size;
 	}
 	return 0;
 }
@@ -250,7 +246,7 @@ deque_t *
 deque_push (deque_t *lst, void *data) {
 	caf_dequen_t *tail, *xnew;
 	if (lst != (deque_t *)NULL) {
-		xnew = (caf_dequen_t *)xmalloc (CAF_CAF_DEQUENODE_SZ);
+		xnew = deque_node_new (lst);
 		if (xnew != (caf_dequen_t *)NULL) {
 			if (lst->tail != (caf_dequen_t *)NULL &&
 				lst->head != (caf_dequen_t *)NULL) {
@@ -281,6 +277,9 @@ deque_pop (deque_t *lst) {
 	caf_dequen_t *ret = (caf_dequen_t *)NULL;
 	caf_dequen_t *ex = (caf_dequen_t *)NULL;
 	if (lst != (deque_t *)NULL) {
+		if (lst->finger == lst->tail) {
+			lst->finger = (caf_dequen_t *)NULL;
+		}
 		if (deque_empty_list (lst) == CAF_OK) {
 			return ret;
 		} else if (deque_oneitem_list (lst) == CAF_OK) {
@@ -307,18 +306,11 @@ deque_pop (deque_t *lst) {
 caf_dequen_t *
 deque_first (deque_t *lst) {
 	caf_dequen_t *ret = (caf_dequen_t *)NULL;
-	caf_dequen_t *ex;
 	if (lst != (deque_t *)NULL) {
 		ret = lst->head;
 		if (ret != (caf_dequen_t *)NULL) {
-			ex = ret->next;
-			if (ex != (caf_dequen_t *)NULL) {
-				ret->next = (void *)NULL;
-				ret->prev = (void *)NULL;
-				ex->prev = (void *)NULL;
-				lst->head = ex;
-				lst->size--;
-			}
+			/* every other node moves one position down */
+			deque_node_unlink (lst, ret);
 		}
 	}
 	return ret;
@@ -328,17 +320,11 @@ deque_first (deque_t *lst) {
 int
 deque_set (deque_t *lst, int pos, void *data) {
 	caf_dequen_t *pn;
-	int c;
 	if (lst != (deque_t *)NULL) {
-		c = 0;
-		pn = lst->head;
-		while (pn != (caf_dequen_t *)NULL) {
-			if (pos == c) {
-				pn->data = data;
-				return pos;
-			}
-			pn = pn->next;
-			c++;
+		pn = deque_node_at (lst, pos);
+		if (pn != (caf_dequen_t *)NULL) {
+			pn->data = data;
+			return pos;
 		}
 	}
 	return CAF_ERROR_SUB;
@@ -348,21 +334,26 @@ deque_set (deque_t *lst, int pos, void *data) {
 int
 deque_insert (deque_t *lst, int pos, void *data) {
 	caf_dequen_t *pn, *xnew;
-	int c;
 	if (lst != (deque_t *)NULL) {
-		c = 0;
-		pn = lst->head;
-		while (pn != (caf_dequen_t *)NULL) {
-			if (pos == c) {
-				xnew = (caf_dequen_t *)xmalloc (CAF_CAF_DEQUENODE_SZ);
-				xnew->data = data;
-				xnew->prev = pn->prev;
-				xnew->next = pn;
-				pn->prev = xnew;
-				return pos;
+		pn = deque_node_at (lst, pos);
+		if (pn != (caf_dequen_t *)NULL) {
+			xnew = deque_node_new (lst);
+			if (xnew == (caf_dequen_t *)NULL) {
+				return CAF_ERROR_SUB;
 			}
-			pn = pn->next;
-			c++;
+			xnew->data = data;
+			xnew->prev = pn->prev;
+			xnew->next = pn;
+			if (pn->prev != (caf_dequen_t *)NULL) {
+				pn->prev->next = xnew;
+			} else {
+				lst->head = xnew;
+			}
+			pn->prev = xnew;
+			lst->size++;
+			/* the new node now holds the position of the finger */
+			lst->finger = xnew;
+			return pos;
 		}
 	}
 	return CAF_ERROR_SUB;
@@ -372,16 +363,10 @@ deque_insert (deque_t *lst, int pos, void *data) {
 void *
 deque_get (deque_t *lst, int pos) {
 	caf_dequen_t *pn;
-	int c;
 	if (lst != (deque_t *)NULL) {
-		c = 0;
-		pn = lst->head;
-		while (pn != (caf_dequen_t *)NULL) {
-			if (pos == c) {
-				return pn->data;
-			}
-			pn = pn->next;
-			c++;
+		pn = deque_node_at (lst, pos);
+		if (pn != (caf_dequen_t *)NULL) {
+			return pn->data;
 		}
 	}
 	return (void *)NULL;
@@ -514,5 +499,74 @@ deque_dump_str_cb (FILE *o, void *data) {
 	                (int)strlen((char *)data), (char *)data);
 }
 
+
+static caf_dequen_t *
+deque_node_new (deque_t *lst) {
+	if (lst->slab != (caf_slab_t *)NULL) {
+		return (caf_dequen_t *)caf_slab_alloc (lst->slab);
+	}
+	return (caf_dequen_t *)xmalloc (CAF_CAF_DEQUENODE_SZ);
+}
+
+
+static caf_dequen_t *
+deque_node_at (deque_t *lst, int pos) {
+	caf_dequen_t *n;
+	int c;
+	if (pos < 0 || pos >= lst->size) {
+		return (caf_dequen_t *)NULL;
+	}
+	/* the walk starts from the closest of the head, tail and finger */
+	if (pos < lst->size - 1 - pos) {
+		n = lst->head;
+		c = 0;
+	} else {
+		n = lst->tail;
+		c = lst->size - 1;
+	}
+	if (lst->finger != (caf_dequen_t *)NULL &&
+		abs (pos - lst->finger_pos) < abs (pos - c)) {
+		n = lst->finger;
+		c = lst->finger_pos;
+	}
+	while (c < pos) {
+		n = n->next;
+		c++;
+	}
+	while (c > pos) {
+		n = n->prev;
+		c--;
+	}
+	lst->finger = n;
+	lst->finger_pos = pos;
+	return n;
+}
+
+
+static void
+deque_node_unlink (deque_t *lst, caf_dequen_t *n) {
+	int first = n->prev == (caf_dequen_t *)NULL;
+	int last = n->next == (caf_dequen_t *)NULL;
+	if (!first) {
+		n->prev->next = n->next;
+	} else {
+		lst->head = n->next;
+	}
+	if (!last) {
+		n->next->prev = n->prev;
+	} else {
+		lst->tail = n->prev;
+	}
+	/* the finger survives removals at both ends of the list */
+	if (lst->finger == n || (!first && !last)) {
+		lst->finger = (caf_dequen_t *)NULL;
+	} else if (first) {
+		lst->finger_pos--;
+	}
+	n->prev = (caf_dequen_t *)NULL;
+	n->next = (caf_dequen_t *)NULL;
+	lst->size--;
+}
+
 /* caf_data_deque.c ends here */
 
@@ -0,0 +1,517 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_ilist.h"
+
+
+ideque_t *
+ideque_create (const size_t offset) {
+	ideque_t *dq;
+	dq = (ideque_t *)xmalloc (CAF_IDEQUE_SZ);
+	if (dq != (ideque_t *)NULL) {
+		ideque_init (dq, offset);
+	}
+	return dq;
+}
+
+
+int
+ideque_init (ideque_t *dq, const size_t offset) {
+	if (dq != (ideque_t *)NULL) {
+		dq->head = (caf_ilink_t *)NULL;
+		dq->tail = (caf_ilink_t *)NULL;
+		dq->size = 0;
+		dq->offset = offset;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ideque_delete (ideque_t *dq, CAF_CAF_DEQUENODE_CBDEL(del)) {
+	void *obj;
+	if (dq != (ideque_t *)NULL && del != NULL) {
+		while (dq->head != (caf_ilink_t *)NULL) {
+			obj = ideque_first (dq);
+			if ((del (obj)) != CAF_OK) {
+				ideque_prepend (dq, obj);
+				return CAF_ERROR;
+			}
+		}
+		xfree (dq);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ideque_delete_nocb (ideque_t *dq) {
+	if (dq != (ideque_t *)NULL) {
+		while (dq->head != (caf_ilink_t *)NULL) {
+			ideque_first (dq);
+		}
+		xfree (dq);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ideque_length (ideque_t *dq) {
+	if (dq != (ideque_t *)NULL) {
+		return dq->size;
+	}
+	return 0;
+}
+
+
+ideque_t *
+ideque_push (ideque_t *dq, void *obj) {
+	caf_ilink_t *l;
+	if (dq != (ideque_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(dq, obj);
+		l->prev = dq->tail;
+		l->next = (caf_ilink_t *)NULL;
+		if (dq->tail != (caf_ilink_t *)NULL) {
+			dq->tail->next = l;
+		} else {
+			dq->head = l;
+		}
+		dq->tail = l;
+		dq->size++;
+		return dq;
+	}
+	return (ideque_t *)NULL;
+}
+
+
+ideque_t *
+ideque_prepend (ideque_t *dq, void *obj) {
+	caf_ilink_t *l;
+	if (dq != (ideque_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(dq, obj);
+		l->prev = (caf_ilink_t *)NULL;
+		l->next = dq->head;
+		if (dq->head != (caf_ilink_t *)NULL) {
+			dq->head->prev = l;
+		} else {
+			dq->tail = l;
+		}
+		dq->head = l;
+		dq->size++;
+		return dq;
+	}
+	return (ideque_t *)NULL;
+}
+
+
+int
+ideque_insert_after (ideque_t *dq, void *pos, void *obj) {
+	caf_ilink_t *p, *l;
+	if (dq != (ideque_t *)NULL && pos != (void *)NULL &&
+		obj != (void *)NULL) {
+		p = CAF_ILINK_OF(dq, pos);
+		l = CAF_ILINK_OF(dq, obj);
+		l->prev = p;
+		l->next = p->next;
+		if (p->next != (caf_ilink_t *)NULL) {
+			p->next->prev = l;
+		} else {
+			dq->tail = l;
+		}
+		p->next = l;
+		dq->size++;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ideque_insert_before (ideque_t *dq, void *pos, void *obj) {
+	caf_ilink_t *p, *l;
+	if (dq != (ideque_t *)NULL && pos != (void *)NULL &&
+		obj != (void *)NULL) {
+		p = CAF_ILINK_OF(dq, pos);
+		l = CAF_ILINK_OF(dq, obj);
+		l->next = p;
+		l->prev = p->prev;
+		if (p->prev != (caf_ilink_t *)NULL) {
+			p->prev->next = l;
+		} else {
+			dq->head = l;
+		}
+		p->prev = l;
+		dq->size++;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void *
+ideque_pop (ideque_t *dq) {
+	void *obj;
+	if (dq != (ideque_t *)NULL && dq->tail != (caf_ilink_t *)NULL) {
+		obj = CAF_ILINK_OBJ(dq, dq->tail);
+		ideque_remove (dq, obj);
+		return obj;
+	}
+	return (void *)NULL;
+}
+
+
+void *
+ideque_first (ideque_t *dq) {
+	void *obj;
+	if (dq != (ideque_t *)NULL && dq->head != (caf_ilink_t *)NULL) {
+		obj = CAF_ILINK_OBJ(dq, dq->head);
+		ideque_remove (dq, obj);
+		return obj;
+	}
+	return (void *)NULL;
+}
+
+
+int
+ideque_remove (ideque_t *dq, void *obj) {
+	caf_ilink_t *l;
+	if (dq != (ideque_t *)NULL && obj != (void *)NULL && dq->size > 0) {
+		l = CAF_ILINK_OF(dq, obj);
+		/* cleared links only belong to an end of this deque */
+		if ((l->prev == (caf_ilink_t *)NULL && dq->head != l) ||
+			(l->next == (caf_ilink_t *)NULL && dq->tail != l)) {
+			return CAF_ERROR;
+		}
+		if (l->prev != (caf_ilink_t *)NULL) {
+			l->prev->next = l->next;
+		} else {
+			dq->head = l->next;
+		}
+		if (l->next != (caf_ilink_t *)NULL) {
+			l->next->prev = l->prev;
+		} else {
+			dq->tail = l->prev;
+		}
+		l->prev = (caf_ilink_t *)NULL;
+		l->next = (caf_ilink_t *)NULL;
+		dq->size--;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void *
+ideque_head (ideque_t *dq) {
+	if (dq != (ideque_t *)NULL && dq->head != (caf_ilink_t *)NULL) {
+		return CAF_ILINK_OBJ(dq, dq->head);
+	}
+	return (void *)NULL;
+}
+
+
+void *
+ideque_tail (ideque_t *dq) {
+	if (dq != (ideque_t *)NULL && dq->tail != (caf_ilink_t *)NULL) {
+		return CAF_ILINK_OBJ(dq, dq->tail);
+	}
+	return (void *)NULL;
+}
+
+
+void *
+ideque_next (ideque_t *dq, void *obj) {
+	caf_ilink_t *l;
+	if (dq != (ideque_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(dq, obj)->next;
+		if (l != (caf_ilink_t *)NULL) {
+			return CAF_ILINK_OBJ(dq, l);
+		}
+	}
+	return (void *)NULL;
+}
+
+
+void *
+ideque_prev (ideque_t *dq, void *obj) {
+	caf_ilink_t *l;
+	if (dq != (ideque_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(dq, obj)->prev;
+		if (l != (caf_ilink_t *)NULL) {
+			return CAF_ILINK_OBJ(dq, l);
+		}
+	}
+	return (void *)NULL;
+}
+
+
+int
+ideque_map (ideque_t *dq, CAF_CAF_DEQUENODE_CBMAP(step)) {
+	caf_ilink_t *l;
+	int c = 0;
+	if (dq != (ideque_t *)NULL) {
+		for (l = dq->head; l != (caf_ilink_t *)NULL; l = l->next) {
+			step (CAF_ILINK_OBJ(dq, l));
+			c++;
+		}
+	}
+	return c;
+}
+
+
+void *
+ideque_search (ideque_t *dq, void *data, CAF_CAF_DEQUENODE_CBSRCH(srch)) {
+	caf_ilink_t *l;
+	if (dq != (ideque_t *)NULL) {
+		for (l = dq->head; l != (caf_ilink_t *)NULL; l = l->next) {
+			if ((srch (CAF_ILINK_OBJ(dq, l), data)) == CAF_OK) {
+				return CAF_ILINK_OBJ(dq, l);
+			}
+		}
+	}
+	return (void *)NULL;
+}
+
+
+ilstc_t *
+ilstc_create (const size_t offset) {
+	ilstc_t *lst;
+	lst = (ilstc_t *)xmalloc (CAF_ILSTC_SZ);
+	if (lst != (ilstc_t *)NULL) {
+		ilstc_init (lst, offset);
+	}
+	return lst;
+}
+
+
+int
+ilstc_init (ilstc_t *lst, const size_t offset) {
+	if (lst != (ilstc_t *)NULL) {
+		/* the sentinel alone closes an empty circle */
+		lst->ring.prev = &(lst->ring);
+		lst->ring.next = &(lst->ring);
+		lst->size = 0;
+		lst->offset = offset;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ilstc_delete (ilstc_t *lst, CAF_CAF_DEQUENODE_CBDEL(del)) {
+	void *obj;
+	if (lst != (ilstc_t *)NULL && del != NULL) {
+		while (lst->size > 0) {
+			obj = ilstc_first (lst);
+			if ((del (obj)) != CAF_OK) {
+				ilstc_prepend (lst, obj);
+				return CAF_ERROR;
+			}
+		}
+		xfree (lst);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ilstc_delete_nocb (ilstc_t *lst) {
+	if (lst != (ilstc_t *)NULL) {
+		while (lst->size > 0) {
+			ilstc_first (lst);
+		}
+		xfree (lst);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+ilstc_length (ilstc_t *lst) {
+	if (lst != (ilstc_t *)NULL) {
+		return lst->size;
+	}
+	return 0;
+}
+
+
+ilstc_t *
+ilstc_push (ilstc_t *lst, void *obj) {
+	caf_ilink_t *l;
+	if (lst != (ilstc_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(lst, obj);
+		l->next = &(lst->ring);
+		l->prev = lst->ring.prev;
+		lst->ring.prev->next = l;
+		lst->ring.prev = l;
+		lst->size++;
+		return lst;
+	}
+	return (ilstc_t *)NULL;
+}
+
+
+ilstc_t *
+ilstc_prepend (ilstc_t *lst, void *obj) {
+	caf_ilink_t *l;
+	if (lst != (ilstc_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(lst, obj);
+		l->prev = &(lst->ring);
+		l->next = lst->ring.next;
+		lst->ring.next->prev = l;
+		lst->ring.next = l;
+		lst->size++;
+		return lst;
+	}
+	return (ilstc_t *)NULL;
+}
+
+
+void *
+ilstc_pop (ilstc_t *lst) {
+	void *obj;
+	if (lst != (ilstc_t *)NULL && lst->size > 0) {
+		obj = CAF_ILINK_OBJ(lst, lst->ring.prev);
+		ilstc_remove (lst, obj);
+		return obj;
+	}
+	return (void *)NULL;
+}
+
+
+void *
+ilstc_first (ilstc_t *lst) {
+	void *obj;
+	if (lst != (ilstc_t *)NULL && lst->size > 0) {
+		obj = CAF_ILINK_OBJ(lst, lst->ring.next);
+		ilstc_remove (lst, obj);
+		return obj;
+	}
+	return (void *)NULL;
+}
+
+
+int
+ilstc_remove (ilstc_t *lst, void *obj) {
+	caf_ilink_t *l;
+	if (lst != (ilstc_t *)NULL && obj != (void *)NULL && lst->size > 0) {
+		l = CAF_ILINK_OF(lst, obj);
+		/* links on the ring are never cleared */
+		if (l->prev == (caf_ilink_t *)NULL ||
+			l->next == (caf_ilink_t *)NULL) {
+			return CAF_ERROR;
+		}
+		l->prev->next = l->next;
+		l->next->prev = l->prev;
+		l->prev = (caf_ilink_t *)NULL;
+		l->next = (caf_ilink_t *)NULL;
+		lst->size--;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void *
+ilstc_rotate (ilstc_t *lst) {
+	void *obj;
+	obj = ilstc_first (lst);
+	if (obj != (void *)NULL) {
+		ilstc_push (lst, obj);
+	}
+	return obj;
+}
+
+
+void *
+ilstc_head (ilstc_t *lst) {
+	if (lst != (ilstc_t *)NULL && lst->size > 0) {
+		return CAF_ILINK_OBJ(lst, lst->ring.next);
+	}
+	return (void *)NULL;
+}
+
+
+void *
+ilstc_next (ilstc_t *lst, void *obj) {
+	caf_ilink_t *l;
+	if (lst != (ilstc_t *)NULL && obj != (void *)NULL) {
+		l = CAF_ILINK_OF(lst, obj)->next;
+		/* the sentinel is not an object, the circle goes on past it */
+		if (l == &(lst->ring)) {
+			l = l->next;
+		}
+		return CAF_ILINK_OBJ(lst, l);
+	}
+	return (void *)NULL;
+}
+
+
+int
+ilstc_map (ilstc_t *lst, CAF_CAF_DEQUENODE_CBMAP(step)) {
+	caf_ilink_t *l;
+	int c = 0;
+	if (lst != (ilstc_t *)NULL) {
+		for (l = lst->ring.next; l != &(lst->ring); l = l->next) {
+			step (CAF_ILINK_OBJ(lst, l));
+			c++;
+		}
+	}
+	return c;
+}
+
+
+void *
+ilstc_search (ilstc_t *lst, void *data, CAF_CAF_DEQUENODE_CBSRCH(srch)) {
+	caf_ilink_t *l;
+	if (lst != (ilstc_t *)NULL) {
+		for (l = lst->ring.next; l != &(lst->ring); l = l->next) {
+			if ((srch (CAF_ILINK_OBJ(lst, l), data)) == CAF_OK) {
+				return CAF_ILINK_OBJ(lst, l);
+			}
+		}
+	}
+	return (void *)NULL;
+}
+
+/* caf_data_ilist.c ends here */
@@ -36,10 +36,24 @@ static char Id[] = "$Id$";
 #include "caf/caf_data_mem.h"
 #include "caf/caf_data_lstc.h"
 
+static lstcn_t *lstc_node_new (void);
+static int lstc_slab_claim (caf_slab_t *slab);
+
+static caf_slab_t *lstc_slab = (caf_slab_t *)NULL;
+
+/** Claimed by the first xmalloc() node, no slab can be set afterwards */
+#define LSTC_SLAB_NONE          ((caf_slab_t *)&lstc_slab)
+
+#ifdef __GNUC__
+#define LSTC_SLAB_LOAD()        __atomic_load_n (&lstc_slab, __ATOMIC_ACQUIRE)
+#else /* !__GNUC__ */
+#define LSTC_SLAB_LOAD()        (lstc_slab)
+#endif /* !__GNUC__ */
+
 
 lstcn_t *
 lstc_new (void *data) {
-	lstcn_t *node = (lstcn_t *)xmalloc (CAF_LSTC_SZ);
+	lstcn_t *node = lstc_node_new ();
 	if (node != (lstcn_t *)NULL) {
 		node->data = data;
 		node->next = node;
@@ -51,7 +65,7 @@ lstc_new (void *data) {
 
 lstcn_t *
 lstc_create () {
-	lstcn_t *node = (lstcn_t *)xmalloc (CAF_LSTC_SZ);
+	lstcn_t *node = lstc_node_new ();
 	if (node != (lstcn_t *)NULL) {
 		node->data = (void *)NULL;
 		node->next = (lstcn_t *)NULL;
@@ -70,7 +84,7 @@ lstc_delete (lstcn_t *lst, CAF_LSTCNODE_CBDEL(del)) {
 			if ((del (current->data)) == CAF_OK) {
 				xtodel = current;
 				current = current->next;
-				xfree(xtodel);
+				lstc_node_free (xtodel);
 			} else {
 				lst = current;
 				return CAF_ERROR;
@@ -82,6 +96,31 @@ lstc_delete (lstcn_t *lst, CAF_LSTCNODE_CBDEL(del)) {
 }
 
 
+int
+lstc_slab_set (caf_slab_t *slab) {
+	/* nodes of both origins would be mixed up on release */
+	if (slab != (caf_slab_t *)NULL && lstc_slab_claim (slab)) {
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+lstc_node_free (lstcn_t *n) {
+	caf_slab_t *slab;
+	if (n != (lstcn_t *)NULL) {
+		slab = LSTC_SLAB_LOAD();
+		if (slab != (caf_slab_t *)NULL && slab != LSTC_SLAB_NONE) {
+			return caf_slab_free (slab, n);
+		}
+		xfree (n);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
 int
 lstc_node_delete (lstcn_t *lst, lstcn_t *n, CAF_LSTCNODE_CBDEL(del)) {
 	lstcn_t *nr;
@@ -95,7 +134,7 @@ lstc_node_delete (lstcn_t *lst, lstcn_t *n, CAF_LSTCNODE_CBDEL(del)) {
 			next->prev = prev;
 			prev->next = next;
 			if ((del (nr->data)) == CAF_OK) {
-				xfree (nr);
+				lstc_node_free (nr);
 				return CAF_OK;
 			} else {
 				nr->next = next;
@@ -125,7 +164,7 @@ lstc_node_delete_by_data (lstcn_t *lst, void *data, CAF_LSTCNODE_CBDEL(del)) {
 				next->prev = prev;
 				prev->next = next;
 				if ((del (nr->data) == CAF_OK)) {
-					xfree (nr);
+					lstc_node_free (nr);
 					return CAF_OK;
 				} else {
 					nr->next = next;
@@ -188,7 +227,7 @@ lstc_push (lstcn_t *lst, void *data) {
 			lst->prev = lst;
 			lst->data = data;
 		} else {
-			xnew = (lstcn_t *)xmalloc (CAF_LSTC_SZ);
+			xnew = lstc_node_new ();
 			if (xnew != (lstcn_t *)NULL) {
 				last = lst->prev;
 				last->next = xnew;
@@ -252,7 +291,7 @@ lstc_insert (lstcn_t *lst, int pos, void *data) {
 	if (lst != (lstcn_t *)NULL) {
 		do {
 			if (pos == c) {
-				nn = (lstcn_t *)xmalloc (CAF_LSTC_SZ);
+				nn = lstc_node_new ();
 				nn->prev = pn->prev;
 				nn->next = pn;
 				pn->prev = nn;
@@ -411,5 +450,37 @@ lstc_dump_str_cb (FILE *o, void *data) {
 	               (char *)data);
 }
 
+
+static lstcn_t *
+lstc_node_new (void) {
+	caf_slab_t *slab = LSTC_SLAB_LOAD();
+	if (slab == (caf_slab_t *)NULL) {
+		/* the first node settles the node origin for the process */
+		lstc_slab_claim (LSTC_SLAB_NONE);
+		slab = LSTC_SLAB_LOAD();
+	}
+	if (slab != LSTC_SLAB_NONE) {
+		return (lstcn_t *)caf_slab_alloc (slab);
+	}
+	return (lstcn_t *)xmalloc (CAF_LSTC_SZ);
+}
+
+
+static int
+lstc_slab_claim (caf_slab_t *slab) {
+#ifdef __GNUC__
+	caf_slab_t *unset = (caf_slab_t *)NULL;
+	/* the slab is ready before other threads can see it */
+	return __atomic_compare_exchange_n (&lstc_slab, &unset, slab, 0,
+	                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else /* !__GNUC__ */
+	if (lstc_slab == (caf_slab_t *)NULL) {
+		lstc_slab = slab;
+		return 1;
+	}
+	return 0;
+#endif /* !__GNUC__ */
+}
+
 /* caf_data_lstc.c ends here */
 
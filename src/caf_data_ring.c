@@ -0,0 +1,278 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_ring.h"
+
+
+#ifdef __GNUC__
+#define CAF_RING_ACQUIRE(p)     __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define CAF_RING_RELEASE(p, v)  __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#else /* !__GNUC__ */
+#define CAF_RING_ACQUIRE(p)     (*(volatile size_t *)(p))
+#define CAF_RING_RELEASE(p, v)  (*(volatile size_t *)(p) = (v))
+#endif /* !__GNUC__ */
+
+static size_t caf_ring_space (caf_ring_t *r, const size_t cnt);
+static size_t caf_ring_avail (caf_ring_t *r, const size_t cnt);
+static void caf_ring_copy_in (caf_ring_t *r, const size_t idx,
+                              const char *src, const size_t cnt);
+static void caf_ring_copy_out (caf_ring_t *r, const size_t idx,
+                               char *dst, const size_t cnt);
+
+
+caf_ring_t *
+caf_ring_new (const size_t cnt) {
+	return caf_ring_new_rec (cnt, sizeof (void *));
+}
+
+
+caf_ring_t *
+caf_ring_new_rec (const size_t cnt, const size_t rec_sz) {
+	caf_ring_t *r = (caf_ring_t *)NULL;
+	size_t cap = CAF_RING_MIN;
+	if (cnt > 0 && rec_sz > 0) {
+		while (cap < cnt) {
+			cap <<= 1;
+		}
+		r = (caf_ring_t *)xmalloc (CAF_RING_SZ);
+		if (r != (caf_ring_t *)NULL) {
+			r->slots = (char *)xmalloc (cap * rec_sz);
+			if (r->slots == (char *)NULL) {
+				xfree (r);
+				return (caf_ring_t *)NULL;
+			}
+			r->head = 0;
+			r->tail_cache = 0;
+			r->tail = 0;
+			r->head_cache = 0;
+			r->mask = cap - 1;
+			r->rec_sz = rec_sz;
+		}
+	}
+	return r;
+}
+
+
+int
+caf_ring_delete (caf_ring_t *r) {
+	if (r != (caf_ring_t *)NULL) {
+		xfree (r->slots);
+		xfree (r);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_ring_push (caf_ring_t *r, void *data) {
+	if (r != (caf_ring_t *)NULL && r->rec_sz == sizeof (void *)) {
+		if (caf_ring_space (r, 1) == 1) {
+			((void **)r->slots)[r->tail & r->mask] = data;
+			CAF_RING_RELEASE(&(r->tail), r->tail + 1);
+			return CAF_OK;
+		}
+	}
+	return CAF_ERROR;
+}
+
+
+void *
+caf_ring_pop (caf_ring_t *r) {
+	void *data = (void *)NULL;
+	if (r != (caf_ring_t *)NULL && r->rec_sz == sizeof (void *)) {
+		if (caf_ring_avail (r, 1) == 1) {
+			data = ((void **)r->slots)[r->head & r->mask];
+			CAF_RING_RELEASE(&(r->head), r->head + 1);
+		}
+	}
+	return data;
+}
+
+
+size_t
+caf_ring_push_batch (caf_ring_t *r, void **data, const size_t cnt) {
+	if (r != (caf_ring_t *)NULL && r->rec_sz == sizeof (void *)) {
+		return caf_ring_write_batch (r, data, cnt);
+	}
+	return 0;
+}
+
+
+size_t
+caf_ring_pop_batch (caf_ring_t *r, void **data, const size_t cnt) {
+	if (r != (caf_ring_t *)NULL && r->rec_sz == sizeof (void *)) {
+		return caf_ring_read_batch (r, data, cnt);
+	}
+	return 0;
+}
+
+
+int
+caf_ring_write (caf_ring_t *r, const void *rec) {
+	return caf_ring_write_batch (r, rec, 1) == 1 ? CAF_OK : CAF_ERROR;
+}
+
+
+int
+caf_ring_read (caf_ring_t *r, void *rec) {
+	return caf_ring_read_batch (r, rec, 1) == 1 ? CAF_OK : CAF_ERROR;
+}
+
+
+size_t
+caf_ring_write_batch (caf_ring_t *r, const void *recs, const size_t cnt) {
+	size_t n = 0;
+	if (r != (caf_ring_t *)NULL && recs != (void *)NULL && cnt > 0) {
+		n = caf_ring_space (r, cnt);
+		if (n > 0) {
+			caf_ring_copy_in (r, r->tail, (const char *)recs, n);
+			/* publishes the records together with the new index */
+			CAF_RING_RELEASE(&(r->tail), r->tail + n);
+		}
+	}
+	return n;
+}
+
+
+size_t
+caf_ring_read_batch (caf_ring_t *r, void *recs, const size_t cnt) {
+	size_t n = 0;
+	if (r != (caf_ring_t *)NULL && recs != (void *)NULL && cnt > 0) {
+		n = caf_ring_avail (r, cnt);
+		if (n > 0) {
+			caf_ring_copy_out (r, r->head, (char *)recs, n);
+			/* hands the slots back to the producer */
+			CAF_RING_RELEASE(&(r->head), r->head + n);
+		}
+	}
+	return n;
+}
+
+
+size_t
+caf_ring_length (caf_ring_t *r) {
+	size_t head, tail;
+	if (r != (caf_ring_t *)NULL) {
+		head = CAF_RING_ACQUIRE(&(r->head));
+		tail = CAF_RING_ACQUIRE(&(r->tail));
+		/* another thread may see the head move past its tail snapshot */
+		return tail - head <= r->mask + 1 ? tail - head : 0;
+	}
+	return 0;
+}
+
+
+size_t
+caf_ring_capacity (caf_ring_t *r) {
+	if (r != (caf_ring_t *)NULL) {
+		return r->mask + 1;
+	}
+	return 0;
+}
+
+
+void
+caf_ring_dump (FILE *out, caf_ring_t *r) {
+	if (out != (FILE *)NULL && r != (caf_ring_t *)NULL) {
+		fprintf (out, "ring %p: capacity %lu, record %lu bytes\n",
+		         (void *)r, (unsigned long)(r->mask + 1),
+		         (unsigned long)r->rec_sz);
+		fprintf (out, "ring %p: head %lu, tail %lu, length %lu\n",
+		         (void *)r, (unsigned long)r->head,
+		         (unsigned long)r->tail,
+		         (unsigned long)caf_ring_length (r));
+	}
+}
+
+
+static size_t
+caf_ring_space (caf_ring_t *r, const size_t cnt) {
+	size_t cap = r->mask + 1;
+	size_t free_sz = cap - (r->tail - r->head_cache);
+	if (free_sz < cnt) {
+		/* only touches the consumer line when the cache says full */
+		r->head_cache = CAF_RING_ACQUIRE(&(r->head));
+		free_sz = cap - (r->tail - r->head_cache);
+	}
+	return free_sz < cnt ? free_sz : cnt;
+}
+
+
+static size_t
+caf_ring_avail (caf_ring_t *r, const size_t cnt) {
+	size_t avail = r->tail_cache - r->head;
+	if (avail < cnt) {
+		/* only touches the producer line when the cache says empty */
+		r->tail_cache = CAF_RING_ACQUIRE(&(r->tail));
+		avail = r->tail_cache - r->head;
+	}
+	return avail < cnt ? avail : cnt;
+}
+
+
+static void
+caf_ring_copy_in (caf_ring_t *r, const size_t idx, const char *src,
+                  const size_t cnt) {
+	size_t pos = idx & r->mask;
+	size_t first = r->mask + 1 - pos;
+	if (first > cnt) {
+		first = cnt;
+	}
+	memcpy (r->slots + pos * r->rec_sz, src, first * r->rec_sz);
+	if (cnt > first) {
+		memcpy (r->slots, src + first * r->rec_sz,
+		        (cnt - first) * r->rec_sz);
+	}
+}
+
+
+static void
+caf_ring_copy_out (caf_ring_t *r, const size_t idx, char *dst,
+                   const size_t cnt) {
+	size_t pos = idx & r->mask;
+	size_t first = r->mask + 1 - pos;
+	if (first > cnt) {
+		first = cnt;
+	}
+	memcpy (dst, r->slots + pos * r->rec_sz, first * r->rec_sz);
+	if (cnt > first) {
+		memcpy (dst + first * r->rec_sz, r->slots,
+		        (cnt - first) * r->rec_sz);
+	}
+}
+
+/* caf_data_ring.c ends here */
@@ -0,0 +1,190 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_slab.h"
+
+
+#ifdef __GNUC__
+/** Spins on a held lock before giving the CPU away */
+#define CAF_SLAB_SPINS          64
+#if defined(__i386__) || defined(__x86_64__)
+#define CAF_SLAB_PAUSE()        __builtin_ia32_pause ()
+#else /* !(__i386__ || __x86_64__) */
+#define CAF_SLAB_PAUSE()        ((void)0)
+#endif /* !(__i386__ || __x86_64__) */
+#define CAF_SLAB_LOCK(s)        if ((s)->locked) { \
+		caf_slab_spin (s); \
+	}
+#define CAF_SLAB_UNLOCK(s)      if ((s)->locked) { \
+		__atomic_clear (&((s)->lock), __ATOMIC_RELEASE); \
+	}
+#else /* !__GNUC__ */
+#define CAF_SLAB_LOCK(s)        ((void)(s))
+#define CAF_SLAB_UNLOCK(s)      ((void)(s))
+#endif /* !__GNUC__ */
+
+
+#ifdef __GNUC__
+static void
+caf_slab_spin (caf_slab_t *s) {
+	int spins = 0;
+	while (__atomic_test_and_set (&(s->lock), __ATOMIC_ACQUIRE)) {
+		/* wait on plain loads, each exchange takes the line exclusive */
+		while (__atomic_load_n (&(s->lock), __ATOMIC_RELAXED)) {
+			if (++spins < CAF_SLAB_SPINS) {
+				CAF_SLAB_PAUSE();
+			} else {
+				spins = 0;
+				sched_yield ();
+			}
+		}
+	}
+}
+#endif /* !__GNUC__ */
+
+
+caf_slab_t *
+caf_slab_new (const size_t obj_sz, const size_t per_chunk, const int locked) {
+	caf_slab_t *r = (caf_slab_t *)NULL;
+#ifndef __GNUC__
+	/* there is no spin lock to share the slab with */
+	if (locked) {
+		return r;
+	}
+#endif /* !__GNUC__ */
+	if (obj_sz > 0) {
+		r = (caf_slab_t *)xmalloc (CAF_SLAB_SZ);
+		if (r != (caf_slab_t *)NULL) {
+			/* free objects keep the free list link in their first word */
+			r->obj_sz = (obj_sz + sizeof (void *) - 1) &
+				~(sizeof (void *) - 1);
+			r->per_chunk = per_chunk > 0 ? per_chunk : CAF_SLAB_CHUNK;
+			r->free_list = (void *)NULL;
+			r->chunks = (void *)NULL;
+			r->left = 0;
+			r->chunk_count = 0;
+			r->locked = locked;
+			r->lock = 0;
+			r->hits = 0;
+			r->misses = 0;
+			r->frees = 0;
+		}
+	}
+	return r;
+}
+
+
+int
+caf_slab_delete (caf_slab_t *slab) {
+	void *chunk, *next;
+	if (slab != (caf_slab_t *)NULL) {
+		chunk = slab->chunks;
+		while (chunk != (void *)NULL) {
+			next = *(void **)chunk;
+			xfree (chunk);
+			chunk = next;
+		}
+		xfree (slab);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void *
+caf_slab_alloc (caf_slab_t *slab) {
+	void *r = (void *)NULL, *chunk;
+	if (slab == (caf_slab_t *)NULL) {
+		return r;
+	}
+	CAF_SLAB_LOCK(slab);
+	if (slab->free_list != (void *)NULL) {
+		r = slab->free_list;
+		slab->free_list = *(void **)r;
+		slab->hits++;
+	} else {
+		if (slab->left == 0) {
+			/* the first word of a chunk links it to the previous one */
+			chunk = xmalloc (sizeof (void *) +
+			                 slab->per_chunk * slab->obj_sz);
+			if (chunk != (void *)NULL) {
+				*(void **)chunk = slab->chunks;
+				slab->chunks = chunk;
+				slab->left = slab->per_chunk;
+				slab->chunk_count++;
+			}
+		}
+		if (slab->left > 0) {
+			/* objects are carved from the end of the newest chunk */
+			slab->left--;
+			r = (char *)slab->chunks + sizeof (void *) +
+				slab->left * slab->obj_sz;
+			slab->misses++;
+		}
+	}
+	CAF_SLAB_UNLOCK(slab);
+	return r;
+}
+
+
+int
+caf_slab_free (caf_slab_t *slab, void *ptr) {
+	if (slab != (caf_slab_t *)NULL && ptr != (void *)NULL) {
+		CAF_SLAB_LOCK(slab);
+		*(void **)ptr = slab->free_list;
+		slab->free_list = ptr;
+		slab->frees++;
+		CAF_SLAB_UNLOCK(slab);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void
+caf_slab_dump (FILE *out, caf_slab_t *slab) {
+	if (slab != (caf_slab_t *)NULL && out != (FILE *)NULL) {
+		fprintf (out, "[%p] Slab: %lu bytes objects, %lu chunks of %lu\n",
+		         (void *)slab, (unsigned long)slab->obj_sz,
+		         (unsigned long)slab->chunk_count,
+		         (unsigned long)slab->per_chunk);
+		fprintf (out, "     hits: %lu; misses: %lu; frees: %lu\n",
+		         slab->hits, slab->misses, slab->frees);
+	}
+}
+
+/* caf_data_slab.c ends here */
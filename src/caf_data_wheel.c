@@ -0,0 +1,341 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_wheel.h"
+
+
+/** Slot index mask */
+#define CAF_WHEEL_MASK          ((unsigned long long)CAF_WHEEL_SLOTS - 1)
+/** Largest distance the wheel holds, in ticks */
+#define CAF_WHEEL_SPAN          ((1ULL << (CAF_WHEEL_BITS              \
+                                           * CAF_WHEEL_LEVELS)) - 1)
+/** Level marking a timer detached to be fired */
+#define CAF_WHEEL_FIRING        CAF_WHEEL_LEVELS
+
+static unsigned long long caf_wheel_clock (caf_wheel_t *w);
+static void caf_wheel_link (caf_wheel_t *w, caf_wheel_timer_t *t);
+static void caf_wheel_unlink (caf_wheel_t *w, caf_wheel_timer_t *t);
+static void caf_wheel_cascade (caf_wheel_t *w, int level);
+static int caf_wheel_fire (caf_wheel_t *w);
+static int caf_wheel_due (caf_wheel_t *w, unsigned long long *tick);
+
+
+caf_wheel_t *
+caf_wheel_new (const long tick_ns) {
+	caf_wheel_t *w = (caf_wheel_t *)NULL;
+	w = (caf_wheel_t *)xmalloc (CAF_WHEEL_SZ);
+	if (w != (caf_wheel_t *)NULL) {
+		memset ((void *)w, 0, CAF_WHEEL_SZ);
+		w->tick_ns = tick_ns > 0 ? tick_ns : CAF_WHEEL_TICK;
+		clock_gettime (CLOCK_MONOTONIC, &(w->origin));
+	}
+	return w;
+}
+
+
+int
+caf_wheel_delete (caf_wheel_t *w) {
+	caf_wheel_timer_t *t;
+	int l, s;
+	if (w == (caf_wheel_t *)NULL) {
+		return CAF_ERROR;
+	}
+	for (l = 0; l < CAF_WHEEL_LEVELS; l++) {
+		for (s = 0; s < CAF_WHEEL_SLOTS; s++) {
+			for (t = w->slots[l][s]; t != (caf_wheel_timer_t *)NULL;
+				 t = t->next) {
+				t->pprev = (caf_wheel_timer_t **)NULL;
+			}
+		}
+	}
+	xfree (w);
+	return CAF_OK;
+}
+
+
+void
+caf_wheel_timer_init (caf_wheel_timer_t *t, CAF_WHEEL_RTN(rtn), void *arg) {
+	if (t != (caf_wheel_timer_t *)NULL) {
+		t->next = (caf_wheel_timer_t *)NULL;
+		t->pprev = (caf_wheel_timer_t **)NULL;
+		t->expires = 0;
+		t->level = 0;
+		t->slot = 0;
+		t->rtn = rtn;
+		t->arg = arg;
+	}
+}
+
+
+int
+caf_wheel_add (caf_wheel_t *w, caf_wheel_timer_t *t,
+               const struct timespec *tm) {
+	unsigned long long ns;
+	if (w == (caf_wheel_t *)NULL || t == (caf_wheel_timer_t *)NULL
+		|| tm == (const struct timespec *)NULL || tm->tv_sec < 0
+		|| tm->tv_nsec < 0 || t->rtn == NULL) {
+		return CAF_ERROR;
+	}
+	if (t->pprev != (caf_wheel_timer_t **)NULL) {
+		caf_wheel_unlink (w, t);
+	}
+	ns = (unsigned long long)tm->tv_sec * 1000000000ULL
+		+ (unsigned long long)tm->tv_nsec;
+	/* rounded up, a timer does not fire before its tick */
+	t->expires = caf_wheel_clock (w)
+		+ (ns + (unsigned long long)w->tick_ns - 1)
+		/ (unsigned long long)w->tick_ns;
+	caf_wheel_link (w, t);
+	return CAF_OK;
+}
+
+
+int
+caf_wheel_cancel (caf_wheel_t *w, caf_wheel_timer_t *t) {
+	if (w != (caf_wheel_t *)NULL && t != (caf_wheel_timer_t *)NULL
+		&& t->pprev != (caf_wheel_timer_t **)NULL) {
+		caf_wheel_unlink (w, t);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_wheel_pending (caf_wheel_timer_t *t) {
+	if (t != (caf_wheel_timer_t *)NULL
+		&& t->pprev != (caf_wheel_timer_t **)NULL) {
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_wheel_advance (caf_wheel_t *w) {
+	unsigned long long now, next;
+	int l, n = 0;
+	if (w == (caf_wheel_t *)NULL) {
+		return 0;
+	}
+	now = caf_wheel_clock (w);
+	while (w->tick <= now) {
+		/* jump over the ticks with nothing to fire or cascade */
+		if (caf_wheel_due (w, &next) != CAF_OK || next > now) {
+			w->tick = now + 1;
+			break;
+		}
+		w->tick = next;
+		for (l = 1; l < CAF_WHEEL_LEVELS
+				 && ((w->tick >> (CAF_WHEEL_BITS * (l - 1)))
+					 & CAF_WHEEL_MASK) == 0; l++) {
+			caf_wheel_cascade (w, l);
+		}
+		n += caf_wheel_fire (w);
+	}
+	return n;
+}
+
+
+int
+caf_wheel_next (caf_wheel_t *w, struct timespec *tm) {
+	struct timespec now;
+	unsigned long long next;
+	long long ns;
+	if (w == (caf_wheel_t *)NULL || tm == (struct timespec *)NULL
+		|| caf_wheel_due (w, &next) != CAF_OK) {
+		return CAF_ERROR;
+	}
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	ns = (long long)(next * (unsigned long long)w->tick_ns)
+		- ((long long)(now.tv_sec - w->origin.tv_sec) * 1000000000LL
+		   + (long long)(now.tv_nsec - w->origin.tv_nsec));
+	if (ns < 0) {
+		ns = 0;
+	}
+	tm->tv_sec = (time_t)(ns / 1000000000LL);
+	tm->tv_nsec = (long)(ns % 1000000000LL);
+	return CAF_OK;
+}
+
+
+void
+caf_wheel_dump (FILE *out, caf_wheel_t *w) {
+	if (w != (caf_wheel_t *)NULL && out != (FILE *)NULL) {
+		fprintf (out, "[%p] Wheel: %lu pending, tick %llu of %ld ns\n",
+		         (void *)w, (unsigned long)w->count, w->tick, w->tick_ns);
+		fprintf (out, "     fired: %lu; cascaded: %lu\n",
+		         w->fired, w->cascaded);
+	}
+}
+
+
+static unsigned long long
+caf_wheel_clock (caf_wheel_t *w) {
+	struct timespec now;
+	long long ns;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	ns = (long long)(now.tv_sec - w->origin.tv_sec) * 1000000000LL
+		+ (long long)(now.tv_nsec - w->origin.tv_nsec);
+	return (unsigned long long)(ns / w->tick_ns);
+}
+
+
+static void
+caf_wheel_link (caf_wheel_t *w, caf_wheel_timer_t *t) {
+	unsigned long long delta;
+	int l = 0;
+	if (t->expires < w->tick) {
+		/* already due, it fires on the next tick processed */
+		t->expires = w->tick;
+	}
+	delta = t->expires - w->tick;
+	if (delta > CAF_WHEEL_SPAN) {
+		delta = CAF_WHEEL_SPAN;
+		t->expires = w->tick + delta;
+	}
+	while (delta >> (CAF_WHEEL_BITS * (l + 1))) {
+		l++;
+	}
+	t->level = l;
+	t->slot = (int)((t->expires >> (CAF_WHEEL_BITS * l)) & CAF_WHEEL_MASK);
+	t->next = w->slots[l][t->slot];
+	if (t->next != (caf_wheel_timer_t *)NULL) {
+		t->next->pprev = &(t->next);
+	}
+	t->pprev = &(w->slots[l][t->slot]);
+	w->slots[l][t->slot] = t;
+	w->busy[l] |= 1ULL << t->slot;
+	w->count++;
+}
+
+
+static void
+caf_wheel_unlink (caf_wheel_t *w, caf_wheel_timer_t *t) {
+	*(t->pprev) = t->next;
+	if (t->next != (caf_wheel_timer_t *)NULL) {
+		t->next->pprev = t->pprev;
+	}
+	t->next = (caf_wheel_timer_t *)NULL;
+	t->pprev = (caf_wheel_timer_t **)NULL;
+	if (t->level != CAF_WHEEL_FIRING
+		&& w->slots[t->level][t->slot] == (caf_wheel_timer_t *)NULL) {
+		w->busy[t->level] &= ~(1ULL << t->slot);
+	}
+	w->count--;
+}
+
+
+static void
+caf_wheel_cascade (caf_wheel_t *w, int level) {
+	caf_wheel_timer_t *t, *next;
+	int s = (int)((w->tick >> (CAF_WHEEL_BITS * level)) & CAF_WHEEL_MASK);
+	t = w->slots[level][s];
+	w->slots[level][s] = (caf_wheel_timer_t *)NULL;
+	w->busy[level] &= ~(1ULL << s);
+	while (t != (caf_wheel_timer_t *)NULL) {
+		next = t->next;
+		w->count--;
+		caf_wheel_link (w, t);
+		w->cascaded++;
+		t = next;
+	}
+}
+
+
+static int
+caf_wheel_fire (caf_wheel_t *w) {
+	caf_wheel_timer_t *work, *t;
+	int s = (int)(w->tick & CAF_WHEEL_MASK), n = 0;
+	/*
+	 * The slot is detached and the tick is done before the callbacks
+	 * run, so a timer armed again for now lands on the next tick, not
+	 * a whole revolution later in the slot being fired.
+	 */
+	work = w->slots[0][s];
+	w->slots[0][s] = (caf_wheel_timer_t *)NULL;
+	w->busy[0] &= ~(1ULL << s);
+	w->tick++;
+	if (work != (caf_wheel_timer_t *)NULL) {
+		work->pprev = &work;
+	}
+	for (t = work; t != (caf_wheel_timer_t *)NULL; t = t->next) {
+		t->level = CAF_WHEEL_FIRING;
+	}
+	while (work != (caf_wheel_timer_t *)NULL) {
+		t = work;
+		caf_wheel_unlink (w, t);
+		w->fired++;
+		n++;
+		t->rtn (t, t->arg);
+	}
+	return n;
+}
+
+
+static int
+caf_wheel_due (caf_wheel_t *w, unsigned long long *tick) {
+	unsigned long long cur, cand, busy, best = ~0ULL;
+	int l, shift, start;
+	if (w->count == 0) {
+		return CAF_ERROR;
+	}
+	for (l = 0; l < CAF_WHEEL_LEVELS; l++) {
+		if (w->busy[l] == 0) {
+			continue;
+		}
+		/*
+		 * A slot of an upper level is due when it is cascaded, at the
+		 * first tick aligned to the level that maps to it.
+		 */
+		shift = CAF_WHEEL_BITS * l;
+		cur = (w->tick + (1ULL << shift) - 1) >> shift;
+		start = (int)(cur & CAF_WHEEL_MASK);
+		busy = w->busy[l];
+		if (start > 0) {
+			busy = (busy >> start) | (busy << (CAF_WHEEL_SLOTS - start));
+		}
+		cand = (cur + (unsigned long long)__builtin_ctzll (busy)) << shift;
+		if (cand < best) {
+			best = cand;
+		}
+	}
+	*tick = best;
+	return CAF_OK;
+}
+
+/* caf_data_wheel.c ends here */
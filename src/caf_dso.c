@@ -127,12 +127,27 @@ caf_dso_sym (caf_dso_t *dso, const char *name) {
 void *
 caf_dso_dlsym (caf_dso_t *dso, const char *name) {
 	void *r = (void *)NULL;
-	if (dso != (caf_dso_t *)NULL && name != (const char *)NULL) {
+	caf_hash_table_t *symt;
+	size_t sz;
+	u_int32_t h1, h2;
+	if (dso != (caf_dso_t *)NULL && name != (const char *)NULL &&
+		dso->table != (caf_dso_table_t *)NULL &&
+		dso->table->symt != (caf_hash_table_t *)NULL) {
+		symt = dso->table->symt;
+		sz = strlen (name) + 1;
+		/* the name is hashed once, for the lookup and the update */
+		if (caf_hash_table_hash (symt, (const void *)name, sz, &h1, &h2)
+			!= CAF_OK) {
+			return r;
+		}
+		r = caf_hash_table_get_hashed (symt, (const void *)name, sz, h1, h2);
+		if (r != (void *)NULL) {
+			return r;
+		}
 		r = dlsym (dso->handle, name);
 		if (r != (void *)NULL) {
-			if ((caf_hash_table_set (dso->table->symt, (const void *)name,
-									 (const size_t)(strlen (name) + 1),
-									 r))
+			if ((caf_hash_table_set_hashed (symt, (const void *)name, sz, r,
+			                                h1, h2))
 				!= CAF_OK) {
 				r = (void *)NULL;
 			}
@@ -31,7 +31,10 @@ static char Id[] = "$Id$";
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
 
 #include <unistd.h>
 
@@ -46,39 +49,45 @@ static char Id[] = "$Id$";
 #include "caf/caf_evt_nio.h"
 #include "caf/caf_evt_nio_pool.h"
 
+static int io_evt_pool_epoll_timeout (io_evt_pool_epoll_t *e);
+static int io_evt_pool_epoll_slot (io_evt_pool_epoll_t *e, int fd);
+static int io_evt_pool_epoll_grow (io_evt_pool_epoll_t *e, int fd);
+static struct epoll_event *io_evt_pool_epoll_event (io_evt_pool_epoll_t *e,
+                                                    int fd);
+
 
 io_evt_pool_epoll_t *
 io_evt_pool_epoll_new (int cnt, int tos, int ton) {
 	io_evt_pool_epoll_t *r = (io_evt_pool_epoll_t *)NULL;
+	int i;
 	if (cnt > 0) {
-		r = (io_evt_pool_epoll_t *)xmalloc (IO_EVENT_DATA_POOL_POLL_SZ);
+		r = (io_evt_pool_epoll_t *)xmalloc (IO_EVENT_DATA_POOL_EPOLL_SZ);
 		if (r != (io_evt_pool_epoll_t *)NULL) {
-			memset ((void *)r, 0, IO_EVENT_DATA_POOL_POLL_SZ);
+			memset ((void *)r, 0, IO_EVENT_DATA_POOL_EPOLL_SZ);
 			r->epoll_count = cnt;
 			r->epoll_sz = (size_t)cnt * IO_EVENT_DATA_EPOLLS_SZ;
 			r->epoll = (struct epoll_event *)xmalloc (r->epoll_sz);
 			r->repoll = (struct epoll_event *)xmalloc (r->epoll_sz);
+			r->slots = (io_evt_pool_epoll_slot_t *)
+				xmalloc ((size_t)cnt * IO_EVENT_DATA_EPOLL_SLOTS_SZ);
+			r->free_slots = (int *)xmalloc ((size_t)cnt * sizeof(int));
+			r->efd = epoll_create (r->epoll_count);
+			r->wheel = caf_wheel_new (0);
 			if (r->epoll != (struct epoll_event *)NULL &&
-				r->repoll != (struct epoll_event *)NULL) {
+				r->repoll != (struct epoll_event *)NULL &&
+				r->slots != (io_evt_pool_epoll_slot_t *)NULL &&
+				r->free_slots != (int *)NULL && r->efd >= 0 &&
+				r->wheel != (caf_wheel_t *)NULL) {
 				memset ((void *)r->epoll, 0, r->epoll_sz);
 				memset ((void *)r->repoll, 0, r->epoll_sz);
-				r->efd = epoll_create (r->epoll_count);
-				if (r->efd >= 0) {
-					caf_io_evt_pool_reset (r);
-					r->timeout.tv_sec = tos;
-					r->timeout.tv_nsec = ton;
-				} else {
-					xfree (r);
-					r = (io_evt_pool_epoll_t *)NULL;
+				for (i = 0; i < cnt; i++) {
+					r->slots[i].fd = -1;
 				}
+				caf_io_evt_pool_reset (r);
+				r->timeout.tv_sec = tos;
+				r->timeout.tv_nsec = ton;
 			} else {
-				if (r->epoll != (struct epoll_event *)NULL) {
-					xfree (r->epoll);
-				}
-				if (r->repoll != (struct epoll_event *)NULL) {
-					xfree (r->repoll);
-				}
-				xfree (r);
+				caf_io_evt_pool_delete (r);
 				r = (io_evt_pool_epoll_t *)NULL;
 			}
 		}
@@ -99,6 +108,12 @@ io_evt_pool_epoll_delete (io_evt_pool_epoll_t *r) {
 		if (r->repoll != (struct epoll_event *)NULL) {
 			xfree (r->repoll);
 		}
+		xfree (r->slots);
+		xfree (r->free_slots);
+		xfree (r->fdmap);
+		if (r->wheel != (caf_wheel_t *)NULL) {
+			caf_wheel_delete (r->wheel);
+		}
 		xfree (r);
 		return CAF_OK;
 	}
@@ -111,10 +126,23 @@ io_evt_pool_epoll_reset (io_evt_pool_epoll_t *e) {
 	int i;
 	if (e != (io_evt_pool_epoll_t *)NULL) {
 		if (e->epoll != (struct epoll_event *)NULL) {
-			for (i = 0; i < e->epoll_count; i++) {
+			for (i = e->epoll_count - 1; i >= 0; i--) {
+				if (e->slots[i].fd >= 0) {
+					epoll_ctl (e->efd, EPOLL_CTL_DEL, e->slots[i].fd,
+					           &(e->epoll[i]));
+					e->fdmap[e->slots[i].fd] = -1;
+				}
 				e->epoll[i].events = 0;
-				e->epoll[i].data.fd = -1;
+				e->epoll[i].data.u64 = (uint64_t)i;
+				e->slots[i].fd = -1;
+				e->slots[i].gen = 0;
+				e->slots[i].data = (void *)NULL;
+				/* slot zero on top, slots fill up in order */
+				e->free_slots[e->epoll_count - 1 - i] = i;
 			}
+			e->free_count = e->epoll_count;
+			e->ready = 0;
+			e->gen = 1;
 			return CAF_OK;
 		}
 	}
@@ -124,27 +152,32 @@ io_evt_pool_epoll_reset (io_evt_pool_epoll_t *e) {
 
 int
 io_evt_pool_epoll_add (int fd, io_evt_pool_epoll_t *e, int ef) {
-	int i, r = -1;
-	if (e != (io_evt_pool_epoll_t *)NULL) {
-		if (e->epoll != (struct epoll_event *)NULL) {
-			for (i = 0; i < e->epoll_count; i++) {
-				if (e->epoll[i].data.fd == -1) {
-					r = i;
-					i = e->epoll_count;
-				}
-			}
-			if (r >= 0) {
-				e->epoll[r].data.fd = fd;
-				e->epoll[r].events = ef;
-				if ((epoll_ctl (e->efd, EPOLL_CTL_ADD, fd, &(e->epoll[r]))) <
-					0) {
-					e->epoll[r].data.fd = -1;
-					e->epoll[r].events = 0;
-					return CAF_ERROR;
-				} else {
-					return CAF_OK;
-				}
+	return io_evt_pool_epoll_add_data (fd, e, ef, (void *)NULL);
+}
+
+
+int
+io_evt_pool_epoll_add_data (int fd, io_evt_pool_epoll_t *e, int ef,
+                            void *data) {
+	int r;
+	if (e != (io_evt_pool_epoll_t *)NULL && fd >= 0) {
+		if (e->epoll != (struct epoll_event *)NULL && e->free_count > 0
+			&& io_evt_pool_epoll_slot (e, fd) < 0
+			&& io_evt_pool_epoll_grow (e, fd) == CAF_OK) {
+			r = e->free_slots[e->free_count - 1];
+			e->epoll[r].data.u64 = (uint64_t)r;
+			e->epoll[r].events = ef;
+			if ((epoll_ctl (e->efd, EPOLL_CTL_ADD, fd, &(e->epoll[r]))) <
+				0) {
+				e->epoll[r].events = 0;
+				return CAF_ERROR;
 			}
+			e->free_count--;
+			e->slots[r].fd = fd;
+			e->slots[r].gen = 0;
+			e->slots[r].data = data;
+			e->fdmap[fd] = r;
+			return CAF_OK;
 		}
 	}
 	return CAF_ERROR;
@@ -152,16 +185,46 @@ io_evt_pool_epoll_add (int fd, io_evt_pool_epoll_t *e, int ef) {
 
 
 int
-io_evt_pool_epoll_hasevent (int fd, io_evt_pool_epoll_t *e, int ef) {
-	int i;
-	if (e != (io_evt_pool_epoll_t *)NULL) {
-		if (e->epoll != (struct epoll_event *)NULL) {
-			for (i = 0; i < e->epoll_count; i++) {
-				if (fd == e->repoll[i].data.fd) {
-					return (e->repoll[i].events & ef) ? CAF_OK : CAF_ERROR;
-				}
-			}
+io_evt_pool_epoll_modify (int fd, io_evt_pool_epoll_t *e, int ef) {
+	int r, old;
+	if (e != (io_evt_pool_epoll_t *)NULL
+		&& (r = io_evt_pool_epoll_slot (e, fd)) >= 0) {
+		old = e->epoll[r].events;
+		e->epoll[r].events = ef;
+		if ((epoll_ctl (e->efd, EPOLL_CTL_MOD, fd, &(e->epoll[r]))) < 0) {
+			e->epoll[r].events = old;
+			return CAF_ERROR;
 		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+io_evt_pool_epoll_remove (int fd, io_evt_pool_epoll_t *e) {
+	int r;
+	if (e != (io_evt_pool_epoll_t *)NULL
+		&& (r = io_evt_pool_epoll_slot (e, fd)) >= 0) {
+		/* fails when fd was closed first, the kernel dropped it then */
+		epoll_ctl (e->efd, EPOLL_CTL_DEL, fd, &(e->epoll[r]));
+		e->epoll[r].events = 0;
+		e->slots[r].fd = -1;
+		e->slots[r].gen = 0;
+		e->slots[r].data = (void *)NULL;
+		e->fdmap[fd] = -1;
+		e->free_slots[e->free_count++] = r;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+io_evt_pool_epoll_hasevent (int fd, io_evt_pool_epoll_t *e, int ef) {
+	struct epoll_event *ev = io_evt_pool_epoll_event (e, fd);
+	if (ev != (struct epoll_event *)NULL) {
+		return (ev->events & ef) ? CAF_OK : CAF_ERROR;
 	}
 	return CAF_ERROR;
 }
@@ -169,15 +232,9 @@ io_evt_pool_epoll_hasevent (int fd, io_evt_pool_epoll_t *e, int ef) {
 
 int
 io_evt_pool_epoll_getevent (int fd, io_evt_pool_epoll_t *e) {
-	int i;
-	if (e != (io_evt_pool_epoll_t *)NULL) {
-		if (e->epoll != (struct epoll_event *)NULL) {
-			for (i = 0; i < e->epoll_count; i++) {
-				if (fd == e->repoll[i].data.fd) {
-					return e->repoll[i].events;
-				}
-			}
-		}
+	struct epoll_event *ev = io_evt_pool_epoll_event (e, fd);
+	if (ev != (struct epoll_event *)NULL) {
+		return ev->events;
 	}
 	return CAF_ERROR;
 }
@@ -185,18 +242,13 @@ io_evt_pool_epoll_getevent (int fd, io_evt_pool_epoll_t *e) {
 
 int
 io_evt_pool_epoll_etype (int fd, io_evt_pool_epoll_t *e) {
-	int i, r = 0;
+	struct epoll_event *ev = io_evt_pool_epoll_event (e, fd);
+	int r = 0;
 	int wre = POLLIN | POLLRDNORM | POLLRDBAND | POLLPRI;
 	int wwe = POLLOUT | POLLWRNORM | POLLWRBAND;
-	if (e != (io_evt_pool_epoll_t *)NULL) {
-		if (e->epoll != (struct epoll_event *)NULL) {
-			for (i = 0; i < e->epoll_count; i++) {
-				if (fd == e->repoll[i].data.fd) {
-					r |= (e->repoll[i].events & wre) ? EVT_IO_READ : 0;
-					r |= (e->repoll[i].events & wwe) ? EVT_IO_WRITE : 0;
-				}
-			}
-		}
+	if (ev != (struct epoll_event *)NULL) {
+		r |= (ev->events & wre) ? EVT_IO_READ : 0;
+		r |= (ev->events & wwe) ? EVT_IO_WRITE : 0;
 	}
 	return r;
 }
@@ -204,16 +256,123 @@ io_evt_pool_epoll_etype (int fd, io_evt_pool_epoll_t *e) {
 
 int
 io_evt_pool_epoll_handle (io_evt_pool_epoll_t *e) {
-	int n = 0;
+	int i, n = 0;
+	io_evt_pool_epoll_slot_t *s;
 	if (e != (io_evt_pool_epoll_t *)NULL) {
 		if (e->epoll != (struct epoll_event *)NULL) {
-			n = epoll_wait (e->efd, e->epoll, (nfds_t)e->epoll_count,
-			                e->timeout.tv_sec);
+			n = epoll_wait (e->efd, e->repoll, e->epoll_count,
+			                io_evt_pool_epoll_timeout (e));
+			e->ready = (n > 0) ? n : 0;
+			if (++e->gen == 0) {
+				e->gen = 1;
+			}
+			/* one pass over the ready events, the lookups are O(1) */
+			for (i = 0; i < e->ready; i++) {
+				s = &(e->slots[e->repoll[i].data.u64]);
+				s->gen = e->gen;
+				s->pos = i;
+			}
+			caf_wheel_advance (e->wheel);
 			return (n > 0) ? CAF_OK : CAF_ERROR;
 		}
 	}
 	return CAF_ERROR;
 }
 
-/* caf_evt_io_pool_poll.c ends here */
 
+int
+io_evt_pool_epoll_next (io_evt_pool_epoll_t *e, int *pos, int *fd,
+                        int *ev, void **data) {
+	io_evt_pool_epoll_slot_t *s;
+	int i;
+	if (e == (io_evt_pool_epoll_t *)NULL || pos == (int *)NULL) {
+		return CAF_ERROR;
+	}
+	while (*pos >= 0 && *pos < e->ready) {
+		i = (*pos)++;
+		s = &(e->slots[e->repoll[i].data.u64]);
+		/* removed, or removed and reused, since the handle call */
+		if (s->fd < 0 || s->gen != e->gen) {
+			continue;
+		}
+		if (fd != (int *)NULL) {
+			*fd = s->fd;
+		}
+		if (ev != (int *)NULL) {
+			*ev = (int)e->repoll[i].events;
+		}
+		if (data != (void **)NULL) {
+			*data = s->data;
+		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+static int
+io_evt_pool_epoll_timeout (io_evt_pool_epoll_t *e) {
+	struct timespec tm;
+	long long ms = -1, wms;
+	/* a negative pool timeout waits for events or timers only */
+	if (e->timeout.tv_sec >= 0) {
+		ms = (long long)e->timeout.tv_sec * 1000LL
+			+ (long long)e->timeout.tv_nsec / 1000000LL;
+	}
+	if (caf_wheel_next (e->wheel, &tm) == CAF_OK) {
+		/* rounded up, so the wait does not end just short of it */
+		wms = (long long)tm.tv_sec * 1000LL
+			+ ((long long)tm.tv_nsec + 999999LL) / 1000000LL;
+		if (ms < 0 || wms < ms) {
+			ms = wms;
+		}
+	}
+	return ms > INT_MAX ? INT_MAX : (int)ms;
+}
+
+
+
+static int
+io_evt_pool_epoll_slot (io_evt_pool_epoll_t *e, int fd) {
+	if (fd >= 0 && fd < e->fdmap_sz) {
+		return e->fdmap[fd];
+	}
+	return -1;
+}
+
+
+static int
+io_evt_pool_epoll_grow (io_evt_pool_epoll_t *e, int fd) {
+	int *map, sz, i;
+	if (fd < e->fdmap_sz) {
+		return CAF_OK;
+	}
+	sz = e->fdmap_sz > 0 ? e->fdmap_sz : 64;
+	while (sz <= fd) {
+		sz *= 2;
+	}
+	map = (int *)xrealloc (e->fdmap, (size_t)sz * sizeof(int));
+	if (map == (int *)NULL) {
+		return CAF_ERROR;
+	}
+	for (i = e->fdmap_sz; i < sz; i++) {
+		map[i] = -1;
+	}
+	e->fdmap = map;
+	e->fdmap_sz = sz;
+	return CAF_OK;
+}
+
+
+static struct epoll_event *
+io_evt_pool_epoll_event (io_evt_pool_epoll_t *e, int fd) {
+	int r;
+	if (e != (io_evt_pool_epoll_t *)NULL
+		&& (r = io_evt_pool_epoll_slot (e, fd)) >= 0
+		&& e->slots[r].gen == e->gen) {
+		return &(e->repoll[e->slots[r].pos]);
+	}
+	return (struct epoll_event *)NULL;
+}
+
+/* caf_evt_io_pool_poll.c ends here */
@@ -29,10 +29,39 @@ static char Id[] = "$Id$";
 #endif /* !HAVE_CONFIG_H */
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
 
 #include "caf/caf_hash_str.h"
 
+/** WY Hash secret */
+#define CAF_SHASH_WY0               0x2d358dccaa6c78a5ULL
+#define CAF_SHASH_WY1               0x8bb84b93962eacc9ULL
+#define CAF_SHASH_WY2               0x4b33a62ed433d4a3ULL
+#define CAF_SHASH_WY3               0x4d5a2da51de1aa47ULL
+
+/** XX Hash 64 bits primes */
+#define CAF_SHASH_XX1               11400714785074694791ULL
+#define CAF_SHASH_XX2               14029467366897019727ULL
+#define CAF_SHASH_XX3               1609587929392839161ULL
+#define CAF_SHASH_XX4               9650029242287828579ULL
+#define CAF_SHASH_XX5               2870177450012600261ULL
+
+/** Rotates a 64 bits word to the left */
+#define CAF_SHASH_ROTL64(x, r)      (((x) << (r)) | ((x) >> (64 - (r))))
+
+static u_int64_t caf_shash_seed = 0;
+
+static u_int64_t caf_shash_r8 (const unsigned char *p);
+static u_int64_t caf_shash_r4 (const unsigned char *p);
+static void caf_shash_mum (u_int64_t *a, u_int64_t *b);
+static u_int64_t caf_shash_mix (u_int64_t a, u_int64_t b);
+static u_int64_t caf_shash_xx_round (u_int64_t acc, const u_int64_t in);
+static u_int64_t caf_shash_xx_merge (u_int64_t acc, const u_int64_t v);
+
 u_int32_t
 caf_shash_rs (const char *str, const u_int len) {
 	/* Modified Robert Sedgwicks String Hash Algorithm */
@@ -399,5 +428,227 @@ caf_shash_fnv (const char* str, const u_int len) {
 	return 0;
 }
 
+u_int64_t
+caf_shash64_wy (const char *str, const size_t len, const u_int64_t seed) {
+	const unsigned char *p = (const unsigned char *)str;
+	u_int64_t a = 0, b = 0, s = seed, s1, s2;
+	size_t i = len;
+	if (p == (const unsigned char *)NULL) {
+		i = 0;
+	}
+	s ^= caf_shash_mix (s ^ CAF_SHASH_WY0, CAF_SHASH_WY1);
+	if (i <= 16) {
+		if (i >= 4) {
+			/* two overlapping pairs of words cover 4 to 16 bytes */
+			a = (caf_shash_r4 (p) << 32) | caf_shash_r4 (p + ((i >> 3) << 2));
+			b = (caf_shash_r4 (p + i - 4) << 32) |
+				caf_shash_r4 (p + i - 4 - ((i >> 3) << 2));
+		} else if (i > 0) {
+			a = ((u_int64_t)p[0] << 16) | ((u_int64_t)p[i >> 1] << 8) |
+				p[i - 1];
+		}
+	} else {
+		if (i > 48) {
+			s1 = s;
+			s2 = s;
+			do {
+				s = caf_shash_mix (caf_shash_r8 (p) ^ CAF_SHASH_WY1,
+				                   caf_shash_r8 (p + 8) ^ s);
+				s1 = caf_shash_mix (caf_shash_r8 (p + 16) ^ CAF_SHASH_WY2,
+				                    caf_shash_r8 (p + 24) ^ s1);
+				s2 = caf_shash_mix (caf_shash_r8 (p + 32) ^ CAF_SHASH_WY3,
+				                    caf_shash_r8 (p + 40) ^ s2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			s ^= s1 ^ s2;
+		}
+		while (i > 16) {
+			s = caf_shash_mix (caf_shash_r8 (p) ^ CAF_SHASH_WY1,
+			                   caf_shash_r8 (p + 8) ^ s);
+			p += 16;
+			i -= 16;
+		}
+		a = caf_shash_r8 (p + i - 16);
+		b = caf_shash_r8 (p + i - 8);
+	}
+	a ^= CAF_SHASH_WY1;
+	b ^= s;
+	caf_shash_mum (&a, &b);
+	return caf_shash_mix (a ^ CAF_SHASH_WY0 ^ (u_int64_t)len,
+	                      b ^ CAF_SHASH_WY1);
+}
+
+
+u_int64_t
+caf_shash64_xx (const char *str, const size_t len, const u_int64_t seed) {
+	const unsigned char *p = (const unsigned char *)str;
+	const unsigned char *end;
+	u_int64_t h, v1, v2, v3, v4;
+	size_t i = len;
+	if (p == (const unsigned char *)NULL) {
+		i = 0;
+	}
+	end = p + i;
+	if (i >= 32) {
+		v1 = seed + CAF_SHASH_XX1 + CAF_SHASH_XX2;
+		v2 = seed + CAF_SHASH_XX2;
+		v3 = seed;
+		v4 = seed - CAF_SHASH_XX1;
+		do {
+			v1 = caf_shash_xx_round (v1, caf_shash_r8 (p));
+			v2 = caf_shash_xx_round (v2, caf_shash_r8 (p + 8));
+			v3 = caf_shash_xx_round (v3, caf_shash_r8 (p + 16));
+			v4 = caf_shash_xx_round (v4, caf_shash_r8 (p + 24));
+			p += 32;
+		} while (p + 32 <= end);
+		h = CAF_SHASH_ROTL64(v1, 1) + CAF_SHASH_ROTL64(v2, 7) +
+			CAF_SHASH_ROTL64(v3, 12) + CAF_SHASH_ROTL64(v4, 18);
+		h = caf_shash_xx_merge (h, v1);
+		h = caf_shash_xx_merge (h, v2);
+		h = caf_shash_xx_merge (h, v3);
+		h = caf_shash_xx_merge (h, v4);
+	} else {
+		h = seed + CAF_SHASH_XX5;
+	}
+	h += (u_int64_t)len;
+	while (p + 8 <= end) {
+		h ^= caf_shash_xx_round (0, caf_shash_r8 (p));
+		h = CAF_SHASH_ROTL64(h, 27) * CAF_SHASH_XX1 + CAF_SHASH_XX4;
+		p += 8;
+	}
+	if (p + 4 <= end) {
+		h ^= caf_shash_r4 (p) * CAF_SHASH_XX1;
+		h = CAF_SHASH_ROTL64(h, 23) * CAF_SHASH_XX2 + CAF_SHASH_XX3;
+		p += 4;
+	}
+	while (p < end) {
+		h ^= (u_int64_t)(*p) * CAF_SHASH_XX5;
+		h = CAF_SHASH_ROTL64(h, 11) * CAF_SHASH_XX1;
+		p++;
+	}
+	h ^= h >> 33;
+	h *= CAF_SHASH_XX2;
+	h ^= h >> 29;
+	h *= CAF_SHASH_XX3;
+	h ^= h >> 32;
+	return h;
+}
+
+
+u_int32_t
+caf_shash_wy (const char *str, const u_int32_t len) {
+	u_int64_t h = caf_shash64_wy (str, (size_t)len, caf_shash_seed);
+	return (u_int32_t)(h ^ (h >> 32));
+}
+
+
+u_int32_t
+caf_shash_xx (const char *str, const u_int32_t len) {
+	u_int64_t h = caf_shash64_xx (str, (size_t)len, caf_shash_seed);
+	return (u_int32_t)(h ^ (h >> 32));
+}
+
+
+u_int64_t
+caf_shash_seed_init (void) {
+	caf_shash_seed = caf_shash_seed_random ();
+	return caf_shash_seed;
+}
+
+
+u_int64_t
+caf_shash_seed_random (void) {
+	static u_int64_t calls = 0;
+	u_int64_t seed = 0;
+	int fd;
+	fd = open ("/dev/urandom", O_RDONLY);
+	if (fd >= 0) {
+		if (read (fd, &seed, sizeof (seed)) != (ssize_t)sizeof (seed)) {
+			seed = 0;
+		}
+		close (fd);
+	}
+	if (seed == 0) {
+		/* the call counter keeps consecutive fallback seeds apart */
+		seed = ((u_int64_t)time ((time_t *)NULL) << 32) ^
+			(u_int64_t)getpid () ^ (u_int64_t)(size_t)&seed ^ ++calls;
+		seed = caf_shash_mix (seed, CAF_SHASH_WY0);
+	}
+	return seed != 0 ? seed : CAF_SHASH_WY0;
+}
+
+
+void
+caf_shash_seed_set (const u_int64_t seed) {
+	caf_shash_seed = seed;
+}
+
+
+u_int64_t
+caf_shash_seed_get (void) {
+	return caf_shash_seed;
+}
+
+
+static u_int64_t
+caf_shash_r8 (const unsigned char *p) {
+	u_int64_t v;
+	memcpy (&v, p, sizeof (v));
+	return v;
+}
+
+
+static u_int64_t
+caf_shash_r4 (const unsigned char *p) {
+	u_int32_t v;
+	memcpy (&v, p, sizeof (v));
+	return (u_int64_t)v;
+}
+
+
+static void
+caf_shash_mum (u_int64_t *a, u_int64_t *b) {
+#ifdef __SIZEOF_INT128__
+	__extension__ unsigned __int128 r = *a;
+	r *= *b;
+	*a = (u_int64_t)r;
+	*b = (u_int64_t)(r >> 64);
+#else /* !__SIZEOF_INT128__ */
+	/* 64x64 to 128 bits product from four 32x32 products */
+	u_int64_t ha = *a >> 32, hb = *b >> 32;
+	u_int64_t la = (u_int32_t)*a, lb = (u_int32_t)*b;
+	u_int64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	u_int64_t t = rl + (rm0 << 32), c = t < rl, lo, hi;
+	lo = t + (rm1 << 32);
+	c += lo < t;
+	hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	*a = lo;
+	*b = hi;
+#endif /* !__SIZEOF_INT128__ */
+}
+
+
+static u_int64_t
+caf_shash_mix (u_int64_t a, u_int64_t b) {
+	caf_shash_mum (&a, &b);
+	return a ^ b;
+}
+
+
+static u_int64_t
+caf_shash_xx_round (u_int64_t acc, const u_int64_t in) {
+	acc += in * CAF_SHASH_XX2;
+	acc = CAF_SHASH_ROTL64(acc, 31);
+	return acc * CAF_SHASH_XX1;
+}
+
+
+static u_int64_t
+caf_shash_xx_merge (u_int64_t acc, const u_int64_t v) {
+	acc ^= caf_shash_xx_round (0, v);
+	return acc * CAF_SHASH_XX1 + CAF_SHASH_XX4;
+}
+
 /* caf_hash_str.c ends here */
 
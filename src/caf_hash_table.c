@@ -29,6 +29,7 @@ static char Id[] = "$Id$";
 #endif /* !HAVE_CONFIG_H */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include "caf/caf.h"
@@ -37,8 +38,62 @@ static char Id[] = "$Id$";
 #include "caf/caf_hash_table.h"
 
 
-static int caf_hash_search_callback (void *lptr, void *data);
-static int caf_hash_delete_callback (void *data);
+/** Hints the CPU to fetch a slot before it is probed */
+#ifdef __GNUC__
+#define CAF_HASH_PREFETCH(p)        __builtin_prefetch ((p), 0, 1)
+#else /* !__GNUC__ */
+#define CAF_HASH_PREFETCH(p)        ((void)(p))
+#endif /* !__GNUC__ */
+
+/** Fingerprint of a free slot, the probe sequence ends here */
+#define CAF_HASH_FP_EMPTY           0x00
+/** Fingerprint of a removed slot, the probe sequence continues */
+#define CAF_HASH_FP_DELETED         0x01
+/** Fingerprint of a live slot, the high bit is always set */
+#define CAF_HASH_FP(h1)             ((u_int8_t)(0x80 | ((h1) >> 25)))
+/** One in every byte of a fingerprint group */
+#define CAF_HASH_FP_ONES            0x0101010101010101ULL
+/** High bit set in every byte of a fingerprint group */
+#define CAF_HASH_FP_HIGHS           0x8080808080808080ULL
+/** Non zero if a byte of the fingerprint group is zero */
+#define CAF_HASH_FP_ZERO(w)         (((w) - CAF_HASH_FP_ONES) & ~(w) & \
+                                     CAF_HASH_FP_HIGHS)
+/** Non zero if a byte of the fingerprint group equals fp */
+#define CAF_HASH_FP_MATCH(w, fp)    CAF_HASH_FP_ZERO((w) ^ \
+                                                     (CAF_HASH_FP_ONES * (fp)))
+/** Slot entry at the given index of a slot array */
+#define CAF_HASH_SLOT_AT(t, s, i)   ((caf_hash_t *)((char *)(s) + \
+                                                    (i) * (t)->stride))
+/** Inline key storage, right after the entry */
+#define CAF_HASH_SLOT_KEY(h)        ((void *)((h) + 1))
+
+static caf_hash_t *caf_hash_slots_new (caf_hash_table_t *table,
+                                       const size_t sz, u_int8_t **fps);
+static caf_hash_t *caf_hash_table_find (caf_hash_table_t *table,
+                                        const void *key, const size_t ksz,
+                                        const u_int32_t h1,
+                                        const u_int32_t h2);
+static caf_hash_t *caf_hash_slots_find (caf_hash_table_t *table,
+                                        caf_hash_t *slots,
+                                        const u_int8_t *fps, const size_t sz,
+                                        const void *key, const size_t ksz,
+                                        const u_int32_t h1,
+                                        const u_int32_t h2);
+static size_t caf_hash_table_slot (const u_int8_t *fps, const size_t sz,
+                                   const u_int32_t h1, const u_int32_t h2,
+                                   size_t *probes);
+static void caf_hash_table_put (caf_hash_table_t *table, caf_hash_t *hash,
+                                const void *key, const size_t ksz);
+static int caf_hash_table_move (caf_hash_table_t *table, caf_hash_t *slots,
+                                u_int8_t *fps, const size_t sz,
+                                caf_hash_t *hash);
+static int caf_hash_table_resize (caf_hash_table_t *table, const size_t sz);
+static void caf_hash_table_step (caf_hash_table_t *table, size_t steps);
+static int caf_hash_table_insert (caf_hash_table_t *table, const void *key,
+                                  const size_t ksz, const void *data,
+                                  const u_int32_t h1, const u_int32_t h2,
+                                  size_t *probes);
+static int caf_hash_table_reseed (caf_hash_table_t *table);
 static int caf_hash_dump (FILE *out, void *data);
 
 
@@ -99,8 +154,26 @@ caf_hash_table_new (const int id, CAF_HASH_STR_FUNCTION(f1),
 			r->id = id;
 			r->f1 = f1;
 			r->f2 = f2;
-			r->hashes = cdeque_create ();
-			if (r->hashes == (cdeque_t *)NULL) {
+			r->size = CAF_HASH_TABLE_MINSZ;
+			r->count = 0;
+			r->used = 0;
+			r->key_inline = 0;
+			r->stride = CAF_HASH_SZ;
+			r->old_slots = (caf_hash_t *)NULL;
+			r->old_fps = (u_int8_t *)NULL;
+			r->old_size = 0;
+			r->old_pos = 0;
+			r->old_count = 0;
+			r->rehash_steps = 0;
+			r->rehash_count = 0;
+			r->seed = 0;
+			r->probe_max = 0;
+			r->probe_peak = 0;
+			r->reseed_adds = 0;
+			r->reseed_count = 0;
+			r->reseed_fails = 0;
+			r->slots = caf_hash_slots_new (r, r->size, &(r->fps));
+			if (r->slots == (caf_hash_t *)NULL) {
 				xfree (r);
 				r = (caf_hash_table_t *)NULL;
 			}
@@ -113,61 +186,193 @@ caf_hash_table_new (const int id, CAF_HASH_STR_FUNCTION(f1),
 int
 caf_hash_table_delete (caf_hash_table_t *table) {
 	if (table != (caf_hash_table_t *)NULL) {
-		if ((cdeque_delete (table->hashes, caf_hash_delete_callback)) ==
-			CAF_OK) {
-			xfree (table);
-			return CAF_OK;
+		if (table->old_slots != (caf_hash_t *)NULL) {
+			xfree (table->old_slots);
 		}
+		xfree (table->slots);
+		xfree (table);
+		return CAF_OK;
 	}
 	return CAF_OK;
 }
 
 
+caf_hash_table_t *
+caf_hash_table_new_seeded (const int id, CAF_HASH_STR_FUNCTION(f1),
+                           CAF_HASH_STR_FUNCTION(f2),
+                           const size_t probe_max) {
+	caf_hash_table_t *r;
+	r = caf_hash_table_new (id, f1, f2);
+	if (r != (caf_hash_table_t *)NULL) {
+		r->seed = caf_shash_seed_random ();
+		r->probe_max = probe_max;
+	}
+	return r;
+}
+
+
+int
+caf_hash_table_hash (caf_hash_table_t *table, const void *key,
+                     const size_t ksz, u_int32_t *h1, u_int32_t *h2) {
+	u_int64_t h;
+	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL) {
+		if (table->seed != 0) {
+			h = caf_shash64_wy ((const char *)key, ksz, table->seed);
+			*h1 = (u_int32_t)h;
+			*h2 = (u_int32_t)(h >> 32);
+		} else {
+			*h1 = table->f1 ((const char *)key, ksz);
+			*h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_hash_table_inline (caf_hash_table_t *table, const size_t ksz) {
+	caf_hash_t *slots;
+	u_int8_t *fps;
+	size_t stride;
+	if (table != (caf_hash_table_t *)NULL && table->count == 0 &&
+		table->old_slots == (caf_hash_t *)NULL &&
+		ksz <= CAF_HASH_TABLE_INLINE_MAX) {
+		stride = table->stride;
+		/* keep the entries aligned as a caf_hash_t array would be */
+		table->stride = (CAF_HASH_SZ + ksz + sizeof (void *) - 1) &
+			~(sizeof (void *) - 1);
+		slots = caf_hash_slots_new (table, table->size, &fps);
+		if (slots == (caf_hash_t *)NULL) {
+			table->stride = stride;
+			return CAF_ERROR;
+		}
+		xfree (table->slots);
+		table->slots = slots;
+		table->fps = fps;
+		table->used = 0;
+		table->key_inline = ksz;
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_hash_table_incremental (caf_hash_table_t *table, const size_t steps) {
+	if (table != (caf_hash_table_t *)NULL) {
+		table->rehash_steps = steps;
+		if (steps == 0) {
+			caf_hash_table_step (table, table->old_size);
+		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_hash_table_migrate (caf_hash_table_t *table, const size_t steps) {
+	if (table != (caf_hash_table_t *)NULL) {
+		caf_hash_table_step (table, steps > 0 ? steps : table->old_size);
+		return (table->old_slots == (caf_hash_t *)NULL) ? CAF_OK
+			: CAF_ERROR;
+	}
+	return CAF_ERROR;
+}
+
+
 int
 caf_hash_table_add (caf_hash_table_t *table, const void *key,
                     const size_t ksz, const void *data) {
-	caf_hash_t *hash;
-	caf_hash_t *hash_new;
+	u_int32_t h1, h2;
+	size_t n = 0;
 	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
 		ksz > 0 && data != (const void *)NULL) {
-		hash_new = caf_hash_new_nodata (key, ksz, table->f1, table->f2);
-		hash = (caf_hash_t *)cdeque_search (table->hashes, (void *)hash_new,
-		                                    caf_hash_search_callback);
-		if (hash == (caf_hash_t *)NULL) {
-			hash = caf_hash_new (key, ksz, data, table->f1, table->f2);
-			if (hash != (caf_hash_t *)NULL) {
-				caf_hash_delete (hash_new);
-				return ((cdeque_push (table->hashes, (void *)hash))
-				        != (cdeque_t *)NULL) ? CAF_OK : CAF_ERROR;
-			}
-		} else {
-			hash->key = (void *)key;
-			hash->data = (void *)data;
-			hash->hash1 = hash_new->hash1;
-			hash->hash2 = hash_new->hash2;
-			hash->key_sz = ksz;
-			caf_hash_delete (hash_new);
-			return CAF_OK;
+		caf_hash_table_hash (table, key, ksz, &h1, &h2);
+		if (caf_hash_table_insert (table, key, ksz, data, h1, h2, &n)
+			!= CAF_OK) {
+			return CAF_ERROR;
+		}
+		/*
+		 * a long probe sequence on a seeded table may be an attack;
+		 * only this entry point reseeds, it hashed the key itself
+		 */
+		if (table->seed != 0 && table->probe_max > 0 &&
+			n > table->probe_max &&
+			table->reseed_adds * 4 >= table->count &&
+			caf_hash_table_reseed (table) != CAF_OK) {
+			/* the entry is in, the next long probe retries */
+			table->reseed_fails++;
 		}
+		return CAF_OK;
 	}
 	return CAF_ERROR;
 }
 
 
+int
+caf_hash_table_add_hashed (caf_hash_table_t *table, const void *key,
+                           const size_t ksz, const void *data,
+                           const u_int32_t h1, const u_int32_t h2) {
+	size_t n = 0;
+	/* never reseeds, the caller hashes stay valid */
+	return caf_hash_table_insert (table, key, ksz, data, h1, h2, &n);
+}
+
+
 int
 caf_hash_table_remove (caf_hash_table_t *table, const void *key,
                        const size_t ksz) {
+	u_int32_t h1, h2;
+	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		caf_hash_table_hash (table, key, ksz, &h1, &h2);
+		return caf_hash_table_remove_hashed (table, key, ksz, h1, h2);
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_hash_table_remove_hashed (caf_hash_table_t *table, const void *key,
+                              const size_t ksz, const u_int32_t h1,
+                              const u_int32_t h2) {
 	caf_hash_t *hash;
-	caf_hash_t *hash_new;
+	u_int8_t *fps;
+	size_t sz;
 	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
 		ksz > 0) {
-		hash_new = caf_hash_new_nodata (key, ksz, table->f1, table->f2);
-		hash = (caf_hash_t *)cdeque_search (table->hashes, (void *)hash_new,
-		                                    caf_hash_search_callback);
+		caf_hash_table_step (table, table->rehash_steps);
+		hash = caf_hash_table_find (table, key, ksz, h1, h2);
 		if (hash != (caf_hash_t *)NULL) {
-			caf_hash_delete (hash_new);
-			return cdeque_node_delete_by_data (table->hashes, (void *)hash,
-			                                   caf_hash_delete_callback);
+			/* the entry lives either in the new or in the old array */
+			if ((char *)hash >= (char *)table->slots &&
+				(char *)hash < (char *)table->fps) {
+				fps = table->fps;
+				sz = ((char *)hash - (char *)table->slots) / table->stride;
+			} else {
+				fps = table->old_fps;
+				sz = ((char *)hash - (char *)table->old_slots) /
+					table->stride;
+				table->old_count--;
+			}
+			fps[sz] = CAF_HASH_FP_DELETED;
+			hash->key = (void *)NULL;
+			hash->data = (void *)NULL;
+			hash->key_sz = 0;
+			table->count--;
+			if (table->old_slots == (caf_hash_t *)NULL) {
+				sz = table->size;
+				while (sz > CAF_HASH_TABLE_MINSZ &&
+					   table->count * 100 < sz * CAF_HASH_TABLE_LOAD_MIN) {
+					sz >>= 1;
+				}
+				if (sz < table->size) {
+					caf_hash_table_resize (table, sz);
+				}
+			}
+			return CAF_OK;
 		}
 	}
 	return CAF_ERROR;
@@ -177,42 +382,118 @@ caf_hash_table_remove (caf_hash_table_t *table, const void *key,
 void *
 caf_hash_table_get (caf_hash_table_t *table, const void *key,
                     const size_t ksz) {
+	u_int32_t h1, h2;
+	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		caf_hash_table_hash (table, key, ksz, &h1, &h2);
+		return caf_hash_table_get_hashed (table, key, ksz, h1, h2);
+	}
+	return (void *)NULL;
+}
+
+
+void *
+caf_hash_table_get_hashed (caf_hash_table_t *table, const void *key,
+                           const size_t ksz, const u_int32_t h1,
+                           const u_int32_t h2) {
 	caf_hash_t *hash;
-	caf_hash_t *hash_new;
-	void *r = (void *)NULL;
 	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
 		ksz > 0) {
-		hash_new = caf_hash_new_nodata (key, ksz, table->f1, table->f2);
-		if ((hash = (caf_hash_t *)cdeque_search (table->hashes,
-												 (void *)hash_new,
-												 caf_hash_search_callback))
-			!= (caf_hash_t *)NULL) {
-			caf_hash_delete (hash_new);
+		caf_hash_table_step (table, table->rehash_steps);
+		hash = caf_hash_table_find (table, key, ksz, h1, h2);
+		if (hash != (caf_hash_t *)NULL) {
 			return hash->data;
 		}
 	}
-	return r;
+	return (void *)NULL;
+}
+
+
+size_t
+caf_hash_table_get_many (caf_hash_table_t *table, const void **keys,
+                         const size_t *sizes, const size_t n, void **out) {
+	u_int32_t h1[CAF_HASH_TABLE_BATCH], h2[CAF_HASH_TABLE_BATCH];
+	caf_hash_t *hash;
+	u_int8_t fp;
+	size_t i, j, k, b, g, mask, found = 0;
+	if (table == (caf_hash_table_t *)NULL || keys == (const void **)NULL ||
+		sizes == (const size_t *)NULL || out == (void **)NULL) {
+		return found;
+	}
+	caf_hash_table_step (table, table->rehash_steps);
+	mask = table->size - 1;
+	for (i = 0; i < n; i += b) {
+		b = (n - i) < CAF_HASH_TABLE_BATCH ? (n - i) : CAF_HASH_TABLE_BATCH;
+		/* hash the whole batch first so the group misses overlap */
+		for (j = 0; j < b; j++) {
+			if (keys[i + j] == (const void *)NULL || sizes[i + j] == 0) {
+				continue;
+			}
+			caf_hash_table_hash (table, keys[i + j], sizes[i + j], &(h1[j]),
+			                     &(h2[j]));
+			g = (h1[j] & mask) & ~(size_t)(CAF_HASH_TABLE_GROUP - 1);
+			CAF_HASH_PREFETCH(&(table->fps[g]));
+		}
+		/* then the first entry matching the fingerprint in each group */
+		for (j = 0; j < b; j++) {
+			if (keys[i + j] == (const void *)NULL || sizes[i + j] == 0) {
+				continue;
+			}
+			fp = CAF_HASH_FP(h1[j]);
+			g = (h1[j] & mask) & ~(size_t)(CAF_HASH_TABLE_GROUP - 1);
+			for (k = 0; k < CAF_HASH_TABLE_GROUP; k++) {
+				if (table->fps[g + k] == fp) {
+					hash = CAF_HASH_SLOT_AT(table, table->slots, g + k);
+					CAF_HASH_PREFETCH(hash);
+					break;
+				}
+			}
+		}
+		for (j = 0; j < b; j++) {
+			out[i + j] = (void *)NULL;
+			if (keys[i + j] == (const void *)NULL || sizes[i + j] == 0) {
+				continue;
+			}
+			hash = caf_hash_table_find (table, keys[i + j], sizes[i + j],
+			                            h1[j], h2[j]);
+			if (hash != (caf_hash_t *)NULL) {
+				out[i + j] = hash->data;
+				found++;
+			}
+		}
+	}
+	return found;
 }
 
 
 int
 caf_hash_table_set (caf_hash_table_t *table, const void *key,
                     const size_t ksz, void *data) {
+	u_int32_t h1, h2;
+	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		caf_hash_table_hash (table, key, ksz, &h1, &h2);
+		return caf_hash_table_set_hashed (table, key, ksz, data, h1, h2);
+	}
+	return CAF_ERROR;
+}
+
+
+int
+caf_hash_table_set_hashed (caf_hash_table_t *table, const void *key,
+                           const size_t ksz, void *data,
+                           const u_int32_t h1, const u_int32_t h2) {
 	caf_hash_t *hash;
-	caf_hash_t *hash_new;
 	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
 		ksz > 0) {
-		hash_new = caf_hash_new_nodata (key, ksz, table->f1, table->f2);
-		if ((hash = (caf_hash_t *)cdeque_search (table->hashes,
-												 (void *)hash_new,
-												 caf_hash_search_callback))
-			!= (caf_hash_t *)NULL) {
+		caf_hash_table_step (table, table->rehash_steps);
+		hash = caf_hash_table_find (table, key, ksz, h1, h2);
+		if (hash != (caf_hash_t *)NULL) {
 			hash->data = (void *)data;
-			hash->key = (void *)key;
-			hash->key_sz = ksz;
-			hash->hash1 = hash_new->hash1;
-			hash->hash2 = hash_new->hash2;
-			caf_hash_delete (hash_new);
+			/* inline keys already hold the same contents */
+			if (hash->key != CAF_HASH_SLOT_KEY(hash)) {
+				hash->key = (void *)key;
+			}
 			return CAF_OK;
 		}
 	}
@@ -222,37 +503,294 @@ caf_hash_table_set (caf_hash_table_t *table, const void *key,
 
 void
 caf_hash_table_dump (FILE *out, caf_hash_table_t *table) {
+	size_t i;
 	if (table != (caf_hash_table_t *)NULL) {
-		fprintf (out, "[%p] Hash Table\n", (void *)table);
-		cdeque_dump (out, table->hashes, caf_hash_dump);
+		fprintf (out, "[%p] Hash Table: %lu/%lu slots\n", (void *)table,
+		         (unsigned long)table->count, (unsigned long)table->size);
+		for (i = 0; i < table->size; i++) {
+			if (table->fps[i] & 0x80) {
+				caf_hash_dump (out, (void *)CAF_HASH_SLOT_AT(table,
+				                                             table->slots, i));
+			}
+		}
+		for (i = table->old_pos; i < table->old_size; i++) {
+			if (table->old_fps[i] & 0x80) {
+				caf_hash_dump (out, (void *)CAF_HASH_SLOT_AT(table,
+				                                             table->old_slots,
+				                                             i));
+			}
+		}
+	}
+}
+
+
+static caf_hash_t *
+caf_hash_slots_new (caf_hash_table_t *table, const size_t sz,
+                    u_int8_t **fps) {
+	caf_hash_t *slots;
+	/* entries first, then their fingerprints, in a single block */
+	slots = (caf_hash_t *)xmalloc (sz * table->stride + sz);
+	if (slots != (caf_hash_t *)NULL) {
+		memset (slots, 0, sz * table->stride + sz);
+		*fps = (u_int8_t *)slots + sz * table->stride;
+	}
+	return slots;
+}
+
+
+static caf_hash_t *
+caf_hash_table_find (caf_hash_table_t *table, const void *key,
+                     const size_t ksz, const u_int32_t h1,
+                     const u_int32_t h2) {
+	caf_hash_t *hash;
+	hash = caf_hash_slots_find (table, table->slots, table->fps, table->size,
+	                            key, ksz, h1, h2);
+	if (hash == (caf_hash_t *)NULL && table->old_slots != (caf_hash_t *)NULL) {
+		hash = caf_hash_slots_find (table, table->old_slots, table->old_fps,
+		                            table->old_size, key, ksz, h1, h2);
+	}
+	return hash;
+}
+
+
+static caf_hash_t *
+caf_hash_slots_find (caf_hash_table_t *table, caf_hash_t *slots,
+                     const u_int8_t *fps, const size_t sz, const void *key,
+                     const size_t ksz, const u_int32_t h1,
+                     const u_int32_t h2) {
+	caf_hash_t *hash;
+	u_int64_t w;
+	u_int8_t fp = CAF_HASH_FP(h1);
+	size_t gmask = sz / CAF_HASH_TABLE_GROUP - 1;
+	size_t step = ((size_t)h2 | 1) & gmask;
+	size_t g = ((size_t)h1 & (sz - 1)) / CAF_HASH_TABLE_GROUP;
+	size_t n, k, i;
+	for (n = 0; n <= gmask; n++) {
+		/* the whole group is tested against the fingerprint at once */
+		i = g * CAF_HASH_TABLE_GROUP;
+		memcpy (&w, &(fps[i]), sizeof (w));
+		if (CAF_HASH_FP_MATCH(w, fp)) {
+			for (k = 0; k < CAF_HASH_TABLE_GROUP; k++) {
+				if (fps[i + k] != fp) {
+					continue;
+				}
+				hash = CAF_HASH_SLOT_AT(table, slots, i + k);
+				if (hash->hash1 == h1 && hash->hash2 == h2 &&
+					hash->key_sz == ksz && (hash->key == key ||
+					memcmp (hash->key, key, ksz) == 0)) {
+					return hash;
+				}
+			}
+		}
+		if (CAF_HASH_FP_ZERO(w)) {
+			break;
+		}
+		g = (g + step) & gmask;
+	}
+	return (caf_hash_t *)NULL;
+}
+
+
+static size_t
+caf_hash_table_slot (const u_int8_t *fps, const size_t sz,
+                     const u_int32_t h1, const u_int32_t h2,
+                     size_t *probes) {
+	u_int64_t w;
+	size_t gmask = sz / CAF_HASH_TABLE_GROUP - 1;
+	size_t step = ((size_t)h2 | 1) & gmask;
+	size_t g = ((size_t)h1 & (sz - 1)) / CAF_HASH_TABLE_GROUP;
+	size_t k, i;
+	for (*probes = 1; ; (*probes)++) {
+		i = g * CAF_HASH_TABLE_GROUP;
+		memcpy (&w, &(fps[i]), sizeof (w));
+		/* empty and deleted slots have the high bit clear */
+		if (~w & CAF_HASH_FP_HIGHS) {
+			for (k = 0; k < CAF_HASH_TABLE_GROUP; k++) {
+				if (!(fps[i + k] & 0x80)) {
+					return i + k;
+				}
+			}
+		}
+		g = (g + step) & gmask;
+	}
+}
+
+
+static void
+caf_hash_table_put (caf_hash_table_t *table, caf_hash_t *hash,
+                    const void *key, const size_t ksz) {
+	hash->key_sz = ksz;
+	if (ksz <= table->key_inline) {
+		memcpy (CAF_HASH_SLOT_KEY(hash), key, ksz);
+		hash->key = CAF_HASH_SLOT_KEY(hash);
+	} else {
+		hash->key = (void *)key;
 	}
 }
 
 
 static int
-caf_hash_search_callback (void *lptr, void *data) {
-	caf_hash_t *hash1;
-	caf_hash_t *hash2;
-	if (lptr != (void *)NULL && data != (void *)NULL) {
-		hash1 = (caf_hash_t *)lptr;
-		hash2 = (caf_hash_t *)data;
-		return ((hash1->hash1 == hash2->hash1 && hash1->hash2 == hash2->hash2)
-		        ? CAF_OK : CAF_ERROR);
+caf_hash_table_move (caf_hash_table_t *table, caf_hash_t *slots,
+                     u_int8_t *fps, const size_t sz, caf_hash_t *hash) {
+	caf_hash_t *dst;
+	size_t i, n;
+	int empty;
+	i = caf_hash_table_slot (fps, sz, hash->hash1, hash->hash2, &n);
+	empty = (fps[i] == CAF_HASH_FP_EMPTY);
+	fps[i] = CAF_HASH_FP(hash->hash1);
+	dst = CAF_HASH_SLOT_AT(table, slots, i);
+	*dst = *hash;
+	if (hash->key == CAF_HASH_SLOT_KEY(hash)) {
+		caf_hash_table_put (table, dst, hash->key, hash->key_sz);
+	}
+	return empty;
+}
+
+
+static int
+caf_hash_table_resize (caf_hash_table_t *table, const size_t sz) {
+	caf_hash_t *slots;
+	u_int8_t *fps;
+	size_t i;
+	slots = caf_hash_slots_new (table, sz, &fps);
+	if (slots != (caf_hash_t *)NULL) {
+		if (table->rehash_steps > 0) {
+			/* entries are moved later by caf_hash_table_step() */
+			table->old_slots = table->slots;
+			table->old_fps = table->fps;
+			table->old_size = table->size;
+			table->old_pos = 0;
+			table->old_count = table->count;
+			table->slots = slots;
+			table->fps = fps;
+			table->size = sz;
+			table->used = 0;
+			return CAF_OK;
+		}
+		for (i = 0; i < table->size; i++) {
+			if (table->fps[i] & 0x80) {
+				caf_hash_table_move (table, slots, fps, sz,
+				                     CAF_HASH_SLOT_AT(table, table->slots, i));
+			}
+		}
+		xfree (table->slots);
+		table->slots = slots;
+		table->fps = fps;
+		table->size = sz;
+		table->used = table->count;
+		return CAF_OK;
 	}
 	return CAF_ERROR;
 }
 
 
+static void
+caf_hash_table_step (caf_hash_table_t *table, size_t steps) {
+	caf_hash_t *hash;
+	while (table->old_slots != (caf_hash_t *)NULL && steps > 0) {
+		if (table->old_fps[table->old_pos] & 0x80) {
+			hash = CAF_HASH_SLOT_AT(table, table->old_slots, table->old_pos);
+			table->used += caf_hash_table_move (table, table->slots,
+			                                    table->fps, table->size, hash);
+			table->old_fps[table->old_pos] = CAF_HASH_FP_DELETED;
+			table->old_count--;
+			table->rehash_count++;
+		}
+		steps--;
+		if (++table->old_pos >= table->old_size) {
+			xfree (table->old_slots);
+			table->old_slots = (caf_hash_t *)NULL;
+			table->old_fps = (u_int8_t *)NULL;
+			table->old_size = 0;
+			table->old_pos = 0;
+			table->old_count = 0;
+		}
+	}
+}
+
+
 static int
-caf_hash_delete_callback (void *data) {
-	if (data != (void *)NULL) {
-		xfree (data);
+caf_hash_table_insert (caf_hash_table_t *table, const void *key,
+                       const size_t ksz, const void *data,
+                       const u_int32_t h1, const u_int32_t h2,
+                       size_t *probes) {
+	caf_hash_t *hash;
+	size_t sz, i, n = 0;
+	if (table != (caf_hash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0 && data != (const void *)NULL) {
+		caf_hash_table_step (table, table->rehash_steps);
+		hash = caf_hash_table_find (table, key, ksz, h1, h2);
+		if (hash == (caf_hash_t *)NULL) {
+			/*
+			 * entries still in the old array land here too, a shrunk
+			 * array could otherwise be filled up by the migration
+			 */
+			if ((table->used + table->old_count + 1) * 100 >
+				table->size * CAF_HASH_TABLE_LOAD_MAX) {
+				/* a pending migration must end before the next one */
+				caf_hash_table_step (table, table->old_size);
+				/* mostly deleted slots only need to be cleaned up */
+				sz = (table->count * 2 >= table->used) ? table->size << 1
+					: table->size;
+				if (caf_hash_table_resize (table, sz) != CAF_OK) {
+					return CAF_ERROR;
+				}
+			}
+			i = caf_hash_table_slot (table->fps, table->size, h1, h2, &n);
+			if (table->fps[i] == CAF_HASH_FP_EMPTY) {
+				table->used++;
+			}
+			table->fps[i] = CAF_HASH_FP(h1);
+			hash = CAF_HASH_SLOT_AT(table, table->slots, i);
+			hash->hash1 = h1;
+			hash->hash2 = h2;
+			caf_hash_table_put (table, hash, key, ksz);
+			table->count++;
+			table->reseed_adds++;
+			if (n > table->probe_peak) {
+				table->probe_peak = n;
+			}
+		} else if (hash->key != CAF_HASH_SLOT_KEY(hash)) {
+			hash->key = (void *)key;
+		}
+		hash->data = (void *)data;
+		*probes = n;
 		return CAF_OK;
 	}
 	return CAF_ERROR;
 }
 
 
+static int
+caf_hash_table_reseed (caf_hash_table_t *table) {
+	caf_hash_t *slots, *hash;
+	u_int8_t *fps;
+	size_t i;
+	/* entries of a pending migration sit where the old seed put them */
+	caf_hash_table_step (table, table->old_size);
+	slots = caf_hash_slots_new (table, table->size, &fps);
+	if (slots == (caf_hash_t *)NULL) {
+		return CAF_ERROR;
+	}
+	table->seed = caf_shash_seed_random ();
+	for (i = 0; i < table->size; i++) {
+		if (table->fps[i] & 0x80) {
+			hash = CAF_HASH_SLOT_AT(table, table->slots, i);
+			caf_hash_table_hash (table, hash->key, hash->key_sz,
+			                     &(hash->hash1), &(hash->hash2));
+			caf_hash_table_move (table, slots, fps, table->size, hash);
+		}
+	}
+	xfree (table->slots);
+	table->slots = slots;
+	table->fps = fps;
+	table->used = table->count;
+	table->reseed_adds = 0;
+	table->reseed_count++;
+	return CAF_OK;
+}
+
+
 static int
 caf_hash_dump (FILE *out, void *data) {
 	caf_hash_t *hash;
@@ -268,4 +806,3 @@ caf_hash_dump (FILE *out, void *data) {
 }
 
 /* caf_hash_table.c ends here */
-
@@ -0,0 +1,519 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/types.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_hash_str.h"
+#include "caf/caf_thread_mutex.h"
+#include "caf/caf_rhash_table.h"
+
+
+/** Loads a pointer or epoch published by other threads */
+#define CAF_RHASH_LOAD(v)           __atomic_load_n (&(v), __ATOMIC_ACQUIRE)
+/** Publishes a pointer or epoch to other threads */
+#define CAF_RHASH_STORE(v, n)       __atomic_store_n (&(v), (n), \
+                                                      __ATOMIC_RELEASE)
+/** Orders a previous store before the next loads */
+#define CAF_RHASH_FENCE()           __atomic_thread_fence (__ATOMIC_SEQ_CST)
+
+static caf_rhash_buckets_t *caf_rhash_buckets_new (const size_t sz);
+static void caf_rhash_buckets_delete (caf_rhash_buckets_t *b);
+static caf_rhash_node_t **caf_rhash_table_find (caf_rhash_table_t *table,
+                                                const void *key,
+                                                const size_t ksz,
+                                                const u_int32_t h1,
+                                                const u_int32_t h2);
+static int caf_rhash_table_grow (caf_rhash_table_t *table);
+static int caf_rhash_table_retire (caf_rhash_table_t *table, void *ptr,
+                                   const int array);
+static void caf_rhash_table_release (caf_rhash_retired_t *item);
+static int caf_rhash_table_collect (caf_rhash_table_t *table);
+
+
+caf_rhash_table_t *
+caf_rhash_table_new (const int id, CAF_HASH_STR_FUNCTION(f1),
+                     CAF_HASH_STR_FUNCTION(f2)) {
+	caf_rhash_table_t *r = (caf_rhash_table_t *)NULL;
+	if (id > 0 && f1 != NULL) {
+		r = (caf_rhash_table_t *)xmalloc (CAF_RHASH_TABLE_SZ);
+		if (r == (caf_rhash_table_t *)NULL) {
+			return r;
+		}
+		r->id = id;
+		r->f1 = f1;
+		r->f2 = f2;
+		r->count = 0;
+		r->epoch = 1;
+		r->readers = (caf_rhash_reader_t *)NULL;
+		r->retired = (caf_rhash_retired_t *)NULL;
+		r->retired_count = 0;
+		r->grow_fails = 0;
+		r->retire_fails = 0;
+		r->buckets = caf_rhash_buckets_new (CAF_RHASH_TABLE_MINSZ);
+		r->lock = pth_mtx_new ();
+		if (r->buckets == (caf_rhash_buckets_t *)NULL ||
+			r->lock == (pth_mutex_t *)NULL ||
+			pth_mtxattr_init (r->lock) != 0 ||
+			pth_mtx_init (r->lock) != 0) {
+			if (r->buckets != (caf_rhash_buckets_t *)NULL) {
+				xfree (r->buckets);
+			}
+			if (r->lock != (pth_mutex_t *)NULL) {
+				pth_mtx_delete (r->lock);
+			}
+			xfree (r);
+			return (caf_rhash_table_t *)NULL;
+		}
+	}
+	return r;
+}
+
+
+int
+caf_rhash_table_delete (caf_rhash_table_t *table) {
+	caf_rhash_retired_t *item, *inext;
+	caf_rhash_reader_t *reader, *rnext;
+	if (table != (caf_rhash_table_t *)NULL) {
+		item = table->retired;
+		while (item != (caf_rhash_retired_t *)NULL) {
+			inext = item->next;
+			caf_rhash_table_release (item);
+			item = inext;
+		}
+		reader = table->readers;
+		while (reader != (caf_rhash_reader_t *)NULL) {
+			rnext = reader->next;
+			xfree (reader);
+			reader = rnext;
+		}
+		caf_rhash_buckets_delete (table->buckets);
+		pth_mtx_destroy (table->lock);
+		pth_mtxattr_destroy (table->lock);
+		pth_mtx_delete (table->lock);
+		xfree (table);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+caf_rhash_reader_t *
+caf_rhash_reader_new (caf_rhash_table_t *table) {
+	caf_rhash_reader_t *r = (caf_rhash_reader_t *)NULL;
+	if (table != (caf_rhash_table_t *)NULL) {
+		r = (caf_rhash_reader_t *)xmalloc (CAF_RHASH_READER_SZ);
+		if (r != (caf_rhash_reader_t *)NULL) {
+			r->table = table;
+			pth_mtx_lock (table->lock);
+			r->epoch = table->epoch;
+			r->next = table->readers;
+			table->readers = r;
+			pth_mtx_unlock (table->lock);
+		}
+	}
+	return r;
+}
+
+
+int
+caf_rhash_reader_delete (caf_rhash_reader_t *reader) {
+	caf_rhash_table_t *table;
+	caf_rhash_reader_t **prev;
+	if (reader != (caf_rhash_reader_t *)NULL) {
+		table = reader->table;
+		pth_mtx_lock (table->lock);
+		prev = &(table->readers);
+		while (*prev != (caf_rhash_reader_t *)NULL && *prev != reader) {
+			prev = &((*prev)->next);
+		}
+		if (*prev == reader) {
+			*prev = reader->next;
+		}
+		caf_rhash_table_collect (table);
+		pth_mtx_unlock (table->lock);
+		xfree (reader);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void
+caf_rhash_reader_quiescent (caf_rhash_reader_t *reader) {
+	CAF_RHASH_STORE(reader->epoch, CAF_RHASH_LOAD(reader->table->epoch));
+}
+
+
+void
+caf_rhash_reader_offline (caf_rhash_reader_t *reader) {
+	CAF_RHASH_STORE(reader->epoch, CAF_RHASH_OFFLINE);
+}
+
+
+void
+caf_rhash_reader_online (caf_rhash_reader_t *reader) {
+	CAF_RHASH_STORE(reader->epoch, CAF_RHASH_LOAD(reader->table->epoch));
+	/* a writer must see us online before we load any node */
+	CAF_RHASH_FENCE();
+}
+
+
+int
+caf_rhash_table_add (caf_rhash_table_t *table, const void *key,
+                     const size_t ksz, const void *data) {
+	caf_rhash_node_t **prev, *node, *old;
+	caf_rhash_buckets_t *b;
+	u_int32_t h1, h2;
+	int r = CAF_ERROR;
+	if (table != (caf_rhash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0 && data != (const void *)NULL) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		node = (caf_rhash_node_t *)xmalloc (CAF_RHASH_NODE_SZ);
+		if (node == (caf_rhash_node_t *)NULL) {
+			return r;
+		}
+		node->hash1 = h1;
+		node->hash2 = h2;
+		node->key_sz = ksz;
+		node->key = (void *)key;
+		node->data = (void *)data;
+		pth_mtx_lock (table->lock);
+		prev = caf_rhash_table_find (table, key, ksz, h1, h2);
+		if (*prev != (caf_rhash_node_t *)NULL) {
+			/* published nodes are immutable, replace it */
+			old = *prev;
+			node->next = old->next;
+			CAF_RHASH_STORE(*prev, node);
+			caf_rhash_table_retire (table, (void *)old, 0);
+		} else {
+			b = table->buckets;
+			prev = &(b->heads[h1 & (b->size - 1)]);
+			node->next = *prev;
+			CAF_RHASH_STORE(*prev, node);
+			table->count++;
+			/* the entry is visible, the next addition retries the grow */
+			if (table->count > b->size &&
+				caf_rhash_table_grow (table) != CAF_OK) {
+				table->grow_fails++;
+			}
+		}
+		r = CAF_OK;
+		caf_rhash_table_collect (table);
+		pth_mtx_unlock (table->lock);
+	}
+	return r;
+}
+
+
+int
+caf_rhash_table_remove (caf_rhash_table_t *table, const void *key,
+                        const size_t ksz) {
+	caf_rhash_node_t **prev, *old;
+	u_int32_t h1, h2;
+	int r = CAF_ERROR;
+	if (table != (caf_rhash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		pth_mtx_lock (table->lock);
+		prev = caf_rhash_table_find (table, key, ksz, h1, h2);
+		if (*prev != (caf_rhash_node_t *)NULL) {
+			old = *prev;
+			/* readers standing on the node still reach its successors */
+			CAF_RHASH_STORE(*prev, old->next);
+			table->count--;
+			caf_rhash_table_retire (table, (void *)old, 0);
+			r = CAF_OK;
+		}
+		caf_rhash_table_collect (table);
+		pth_mtx_unlock (table->lock);
+	}
+	return r;
+}
+
+
+int
+caf_rhash_table_set (caf_rhash_table_t *table, const void *key,
+                     const size_t ksz, void *data) {
+	caf_rhash_node_t **prev, *node, *old;
+	u_int32_t h1, h2;
+	int r = CAF_ERROR;
+	if (table != (caf_rhash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		pth_mtx_lock (table->lock);
+		prev = caf_rhash_table_find (table, key, ksz, h1, h2);
+		old = *prev;
+		if (old != (caf_rhash_node_t *)NULL) {
+			node = (caf_rhash_node_t *)xmalloc (CAF_RHASH_NODE_SZ);
+			if (node != (caf_rhash_node_t *)NULL) {
+				*node = *old;
+				node->key = (void *)key;
+				node->data = data;
+				CAF_RHASH_STORE(*prev, node);
+				caf_rhash_table_retire (table, (void *)old, 0);
+				r = CAF_OK;
+			}
+		}
+		caf_rhash_table_collect (table);
+		pth_mtx_unlock (table->lock);
+	}
+	return r;
+}
+
+
+void *
+caf_rhash_table_get (caf_rhash_table_t *table, const void *key,
+                     const size_t ksz) {
+	caf_rhash_buckets_t *b;
+	caf_rhash_node_t *node;
+	u_int32_t h1, h2;
+	if (table != (caf_rhash_table_t *)NULL && key != (const void *)NULL &&
+		ksz > 0) {
+		h1 = table->f1 ((const char *)key, ksz);
+		h2 = table->f2 != NULL ? table->f2 ((const char *)key, ksz) : 0;
+		b = CAF_RHASH_LOAD(table->buckets);
+		node = CAF_RHASH_LOAD(b->heads[h1 & (b->size - 1)]);
+		while (node != (caf_rhash_node_t *)NULL) {
+			if (node->hash1 == h1 && node->hash2 == h2 &&
+				node->key_sz == ksz &&
+				(node->key == key || memcmp (node->key, key, ksz) == 0)) {
+				return node->data;
+			}
+			node = CAF_RHASH_LOAD(node->next);
+		}
+	}
+	return (void *)NULL;
+}
+
+
+int
+caf_rhash_table_reclaim (caf_rhash_table_t *table) {
+	int r = CAF_ERROR;
+	if (table != (caf_rhash_table_t *)NULL) {
+		pth_mtx_lock (table->lock);
+		r = caf_rhash_table_collect (table);
+		pth_mtx_unlock (table->lock);
+	}
+	return r;
+}
+
+
+int
+caf_rhash_table_synchronize (caf_rhash_table_t *table) {
+	if (table != (caf_rhash_table_t *)NULL) {
+		while (caf_rhash_table_reclaim (table) != CAF_OK) {
+			sched_yield ();
+		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+void
+caf_rhash_table_dump (FILE *out, caf_rhash_table_t *table) {
+	caf_rhash_node_t *node;
+	size_t i;
+	const char *msg = "[%p] hash1: %15.15u; hash2: %15.15u; key: %30.30s\n"
+		"     data: %s\n\n";
+	if (table != (caf_rhash_table_t *)NULL) {
+		pth_mtx_lock (table->lock);
+		fprintf (out, "[%p] Read-Mostly Hash Table: %lu/%lu buckets, "
+		         "epoch %lu, %lu retired, %lu failed grows, "
+		         "%lu leaked\n", (void *)table,
+		         (unsigned long)table->count,
+		         (unsigned long)table->buckets->size, table->epoch,
+		         (unsigned long)table->retired_count, table->grow_fails,
+		         table->retire_fails);
+		for (i = 0; i < table->buckets->size; i++) {
+			node = table->buckets->heads[i];
+			while (node != (caf_rhash_node_t *)NULL) {
+				fprintf (out, msg, (void *)node, node->hash1, node->hash2,
+				         (char *)node->key, (char *)node->data);
+				node = node->next;
+			}
+		}
+		pth_mtx_unlock (table->lock);
+	}
+}
+
+
+static caf_rhash_buckets_t *
+caf_rhash_buckets_new (const size_t sz) {
+	caf_rhash_buckets_t *r;
+	size_t i;
+	r = (caf_rhash_buckets_t *)xmalloc (sizeof (caf_rhash_buckets_t) +
+	                                    sz * sizeof (caf_rhash_node_t *));
+	if (r != (caf_rhash_buckets_t *)NULL) {
+		r->size = sz;
+		for (i = 0; i < sz; i++) {
+			r->heads[i] = (caf_rhash_node_t *)NULL;
+		}
+	}
+	return r;
+}
+
+
+static void
+caf_rhash_buckets_delete (caf_rhash_buckets_t *b) {
+	caf_rhash_node_t *node, *next;
+	size_t i;
+	for (i = 0; i < b->size; i++) {
+		node = b->heads[i];
+		while (node != (caf_rhash_node_t *)NULL) {
+			next = node->next;
+			xfree (node);
+			node = next;
+		}
+	}
+	xfree (b);
+}
+
+
+static caf_rhash_node_t **
+caf_rhash_table_find (caf_rhash_table_t *table, const void *key,
+                      const size_t ksz, const u_int32_t h1,
+                      const u_int32_t h2) {
+	caf_rhash_buckets_t *b = table->buckets;
+	caf_rhash_node_t **prev = &(b->heads[h1 & (b->size - 1)]);
+	caf_rhash_node_t *node;
+	while ((node = *prev) != (caf_rhash_node_t *)NULL) {
+		if (node->hash1 == h1 && node->hash2 == h2 && node->key_sz == ksz &&
+			(node->key == key || memcmp (node->key, key, ksz) == 0)) {
+			break;
+		}
+		prev = &(node->next);
+	}
+	return prev;
+}
+
+
+static int
+caf_rhash_table_grow (caf_rhash_table_t *table) {
+	caf_rhash_buckets_t *old = table->buckets, *b;
+	caf_rhash_node_t *node, *copy, **head;
+	size_t i;
+	b = caf_rhash_buckets_new (old->size << 1);
+	if (b == (caf_rhash_buckets_t *)NULL) {
+		return CAF_ERROR;
+	}
+	/* readers may walk the old chains, so nodes are copied, not moved */
+	for (i = 0; i < old->size; i++) {
+		for (node = old->heads[i]; node != (caf_rhash_node_t *)NULL;
+			 node = node->next) {
+			copy = (caf_rhash_node_t *)xmalloc (CAF_RHASH_NODE_SZ);
+			if (copy == (caf_rhash_node_t *)NULL) {
+				caf_rhash_buckets_delete (b);
+				return CAF_ERROR;
+			}
+			*copy = *node;
+			head = &(b->heads[node->hash1 & (b->size - 1)]);
+			copy->next = *head;
+			*head = copy;
+		}
+	}
+	CAF_RHASH_STORE(table->buckets, b);
+	caf_rhash_table_retire (table, (void *)old, 1);
+	return CAF_OK;
+}
+
+
+static int
+caf_rhash_table_retire (caf_rhash_table_t *table, void *ptr,
+                        const int array) {
+	caf_rhash_retired_t *item;
+	item = (caf_rhash_retired_t *)xmalloc (sizeof (caf_rhash_retired_t));
+	if (item == (caf_rhash_retired_t *)NULL) {
+		/* leaking beats freeing memory a reader may be using */
+		table->retire_fails++;
+		return CAF_ERROR;
+	}
+	item->ptr = ptr;
+	item->array = array;
+	item->epoch = table->epoch;
+	item->next = table->retired;
+	table->retired = item;
+	table->retired_count++;
+	/* readers announcing the next epoch can't reach the item anymore */
+	CAF_RHASH_STORE(table->epoch, table->epoch + 1);
+	return CAF_OK;
+}
+
+
+static void
+caf_rhash_table_release (caf_rhash_retired_t *item) {
+	if (item->array) {
+		caf_rhash_buckets_delete ((caf_rhash_buckets_t *)item->ptr);
+	} else {
+		xfree (item->ptr);
+	}
+	xfree (item);
+}
+
+
+static int
+caf_rhash_table_collect (caf_rhash_table_t *table) {
+	caf_rhash_retired_t **prev, *item;
+	caf_rhash_reader_t *reader;
+	unsigned long min = table->epoch, e;
+	CAF_RHASH_FENCE();
+	for (reader = table->readers; reader != (caf_rhash_reader_t *)NULL;
+		 reader = reader->next) {
+		e = CAF_RHASH_LOAD(reader->epoch);
+		if (e != CAF_RHASH_OFFLINE && e < min) {
+			min = e;
+		}
+	}
+	/* items retired before the oldest reader epoch are unreachable */
+	prev = &(table->retired);
+	while ((item = *prev) != (caf_rhash_retired_t *)NULL) {
+		if (item->epoch < min) {
+			*prev = item->next;
+			caf_rhash_table_release (item);
+			table->retired_count--;
+		} else {
+			prev = &(item->next);
+		}
+	}
+	return table->retired == (caf_rhash_retired_t *)NULL ? CAF_OK
+		: CAF_ERROR;
+}
+
+/* caf_rhash_table.c ends here */
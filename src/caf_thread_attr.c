@@ -29,13 +29,32 @@ static char Id[] = "$Id$";
 #endif /* !HAVE_CONFIG_H */
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <errno.h>
 #include <pthread.h>
+#ifdef LINUX_SYSTEM
+#include <sched.h>
+#endif /* !LINUX_SYSTEM */
 
 #include "caf/caf.h"
 #include "caf/caf_data_mem.h"
 #include "caf/caf_thread_attr.h"
 
+/** Where Linux reports the CPU and NUMA topology */
+#define PTH_ATTRI_SYSFS         "/sys/devices/system"
+/** Size of a topology file path */
+#define PTH_ATTRI_PATH          128
+
+#ifdef LINUX_SYSTEM
+static int pth_attri_cpus (pth_attri_t *attri, pth_attr_types_t t,
+                           const cpu_set_t *set);
+static int pth_attri_node (pth_attri_t *attri, pth_attr_types_t t,
+                           const int *node);
+static int pth_attri_list (pth_attri_t *attri, const cpu_set_t *set);
+static int pth_attri_primary (int cpu);
+static int pth_attri_cpulist (const char *path, cpu_set_t *set);
+#endif /* !LINUX_SYSTEM */
+
 
 pth_attri_t *
 pth_attri_new (void) {
@@ -43,6 +62,10 @@ pth_attri_new (void) {
 	attri = (pth_attri_t *)xmalloc (CAF_PT_ATTRI_SZ);
 	if (attri != (pth_attri_t *)NULL) {
 		attri->at = 0;
+		attri->cpus = (int *)NULL;
+		attri->ncpu = 0;
+		attri->next = 0;
+		attri->node = -1;
 	}
 	return attri;
 }
@@ -51,6 +74,9 @@ pth_attri_new (void) {
 void
 pth_attri_delete (pth_attri_t *attri) {
 	if (attri != (pth_attri_t *)NULL) {
+		if (attri->cpus != (int *)NULL) {
+			xfree (attri->cpus);
+		}
 		xfree (attri);
 	}
 }
@@ -108,18 +134,21 @@ int
 pth_attri_set (pth_attri_t *attri, pth_attr_types_t t, void *data) {
 	int *di = (int *)data;
 	size_t *ds = (size_t *)data;
+#ifdef LINUX_SYSTEM
+	cpu_set_t set;
+#endif /* !LINUX_SYSTEM */
 	if (attri != (pth_attri_t *)NULL) {
 		switch (t) {
 			/* pthread_attr_setdetachstate */
 		case PTH_ATTR_DETACHED:
 			attri->at |= t;
 			return pthread_attr_setdetachstate (&(attri->attr),
-			                                    PTHREAD_CREATE_JOINABLE);
+			                                    PTHREAD_CREATE_DETACHED);
 			/* pthread_attr_setdetachstate */
 		case PTH_ATTR_JOINABLE:
 			attri->at |= t;
 			return pthread_attr_setdetachstate (&(attri->attr),
-			                                    PTHREAD_CREATE_DETACHED);
+			                                    PTHREAD_CREATE_JOINABLE);
 #ifndef LINUX
 			/* pthread_attr_setstacksize */
 		case PTH_ATTR_STACKSZ:
@@ -147,6 +176,25 @@ pth_attri_set (pth_attri_t *attri, pth_attr_types_t t, void *data) {
 		case PTH_ATTR_SCOPE:
 			attri->at |= t;
 			return pthread_attr_setscope (&(attri->attr), *di);
+#ifdef LINUX_SYSTEM
+			/* pthread_attr_setaffinity_np */
+		case PTH_ATTR_CPUSET:
+			return pth_attri_cpus (attri, t, (cpu_set_t *)data);
+			/* pthread_attr_setaffinity_np, node CPUs */
+		case PTH_ATTR_NUMANODE:
+			return pth_attri_node (attri, t, di);
+			/* pth_attri_place */
+		case PTH_ATTR_PERCORE:
+			if (attri->cpus == (int *)NULL) {
+				/* round robin over the CPUs the process may use */
+				if (sched_getaffinity (0, sizeof(cpu_set_t), &set) != 0
+					|| pth_attri_list (attri, &set) != CAF_OK) {
+					return CAF_ERROR_SUB;
+				}
+			}
+			attri->at |= t;
+			return 0;
+#endif /* !LINUX_SYSTEM */
 		default:
 			return CAF_ERROR_SUB;
 		}
@@ -186,6 +234,21 @@ pth_attri_get (pth_attri_t *attri, pth_attr_types_t t, void *data) {
 			/* pthread_attr_getscope */
 		case PTH_ATTR_SCOPE:
 			return pthread_attr_getscope (&(attri->attr), (int *)data);
+#ifdef LINUX_SYSTEM
+			/* pthread_attr_getaffinity_np */
+		case PTH_ATTR_CPUSET:
+			return pthread_attr_getaffinity_np (&(attri->attr),
+			                                    sizeof(cpu_set_t),
+			                                    (cpu_set_t *)data);
+			/* the node number */
+		case PTH_ATTR_NUMANODE:
+			*((int *)data) = attri->node;
+			return 0;
+			/* one if threads are placed per core */
+		case PTH_ATTR_PERCORE:
+			*((int *)data) = (attri->at & PTH_ATTR_PERCORE) != 0;
+			return 0;
+#endif /* !LINUX_SYSTEM */
 		default:
 			return CAF_ERROR_SUB;
 		}
@@ -193,5 +256,215 @@ pth_attri_get (pth_attri_t *attri, pth_attr_types_t t, void *data) {
 	return CAF_ERROR_SUB;
 }
 
+
+
+int
+pth_attri_place (pth_attri_t *attri, pthread_attr_t *attr) {
+	struct sched_param sp;
+	size_t sz;
+	int v, rt;
+#ifdef LINUX_SYSTEM
+	cpu_set_t set;
+	unsigned int c;
+#endif /* !LINUX_SYSTEM */
+	if (attri == (pth_attri_t *)NULL || attr == (pthread_attr_t *)NULL) {
+		return EINVAL;
+	}
+	rt = pthread_attr_init (attr);
+	if (rt != 0) {
+		return rt;
+	}
+	/* pthread attributes can not be copied, each one is carried over */
+	if ((rt = pthread_attr_getdetachstate (&(attri->attr), &v)) == 0) {
+		rt = pthread_attr_setdetachstate (attr, v);
+	}
+	if (rt == 0
+		&& (rt = pthread_attr_getstacksize (&(attri->attr), &sz)) == 0) {
+		rt = pthread_attr_setstacksize (attr, sz);
+	}
+	if (rt == 0
+		&& (rt = pthread_attr_getguardsize (&(attri->attr), &sz)) == 0) {
+		rt = pthread_attr_setguardsize (attr, sz);
+	}
+	if (rt == 0
+		&& (rt = pthread_attr_getinheritsched (&(attri->attr), &v)) == 0) {
+		rt = pthread_attr_setinheritsched (attr, v);
+	}
+	if (rt == 0
+		&& (rt = pthread_attr_getschedpolicy (&(attri->attr), &v)) == 0) {
+		rt = pthread_attr_setschedpolicy (attr, v);
+	}
+	if (rt == 0
+		&& (rt = pthread_attr_getschedparam (&(attri->attr), &sp)) == 0) {
+		rt = pthread_attr_setschedparam (attr, &sp);
+	}
+	if (rt == 0
+		&& (rt = pthread_attr_getscope (&(attri->attr), &v)) == 0) {
+		rt = pthread_attr_setscope (attr, v);
+	}
+#ifdef LINUX_SYSTEM
+	if (rt == 0 && (attri->at & PTH_ATTR_PERCORE)
+		&& attri->cpus != (int *)NULL) {
+		/* the thread starts on its CPU and first touches memory there */
+		c = (unsigned int)__atomic_fetch_add (&(attri->next), 1,
+		                                      __ATOMIC_RELAXED);
+		CPU_ZERO (&set);
+		CPU_SET (attri->cpus[c % (unsigned int)attri->ncpu], &set);
+		rt = pthread_attr_setaffinity_np (attr, sizeof(cpu_set_t), &set);
+	} else if (rt == 0
+			   && (attri->at & (PTH_ATTR_CPUSET | PTH_ATTR_NUMANODE))
+			   && (rt = pthread_attr_getaffinity_np (&(attri->attr),
+			                                         sizeof(cpu_set_t),
+			                                         &set)) == 0) {
+		rt = pthread_attr_setaffinity_np (attr, sizeof(cpu_set_t), &set);
+	}
+#endif /* !LINUX_SYSTEM */
+	if (rt != 0) {
+		pthread_attr_destroy (attr);
+	}
+	return rt;
+}
+
+
+int
+pth_attri_nodes (void) {
+#ifdef LINUX_SYSTEM
+	cpu_set_t nodes;
+	/* the node list has the same format as a CPU list */
+	if (pth_attri_cpulist (PTH_ATTRI_SYSFS "/node/online", &nodes)
+		== CAF_OK) {
+		return CPU_COUNT (&nodes);
+	}
+#endif /* !LINUX_SYSTEM */
+	return 1;
+}
+
+
+#ifdef LINUX_SYSTEM
+static int
+pth_attri_cpus (pth_attri_t *attri, pth_attr_types_t t,
+                const cpu_set_t *set) {
+	int rt;
+	if (set == (const cpu_set_t *)NULL) {
+		return CAF_ERROR_SUB;
+	}
+	rt = pthread_attr_setaffinity_np (&(attri->attr), sizeof(cpu_set_t),
+	                                  set);
+	if (rt == 0) {
+		if (pth_attri_list (attri, set) != CAF_OK) {
+			return CAF_ERROR_SUB;
+		}
+		attri->at |= t;
+	}
+	return rt;
+}
+
+
+static int
+pth_attri_node (pth_attri_t *attri, pth_attr_types_t t, const int *node) {
+	char path[PTH_ATTRI_PATH];
+	cpu_set_t set;
+	int rt;
+	if (node == (const int *)NULL || *node < 0) {
+		return CAF_ERROR_SUB;
+	}
+	snprintf (path, sizeof(path), PTH_ATTRI_SYSFS "/node/node%d/cpulist",
+	          *node);
+	if (pth_attri_cpulist (path, &set) != CAF_OK) {
+		return CAF_ERROR_SUB;
+	}
+	rt = pth_attri_cpus (attri, t, &set);
+	if (rt == 0) {
+		attri->node = *node;
+	}
+	return rt;
+}
+
+
+static int
+pth_attri_list (pth_attri_t *attri, const cpu_set_t *set) {
+	int *cpus;
+	int c, pass, n = 0;
+	cpus = (int *)xmalloc ((size_t)CPU_COUNT (set) * sizeof(int));
+	if (cpus == (int *)NULL) {
+		return CAF_ERROR;
+	}
+	/* the first thread of every core, then their siblings */
+	for (pass = 0; pass < 2; pass++) {
+		for (c = 0; c < CPU_SETSIZE; c++) {
+			if (CPU_ISSET (c, set)
+				&& (pth_attri_primary (c) == CAF_OK) == (pass == 0)) {
+				cpus[n++] = c;
+			}
+		}
+	}
+	if (attri->cpus != (int *)NULL) {
+		xfree (attri->cpus);
+	}
+	attri->cpus = cpus;
+	attri->ncpu = n;
+	attri->next = 0;
+	return CAF_OK;
+}
+
+
+static int
+pth_attri_primary (int cpu) {
+	char path[PTH_ATTRI_PATH];
+	cpu_set_t siblings;
+	int c;
+	snprintf (path, sizeof(path), PTH_ATTRI_SYSFS
+	          "/cpu/cpu%d/topology/thread_siblings_list", cpu);
+	if (pth_attri_cpulist (path, &siblings) != CAF_OK) {
+		/* without topology every CPU counts as a core */
+		return CAF_OK;
+	}
+	for (c = 0; c < cpu; c++) {
+		if (CPU_ISSET (c, &siblings)) {
+			return CAF_ERROR;
+		}
+	}
+	return CAF_OK;
+}
+
+
+static int
+pth_attri_cpulist (const char *path, cpu_set_t *set) {
+	char buf[1024], *p, *end;
+	long lo, hi;
+	FILE *f;
+	CPU_ZERO (set);
+	f = fopen (path, "r");
+	if (f == (FILE *)NULL) {
+		return CAF_ERROR;
+	}
+	p = fgets (buf, sizeof(buf), f);
+	fclose (f);
+	if (p == (char *)NULL) {
+		return CAF_ERROR;
+	}
+	/* comma separated ranges, such as 0-3,8-11 */
+	while (*p != '\0' && *p != '\n') {
+		lo = strtol (p, &end, 10);
+		if (end == p || lo < 0) {
+			return CAF_ERROR;
+		}
+		hi = lo;
+		if (*end == '-') {
+			p = end + 1;
+			hi = strtol (p, &end, 10);
+			if (end == p) {
+				return CAF_ERROR;
+			}
+		}
+		for (; lo <= hi && lo < CPU_SETSIZE; lo++) {
+			CPU_SET (lo, set);
+		}
+		p = *end == ',' ? end + 1 : end;
+	}
+	return CPU_COUNT (set) > 0 ? CAF_OK : CAF_ERROR;
+}
+#endif /* !LINUX_SYSTEM */
+
 /* caf_thread_attr.c ends here */
 
@@ -0,0 +1,503 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_queue.h"
+#include "caf/caf_thread_future.h"
+
+/**
+ * A continuation waiting for its source future.
+ */
+typedef struct pth_future_then_s pth_future_then_t;
+struct pth_future_then_s {
+	/** Continuation Routine */
+	PTH_FUTURE_THEN(rtn);
+	/** Continuation Routine Argument */
+	void *arg;
+	/** Pool to run on, or NULL */
+	pth_pool_t *pool;
+	/** Source Value */
+	void *value;
+	/** Continuation Future */
+	pth_future_t *next;
+};
+
+/**
+ * The state shared by the listeners of a combinator.
+ */
+typedef struct pth_future_join_s pth_future_join_t;
+struct pth_future_join_s {
+	/** Combined Future */
+	pth_future_t *out;
+	/** Futures not settled yet */
+	int left;
+};
+
+/**
+ * A routine running on an executor pool for a future.
+ */
+typedef struct pth_future_job_s pth_future_job_t;
+struct pth_future_job_s {
+	/** Routine */
+	CAF_PT_PROTOTYPE(rtn);
+	/** Routine Argument */
+	void *arg;
+	/** Future of the routine result */
+	pth_future_t *f;
+};
+
+static int pth_future_settle (pth_future_t *f, int state, void *value,
+                              int error);
+static int pth_future_listen (pth_future_t *f,
+                              void (*rtn)(pth_future_t *f, void *arg),
+                              void *arg);
+static void pth_future_then_cb (pth_future_t *f, void *arg);
+static void *pth_future_then_run (void *arg);
+static void pth_future_all_cb (pth_future_t *f, void *arg);
+static void pth_future_any_cb (pth_future_t *f, void *arg);
+static void *pth_future_job_run (void *arg);
+static pth_future_join_t *pth_future_join (int cnt);
+static int pth_future_remaining (const struct timespec *end,
+                                 struct timespec *left);
+
+
+pth_future_t *
+pth_future_new (void) {
+	pth_future_t *f = (pth_future_t *)NULL;
+	f = (pth_future_t *)xmalloc (PTH_FUTURE_SZ);
+	if (f != (pth_future_t *)NULL) {
+		if (pthread_mutex_init (&(f->lock), NULL) != 0) {
+			xfree (f);
+			return (pth_future_t *)NULL;
+		}
+		f->state = PTH_FUTURE_PENDING;
+		f->value = (void *)NULL;
+		f->error = 0;
+		f->cbs = (pth_future_cb_t *)NULL;
+		f->waiters = 0;
+		f->refs = 1;
+	}
+	return f;
+}
+
+
+pth_future_t *
+pth_future_retain (pth_future_t *f) {
+	if (f != (pth_future_t *)NULL) {
+		__atomic_add_fetch (&(f->refs), 1, __ATOMIC_RELAXED);
+	}
+	return f;
+}
+
+
+void
+pth_future_release (pth_future_t *f) {
+	pth_future_cb_t *cb, *next;
+	if (f != (pth_future_t *)NULL
+		&& __atomic_sub_fetch (&(f->refs), 1, __ATOMIC_ACQ_REL) == 0) {
+		/* listeners of a future that never settled */
+		cb = f->cbs;
+		while (cb != (pth_future_cb_t *)NULL) {
+			next = cb->next;
+			xfree (cb);
+			cb = next;
+		}
+		pthread_mutex_destroy (&(f->lock));
+		xfree (f);
+	}
+}
+
+
+int
+pth_future_resolve (pth_future_t *f, void *value) {
+	return pth_future_settle (f, PTH_FUTURE_READY, value, 0);
+}
+
+
+int
+pth_future_fail (pth_future_t *f, int error) {
+	return pth_future_settle (f, PTH_FUTURE_FAILED, (void *)NULL, error);
+}
+
+
+int
+pth_future_state (pth_future_t *f) {
+	if (f != (pth_future_t *)NULL) {
+		return __atomic_load_n (&(f->state), __ATOMIC_ACQUIRE);
+	}
+	return PTH_FUTURE_FAILED;
+}
+
+
+int
+pth_future_error (pth_future_t *f) {
+	if (pth_future_state (f) == PTH_FUTURE_FAILED
+		&& f != (pth_future_t *)NULL) {
+		return f->error;
+	}
+	return 0;
+}
+
+
+int
+pth_future_wait (pth_future_t *f, const struct timespec *tm,
+                 void **value) {
+	struct timespec end, left;
+	int st;
+	if (f == (pth_future_t *)NULL) {
+		return CAF_ERROR;
+	}
+	if (tm != (const struct timespec *)NULL) {
+		clock_gettime (CLOCK_MONOTONIC, &end);
+		end.tv_sec += tm->tv_sec;
+		end.tv_nsec += tm->tv_nsec;
+		if (end.tv_nsec >= 1000000000L) {
+			end.tv_sec++;
+			end.tv_nsec -= 1000000000L;
+		}
+	}
+	while ((st = __atomic_load_n (&(f->state), __ATOMIC_SEQ_CST))
+		   == PTH_FUTURE_PENDING) {
+		if (tm != (const struct timespec *)NULL
+			&& pth_future_remaining (&end, &left) != CAF_OK) {
+			return CAF_ERROR_SUB;
+		}
+		__atomic_add_fetch (&(f->waiters), 1, __ATOMIC_SEQ_CST);
+		pth_word_wait (&(f->state), st, tm != (const struct timespec *)NULL
+		               ? &left : (const struct timespec *)NULL);
+		__atomic_sub_fetch (&(f->waiters), 1, __ATOMIC_SEQ_CST);
+	}
+	if (st == PTH_FUTURE_READY) {
+		if (value != (void **)NULL) {
+			*value = f->value;
+		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+pth_future_t *
+pth_future_then (pth_future_t *f, pth_pool_t *pool, PTH_FUTURE_THEN(rtn),
+                 void *arg) {
+	pth_future_then_t *t;
+	pth_future_t *next;
+	if (f == (pth_future_t *)NULL || rtn == NULL) {
+		return (pth_future_t *)NULL;
+	}
+	t = (pth_future_then_t *)xmalloc (sizeof(pth_future_then_t));
+	if (t == (pth_future_then_t *)NULL) {
+		return (pth_future_t *)NULL;
+	}
+	t->next = pth_future_new ();
+	if (t->next == (pth_future_t *)NULL) {
+		xfree (t);
+		return (pth_future_t *)NULL;
+	}
+	t->rtn = rtn;
+	t->arg = arg;
+	t->pool = pool;
+	t->value = (void *)NULL;
+	/* one reference for the caller, one for the continuation */
+	next = pth_future_retain (t->next);
+	if (pth_future_listen (f, pth_future_then_cb, t) != CAF_OK) {
+		pth_future_release (next);
+		pth_future_release (next);
+		xfree (t);
+		return (pth_future_t *)NULL;
+	}
+	/* t may be gone already, the continuation could have run */
+	return next;
+}
+
+
+pth_future_t *
+pth_future_when_all (pth_future_t **fs, int cnt) {
+	pth_future_join_t *j;
+	pth_future_t *out;
+	int c;
+	if (fs == (pth_future_t **)NULL || cnt < 0) {
+		return (pth_future_t *)NULL;
+	}
+	j = pth_future_join (cnt);
+	if (j == (pth_future_join_t *)NULL) {
+		return (pth_future_t *)NULL;
+	}
+	out = pth_future_retain (j->out);
+	if (cnt == 0) {
+		pth_future_resolve (out, (void *)NULL);
+		pth_future_release (out);
+		xfree (j);
+		return out;
+	}
+	for (c = 0; c < cnt; c++) {
+		if (pth_future_listen (fs[c], pth_future_all_cb, j) != CAF_OK) {
+			/* counts as a failure, so the join still completes */
+			pth_future_all_cb ((pth_future_t *)NULL, j);
+		}
+	}
+	return out;
+}
+
+
+pth_future_t *
+pth_future_when_any (pth_future_t **fs, int cnt) {
+	pth_future_join_t *j;
+	pth_future_t *out;
+	int c;
+	if (fs == (pth_future_t **)NULL || cnt <= 0) {
+		return (pth_future_t *)NULL;
+	}
+	j = pth_future_join (cnt);
+	if (j == (pth_future_join_t *)NULL) {
+		return (pth_future_t *)NULL;
+	}
+	out = pth_future_retain (j->out);
+	for (c = 0; c < cnt; c++) {
+		if (pth_future_listen (fs[c], pth_future_any_cb, j) != CAF_OK) {
+			pth_future_any_cb ((pth_future_t *)NULL, j);
+		}
+	}
+	return out;
+}
+
+
+pth_future_t *
+pth_future_async (pth_pool_t *pool, CAF_PT_PROTOTYPE(rtn), void *arg) {
+	pth_future_job_t *job;
+	pth_task_t *task;
+	pth_future_t *f;
+	if (pool == (pth_pool_t *)NULL || rtn == NULL) {
+		return (pth_future_t *)NULL;
+	}
+	job = (pth_future_job_t *)xmalloc (sizeof(pth_future_job_t));
+	if (job == (pth_future_job_t *)NULL) {
+		return (pth_future_t *)NULL;
+	}
+	job->f = pth_future_new ();
+	if (job->f == (pth_future_t *)NULL) {
+		xfree (job);
+		return (pth_future_t *)NULL;
+	}
+	job->rtn = rtn;
+	job->arg = arg;
+	/* one reference for the caller, one for the task */
+	f = pth_future_retain (job->f);
+	task = pth_pool_submit (pool, pth_future_job_run, job);
+	if (task == (pth_task_t *)NULL) {
+		pth_future_release (f);
+		pth_future_release (f);
+		xfree (job);
+		return (pth_future_t *)NULL;
+	}
+	pth_task_release (task);
+	return f;
+}
+
+
+static int
+pth_future_settle (pth_future_t *f, int state, void *value, int error) {
+	pth_future_cb_t *cb, *next, *run = (pth_future_cb_t *)NULL;
+	if (f == (pth_future_t *)NULL) {
+		return CAF_ERROR;
+	}
+	pthread_mutex_lock (&(f->lock));
+	if (f->state != PTH_FUTURE_PENDING) {
+		pthread_mutex_unlock (&(f->lock));
+		return CAF_ERROR;
+	}
+	f->value = value;
+	f->error = error;
+	cb = f->cbs;
+	f->cbs = (pth_future_cb_t *)NULL;
+	__atomic_store_n (&(f->state), state, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock (&(f->lock));
+	if (__atomic_load_n (&(f->waiters), __ATOMIC_SEQ_CST) > 0) {
+		pth_word_wake (&(f->state), INT_MAX);
+	}
+	/* the listeners run in the order they were added */
+	while (cb != (pth_future_cb_t *)NULL) {
+		next = cb->next;
+		cb->next = run;
+		run = cb;
+		cb = next;
+	}
+	while (run != (pth_future_cb_t *)NULL) {
+		next = run->next;
+		run->rtn (f, run->arg);
+		xfree (run);
+		run = next;
+	}
+	return CAF_OK;
+}
+
+
+static int
+pth_future_listen (pth_future_t *f, void (*rtn)(pth_future_t *f, void *arg),
+                   void *arg) {
+	pth_future_cb_t *cb;
+	if (f == (pth_future_t *)NULL) {
+		return CAF_ERROR;
+	}
+	cb = (pth_future_cb_t *)xmalloc (sizeof(pth_future_cb_t));
+	if (cb == (pth_future_cb_t *)NULL) {
+		return CAF_ERROR;
+	}
+	cb->rtn = rtn;
+	cb->arg = arg;
+	pthread_mutex_lock (&(f->lock));
+	if (f->state == PTH_FUTURE_PENDING) {
+		cb->next = f->cbs;
+		f->cbs = cb;
+		pthread_mutex_unlock (&(f->lock));
+		return CAF_OK;
+	}
+	pthread_mutex_unlock (&(f->lock));
+	/* already settled, the listener runs at once */
+	xfree (cb);
+	rtn (f, arg);
+	return CAF_OK;
+}
+
+
+static void
+pth_future_then_cb (pth_future_t *f, void *arg) {
+	pth_future_then_t *t = (pth_future_then_t *)arg;
+	pth_task_t *task = (pth_task_t *)NULL;
+	if (f->state == PTH_FUTURE_FAILED) {
+		pth_future_fail (t->next, f->error);
+		pth_future_release (t->next);
+		xfree (t);
+		return;
+	}
+	t->value = f->value;
+	if (t->pool != (pth_pool_t *)NULL) {
+		task = pth_pool_submit (t->pool, pth_future_then_run, t);
+	}
+	if (task != (pth_task_t *)NULL) {
+		pth_task_release (task);
+	} else {
+		/* no pool, or it does not take tasks any more */
+		pth_future_then_run (t);
+	}
+}
+
+
+static void *
+pth_future_then_run (void *arg) {
+	pth_future_then_t *t = (pth_future_then_t *)arg;
+	pth_future_resolve (t->next, t->rtn (t->value, t->arg));
+	pth_future_release (t->next);
+	xfree (t);
+	return (void *)NULL;
+}
+
+
+static void
+pth_future_all_cb (pth_future_t *f, void *arg) {
+	pth_future_join_t *j = (pth_future_join_t *)arg;
+	if (f == (pth_future_t *)NULL) {
+		pth_future_fail (j->out, ENOMEM);
+	} else if (f->state == PTH_FUTURE_FAILED) {
+		/* only the first failure settles the combined future */
+		pth_future_fail (j->out, f->error);
+	}
+	if (__atomic_sub_fetch (&(j->left), 1, __ATOMIC_ACQ_REL) == 0) {
+		pth_future_resolve (j->out, (void *)NULL);
+		pth_future_release (j->out);
+		xfree (j);
+	}
+}
+
+
+static void
+pth_future_any_cb (pth_future_t *f, void *arg) {
+	pth_future_join_t *j = (pth_future_join_t *)arg;
+	if (f != (pth_future_t *)NULL) {
+		pth_future_resolve (j->out, (void *)f);
+	}
+	if (__atomic_sub_fetch (&(j->left), 1, __ATOMIC_ACQ_REL) == 0) {
+		/* no future could be listened to */
+		pth_future_fail (j->out, ENOMEM);
+		pth_future_release (j->out);
+		xfree (j);
+	}
+}
+
+
+static void *
+pth_future_job_run (void *arg) {
+	pth_future_job_t *job = (pth_future_job_t *)arg;
+	pth_future_resolve (job->f, job->rtn (job->arg));
+	pth_future_release (job->f);
+	xfree (job);
+	return (void *)NULL;
+}
+
+
+static pth_future_join_t *
+pth_future_join (int cnt) {
+	pth_future_join_t *j;
+	j = (pth_future_join_t *)xmalloc (sizeof(pth_future_join_t));
+	if (j != (pth_future_join_t *)NULL) {
+		j->out = pth_future_new ();
+		if (j->out == (pth_future_t *)NULL) {
+			xfree (j);
+			return (pth_future_join_t *)NULL;
+		}
+		j->left = cnt;
+	}
+	return j;
+}
+
+
+static int
+pth_future_remaining (const struct timespec *end, struct timespec *left) {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	left->tv_sec = end->tv_sec - now.tv_sec;
+	left->tv_nsec = end->tv_nsec - now.tv_nsec;
+	if (left->tv_nsec < 0) {
+		left->tv_sec--;
+		left->tv_nsec += 1000000000L;
+	}
+	if (left->tv_sec < 0) {
+		return CAF_ERROR;
+	}
+	return CAF_OK;
+}
+
+/* caf_thread_future.c ends here */
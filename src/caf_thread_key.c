@@ -36,6 +36,8 @@ static char Id[] = "$Id$";
 #include "caf/caf_data_mem.h"
 #include "caf/caf_thread_key.h"
 
+static void pth_key_arena_delete (void *ptr);
+
 
 pth_key_t *
 pth_key_new (int id, PTH_KEY_DESTROY_RTN(rtn)) {
@@ -209,5 +211,52 @@ pth_kpool_remove_callback (void *k) {
 	return 1;
 }
 
+
+
+pth_key_t *
+pth_key_arena (int id, size_t chunk_sz) {
+	pth_key_t *k = pth_key_new (id, pth_key_arena_delete);
+	if (k != (pth_key_t *)NULL) {
+		/* every thread creates its own arena with this chunk size */
+		k->ptr = (void *)NULL;
+		k->sz = chunk_sz;
+	}
+	return k;
+}
+
+
+caf_arena_t *
+pth_key_get_arena (pth_key_t *key) {
+	caf_arena_t *arena = (caf_arena_t *)NULL;
+	if (key != (pth_key_t *)NULL) {
+		arena = (caf_arena_t *)pthread_getspecific (key->key);
+		if (arena == (caf_arena_t *)NULL) {
+			arena = caf_arena_new (key->sz);
+			if (arena != (caf_arena_t *)NULL
+				&& pthread_setspecific (key->key, arena) != 0) {
+				caf_arena_delete (arena);
+				arena = (caf_arena_t *)NULL;
+			}
+		}
+	}
+	return arena;
+}
+
+
+caf_arena_t *
+pth_kpool_get_arena (pth_kpool_t *pool, int id) {
+	pth_key_t *k = pth_kpool_get_key (pool, id);
+	if (k != (pth_key_t *)NULL && k->id == id) {
+		return pth_key_get_arena (k);
+	}
+	return (caf_arena_t *)NULL;
+}
+
+
+static void
+pth_key_arena_delete (void *ptr) {
+	caf_arena_delete ((caf_arena_t *)ptr);
+}
+
 /* caf_thread_key.c ends here */
 
@@ -0,0 +1,363 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_map.h"
+
+/**
+ * The state shared by the chunks of one parallel map or reduce.
+ */
+typedef struct pth_map_job_s pth_map_job_t;
+struct pth_map_job_s {
+	/** List elements, in list order */
+	void **items;
+	/** Element results, in list order, NULL if not kept */
+	void **out;
+	/** Element count */
+	size_t n;
+	/** Map routine, NULL for reductions */
+	PTH_MAP_RTN(step);
+	/** Fold routine, NULL for maps */
+	PTH_REDUCE_RTN(fold);
+	/** Initial accumulator of every chunk */
+	void *init;
+	/** Chunk indexes in completion order */
+	int *order;
+	/** Completed chunks */
+	int done;
+};
+
+/**
+ * One task worth of elements.
+ */
+typedef struct pth_map_chunk_s pth_map_chunk_t;
+struct pth_map_chunk_s {
+	/** The job of the chunk */
+	pth_map_job_t *job;
+	/** First element */
+	size_t first;
+	/** Element count */
+	size_t cnt;
+	/** Chunk index */
+	int id;
+	/** Chunk accumulator */
+	void *acc;
+};
+
+static int pth_map_job (pth_pool_t *pool, pth_map_job_t *job, size_t grain,
+                        int order, PTH_REDUCE_RTN(combine), void **result);
+static void *pth_map_chunk (void *arg);
+static void **pth_map_deque_items (deque_t *lst, size_t *n);
+static void **pth_map_cdeque_items (cdeque_t *lst, size_t *n);
+
+
+int
+deque_map_parallel (pth_pool_t *pool, deque_t *lst, PTH_MAP_RTN(step),
+                    size_t grain, int order, deque_t *results) {
+	pth_map_job_t job;
+	size_t c;
+	int rt;
+	if (lst == (deque_t *)NULL || step == NULL) {
+		return CAF_ERROR_SUB;
+	}
+	memset (&job, 0, sizeof(pth_map_job_t));
+	job.step = step;
+	job.items = pth_map_deque_items (lst, &(job.n));
+	if (job.n == 0) {
+		return 0;
+	}
+	if (results != (deque_t *)NULL) {
+		job.out = (void **)xmalloc (job.n * sizeof(void *));
+	}
+	if (job.items == (void **)NULL
+		|| (results != (deque_t *)NULL && job.out == (void **)NULL)) {
+		xfree (job.items);
+		xfree (job.out);
+		return CAF_ERROR_SUB;
+	}
+	rt = pth_map_job (pool, &job, grain, order, NULL, (void **)NULL);
+	if (rt == CAF_OK && results != (deque_t *)NULL) {
+		for (c = 0; c < job.n; c++) {
+			deque_push (results, job.out[c]);
+		}
+	}
+	xfree (job.items);
+	xfree (job.out);
+	return rt == CAF_OK ? (int)job.n : CAF_ERROR_SUB;
+}
+
+
+int
+deque_reduce_parallel (pth_pool_t *pool, deque_t *lst, PTH_REDUCE_RTN(fold),
+                       PTH_REDUCE_RTN(combine), void *init, size_t grain,
+                       int order, void **result) {
+	pth_map_job_t job;
+	int rt;
+	if (lst == (deque_t *)NULL || fold == NULL || combine == NULL
+		|| result == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	memset (&job, 0, sizeof(pth_map_job_t));
+	job.fold = fold;
+	job.init = init;
+	job.items = pth_map_deque_items (lst, &(job.n));
+	if (job.n == 0) {
+		*result = init;
+		return CAF_OK;
+	}
+	if (job.items == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	rt = pth_map_job (pool, &job, grain, order, combine, result);
+	xfree (job.items);
+	return rt;
+}
+
+
+int
+cdeque_map_parallel (pth_pool_t *pool, cdeque_t *lst, PTH_MAP_RTN(step),
+                     size_t grain, int order, cdeque_t *results) {
+	pth_map_job_t job;
+	size_t c;
+	int rt;
+	if (lst == (cdeque_t *)NULL || step == NULL) {
+		return CAF_ERROR_SUB;
+	}
+	memset (&job, 0, sizeof(pth_map_job_t));
+	job.step = step;
+	job.items = pth_map_cdeque_items (lst, &(job.n));
+	if (job.n == 0) {
+		return 0;
+	}
+	if (results != (cdeque_t *)NULL) {
+		job.out = (void **)xmalloc (job.n * sizeof(void *));
+	}
+	if (job.items == (void **)NULL
+		|| (results != (cdeque_t *)NULL && job.out == (void **)NULL)) {
+		xfree (job.items);
+		xfree (job.out);
+		return CAF_ERROR_SUB;
+	}
+	rt = pth_map_job (pool, &job, grain, order, NULL, (void **)NULL);
+	if (rt == CAF_OK && results != (cdeque_t *)NULL) {
+		for (c = 0; c < job.n; c++) {
+			cdeque_push (results, job.out[c]);
+		}
+	}
+	xfree (job.items);
+	xfree (job.out);
+	return rt == CAF_OK ? (int)job.n : CAF_ERROR_SUB;
+}
+
+
+int
+cdeque_reduce_parallel (pth_pool_t *pool, cdeque_t *lst,
+                        PTH_REDUCE_RTN(fold), PTH_REDUCE_RTN(combine),
+                        void *init, size_t grain, int order,
+                        void **result) {
+	pth_map_job_t job;
+	int rt;
+	if (lst == (cdeque_t *)NULL || fold == NULL || combine == NULL
+		|| result == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	memset (&job, 0, sizeof(pth_map_job_t));
+	job.fold = fold;
+	job.init = init;
+	job.items = pth_map_cdeque_items (lst, &(job.n));
+	if (job.n == 0) {
+		*result = init;
+		return CAF_OK;
+	}
+	if (job.items == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	rt = pth_map_job (pool, &job, grain, order, combine, result);
+	xfree (job.items);
+	return rt;
+}
+
+
+static int
+pth_map_job (pth_pool_t *pool, pth_map_job_t *job, size_t grain, int order,
+             PTH_REDUCE_RTN(combine), void **result) {
+	pth_map_chunk_t *chunks, *ch;
+	pth_task_t **tasks;
+	void **out;
+	size_t w, pos;
+	int c, cnt, rt = CAF_OK;
+	if (grain == 0) {
+		w = pool != (pth_pool_t *)NULL && pool->count > 0
+			? (size_t)pool->count : 1;
+		grain = (job->n + w * PTH_MAP_CHUNKS - 1) / (w * PTH_MAP_CHUNKS);
+	}
+	cnt = (int)((job->n + grain - 1) / grain);
+	chunks = (pth_map_chunk_t *)xmalloc ((size_t)cnt
+	                                     * sizeof(pth_map_chunk_t));
+	tasks = (pth_task_t **)xmalloc ((size_t)cnt * sizeof(pth_task_t *));
+	job->order = (int *)xmalloc ((size_t)cnt * sizeof(int));
+	job->done = 0;
+	if (chunks == (pth_map_chunk_t *)NULL || tasks == (pth_task_t **)NULL
+		|| job->order == (int *)NULL) {
+		xfree (chunks);
+		xfree (tasks);
+		xfree (job->order);
+		return CAF_ERROR;
+	}
+	for (c = 0; c < cnt; c++) {
+		ch = &(chunks[c]);
+		ch->job = job;
+		ch->first = (size_t)c * grain;
+		ch->cnt = job->n - ch->first < grain ? job->n - ch->first : grain;
+		ch->id = c;
+		ch->acc = job->init;
+		tasks[c] = (pth_task_t *)NULL;
+		if (c > 0 && pool != (pth_pool_t *)NULL) {
+			tasks[c] = pth_pool_submit (pool, pth_map_chunk, (void *)ch);
+		}
+	}
+	pth_map_chunk ((void *)&(chunks[0]));
+	/* workers take chunks from the front, the caller from the back */
+	for (c = cnt - 1; c > 0; c--) {
+		if (tasks[c] == (pth_task_t *)NULL) {
+			pth_map_chunk ((void *)&(chunks[c]));
+		} else if (pth_task_cancel (tasks[c]) == CAF_OK) {
+			pth_task_release (tasks[c]);
+			tasks[c] = (pth_task_t *)NULL;
+			pth_map_chunk ((void *)&(chunks[c]));
+		}
+	}
+	for (c = 1; c < cnt; c++) {
+		if (tasks[c] != (pth_task_t *)NULL) {
+			if (pth_task_wait (tasks[c], (void **)NULL) != CAF_OK) {
+				/* canceled by a pool shutdown, the chunk never ran */
+				pth_map_chunk ((void *)&(chunks[c]));
+			}
+			pth_task_release (tasks[c]);
+		}
+	}
+	if (job->fold != NULL) {
+		*result = chunks[order == PTH_MAP_ORDERED ? 0 : job->order[0]].acc;
+		for (c = 1; c < cnt; c++) {
+			ch = &(chunks[order == PTH_MAP_ORDERED ? c : job->order[c]]);
+			*result = combine (*result, ch->acc);
+		}
+	} else if (job->out != (void **)NULL && order != PTH_MAP_ORDERED) {
+		out = (void **)xmalloc (job->n * sizeof(void *));
+		if (out == (void **)NULL) {
+			rt = CAF_ERROR;
+		} else {
+			for (c = 0, pos = 0; c < cnt; c++) {
+				ch = &(chunks[job->order[c]]);
+				memcpy (out + pos, job->out + ch->first,
+				        ch->cnt * sizeof(void *));
+				pos += ch->cnt;
+			}
+			xfree (job->out);
+			job->out = out;
+		}
+	}
+	xfree (chunks);
+	xfree (tasks);
+	xfree (job->order);
+	job->order = (int *)NULL;
+	return rt;
+}
+
+
+static void *
+pth_map_chunk (void *arg) {
+	pth_map_chunk_t *ch = (pth_map_chunk_t *)arg;
+	pth_map_job_t *job = ch->job;
+	void *res;
+	size_t c;
+	for (c = ch->first; c < ch->first + ch->cnt; c++) {
+		if (job->fold != NULL) {
+			ch->acc = job->fold (ch->acc, job->items[c]);
+		} else {
+			res = job->step (job->items[c]);
+			if (job->out != (void **)NULL) {
+				job->out[c] = res;
+			}
+		}
+	}
+	job->order[__atomic_fetch_add (&(job->done), 1, __ATOMIC_ACQ_REL)]
+		= ch->id;
+	return arg;
+}
+
+
+static void **
+pth_map_deque_items (deque_t *lst, size_t *n) {
+	caf_dequen_t *node;
+	void **items;
+	size_t c = 0;
+	*n = (size_t)deque_length (lst);
+	if (*n == 0) {
+		return (void **)NULL;
+	}
+	items = (void **)xmalloc (*n * sizeof(void *));
+	if (items != (void **)NULL) {
+		node = lst->head;
+		while (node != (caf_dequen_t *)NULL && c < *n) {
+			items[c++] = node->data;
+			node = node->next;
+		}
+	}
+	return items;
+}
+
+
+static void **
+pth_map_cdeque_items (cdeque_t *lst, size_t *n) {
+	caf_cdequen_t *node;
+	void **items;
+	size_t c = 0;
+	*n = (size_t)cdeque_length (lst);
+	if (*n == 0) {
+		return (void **)NULL;
+	}
+	items = (void **)xmalloc (*n * sizeof(void *));
+	if (items != (void **)NULL) {
+		/* the list is circular, the length bounds the walk */
+		node = lst->head;
+		while (node != (caf_cdequen_t *)NULL && c < *n) {
+			items[c++] = node->data;
+			node = node->next;
+		}
+	}
+	return items;
+}
+
+/* caf_thread_map.c ends here */
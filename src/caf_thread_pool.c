@@ -29,7 +29,10 @@ static char Id[] = "$Id$";
 #endif /* !HAVE_CONFIG_H */
 
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
 #include <pthread.h>
 
 #include "caf/caf.h"
@@ -37,6 +40,28 @@ static char Id[] = "$Id$";
 #include "caf/caf_thread_attr.h"
 #include "caf/caf_thread_pool.h"
 
+/** Nap of a waiting worker that found nothing else to run, in ns */
+#define PTH_TASK_HELP_NS        100000L
+
+/** Counts a work stealing event, read by other threads */
+#define PTH_WORKER_COUNT(w, c)  __atomic_store_n (&((w)->c), (w)->c + 1, \
+                                                  __ATOMIC_RELAXED)
+
+static pth_pool_t *pth_pool_start (pth_pool_t *pool);
+static int pth_pool_spawn (pth_attri_t *attri, pthread_t *thr,
+                           CAF_PT_PROTOTYPE(rtn), void *arg);
+static void *pth_pool_worker (void *arg);
+static void *pth_pool_stealer (void *arg);
+static void *pth_pool_scaler (void *arg);
+static void pth_pool_grow (pth_pool_t *pool, long long now);
+static int pth_pool_retire (pth_pool_t *pool);
+static long long pth_pool_now (void);
+static long long pth_pool_ns (const struct timespec *tm);
+static void pth_pool_run (pth_pool_t *pool, pth_task_t *task);
+static int pth_pool_find (pth_worker_t *w, void **data);
+static int pth_pool_has_work (pth_pool_t *pool);
+static void pth_pool_notify (pth_pool_t *pool);
+static void pth_task_finish (pth_task_t *task);
 
 pth_pool_t *
 pth_pool_new (pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn), int count) {
@@ -49,6 +74,16 @@ pth_pool_new (pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn), int count) {
 		if (ptp != (pth_pool_t *)NULL && count > 0) {
 			ptp->attri = attrs;
 			ptp->rtn = rtn;
+			ptp->tasks = (pth_queue_t *)NULL;
+			ptp->state = PTH_POOL_RUNNING;
+			ptp->live = 0;
+			ptp->workers = (pth_worker_t *)NULL;
+			ptp->park_ev = 0;
+			ptp->parked = 0;
+			ptp->policy = (pth_pool_policy_t *)NULL;
+			ptp->idle = 0;
+			ptp->last_pop = 0;
+			ptp->grown_at = 0;
 			ptp->threads = deque_create ();
 			for (c = 1; c <= count; c++) {
 				thr = (pthread_t *)xmalloc (sizeof(pthread_t));
@@ -67,7 +102,31 @@ pth_pool_new (pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn), int count) {
 
 void
 pth_pool_delete (pth_pool_t *p) {
+	int c;
 	if (p != (pth_pool_t *)NULL) {
+		if (p->rtn == pth_pool_worker || p->rtn == pth_pool_stealer
+			|| p->rtn == pth_pool_scaler) {
+			/* executor workers exit by themselves, nothing to cancel */
+			if (p->state == PTH_POOL_RUNNING) {
+				pth_pool_shutdown (p, 1);
+			}
+			if (p->threads != (deque_t *)NULL) {
+				deque_delete (p->threads, deque_delete_cb);
+				p->threads = (deque_t *)NULL;
+			}
+			pth_queue_delete (p->tasks);
+		}
+		if (p->workers != (pth_worker_t *)NULL) {
+			for (c = 0; c < p->count; c++) {
+				pth_wsdeque_delete (p->workers[c].deque);
+			}
+			xfree (p->workers);
+			pthread_key_delete (p->self);
+		}
+		if (p->policy != (pth_pool_policy_t *)NULL) {
+			pthread_mutex_destroy (&(p->lock));
+			xfree (p->policy);
+		}
 		if (p->threads != (deque_t *)NULL) {
 			deque_delete (p->threads, pth_pool_delete_callback);
 		}
@@ -95,7 +154,7 @@ pth_pool_t *
 pth_pool_create (pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn), int cnt, void *arg) {
 	pth_pool_t *pool = (pth_pool_t *)NULL;
 	int rt = 0;
-	caf_dequen_t *n;
+	caf_dequen_t *n, *next;
 	pthread_t *thr;
 	if (rtn != NULL && cnt > 0) {
 		pool = pth_pool_new (attrs, rtn, cnt);
@@ -105,9 +164,14 @@ pth_pool_create (pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn), int cnt, void *arg)
 				if (n != (caf_dequen_t *)NULL) {
 					while (n != (caf_dequen_t *)NULL) {
 						thr = (pthread_t *)n->data;
-						rt = pthread_create (thr, &(pool->attri->attr), rtn,
-						                     arg);
-						n = n->next;
+						next = n->next;
+						rt = pth_pool_spawn (pool->attri, thr, rtn, arg);
+						if (rt != 0) {
+							/* only launched threads stay in the list */
+							deque_node_delete (pool->threads, n,
+							                   deque_delete_cb);
+						}
+						n = next;
 					}
 				}
 			}
@@ -120,7 +184,7 @@ pth_pool_create (pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn), int cnt, void *arg)
 int
 pth_pool_add (pth_pool_t *p, pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn),
               void *arg) {
-	pth_pool_t *pool = (pth_pool_t *)NULL;
+	pth_attri_t *attri;
 	int rt = CAF_ERROR;
 	pthread_t *thr;
 	if (rtn != NULL
@@ -128,15 +192,12 @@ pth_pool_add (pth_pool_t *p, pth_attri_t *attrs, CAF_PT_PROTOTYPE(rtn),
 		&& p->threads != (deque_t *)NULL) {
 		thr = (pthread_t *)xmalloc (sizeof (pthread_t));
 		if (thr != (pthread_t *)NULL) {
-			if (attrs != (pth_attri_t *)NULL) {
-				rt = pthread_create (thr, &(attrs->attr), rtn,
-									 arg);
-			} else {
-				rt = pthread_create (thr, &(pool->attri->attr), rtn,
-									 arg);
-			}
+			attri = attrs != (pth_attri_t *)NULL ? attrs : p->attri;
+			rt = pth_pool_spawn (attri, thr, rtn, arg);
 			if (rt == 0) {
-				deque_push (pool->threads, thr);
+				deque_push (p->threads, thr);
+			} else {
+				xfree (thr);
 			}
 		}
 	}
@@ -224,5 +285,632 @@ pth_pool_cancel (pth_pool_t *pool) {
 	return final;
 }
 
+
+pth_pool_t *
+pth_pool_executor (pth_attri_t *attrs, int cnt, size_t qsz) {
+	pth_pool_t *pool = (pth_pool_t *)NULL;
+	if (cnt > 0) {
+		pool = pth_pool_new (attrs, pth_pool_worker, cnt);
+		if (pool == (pth_pool_t *)NULL) {
+			return pool;
+		}
+		pool->tasks = pth_queue_new (qsz > 0 ? qsz : CAF_PT_QUEUE);
+		pool = pth_pool_start (pool);
+	}
+	return pool;
+}
+
+
+pth_pool_t *
+pth_pool_stealing (pth_attri_t *attrs, int cnt, size_t qsz) {
+	pth_pool_t *pool = (pth_pool_t *)NULL;
+	pth_worker_t *w;
+	int c;
+	if (cnt > 0) {
+		pool = pth_pool_new (attrs, pth_pool_stealer, cnt);
+		if (pool == (pth_pool_t *)NULL) {
+			return pool;
+		}
+		pool->tasks = pth_queue_new (qsz > 0 ? qsz : CAF_PT_QUEUE);
+		/* no worker runs yet, deleting the pool must not wait for them */
+		pool->state = PTH_POOL_STOPPING;
+		if (pool->tasks == (pth_queue_t *)NULL
+			|| pthread_key_create (&(pool->self), NULL) != 0) {
+			pth_pool_delete (pool);
+			return (pth_pool_t *)NULL;
+		}
+		pool->workers = (pth_worker_t *)xmalloc (pool->count *
+		                                         CAF_PT_WORKER_SZ);
+		if (pool->workers == (pth_worker_t *)NULL) {
+			pthread_key_delete (pool->self);
+			pth_pool_delete (pool);
+			return (pth_pool_t *)NULL;
+		}
+		for (c = 0; c < pool->count; c++) {
+			w = &(pool->workers[c]);
+			w->pool = pool;
+			w->deque = pth_wsdeque_new (CAF_PT_WSDEQUE);
+			w->id = c;
+			w->seed = (unsigned int)c * 2654435761U + 1;
+			w->runs = 0;
+			w->steals = 0;
+			w->steal_fails = 0;
+			w->parks = 0;
+			if (w->deque == (pth_wsdeque_t *)NULL) {
+				pool->count = c;
+				pth_pool_delete (pool);
+				return (pth_pool_t *)NULL;
+			}
+		}
+		pool->state = PTH_POOL_RUNNING;
+		pool = pth_pool_start (pool);
+	}
+	return pool;
+}
+
+
+pth_pool_t *
+pth_pool_elastic (pth_attri_t *attrs, const pth_pool_policy_t *policy,
+                  size_t qsz) {
+	pth_pool_t *pool = (pth_pool_t *)NULL;
+	if (policy == (const pth_pool_policy_t *)NULL || policy->min < 1
+		|| policy->max < policy->min) {
+		return pool;
+	}
+	pool = pth_pool_new (attrs, pth_pool_scaler, policy->min);
+	if (pool == (pth_pool_t *)NULL) {
+		return pool;
+	}
+	pool->tasks = pth_queue_new (qsz > 0 ? qsz : CAF_PT_QUEUE);
+	pool->policy = (pth_pool_policy_t *)xmalloc (CAF_PT_POLICY_SZ);
+	if (pool->policy == (pth_pool_policy_t *)NULL) {
+		pool->state = PTH_POOL_STOPPING;
+		pth_pool_delete (pool);
+		return (pth_pool_t *)NULL;
+	}
+	memcpy (pool->policy, policy, CAF_PT_POLICY_SZ);
+	pthread_mutex_init (&(pool->lock), NULL);
+	pool->last_pop = pth_pool_now ();
+	return pth_pool_start (pool);
+}
+
+
+int
+pth_pool_size (pth_pool_t *pool) {
+	if (pool != (pth_pool_t *)NULL) {
+		return __atomic_load_n (&(pool->live), __ATOMIC_SEQ_CST);
+	}
+	return 0;
+}
+
+
+pth_task_t *
+pth_pool_submit (pth_pool_t *pool, CAF_PT_PROTOTYPE(fn), void *arg) {
+	pth_task_t *task = (pth_task_t *)NULL;
+	pth_worker_t *w = (pth_worker_t *)NULL;
+	int st, rt;
+	if (pool == (pth_pool_t *)NULL || pool->tasks == (pth_queue_t *)NULL
+		|| fn == NULL) {
+		return task;
+	}
+	if (pool->workers != (pth_worker_t *)NULL) {
+		w = (pth_worker_t *)pthread_getspecific (pool->self);
+	}
+	st = __atomic_load_n (&(pool->state), __ATOMIC_ACQUIRE);
+	/* a draining pool still runs the sub tasks of its running tasks */
+	if (st == PTH_POOL_RUNNING
+		|| (st == PTH_POOL_DRAINING && w != (pth_worker_t *)NULL)) {
+		task = (pth_task_t *)xmalloc (CAF_PT_TASK_SZ);
+		if (task != (pth_task_t *)NULL) {
+			task->fn = fn;
+			task->arg = arg;
+			task->result = (void *)NULL;
+			task->state = PTH_TASK_QUEUED;
+			task->waiters = 0;
+			/* one reference for the submitter, one for the worker */
+			task->refs = 2;
+			task->queued = pool->policy != (pth_pool_policy_t *)NULL
+				? pth_pool_now () : 0;
+			task->pool = pool;
+			if (w != (pth_worker_t *)NULL) {
+				rt = pth_wsdeque_push (w->deque, task);
+			} else {
+				rt = pth_queue_push (pool->tasks, task);
+			}
+			if (rt != CAF_OK) {
+				xfree (task);
+				return (pth_task_t *)NULL;
+			}
+			if (pool->workers != (pth_worker_t *)NULL) {
+				pth_pool_notify (pool);
+			}
+			/* every worker is busy and none took a task for too long */
+			if (pool->policy != (pth_pool_policy_t *)NULL
+				&& __atomic_load_n (&(pool->idle), __ATOMIC_SEQ_CST) == 0
+				&& task->queued - __atomic_load_n (&(pool->last_pop),
+				                                   __ATOMIC_RELAXED)
+				> pth_pool_ns (&(pool->policy->latency))) {
+				pth_pool_grow (pool, task->queued);
+			}
+		}
+	}
+	return task;
+}
+
+
+int
+pth_pool_submit_batch (pth_pool_t *pool, CAF_PT_PROTOTYPE(fn), void **args,
+                       int cnt, pth_task_t **tasks) {
+	pth_task_t *task;
+	int c;
+	if (args == (void **)NULL) {
+		return 0;
+	}
+	for (c = 0; c < cnt; c++) {
+		task = pth_pool_submit (pool, fn, args[c]);
+		if (task == (pth_task_t *)NULL) {
+			break;
+		}
+		if (tasks != (pth_task_t **)NULL) {
+			tasks[c] = task;
+		} else {
+			pth_task_release (task);
+		}
+	}
+	return c;
+}
+
+
+int
+pth_pool_shutdown (pth_pool_t *pool, int drain) {
+	int live, st = PTH_POOL_RUNNING;
+	if (pool == (pth_pool_t *)NULL || pool->tasks == (pth_queue_t *)NULL) {
+		return CAF_ERROR;
+	}
+	/* only the first shutdown waits for and joins the workers */
+	if (!__atomic_compare_exchange_n (&(pool->state), &st,
+	                                  drain ? PTH_POOL_DRAINING
+	                                  : PTH_POOL_STOPPING, 0,
+	                                  __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+		return CAF_ERROR;
+	}
+	if (pool->policy != (pth_pool_policy_t *)NULL) {
+		/* workers added or retired from now on see the new state */
+		pthread_mutex_lock (&(pool->lock));
+		pthread_mutex_unlock (&(pool->lock));
+	}
+	/* workers keep popping until the closed queue is empty */
+	pth_queue_close (pool->tasks);
+	if (pool->workers != (pth_worker_t *)NULL) {
+		__atomic_add_fetch (&(pool->park_ev), 1, __ATOMIC_SEQ_CST);
+		pth_word_wake (&(pool->park_ev), INT_MAX);
+	}
+	while ((live = __atomic_load_n (&(pool->live), __ATOMIC_SEQ_CST)) > 0) {
+		pth_word_wait (&(pool->live), live, (const struct timespec *)NULL);
+	}
+	/* a worker still touches the pool after it drops the live count */
+	pth_pool_join (pool);
+	return CAF_OK;
+}
+
+
+int
+pth_pool_stats (pth_pool_t *pool, pth_pool_stats_t *stats) {
+	pth_worker_t *w;
+	int c;
+	if (pool == (pth_pool_t *)NULL || stats == (pth_pool_stats_t *)NULL
+		|| pool->workers == (pth_worker_t *)NULL) {
+		return CAF_ERROR;
+	}
+	memset (stats, 0, sizeof (pth_pool_stats_t));
+	for (c = 0; c < pool->count; c++) {
+		w = &(pool->workers[c]);
+		stats->runs += __atomic_load_n (&(w->runs), __ATOMIC_RELAXED);
+		stats->steals += __atomic_load_n (&(w->steals), __ATOMIC_RELAXED);
+		stats->steal_fails += __atomic_load_n (&(w->steal_fails),
+		                                       __ATOMIC_RELAXED);
+		stats->parks += __atomic_load_n (&(w->parks), __ATOMIC_RELAXED);
+	}
+	return CAF_OK;
+}
+
+
+void
+pth_pool_stats_dump (FILE *out, pth_pool_t *pool) {
+	pth_worker_t *w;
+	int c;
+	if (out == (FILE *)NULL || pool == (pth_pool_t *)NULL
+		|| pool->workers == (pth_worker_t *)NULL) {
+		return;
+	}
+	for (c = 0; c < pool->count; c++) {
+		w = &(pool->workers[c]);
+		fprintf (out, "worker %d: runs %lu, steals %lu, steal fails %lu, "
+		         "parks %lu\n", w->id,
+		         __atomic_load_n (&(w->runs), __ATOMIC_RELAXED),
+		         __atomic_load_n (&(w->steals), __ATOMIC_RELAXED),
+		         __atomic_load_n (&(w->steal_fails), __ATOMIC_RELAXED),
+		         __atomic_load_n (&(w->parks), __ATOMIC_RELAXED));
+	}
+}
+
+
+int
+pth_task_wait (pth_task_t *task, void **result) {
+	struct timespec nap = { 0, PTH_TASK_HELP_NS };
+	pth_worker_t *w = (pth_worker_t *)NULL;
+	void *data;
+	int st;
+	if (task == (pth_task_t *)NULL) {
+		return CAF_ERROR;
+	}
+	while ((st = __atomic_load_n (&(task->state), __ATOMIC_SEQ_CST))
+		   < PTH_TASK_DONE) {
+		/* the pool outlives its unfinished tasks */
+		if (w == (pth_worker_t *)NULL
+			&& task->pool->workers != (pth_worker_t *)NULL) {
+			w = (pth_worker_t *)pthread_getspecific (task->pool->self);
+		}
+		if (w != (pth_worker_t *)NULL) {
+			/* the task may sit in this worker's own deque, run it here */
+			if (pth_pool_find (w, &data) == CAF_OK) {
+				pth_pool_run (w->pool, (pth_task_t *)data);
+				PTH_WORKER_COUNT(w, runs);
+				continue;
+			}
+		}
+		__atomic_add_fetch (&(task->waiters), 1, __ATOMIC_SEQ_CST);
+		/* new work wakes nobody up, so a worker only naps */
+		pth_word_wait (&(task->state), st, w != (pth_worker_t *)NULL
+		               ? &nap : (const struct timespec *)NULL);
+		__atomic_sub_fetch (&(task->waiters), 1, __ATOMIC_SEQ_CST);
+	}
+	if (st == PTH_TASK_DONE) {
+		if (result != (void **)NULL) {
+			*result = task->result;
+		}
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+pth_task_poll (pth_task_t *task) {
+	if (task != (pth_task_t *)NULL) {
+		return __atomic_load_n (&(task->state), __ATOMIC_ACQUIRE);
+	}
+	return PTH_TASK_CANCELED;
+}
+
+
+int
+pth_task_cancel (pth_task_t *task) {
+	int st = PTH_TASK_QUEUED;
+	if (task != (pth_task_t *)NULL) {
+		if (__atomic_compare_exchange_n (&(task->state), &st,
+		                                 PTH_TASK_CANCELED, 0,
+		                                 __ATOMIC_SEQ_CST,
+		                                 __ATOMIC_SEQ_CST)) {
+			/* the worker drops the task when it pops it */
+			pth_task_finish (task);
+			return CAF_OK;
+		}
+	}
+	return CAF_ERROR;
+}
+
+
+void
+pth_task_release (pth_task_t *task) {
+	if (task != (pth_task_t *)NULL) {
+		if (__atomic_sub_fetch (&(task->refs), 1, __ATOMIC_ACQ_REL) == 0) {
+			xfree (task);
+		}
+	}
+}
+
+
+static pth_pool_t *
+pth_pool_start (pth_pool_t *pool) {
+	caf_dequen_t *n, *next;
+	pthread_t *thr;
+	void *arg;
+	int c = 0;
+	/* shutdown joins every worker, whatever the attributes asked for */
+	if (pool->tasks == (pth_queue_t *)NULL
+		|| pool->threads == (deque_t *)NULL
+		|| pth_attri_set (pool->attri, PTH_ATTR_JOINABLE, (void *)NULL) != 0) {
+		pool->state = PTH_POOL_STOPPING;
+		pth_pool_delete (pool);
+		return (pth_pool_t *)NULL;
+	}
+	n = pool->threads->head;
+	while (n != (caf_dequen_t *)NULL) {
+		next = n->next;
+		thr = (pthread_t *)n->data;
+		arg = pool->workers != (pth_worker_t *)NULL
+			? (void *)&(pool->workers[c]) : (void *)pool;
+		__atomic_add_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+		if (pth_pool_spawn (pool->attri, thr, pool->rtn, arg) != 0) {
+			/* only launched workers stay in the thread list */
+			__atomic_sub_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+			deque_node_delete (pool->threads, n, deque_delete_cb);
+		}
+		n = next;
+		c++;
+	}
+	return pool;
+}
+
+
+static int
+pth_pool_spawn (pth_attri_t *attri, pthread_t *thr, CAF_PT_PROTOTYPE(rtn),
+                void *arg) {
+	pthread_attr_t attr;
+	int rt;
+	/* every thread gets its own attributes, placed before it runs */
+	rt = pth_attri_place (attri, &attr);
+	if (rt == 0) {
+		rt = pthread_create (thr, &attr, rtn, arg);
+		pthread_attr_destroy (&attr);
+	}
+	return rt;
+}
+
+
+static void *
+pth_pool_worker (void *arg) {
+	pth_pool_t *pool = (pth_pool_t *)arg;
+	void *data;
+	while (pth_queue_pop (pool->tasks, &data) == CAF_OK) {
+		pth_pool_run (pool, (pth_task_t *)data);
+	}
+	__atomic_sub_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+	pth_word_wake (&(pool->live), INT_MAX);
+	return (void *)NULL;
+}
+
+
+static void *
+pth_pool_stealer (void *arg) {
+	pth_worker_t *w = (pth_worker_t *)arg;
+	pth_pool_t *pool = w->pool;
+	void *data;
+	int seen;
+	pthread_setspecific (pool->self, w);
+	for (;;) {
+		if (pth_pool_find (w, &data) == CAF_OK) {
+			pth_pool_run (pool, (pth_task_t *)data);
+			PTH_WORKER_COUNT(w, runs);
+			continue;
+		}
+		if (__atomic_load_n (&(pool->state), __ATOMIC_SEQ_CST)
+			!= PTH_POOL_RUNNING) {
+			/* one more round, then the work left belongs to its owners */
+			if (pth_pool_find (w, &data) == CAF_OK) {
+				pth_pool_run (pool, (pth_task_t *)data);
+				PTH_WORKER_COUNT(w, runs);
+				continue;
+			}
+			break;
+		}
+		/* the counter is read before the last check, so no push is missed */
+		seen = __atomic_load_n (&(pool->park_ev), __ATOMIC_SEQ_CST);
+		__atomic_add_fetch (&(pool->parked), 1, __ATOMIC_SEQ_CST);
+		if (pth_pool_has_work (pool) != CAF_OK
+			&& __atomic_load_n (&(pool->state), __ATOMIC_SEQ_CST)
+			== PTH_POOL_RUNNING) {
+			PTH_WORKER_COUNT(w, parks);
+			pth_word_wait (&(pool->park_ev), seen,
+			               (const struct timespec *)NULL);
+		}
+		__atomic_sub_fetch (&(pool->parked), 1, __ATOMIC_SEQ_CST);
+	}
+	pthread_setspecific (pool->self, NULL);
+	__atomic_sub_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+	pth_word_wake (&(pool->live), INT_MAX);
+	return (void *)NULL;
+}
+
+
+static void *
+pth_pool_scaler (void *arg) {
+	pth_pool_t *pool = (pth_pool_t *)arg;
+	pth_task_t *task;
+	long long now;
+	void *data;
+	int rt;
+	for (;;) {
+		__atomic_add_fetch (&(pool->idle), 1, __ATOMIC_SEQ_CST);
+		rt = pth_queue_timedpop (pool->tasks, &data, &(pool->policy->idle));
+		__atomic_sub_fetch (&(pool->idle), 1, __ATOMIC_SEQ_CST);
+		if (rt == CAF_OK) {
+			task = (pth_task_t *)data;
+			now = pth_pool_now ();
+			__atomic_store_n (&(pool->last_pop), now, __ATOMIC_RELAXED);
+			if (now - task->queued > pth_pool_ns (&(pool->policy->latency))
+				&& pth_queue_length (pool->tasks) > 0) {
+				pth_pool_grow (pool, now);
+			}
+			pth_pool_run (pool, task);
+			continue;
+		}
+		/* the queue is only closed once the pool stops running */
+		if (__atomic_load_n (&(pool->state), __ATOMIC_SEQ_CST)
+			!= PTH_POOL_RUNNING) {
+			break;
+		}
+		if (pth_pool_retire (pool) == CAF_OK) {
+			/* the pool may be gone, the retired thread is detached */
+			return (void *)NULL;
+		}
+	}
+	__atomic_sub_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+	pth_word_wake (&(pool->live), INT_MAX);
+	return (void *)NULL;
+}
+
+
+static void
+pth_pool_grow (pth_pool_t *pool, long long now) {
+	long long period = pth_pool_ns (&(pool->policy->latency));
+	pthread_t *thr;
+	int st, live;
+	if (__atomic_load_n (&(pool->live), __ATOMIC_SEQ_CST) >= pool->policy->max
+		|| now - __atomic_load_n (&(pool->grown_at), __ATOMIC_RELAXED)
+		< period) {
+		return;
+	}
+	pthread_mutex_lock (&(pool->lock));
+	st = __atomic_load_n (&(pool->state), __ATOMIC_SEQ_CST);
+	live = __atomic_load_n (&(pool->live), __ATOMIC_SEQ_CST);
+	if (st == PTH_POOL_RUNNING && live < pool->policy->max
+		&& now - pool->grown_at >= period) {
+		thr = (pthread_t *)xmalloc (sizeof(pthread_t));
+		if (thr != (pthread_t *)NULL) {
+			__atomic_add_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+			/* the new worker can not retire before it is listed */
+			if (pth_pool_spawn (pool->attri, thr, pth_pool_scaler,
+			                    pool) == 0) {
+				deque_push (pool->threads, thr);
+				pool->count++;
+				__atomic_store_n (&(pool->grown_at), now, __ATOMIC_RELAXED);
+			} else {
+				__atomic_sub_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+				xfree (thr);
+			}
+		}
+	}
+	pthread_mutex_unlock (&(pool->lock));
+}
+
+
+static int
+pth_pool_retire (pth_pool_t *pool) {
+	pthread_t self = pthread_self ();
+	caf_dequen_t *n;
+	int st, live, rt = CAF_ERROR;
+	pthread_mutex_lock (&(pool->lock));
+	st = __atomic_load_n (&(pool->state), __ATOMIC_SEQ_CST);
+	live = __atomic_load_n (&(pool->live), __ATOMIC_SEQ_CST);
+	if (st == PTH_POOL_RUNNING && live > pool->policy->min) {
+		n = pool->threads->head;
+		while (n != (caf_dequen_t *)NULL) {
+			if (pthread_equal (*((pthread_t *)n->data), self)) {
+				deque_node_delete (pool->threads, n, deque_delete_cb);
+				break;
+			}
+			n = n->next;
+		}
+		/* nobody joins a thread that left the list */
+		pthread_detach (self);
+		pool->count--;
+		/* shutdown takes the lock, so it reads the live count after this */
+		__atomic_sub_fetch (&(pool->live), 1, __ATOMIC_SEQ_CST);
+		rt = CAF_OK;
+	}
+	pthread_mutex_unlock (&(pool->lock));
+	return rt;
+}
+
+
+static long long
+pth_pool_now (void) {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return pth_pool_ns (&now);
+}
+
+
+static long long
+pth_pool_ns (const struct timespec *tm) {
+	return (long long)tm->tv_sec * 1000000000LL + (long long)tm->tv_nsec;
+}
+
+
+static void
+pth_pool_run (pth_pool_t *pool, pth_task_t *task) {
+	int st = PTH_TASK_QUEUED;
+	if (__atomic_load_n (&(pool->state), __ATOMIC_ACQUIRE)
+		== PTH_POOL_STOPPING) {
+		if (__atomic_compare_exchange_n (&(task->state), &st,
+		                                 PTH_TASK_CANCELED, 0,
+		                                 __ATOMIC_SEQ_CST,
+		                                 __ATOMIC_SEQ_CST)) {
+			pth_task_finish (task);
+		}
+	} else if (__atomic_compare_exchange_n (&(task->state), &st,
+	                                        PTH_TASK_RUNNING, 0,
+	                                        __ATOMIC_SEQ_CST,
+	                                        __ATOMIC_SEQ_CST)) {
+		task->result = task->fn (task->arg);
+		__atomic_store_n (&(task->state), PTH_TASK_DONE, __ATOMIC_SEQ_CST);
+		pth_task_finish (task);
+	}
+	pth_task_release (task);
+}
+
+
+static int
+pth_pool_find (pth_worker_t *w, void **data) {
+	pth_pool_t *pool = w->pool;
+	int c, v;
+	if (pth_wsdeque_pop (w->deque, data) == CAF_OK
+		|| pth_queue_trypop (pool->tasks, data) == CAF_OK) {
+		return CAF_OK;
+	}
+	for (c = 0; c < 2 * pool->count; c++) {
+		/* xorshift victim selection, private to the worker */
+		w->seed ^= w->seed << 13;
+		w->seed ^= w->seed >> 17;
+		w->seed ^= w->seed << 5;
+		v = (int)(w->seed % (unsigned int)pool->count);
+		if (v == w->id) {
+			continue;
+		}
+		if (pth_wsdeque_steal (pool->workers[v].deque, data) == CAF_OK) {
+			PTH_WORKER_COUNT(w, steals);
+			return CAF_OK;
+		}
+		PTH_WORKER_COUNT(w, steal_fails);
+	}
+	return CAF_ERROR;
+}
+
+
+static int
+pth_pool_has_work (pth_pool_t *pool) {
+	int c;
+	if (pth_queue_length (pool->tasks) > 0) {
+		return CAF_OK;
+	}
+	for (c = 0; c < pool->count; c++) {
+		if (pth_wsdeque_length (pool->workers[c].deque) > 0) {
+			return CAF_OK;
+		}
+	}
+	return CAF_ERROR;
+}
+
+
+static void
+pth_pool_notify (pth_pool_t *pool) {
+	/* pairs with the parked count increment of a parking worker */
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	if (__atomic_load_n (&(pool->parked), __ATOMIC_SEQ_CST) > 0) {
+		__atomic_add_fetch (&(pool->park_ev), 1, __ATOMIC_SEQ_CST);
+		pth_word_wake (&(pool->park_ev), 1);
+	}
+}
+
+
+static void
+pth_task_finish (pth_task_t *task) {
+	if (__atomic_load_n (&(task->waiters), __ATOMIC_SEQ_CST) > 0) {
+		pth_word_wake (&(task->state), INT_MAX);
+	}
+}
+
 /* caf_thread_pool.c ends here */
 
@@ -0,0 +1,531 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+#ifndef lint
+static char Id[] = "$Id$";
+#endif /* !lint */
+
+#ifdef HAVE_CONFIG_H
+#include "caf/config.h"
+#endif /* !HAVE_CONFIG_H */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#ifdef LINUX_SYSTEM
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif /* !LINUX_SYSTEM */
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_queue.h"
+
+
+#define PTH_QUEUE_LOAD(p)       __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#define PTH_QUEUE_STORE(p, v)   __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#define PTH_QUEUE_CAS(p, o, n)  __atomic_compare_exchange_n ((p), (o), (n), \
+                                    1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define PTH_QUEUE_ADD(p, v)     __atomic_add_fetch ((p), (v), __ATOMIC_SEQ_CST)
+
+#ifndef PTH_QUEUE_RETRY_HOOK
+/**
+ * Runs between a waiter registration and its retry. Empty, the
+ * regression test defines it to force a push or pop into the window.
+ */
+#define PTH_QUEUE_RETRY_HOOK(q)
+#endif /* !PTH_QUEUE_RETRY_HOOK */
+
+static void pth_queue_signal (int *word, int *waiters, int *pending);
+static pth_wsarray_t *pth_wsarray_new (const size_t cnt);
+static pth_wsarray_t *pth_wsarray_grow (pth_wsdeque_t *d, pth_wsarray_t *a,
+                                        const long b, const long t);
+static int pth_queue_remaining (const struct timespec *end,
+                                struct timespec *left);
+
+
+pth_queue_t *
+pth_queue_new (const size_t cnt) {
+	pth_queue_t *q = (pth_queue_t *)NULL;
+	size_t cap = PTH_QUEUE_MIN, i;
+	if (cnt > 0) {
+		while (cap < cnt) {
+			cap <<= 1;
+		}
+		q = (pth_queue_t *)xmalloc (PTH_QUEUE_SZ);
+		if (q != (pth_queue_t *)NULL) {
+			q->slots = (pth_queue_slot_t *)xmalloc (cap * PTH_QUEUE_SLOT_SZ);
+			if (q->slots == (pth_queue_slot_t *)NULL) {
+				xfree (q);
+				return (pth_queue_t *)NULL;
+			}
+			for (i = 0; i < cap; i++) {
+				q->slots[i].seq = i;
+				q->slots[i].data = (void *)NULL;
+			}
+			q->enq = 0;
+			q->deq = 0;
+			q->push_ev = 0;
+			q->pop_ev = 0;
+			q->push_waiters = 0;
+			q->pop_waiters = 0;
+			q->push_pending = 0;
+			q->pop_pending = 0;
+			q->closed = 0;
+			q->mask = cap - 1;
+		}
+	}
+	return q;
+}
+
+
+int
+pth_queue_delete (pth_queue_t *q) {
+	if (q != (pth_queue_t *)NULL) {
+		xfree (q->slots);
+		xfree (q);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+pth_queue_trypush (pth_queue_t *q, void *data) {
+	pth_queue_slot_t *slot;
+	size_t pos, seq;
+	long dif;
+	if (q == (pth_queue_t *)NULL || PTH_QUEUE_LOAD(&(q->closed))) {
+		return CAF_ERROR;
+	}
+	pos = __atomic_load_n (&(q->enq), __ATOMIC_RELAXED);
+	for (;;) {
+		slot = &(q->slots[pos & q->mask]);
+		seq = PTH_QUEUE_LOAD(&(slot->seq));
+		dif = (long)seq - (long)pos;
+		if (dif == 0) {
+			/* the slot is free for this lap, claims the position */
+			if (PTH_QUEUE_CAS(&(q->enq), &pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			/* the slot still holds the item of the previous lap */
+			return CAF_ERROR;
+		} else {
+			pos = __atomic_load_n (&(q->enq), __ATOMIC_RELAXED);
+		}
+	}
+	slot->data = data;
+	PTH_QUEUE_STORE(&(slot->seq), pos + 1);
+	PTH_QUEUE_ADD(&(q->push_ev), 1);
+	pth_queue_signal (&(q->push_ev), &(q->push_waiters), &(q->push_pending));
+	return CAF_OK;
+}
+
+
+int
+pth_queue_trypop (pth_queue_t *q, void **data) {
+	pth_queue_slot_t *slot;
+	size_t pos, seq;
+	long dif;
+	if (q == (pth_queue_t *)NULL || data == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	pos = __atomic_load_n (&(q->deq), __ATOMIC_RELAXED);
+	for (;;) {
+		slot = &(q->slots[pos & q->mask]);
+		seq = PTH_QUEUE_LOAD(&(slot->seq));
+		dif = (long)seq - (long)(pos + 1);
+		if (dif == 0) {
+			if (PTH_QUEUE_CAS(&(q->deq), &pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			/* the producer of this lap did not publish yet */
+			return CAF_ERROR;
+		} else {
+			pos = __atomic_load_n (&(q->deq), __ATOMIC_RELAXED);
+		}
+	}
+	*data = slot->data;
+	/* frees the slot for the producer of the next lap */
+	PTH_QUEUE_STORE(&(slot->seq), pos + q->mask + 1);
+	PTH_QUEUE_ADD(&(q->pop_ev), 1);
+	pth_queue_signal (&(q->pop_ev), &(q->pop_waiters), &(q->pop_pending));
+	return CAF_OK;
+}
+
+
+int
+pth_queue_push (pth_queue_t *q, void *data) {
+	int seen, waited = 0;
+	if (q == (pth_queue_t *)NULL) {
+		return CAF_ERROR;
+	}
+	while (pth_queue_trypush (q, data) != CAF_OK) {
+		/* the counter is read before the retry, so no pop is missed */
+		seen = PTH_QUEUE_LOAD(&(q->pop_ev));
+		PTH_QUEUE_ADD(&(q->pop_waiters), 1);
+		if (PTH_QUEUE_LOAD(&(q->closed))) {
+			PTH_QUEUE_STORE(&(q->pop_pending), 0);
+			PTH_QUEUE_ADD(&(q->pop_waiters), -1);
+			return CAF_ERROR;
+		}
+		PTH_QUEUE_RETRY_HOOK(q);
+		if (pth_queue_trypush (q, data) == CAF_OK) {
+			/*
+			 * A consumer may have signalled us in between, its wake
+			 * up reached no one, so the flag is ours to clear.
+			 */
+			PTH_QUEUE_STORE(&(q->pop_pending), 0);
+			PTH_QUEUE_ADD(&(q->pop_waiters), -1);
+			waited = 1;
+			break;
+		}
+		pth_word_wait (&(q->pop_ev), seen, (const struct timespec *)NULL);
+		waited = 1;
+		PTH_QUEUE_STORE(&(q->pop_pending), 0);
+		PTH_QUEUE_ADD(&(q->pop_waiters), -1);
+	}
+	if (waited && pth_queue_length (q) <= q->mask) {
+		/* passes the wake up on to the next sleeping producer */
+		pth_queue_signal (&(q->pop_ev), &(q->pop_waiters),
+		                  &(q->pop_pending));
+	}
+	return CAF_OK;
+}
+
+
+int
+pth_queue_pop (pth_queue_t *q, void **data) {
+	return pth_queue_timedpop (q, data, (const struct timespec *)NULL);
+}
+
+
+int
+pth_queue_timedpop (pth_queue_t *q, void **data, const struct timespec *tm) {
+	struct timespec end, left;
+	int seen, waited = 0;
+	if (q == (pth_queue_t *)NULL || data == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	if (tm != (const struct timespec *)NULL) {
+		clock_gettime (CLOCK_MONOTONIC, &end);
+		end.tv_sec += tm->tv_sec;
+		end.tv_nsec += tm->tv_nsec;
+		if (end.tv_nsec >= 1000000000L) {
+			end.tv_sec++;
+			end.tv_nsec -= 1000000000L;
+		}
+	}
+	while (pth_queue_trypop (q, data) != CAF_OK) {
+		seen = PTH_QUEUE_LOAD(&(q->push_ev));
+		PTH_QUEUE_ADD(&(q->push_waiters), 1);
+		PTH_QUEUE_RETRY_HOOK(q);
+		if (pth_queue_trypop (q, data) == CAF_OK) {
+			/* a producer may have signalled us in between */
+			PTH_QUEUE_STORE(&(q->push_pending), 0);
+			PTH_QUEUE_ADD(&(q->push_waiters), -1);
+			waited = 1;
+			break;
+		}
+		if (PTH_QUEUE_LOAD(&(q->closed))) {
+			PTH_QUEUE_STORE(&(q->push_pending), 0);
+			PTH_QUEUE_ADD(&(q->push_waiters), -1);
+			return CAF_ERROR;
+		}
+		if (tm != (const struct timespec *)NULL) {
+			if (pth_queue_remaining (&end, &left) != CAF_OK) {
+				PTH_QUEUE_STORE(&(q->push_pending), 0);
+				PTH_QUEUE_ADD(&(q->push_waiters), -1);
+				if (pth_queue_length (q) > 0) {
+					/* the wake up may have been ours, passes it on */
+					pth_queue_signal (&(q->push_ev), &(q->push_waiters),
+					                  &(q->push_pending));
+				}
+				return CAF_ERROR;
+			}
+			pth_word_wait (&(q->push_ev), seen, &left);
+		} else {
+			pth_word_wait (&(q->push_ev), seen,
+			                 (const struct timespec *)NULL);
+		}
+		waited = 1;
+		PTH_QUEUE_STORE(&(q->push_pending), 0);
+		PTH_QUEUE_ADD(&(q->push_waiters), -1);
+	}
+	if (waited && pth_queue_length (q) > 0) {
+		/* passes the wake up on to the next sleeping consumer */
+		pth_queue_signal (&(q->push_ev), &(q->push_waiters),
+		                  &(q->push_pending));
+	}
+	return CAF_OK;
+}
+
+
+int
+pth_queue_close (pth_queue_t *q) {
+	if (q != (pth_queue_t *)NULL) {
+		PTH_QUEUE_STORE(&(q->closed), 1);
+		/* bumps both counters, so no sleeper misses the close */
+		PTH_QUEUE_ADD(&(q->push_ev), 1);
+		PTH_QUEUE_ADD(&(q->pop_ev), 1);
+		pth_word_wake (&(q->push_ev), INT_MAX);
+		pth_word_wake (&(q->pop_ev), INT_MAX);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+size_t
+pth_queue_length (pth_queue_t *q) {
+	size_t enq, deq;
+	if (q != (pth_queue_t *)NULL) {
+		deq = PTH_QUEUE_LOAD(&(q->deq));
+		enq = PTH_QUEUE_LOAD(&(q->enq));
+		return enq - deq <= q->mask + 1 ? enq - deq : 0;
+	}
+	return 0;
+}
+
+
+pth_wsdeque_t *
+pth_wsdeque_new (const size_t cnt) {
+	pth_wsdeque_t *d;
+	d = (pth_wsdeque_t *)xmalloc (PTH_WSDEQUE_SZ);
+	if (d != (pth_wsdeque_t *)NULL) {
+		d->top = 0;
+		d->bottom = 0;
+		d->array = pth_wsarray_new (cnt > PTH_QUEUE_MIN ? cnt : PTH_QUEUE_MIN);
+		if (d->array == (pth_wsarray_t *)NULL) {
+			xfree (d);
+			return (pth_wsdeque_t *)NULL;
+		}
+	}
+	return d;
+}
+
+
+int
+pth_wsdeque_delete (pth_wsdeque_t *d) {
+	pth_wsarray_t *a, *prev;
+	if (d != (pth_wsdeque_t *)NULL) {
+		a = d->array;
+		while (a != (pth_wsarray_t *)NULL) {
+			prev = a->prev;
+			xfree (a);
+			a = prev;
+		}
+		xfree (d);
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+
+int
+pth_wsdeque_push (pth_wsdeque_t *d, void *data) {
+	pth_wsarray_t *a;
+	long b, t;
+	if (d == (pth_wsdeque_t *)NULL) {
+		return CAF_ERROR;
+	}
+	b = __atomic_load_n (&(d->bottom), __ATOMIC_RELAXED);
+	t = __atomic_load_n (&(d->top), __ATOMIC_ACQUIRE);
+	a = __atomic_load_n (&(d->array), __ATOMIC_RELAXED);
+	if (b - t > a->mask) {
+		a = pth_wsarray_grow (d, a, b, t);
+		if (a == (pth_wsarray_t *)NULL) {
+			return CAF_ERROR;
+		}
+	}
+	__atomic_store_n (&(a->slots[b & a->mask]), data, __ATOMIC_RELAXED);
+	/* the slot is visible to thieves before the new bottom */
+	__atomic_store_n (&(d->bottom), b + 1, __ATOMIC_RELEASE);
+	return CAF_OK;
+}
+
+
+int
+pth_wsdeque_pop (pth_wsdeque_t *d, void **data) {
+	pth_wsarray_t *a;
+	long b, t;
+	int rt = CAF_OK;
+	if (d == (pth_wsdeque_t *)NULL || data == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	b = __atomic_load_n (&(d->bottom), __ATOMIC_RELAXED) - 1;
+	a = __atomic_load_n (&(d->array), __ATOMIC_RELAXED);
+	__atomic_store_n (&(d->bottom), b, __ATOMIC_RELAXED);
+	/* orders the bottom claim against the thieves top reads */
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	t = __atomic_load_n (&(d->top), __ATOMIC_RELAXED);
+	if (t <= b) {
+		*data = __atomic_load_n (&(a->slots[b & a->mask]), __ATOMIC_RELAXED);
+		if (t == b) {
+			/* the last item, races the thieves for it */
+			if (!__atomic_compare_exchange_n (&(d->top), &t, t + 1, 0,
+			                                  __ATOMIC_SEQ_CST,
+			                                  __ATOMIC_RELAXED)) {
+				rt = CAF_ERROR;
+			}
+			__atomic_store_n (&(d->bottom), b + 1, __ATOMIC_RELAXED);
+		}
+	} else {
+		rt = CAF_ERROR;
+		__atomic_store_n (&(d->bottom), b + 1, __ATOMIC_RELAXED);
+	}
+	return rt;
+}
+
+
+int
+pth_wsdeque_steal (pth_wsdeque_t *d, void **data) {
+	pth_wsarray_t *a;
+	long b, t;
+	if (d == (pth_wsdeque_t *)NULL || data == (void **)NULL) {
+		return CAF_ERROR;
+	}
+	t = __atomic_load_n (&(d->top), __ATOMIC_ACQUIRE);
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+	b = __atomic_load_n (&(d->bottom), __ATOMIC_ACQUIRE);
+	if (t >= b) {
+		return CAF_ERROR;
+	}
+	a = __atomic_load_n (&(d->array), __ATOMIC_ACQUIRE);
+	*data = __atomic_load_n (&(a->slots[t & a->mask]), __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n (&(d->top), &t, t + 1, 0,
+	                                  __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+		return CAF_ERROR_SUB;
+	}
+	return CAF_OK;
+}
+
+
+size_t
+pth_wsdeque_length (pth_wsdeque_t *d) {
+	long b, t;
+	if (d != (pth_wsdeque_t *)NULL) {
+		t = __atomic_load_n (&(d->top), __ATOMIC_ACQUIRE);
+		b = __atomic_load_n (&(d->bottom), __ATOMIC_ACQUIRE);
+		return b > t ? (size_t)(b - t) : 0;
+	}
+	return 0;
+}
+
+
+void
+pth_word_wait (int *word, const int seen, const struct timespec *tm) {
+#ifdef LINUX_SYSTEM
+	/* returns at once if the counter moved since it was read */
+	syscall (SYS_futex, word, FUTEX_WAIT_PRIVATE, seen, tm,
+	         (int *)NULL, 0);
+#else /* !LINUX_SYSTEM */
+	struct timespec nap;
+	nap.tv_sec = 0;
+	nap.tv_nsec = 1000000L;
+	if (tm != (const struct timespec *)NULL && tm->tv_sec == 0
+		&& tm->tv_nsec < nap.tv_nsec) {
+		nap.tv_nsec = tm->tv_nsec;
+	}
+	if (PTH_QUEUE_LOAD(word) == seen) {
+		nanosleep (&nap, (struct timespec *)NULL);
+	}
+#endif /* !LINUX_SYSTEM */
+}
+
+
+void
+pth_word_wake (int *word, const int cnt) {
+#ifdef LINUX_SYSTEM
+	syscall (SYS_futex, word, FUTEX_WAKE_PRIVATE, cnt,
+	         (const struct timespec *)NULL, (int *)NULL, 0);
+#else /* !LINUX_SYSTEM */
+	/* sleepers poll their counter, there is nobody to wake */
+	(void)word;
+	(void)cnt;
+#endif /* !LINUX_SYSTEM */
+}
+
+
+static pth_wsarray_t *
+pth_wsarray_new (const size_t cnt) {
+	pth_wsarray_t *a;
+	size_t cap = PTH_QUEUE_MIN;
+	while (cap < cnt) {
+		cap <<= 1;
+	}
+	a = (pth_wsarray_t *)xmalloc (PTH_WSARRAY_SZ + (cap - 1) * sizeof (void *));
+	if (a != (pth_wsarray_t *)NULL) {
+		a->mask = (long)cap - 1;
+		a->prev = (pth_wsarray_t *)NULL;
+	}
+	return a;
+}
+
+
+static pth_wsarray_t *
+pth_wsarray_grow (pth_wsdeque_t *d, pth_wsarray_t *a, const long b,
+                  const long t) {
+	pth_wsarray_t *n;
+	long i;
+	n = pth_wsarray_new ((size_t)(a->mask + 1) << 1);
+	if (n != (pth_wsarray_t *)NULL) {
+		for (i = t; i < b; i++) {
+			n->slots[i & n->mask] = a->slots[i & a->mask];
+		}
+		/* thieves may still read the old array, it lives on */
+		n->prev = a;
+		__atomic_store_n (&(d->array), n, __ATOMIC_RELEASE);
+	}
+	return n;
+}
+
+
+static void
+pth_queue_signal (int *word, int *waiters, int *pending) {
+	/* one wake up in flight is enough, the woken thread passes it on */
+	if (__atomic_load_n (waiters, __ATOMIC_SEQ_CST) > 0
+		&& !__atomic_exchange_n (pending, 1, __ATOMIC_SEQ_CST)) {
+		pth_word_wake (word, 1);
+	}
+}
+
+
+static int
+pth_queue_remaining (const struct timespec *end, struct timespec *left) {
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	left->tv_sec = end->tv_sec - now.tv_sec;
+	left->tv_nsec = end->tv_nsec - now.tv_nsec;
+	if (left->tv_nsec < 0) {
+		left->tv_sec--;
+		left->tv_nsec += 1000000000L;
+	}
+	return left->tv_sec >= 0 ? CAF_OK : CAF_ERROR;
+}
+
+/* caf_thread_queue.c ends here */
@@ -0,0 +1,156 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <caf/caf.h>
+#include <caf/caf_data_mem.h>
+#include <caf/caf_data_arena.h>
+#include <caf/caf_thread_key.h>
+
+
+#define TEST_THREADS        4
+#define TEST_REQUESTS       2000
+#define TEST_TEMPS          200
+#define TEST_ARENA_KEY      1
+
+typedef void *(*test_rtn_t)(void *);
+
+pth_key_t *arena_key;
+
+void test_basic (void);
+double test_threads (test_rtn_t rtn);
+double test_now (void);
+void *test_malloc (void *arg);
+void *test_arena (void *arg);
+
+int
+main (void) {
+	double tm, ta;
+	test_basic ();
+	arena_key = pth_key_arena (TEST_ARENA_KEY, 0);
+	tm = test_threads (test_malloc);
+	ta = test_threads (test_arena);
+	printf ("%d threads, %d requests of %d temporaries each\n",
+	        TEST_THREADS, TEST_REQUESTS, TEST_TEMPS);
+	printf ("xmalloc/xfree         %8.3f s\n", tm);
+	printf ("arena alloc/reset     %8.3f s\n", ta);
+	pth_key_delete (arena_key);
+	return 0;
+}
+
+
+void
+test_basic (void) {
+	caf_arena_t *arena = caf_arena_new (1024);
+	char *s, *big;
+	void *p;
+	size_t chunks;
+	int i, bad = 0;
+	for (i = 1; i <= 100; i++) {
+		p = caf_arena_alloc (arena, (size_t)i);
+		bad += ((unsigned long)p % CAF_ARENA_ALIGN) != 0;
+	}
+	printf ("aligned allocations: %s\n", bad == 0 ? "ok" : "bad");
+	s = caf_arena_strdup (arena, "request temporary");
+	printf ("strdup: %s\n", s);
+	big = (char *)caf_arena_alloc (arena, 4096);
+	memset (big, 'x', 4096);
+	printf ("zero size allocation: %p\n", caf_arena_alloc (arena, 0));
+	caf_arena_dump (stdout, arena);
+	chunks = arena->chunk_count;
+	caf_arena_reset (arena);
+	printf ("used after reset: %lu\n", (unsigned long)caf_arena_used (arena));
+	for (i = 1; i <= 100; i++) {
+		caf_arena_alloc (arena, (size_t)i);
+	}
+	caf_arena_alloc (arena, 4096);
+	printf ("chunks reused after reset: %s\n",
+	        chunks == arena->chunk_count ? "ok" : "bad");
+	caf_arena_dump (stdout, arena);
+	caf_arena_delete (arena);
+}
+
+
+double
+test_threads (test_rtn_t rtn) {
+	pthread_t thr[TEST_THREADS];
+	double start;
+	int i;
+	start = test_now ();
+	for (i = 0; i < TEST_THREADS; i++) {
+		pthread_create (&(thr[i]), NULL, rtn, NULL);
+	}
+	for (i = 0; i < TEST_THREADS; i++) {
+		pthread_join (thr[i], NULL);
+	}
+	return test_now () - start;
+}
+
+
+double
+test_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+void *
+test_malloc (void *arg) {
+	void *temps[TEST_TEMPS];
+	int r, i;
+	for (r = 0; r < TEST_REQUESTS; r++) {
+		for (i = 0; i < TEST_TEMPS; i++) {
+			temps[i] = xmalloc ((size_t)(16 + (i * 37) % 240));
+			memset (temps[i], r, 16);
+		}
+		for (i = 0; i < TEST_TEMPS; i++) {
+			xfree (temps[i]);
+		}
+	}
+	return arg;
+}
+
+
+void *
+test_arena (void *arg) {
+	caf_arena_t *arena = pth_key_get_arena (arena_key);
+	void *tmp;
+	int r, i;
+	for (r = 0; r < TEST_REQUESTS; r++) {
+		for (i = 0; i < TEST_TEMPS; i++) {
+			tmp = caf_arena_alloc (arena, (size_t)(16 + (i * 37) % 240));
+			memset (tmp, r, 16);
+		}
+		/* the whole request is released at once */
+		caf_arena_reset (arena);
+	}
+	return arg;
+}
+
+/* caf_arena.c ends here */
@@ -0,0 +1,153 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_tool_macro.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_deque.h"
+#include "caf/caf_data_bdeque.h"
+#include "caf/caf_data_buffer.h"
+
+#ifdef _GNU_SOURCE
+#define strdup(s)           strndup (s, 1024)
+#endif /* !_GNU_SOURCE */
+
+#define TEST_ITEMS          10000
+
+void test_ends (void);
+void test_insert (void);
+void test_compat (void);
+int test_map_cb (void *data);
+int test_search_cb (void *ndata, void *data);
+
+
+int
+main (void) {
+	test_ends ();
+	test_insert ();
+	test_compat ();
+	return 0;
+}
+
+
+void
+test_ends (void) {
+	bdeque_t *dq = bdeque_create ();
+	long i, bad = 0;
+	/* the ring wraps and grows many times while both ends move */
+	for (i = 0; i < TEST_ITEMS; i++) {
+		bdeque_push (dq, (void *)(i + 1));
+		bdeque_prepend (dq, (void *)(-i - 1));
+	}
+	printf ("bdeque_t *: %d elements, %lu blocks\n", bdeque_length (dq),
+	        (unsigned long)dq->map_sz);
+	for (i = 0; i < TEST_ITEMS; i++) {
+		if (bdeque_get (dq, (int)(TEST_ITEMS + i)) != (void *)(i + 1) ||
+			bdeque_get (dq, (int)(TEST_ITEMS - 1 - i)) != (void *)(-i - 1)) {
+			bad++;
+		}
+	}
+	printf ("get: %ld misplaced\n", bad);
+	for (i = TEST_ITEMS; i > 0; i--) {
+		if (bdeque_pop (dq) != (void *)i || bdeque_first (dq) != (void *)-i) {
+			bad++;
+		}
+	}
+	printf ("pop/first: %ld misplaced, length %d, empty pop %p\n", bad,
+	        bdeque_length (dq), bdeque_pop (dq));
+	bdeque_delete_nocb (dq);
+}
+
+
+void
+test_insert (void) {
+	bdeque_t *dq = bdeque_create ();
+	bdeque_push (dq, strdup ("2"));
+	bdeque_push (dq, strdup ("4"));
+	bdeque_insert (dq, 0, strdup ("1"));
+	bdeque_insert (dq, 2, strdup ("3"));
+	bdeque_insert (dq, 4, strdup ("5"));
+	bdeque_insert (dq, 5, strdup ("6"));
+	printf ("bdeque_t *: after inserts\n");
+	bdeque_dump (stdout, dq, deque_dump_str_cb);
+	xfree (bdeque_remove (dq, 1));
+	xfree (bdeque_remove (dq, 3));
+	xfree (bdeque_get (dq, 0));
+	bdeque_set (dq, 0, strdup ("x"));
+	printf ("bdeque_t *: after removes and set\n");
+	bdeque_dump (stdout, dq, deque_dump_str_cb);
+	printf ("list length: %d\n", bdeque_length (dq));
+	bdeque_delete (dq, deque_str_delete_cb);
+}
+
+
+void
+test_compat (void) {
+	char str0[] = "\x01";
+	char str1[] = "a\x01" "bc\x01" "def\x01" "ghij";
+	cbuffer_t *buf = cbuf_new ();
+	cbuffer_t *found;
+	deque_t *split, *back;
+	bdeque_t *dq;
+	cbuf_import (buf, str1, strlen (str1));
+	split = cbuf_split (buf, (void *)str0, 1);
+	dq = bdeque_from_deque (split);
+	printf ("bdeque_t *: split in %d, copied %d\n", deque_length (split),
+	        bdeque_length (dq));
+	printf ("map: %d\n", bdeque_map (dq, test_map_cb));
+	found = (cbuffer_t *)bdeque_search (dq, (void *)"def", test_search_cb);
+	printf ("search: %s\n", found != (cbuffer_t *)NULL ? "found"
+	        : "not found");
+	back = bdeque_to_deque (dq);
+	printf ("back: %d, same order %s\n", deque_length (back),
+	        deque_get (back, 3) == deque_get (split, 3) ? "yes" : "no");
+	deque_delete_nocb (back);
+	bdeque_delete_nocb (dq);
+	deque_delete (split, cbuf_delete_callback);
+	cbuf_delete (buf);
+}
+
+
+int
+test_map_cb (void *data) {
+	cbuffer_t *buf = (cbuffer_t *)data;
+	printf ("map: %lu bytes\n", (unsigned long)buf->sz);
+	return CAF_OK;
+}
+
+
+int
+test_search_cb (void *ndata, void *data) {
+	cbuffer_t *buf = (cbuffer_t *)ndata;
+	if (buf->sz == strlen ((char *)data) &&
+		memcmp (buf->data, data, buf->sz) == 0) {
+		return CAF_OK;
+	}
+	return CAF_ERROR;
+}
+
+/* caf_bdeque.c ends here */
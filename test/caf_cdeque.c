@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "caf/caf.h"
 #include "caf/caf_tool_macro.h"
 #include "caf/caf_data_mem.h"
 #include "caf/caf_data_cdeque.h"
@@ -37,6 +38,7 @@ void test_create (void);
 void test_new (void);
 void test_pop (void);
 void test_get (void);
+void test_insert (void);
 void test_map (void);
 int test_map_cb (void *data);
 
@@ -47,6 +49,7 @@ main (void) {
 	test_new ();
 	test_pop ();
 	test_get ();
+	test_insert ();
 	test_map ();
 	return 0;
 }
@@ -186,6 +189,58 @@ test_get (void) {
 }
 
 
+void
+test_insert (void) {
+	caf_cdequen_t *n;
+	int i;
+	cdeque_t *lst = cdeque_new (strdup("2"));
+	printf ("cdeque_t *: list after inserts\n");
+	cdeque_push (lst, strdup("4"));
+	cdeque_insert (lst, 0, strdup("1"));
+	cdeque_insert (lst, 2, strdup("3"));
+	/* one past the tail appends */
+	printf ("insert at end: %d\n", cdeque_insert (lst, 4, strdup("5")));
+	printf ("insert past end: %d\n", cdeque_insert (lst, 6, "x"));
+	cdeque_dump (stdout, lst, cdeque_dump_str_cb);
+	printf ("list length: %d\n", cdeque_length (lst));
+	/* the finger follows the walk in both directions */
+	for (i = 0; i < cdeque_length (lst); i++) {
+		printf ("element %d: %s\n", i + 1, (char *)cdeque_get (lst, i));
+	}
+	for (i = cdeque_length (lst) - 1; i >= 0; i--) {
+		printf ("element %d: %s\n", i + 1, (char *)cdeque_get (lst, i));
+	}
+	printf ("element 4: %s\n", (char *)cdeque_get (lst, 3));
+	n = cdeque_first (lst);
+	xfree (n->data);
+	cdeque_node_free (lst, n);
+	printf ("cdeque_t *: list after first\n");
+	printf ("list length: %d\n", cdeque_length (lst));
+	printf ("element 1: %s\n", (char *)cdeque_get (lst, 0));
+	printf ("element 3: %s\n", (char *)cdeque_get (lst, 2));
+	printf ("element 4: %s\n", (char *)cdeque_get (lst, 3));
+	n = cdeque_pop (lst);
+	xfree (n->data);
+	cdeque_node_free (lst, n);
+	printf ("cdeque_t *: list after pop\n");
+	printf ("list length: %d\n", cdeque_length (lst));
+	printf ("element 3: %s\n", (char *)cdeque_get (lst, 2));
+	cdeque_delete (lst, cdeque_str_delete_cb);
+
+	printf ("cdeque_t *: 1 element list after first\n");
+	lst = cdeque_new (strdup("1"));
+	n = cdeque_first (lst);
+	xfree (n->data);
+	cdeque_node_free (lst, n);
+	printf ("list length: %d, empty: %d\n", cdeque_length (lst),
+	        cdeque_empty_list (lst) == CAF_OK);
+	cdeque_push (lst, strdup("2"));
+	printf ("element 1: %s\n", (char *)cdeque_get (lst, 0));
+	printf ("list length: %d\n", cdeque_length (lst));
+	cdeque_delete (lst, cdeque_str_delete_cb);
+}
+
+
 void
 test_map (void) {
 	char *d1 = strdup("3");
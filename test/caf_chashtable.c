@@ -0,0 +1,124 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_hash_str.h"
+#include "caf/caf_chash_table.h"
+#include "caf/caf_thread_attr.h"
+#include "caf/caf_thread_pool.h"
+#include "caf/caf_thread_mutex.h"
+
+
+#define TABLE_ID            1000
+#define TABLE_SEGMENTS      8
+#define TABLE_KEYS          4096
+#define TABLE_KEY_SZ        16
+#define TABLE_THREADS       4
+
+void *pth_rtn (void *p);
+
+caf_chash_table_t *table = (caf_chash_table_t *)NULL;
+pth_mutex_t *common_mutex = (pth_mutex_t *)NULL;
+char keys[TABLE_KEYS][TABLE_KEY_SZ];
+int wins = 0;
+int misses = 0;
+
+int
+main (void) {
+	int i, rt, removed = 0;
+	pth_attri_t *attr = (pth_attri_t *)NULL;
+	pth_pool_t *pool = (pth_pool_t *)NULL;
+	table = caf_chash_table_new (TABLE_ID, TABLE_SEGMENTS, caf_shash_dek,
+	                             caf_shash_fnv);
+	common_mutex = pth_mtx_new ();
+	attr = pth_attri_new ();
+	if (table == (caf_chash_table_t *)NULL ||
+		common_mutex == (pth_mutex_t *)NULL ||
+		attr == (pth_attri_t *)NULL) {
+		return 1;
+	}
+	for (i = 0; i < TABLE_KEYS; i++) {
+		snprintf (keys[i], TABLE_KEY_SZ, "key %d", i);
+	}
+	pth_mtxattr_init (common_mutex);
+	pth_mtx_init (common_mutex);
+	rt = pth_attr_init (attr);
+	if (rt == 0) {
+		rt = pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL);
+	}
+	if (rt == 0) {
+		pool = pth_pool_create (attr, pth_rtn, TABLE_THREADS, (void *)NULL);
+		pth_pool_join (pool);
+		printf ("get_or_add: wins %d/%d, misses: %d, count: %lu\n", wins,
+		        TABLE_KEYS, misses,
+		        (unsigned long)caf_chash_table_count (table));
+		for (i = 0; i < TABLE_KEYS; i += 2) {
+			if (caf_chash_table_remove (table, keys[i],
+			                            strlen (keys[i]) + 1) == CAF_OK) {
+				removed++;
+			}
+		}
+		printf ("remove: %d, count: %lu, get: %p\n", removed,
+		        (unsigned long)caf_chash_table_count (table),
+		        caf_chash_table_get (table, keys[0], strlen (keys[0]) + 1));
+		pth_pool_delete (pool);
+	}
+	pth_attri_destroy (attr);
+	pth_mtx_destroy (common_mutex);
+	pth_mtxattr_destroy (common_mutex);
+	pth_mtx_delete (common_mutex);
+	caf_chash_table_delete (table);
+	return 0;
+}
+
+void *
+pth_rtn (void *p) {
+	int i, own = 0, lost = 0;
+	char self = 0;
+	void *data;
+	for (i = 0; i < TABLE_KEYS; i++) {
+		data = caf_chash_table_get_or_add (table, keys[i],
+		                                   strlen (keys[i]) + 1,
+		                                   (void *)&self);
+		if (data == (void *)&self) {
+			own++;
+		}
+	}
+	for (i = 0; i < TABLE_KEYS; i++) {
+		if (caf_chash_table_get (table, keys[i],
+		                         strlen (keys[i]) + 1) == (void *)NULL) {
+			lost++;
+		}
+	}
+	pth_mtx_lock (common_mutex);
+	wins += own;
+	misses += lost;
+	pth_mtx_unlock (common_mutex);
+	pthread_exit (p);
+}
+
+/* caf_chashtable.c ends here */
@@ -37,6 +37,7 @@ void test_create (void);
 void test_new (void);
 void test_pop (void);
 void test_get (void);
+void test_insert (void);
 void test_map (void);
 int test_map_cb (void *data);
 
@@ -47,6 +48,7 @@ main (void) {
 	test_new ();
 	test_pop ();
 	test_get ();
+	test_insert ();
 	test_map ();
 	return 0;
 }
@@ -182,6 +184,42 @@ test_get (void) {
 }
 
 
+void
+test_insert (void) {
+	caf_dequen_t *n;
+	int i;
+	deque_t *lst = deque_new (strdup("2"));
+	printf ("deque_t *: list after inserts\n");
+	deque_push (lst, strdup("4"));
+	deque_push (lst, strdup("6"));
+	deque_insert (lst, 0, strdup("1"));
+	deque_insert (lst, 2, strdup("3"));
+	deque_insert (lst, 4, strdup("5"));
+	deque_dump (stdout, lst, deque_dump_str_cb);
+	printf ("list length: %d\n", deque_length (lst));
+	for (i = 0; i < deque_length (lst); i++) {
+		printf ("element %d: %s\n", i + 1, (char *)deque_get (lst, i));
+	}
+	n = deque_first (lst);
+	xfree (n->data);
+	deque_node_free (lst, n);
+	printf ("deque_t *: list after first\n");
+	printf ("list length: %d\n", deque_length (lst));
+	printf ("element 1: %s\n", (char *)deque_get (lst, 0));
+	printf ("element 5: %s\n", (char *)deque_get (lst, 4));
+	deque_delete (lst, deque_str_delete_cb);
+
+	printf ("deque_t *: 1 element list after first\n");
+	lst = deque_new (strdup("1"));
+	n = deque_first (lst);
+	xfree (n->data);
+	deque_node_free (lst, n);
+	printf ("list length: %d, head: %p\n", deque_length (lst),
+	        (void *)lst->head);
+	deque_delete (lst, deque_str_delete_cb);
+}
+
+
 void
 test_map (void) {
 	char *d1 = strdup("3");
@@ -0,0 +1,185 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <caf/caf.h>
+#include <caf/caf_data_mem.h>
+#ifdef LINUX_SYSTEM
+#define IO_EVENT_USE_EPOLL
+#include <caf/caf_evt_nio.h>
+#include <caf/caf_evt_nio_pool.h>
+#endif /* !LINUX_SYSTEM */
+
+
+#define TEST_PIPES          400
+#define TEST_EVERY          10
+
+#ifdef LINUX_SYSTEM
+int pipes[TEST_PIPES][2];
+io_evt_pool_epoll_t *pool;
+
+void test_ready (void);
+void test_modify (void);
+void test_remove (void);
+void test_reuse (void);
+int test_drain (int n);
+#endif /* !LINUX_SYSTEM */
+
+int
+main (void) {
+#ifdef LINUX_SYSTEM
+	int i;
+	pool = io_evt_pool_epoll_new (TEST_PIPES, 0, 0);
+	if (pool == (io_evt_pool_epoll_t *)NULL) {
+		return 1;
+	}
+	for (i = 0; i < TEST_PIPES; i++) {
+		if (pipe (pipes[i]) != 0) {
+			return 1;
+		}
+		/* the pipe index is the user data */
+		io_evt_pool_epoll_add_data (pipes[i][0], pool, EPOLLIN,
+		                            (void *)(long)i);
+	}
+	printf ("add twice: %s\n", io_evt_pool_epoll_add (pipes[0][0], pool,
+	                                                   EPOLLIN) == CAF_OK
+	        ? "bad" : "ok");
+	printf ("pool full: %s\n", io_evt_pool_epoll_add (1, pool, EPOLLOUT)
+	        == CAF_OK ? "bad" : "ok");
+	test_ready ();
+	test_modify ();
+	test_remove ();
+	test_reuse ();
+	for (i = 0; i < TEST_PIPES; i++) {
+		close (pipes[i][0]);
+		close (pipes[i][1]);
+	}
+	io_evt_pool_epoll_delete (pool);
+#endif /* !LINUX_SYSTEM */
+	return 0;
+}
+
+#ifdef LINUX_SYSTEM
+
+void
+test_ready (void) {
+	int i, pos = 0, fd, ev, cnt = 0, bad = 0;
+	void *data;
+	for (i = 0; i < TEST_PIPES; i += TEST_EVERY) {
+		write (pipes[i][1], "x", 1);
+	}
+	io_evt_pool_epoll_handle (pool);
+	while (io_evt_pool_epoll_next (pool, &pos, &fd, &ev, &data) == CAF_OK) {
+		cnt++;
+		bad += fd != pipes[(long)data][0] || (long)data % TEST_EVERY != 0;
+		bad += io_evt_pool_epoll_hasevent (fd, pool, EPOLLIN) != CAF_OK;
+		bad += io_evt_pool_epoll_etype (fd, pool) != EVT_IO_READ;
+	}
+	printf ("ready: %d of %d pipes, %s\n", cnt, TEST_PIPES,
+	        bad == 0 ? "ok" : "bad");
+	printf ("idle pipe: %s\n",
+	        io_evt_pool_epoll_hasevent (pipes[1][0], pool, EPOLLIN)
+	        == CAF_OK ? "bad" : "ok");
+	test_drain (TEST_PIPES);
+}
+
+
+void
+test_modify (void) {
+	int fd, pos = 0;
+	/* the write ends are writable, so EPOLLOUT fires at once */
+	io_evt_pool_epoll_remove (pipes[5][0], pool);
+	io_evt_pool_epoll_add_data (pipes[5][1], pool, EPOLLIN, (void *)5L);
+	io_evt_pool_epoll_handle (pool);
+	printf ("before modify: %d ready\n", pool->ready);
+	io_evt_pool_epoll_modify (pipes[5][1], pool, EPOLLOUT);
+	io_evt_pool_epoll_handle (pool);
+	io_evt_pool_epoll_next (pool, &pos, &fd, (int *)NULL, (void **)NULL);
+	printf ("after modify: %d ready, %s\n", pool->ready,
+	        fd == pipes[5][1] && io_evt_pool_epoll_etype (fd, pool)
+	        == EVT_IO_WRITE ? "writable" : "bad");
+	io_evt_pool_epoll_remove (pipes[5][1], pool);
+	io_evt_pool_epoll_add_data (pipes[5][0], pool, EPOLLIN, (void *)5L);
+}
+
+
+void
+test_remove (void) {
+	int pos = 0, fd, cnt = 0, other = -1;
+	write (pipes[2][1], "x", 1);
+	write (pipes[3][1], "x", 1);
+	io_evt_pool_epoll_handle (pool);
+	/* the handler of the first event closes the other one */
+	while (io_evt_pool_epoll_next (pool, &pos, &fd, (int *)NULL,
+	                               (void **)NULL) == CAF_OK) {
+		cnt++;
+		if (other < 0) {
+			other = fd == pipes[2][0] ? pipes[3][0] : pipes[2][0];
+			io_evt_pool_epoll_remove (other, pool);
+		}
+	}
+	printf ("remove while iterating: %d of 2 visited\n", cnt);
+	printf ("remove twice: %s\n",
+	        io_evt_pool_epoll_remove (other, pool) == CAF_OK ? "bad" : "ok");
+	test_drain (4);
+}
+
+
+void
+test_reuse (void) {
+	int pos = 0, fd, cnt = 0;
+	void *data = (void *)NULL;
+	io_evt_pool_epoll_remove (pipes[7][0], pool);
+	printf ("free slots: %d\n", pool->free_count);
+	io_evt_pool_epoll_add_data (pipes[7][0], pool, EPOLLIN, (void *)7L);
+	write (pipes[7][1], "x", 1);
+	io_evt_pool_epoll_handle (pool);
+	while (io_evt_pool_epoll_next (pool, &pos, &fd, (int *)NULL, &data)
+		   == CAF_OK) {
+		cnt++;
+	}
+	printf ("reused slot: %d ready, data %ld\n", cnt, (long)data);
+	test_drain (8);
+}
+
+
+int
+test_drain (int n) {
+	char buf[16];
+	int i;
+	for (i = 0; i < n; i++) {
+		if (io_evt_pool_epoll_hasevent (pipes[i][0], pool, EPOLLIN)
+			== CAF_OK) {
+			read (pipes[i][0], buf, sizeof(buf));
+		}
+	}
+	return CAF_OK;
+}
+
+#endif /* !LINUX_SYSTEM */
+
+/* caf_evt_pool.c ends here */
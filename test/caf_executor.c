@@ -0,0 +1,433 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef LINUX_SYSTEM
+#include <sched.h>
+#endif /* !LINUX_SYSTEM */
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_attr.h"
+#include "caf/caf_thread_pool.h"
+
+
+#define TEST_TASKS          1000
+#define TEST_WORKERS        4
+
+#define TEST_TREE_DEPTH     14
+#define TEST_BURST          40
+#define TEST_CYCLES         100
+#define TEST_FIB            18
+#define TEST_FIB_RESULT     2584
+/** Address space growth in KB that still means every stack was freed */
+#define TEST_VM_SLACK       (256 * 1024)
+
+unsigned long detached_sum;
+unsigned long tree_leaves;
+pth_pool_t *tree_pool;
+pth_pool_t *fib_pool;
+
+void test_submit (pth_attri_t *attr);
+void test_batch (pth_attri_t *attr);
+void test_cancel (pth_attri_t *attr);
+void test_shutdown (pth_attri_t *attr);
+void test_stealing (pth_attri_t *attr);
+void test_join (pth_attri_t *attr, int workers);
+void test_elastic (pth_attri_t *attr);
+void test_placement (void);
+void test_default (void);
+long test_vmsize (void);
+void *task_square (void *arg);
+void *task_add (void *arg);
+void *task_nap (void *arg);
+void *task_tree (void *arg);
+void *task_fib (void *arg);
+void *task_cpu (void *arg);
+void *task_pinned (void *arg);
+
+int
+main (void) {
+	pth_attri_t *attr = pth_attri_new ();
+	if (attr == (pth_attri_t *)NULL || pth_attr_init (attr) != 0
+		|| pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL) != 0) {
+		return 1;
+	}
+	test_submit (attr);
+	test_batch (attr);
+	test_cancel (attr);
+	test_shutdown (attr);
+	test_stealing (attr);
+	test_join (attr, 1);
+	test_join (attr, TEST_WORKERS);
+	test_elastic (attr);
+	test_placement ();
+	test_default ();
+	pth_attri_destroy (attr);
+	return 0;
+}
+
+
+void
+test_submit (pth_attri_t *attr) {
+	pth_pool_t *pool = pth_pool_executor (attr, TEST_WORKERS, 64);
+	pth_task_t **tasks;
+	unsigned long sum = 0, expected = 0, i;
+	void *res;
+	tasks = (pth_task_t **)xmalloc (TEST_TASKS * sizeof (pth_task_t *));
+	printf ("executor: %d workers\n", pool->count);
+	for (i = 0; i < TEST_TASKS; i++) {
+		tasks[i] = pth_pool_submit (pool, task_square, (void *)i);
+		expected += i * i;
+	}
+	for (i = 0; i < TEST_TASKS; i++) {
+		if (pth_task_wait (tasks[i], &res) == CAF_OK) {
+			sum += (unsigned long)res;
+		}
+		pth_task_release (tasks[i]);
+	}
+	printf ("submit: %d tasks, sum %s\n", TEST_TASKS,
+	        sum == expected ? "ok" : "bad");
+	xfree (tasks);
+	pth_pool_delete (pool);
+}
+
+
+void
+test_batch (pth_attri_t *attr) {
+	pth_pool_t *pool = pth_pool_executor (attr, TEST_WORKERS, 0);
+	void *args[TEST_TASKS];
+	unsigned long i;
+	int c;
+	detached_sum = 0;
+	for (i = 0; i < TEST_TASKS; i++) {
+		args[i] = (void *)(i + 1);
+	}
+	c = pth_pool_submit_batch (pool, task_add, args, TEST_TASKS,
+	                           (pth_task_t **)NULL);
+	/* draining runs every detached task before the workers exit */
+	pth_pool_shutdown (pool, 1);
+	printf ("batch: %d detached tasks, sum %s\n", c,
+	        detached_sum == (unsigned long)TEST_TASKS * (TEST_TASKS + 1) / 2
+	        ? "ok" : "bad");
+	printf ("submit after shutdown: %p\n",
+	        (void *)pth_pool_submit (pool, task_add, args[0]));
+	pth_pool_delete (pool);
+}
+
+
+void
+test_cancel (pth_attri_t *attr) {
+	pth_pool_t *pool = pth_pool_executor (attr, 1, 0);
+	pth_task_t *busy, *t1, *t2;
+	void *res = (void *)NULL;
+	int rc;
+	busy = pth_pool_submit (pool, task_nap, (void *)200000L);
+	t1 = pth_pool_submit (pool, task_square, (void *)7L);
+	t2 = pth_pool_submit (pool, task_square, (void *)8L);
+	printf ("cancel queued task: %d\n", pth_task_cancel (t2));
+	printf ("task states: %d %d\n", pth_task_poll (t1), pth_task_poll (t2));
+	rc = pth_task_wait (t1, &res);
+	printf ("wait task: %d (%ld)\n", rc, (long)res);
+	printf ("wait canceled task: %d\n", pth_task_wait (t2, &res));
+	printf ("cancel finished task: %d\n", pth_task_cancel (t1));
+	pth_task_wait (busy, (void **)NULL);
+	pth_task_release (busy);
+	pth_task_release (t1);
+	pth_task_release (t2);
+	pth_pool_delete (pool);
+}
+
+
+void
+test_shutdown (pth_attri_t *attr) {
+	pth_pool_t *pool = pth_pool_executor (attr, 1, 0);
+	pth_task_t *tasks[6];
+	int i, done = 0, canceled = 0;
+	tasks[0] = pth_pool_submit (pool, task_nap, (void *)200000L);
+	for (i = 1; i < 6; i++) {
+		tasks[i] = pth_pool_submit (pool, task_square, (void *)(long)i);
+	}
+	/* the worker is busy with the nap, the rest gets canceled */
+	usleep (50000);
+	pth_pool_shutdown (pool, 0);
+	for (i = 0; i < 6; i++) {
+		if (pth_task_poll (tasks[i]) == PTH_TASK_DONE) {
+			done++;
+		} else if (pth_task_poll (tasks[i]) == PTH_TASK_CANCELED) {
+			canceled++;
+		}
+		pth_task_release (tasks[i]);
+	}
+	printf ("shutdown without drain: %d done, %d canceled\n", done,
+	        canceled);
+	pth_pool_delete (pool);
+}
+
+
+void
+test_stealing (pth_attri_t *attr) {
+	pth_pool_stats_t st;
+	tree_pool = pth_pool_stealing (attr, TEST_WORKERS, 0);
+	tree_leaves = 0;
+	/* every node spawns its children from inside a worker */
+	pth_task_release (pth_pool_submit (tree_pool, task_tree,
+	                                   (void *)(long)TEST_TREE_DEPTH));
+	pth_pool_shutdown (tree_pool, 1);
+	pth_pool_stats (tree_pool, &st);
+	printf ("stealing: %lu leaves %s, %lu tasks run %s\n", tree_leaves,
+	        tree_leaves == 1UL << TEST_TREE_DEPTH ? "ok" : "bad", st.runs,
+	        st.runs == (2UL << TEST_TREE_DEPTH) - 1 ? "ok" : "bad");
+	pth_pool_stats_dump (stdout, tree_pool);
+	pth_pool_delete (tree_pool);
+}
+
+
+void
+test_join (pth_attri_t *attr, int workers) {
+	pth_task_t *task;
+	void *res = (void *)NULL;
+	fib_pool = pth_pool_stealing (attr, workers, 0);
+	/* every task waits for its two sub tasks, so all workers end up waiting */
+	task = pth_pool_submit (fib_pool, task_fib, (void *)(long)TEST_FIB);
+	pth_task_wait (task, &res);
+	pth_task_release (task);
+	printf ("join: %d workers, fib(%d) %s\n", workers, TEST_FIB,
+	        (long)res == TEST_FIB_RESULT ? "ok" : "bad");
+	pth_pool_delete (fib_pool);
+}
+
+
+void
+test_elastic (pth_attri_t *attr) {
+	pth_pool_policy_t policy;
+	pth_pool_t *pool;
+	pth_task_t *tasks[TEST_BURST];
+	int i, size, peak = 0;
+	policy.min = 1;
+	policy.max = TEST_WORKERS;
+	policy.latency.tv_sec = 0;
+	policy.latency.tv_nsec = 2000000L;
+	policy.idle.tv_sec = 0;
+	policy.idle.tv_nsec = 100000000L;
+	pool = pth_pool_elastic (attr, &policy, 0);
+	printf ("elastic: %d workers at start\n", pth_pool_size (pool));
+	for (i = 0; i < TEST_BURST; i++) {
+		tasks[i] = pth_pool_submit (pool, task_nap, (void *)5000L);
+	}
+	for (i = 0; i < TEST_BURST; i++) {
+		pth_task_wait (tasks[i], (void **)NULL);
+		pth_task_release (tasks[i]);
+		size = pth_pool_size (pool);
+		peak = size > peak ? size : peak;
+	}
+	printf ("elastic: burst grew the pool %s\n",
+	        peak > policy.min && peak <= policy.max ? "ok" : "bad");
+	usleep (500000);
+	printf ("elastic: %d workers after idling\n", pth_pool_size (pool));
+	pth_pool_shutdown (pool, 1);
+	pth_pool_delete (pool);
+}
+
+
+void
+test_placement (void) {
+#ifdef LINUX_SYSTEM
+	pth_attri_t *attr = pth_attri_init ();
+	pth_task_t *tasks[TEST_WORKERS];
+	pth_pool_t *pool;
+	cpu_set_t set;
+	void *res;
+	int i, node = 0, bad = 0;
+	pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL);
+	printf ("placement: %d numa nodes\n", pth_attri_nodes ());
+	/* systems without /sys node entries keep the process CPUs */
+	if (pth_attri_set (attr, PTH_ATTR_NUMANODE, (void *)&node) != 0) {
+		printf ("placement: no numa node 0\n");
+	}
+	printf ("placement: per core %d\n",
+	        pth_attri_set (attr, PTH_ATTR_PERCORE, (void *)NULL));
+	if (pth_attri_get (attr, PTH_ATTR_CPUSET, (void *)&set) != 0) {
+		sched_getaffinity (0, sizeof(cpu_set_t), &set);
+	}
+	pool = pth_pool_executor (attr, TEST_WORKERS, 0);
+	for (i = 0; i < TEST_WORKERS; i++) {
+		tasks[i] = pth_pool_submit (pool, task_cpu, (void *)NULL);
+	}
+	for (i = 0; i < TEST_WORKERS; i++) {
+		pth_task_wait (tasks[i], &res);
+		bad += !CPU_ISSET ((long)res, &set);
+		pth_task_release (tasks[i]);
+	}
+	printf ("placement: workers on the placement cpus %s\n",
+	        bad == 0 ? "ok" : "bad");
+	/* per core workers are created already bound to a single CPU */
+	for (i = 0, bad = 0; i < TEST_WORKERS; i++) {
+		tasks[i] = pth_pool_submit (pool, task_pinned, (void *)NULL);
+	}
+	for (i = 0; i < TEST_WORKERS; i++) {
+		pth_task_wait (tasks[i], &res);
+		bad += (long)res != 1;
+		pth_task_release (tasks[i]);
+	}
+	printf ("placement: workers bound to one cpu %s\n",
+	        bad == 0 ? "ok" : "bad");
+	pth_pool_shutdown (pool, 1);
+	pth_pool_delete (pool);
+	pth_attri_destroy (attr);
+#endif /* !LINUX_SYSTEM */
+}
+
+
+void
+test_default (void) {
+	pth_attri_t *attr = pth_attri_init ();
+	pth_pool_t *pool;
+	pth_task_t *task;
+	long before;
+	int i, done = 0;
+	void *res;
+	/* without PTH_ATTR_JOINABLE the workers still have to be joined */
+	before = test_vmsize ();
+	for (i = 0; i < TEST_CYCLES; i++) {
+		pool = (i & 1) ? pth_pool_stealing (attr, TEST_WORKERS, 0)
+			: pth_pool_executor (attr, TEST_WORKERS, 0);
+		task = pth_pool_submit (pool, task_square, (void *)(long)i);
+		if (pth_task_wait (task, &res) == CAF_OK
+			&& (long)res == (long)i * i) {
+			done++;
+		}
+		pth_task_release (task);
+		pth_pool_delete (pool);
+	}
+	printf ("default attributes: %d/%d cycles, stacks released %s\n", done,
+	        TEST_CYCLES, test_vmsize () - before < TEST_VM_SLACK ? "ok"
+	        : "bad");
+	pth_attri_destroy (attr);
+}
+
+
+long
+test_vmsize (void) {
+	char line[128];
+	long kb = 0;
+	FILE *f = fopen ("/proc/self/status", "r");
+	if (f == (FILE *)NULL) {
+		return 0;
+	}
+	while (fgets (line, sizeof(line), f) != (char *)NULL) {
+		if (sscanf (line, "VmSize: %ld", &kb) == 1) {
+			break;
+		}
+	}
+	fclose (f);
+	return kb;
+}
+
+
+void *
+task_square (void *arg) {
+	unsigned long v = (unsigned long)arg;
+	return (void *)(v * v);
+}
+
+
+void *
+task_add (void *arg) {
+	__atomic_add_fetch (&detached_sum, (unsigned long)arg, __ATOMIC_RELAXED);
+	return (void *)NULL;
+}
+
+
+void *
+task_nap (void *arg) {
+	usleep ((useconds_t)(long)arg);
+	return arg;
+}
+
+
+
+void *
+task_tree (void *arg) {
+	long depth = (long)arg;
+	if (depth == 0) {
+		__atomic_add_fetch (&tree_leaves, 1, __ATOMIC_RELAXED);
+	} else {
+		pth_task_release (pth_pool_submit (tree_pool, task_tree,
+		                                   (void *)(depth - 1)));
+		pth_task_release (pth_pool_submit (tree_pool, task_tree,
+		                                   (void *)(depth - 1)));
+	}
+	return arg;
+}
+
+
+void *
+task_fib (void *arg) {
+	long n = (long)arg;
+	pth_task_t *a, *b;
+	void *ra = (void *)NULL, *rb = (void *)NULL;
+	if (n < 2) {
+		return arg;
+	}
+	a = pth_pool_submit (fib_pool, task_fib, (void *)(n - 1));
+	b = pth_pool_submit (fib_pool, task_fib, (void *)(n - 2));
+	pth_task_wait (a, &ra);
+	pth_task_wait (b, &rb);
+	pth_task_release (a);
+	pth_task_release (b);
+	return (void *)((long)ra + (long)rb);
+}
+
+
+void *
+task_cpu (void *arg) {
+#ifdef LINUX_SYSTEM
+	(void)arg;
+	return (void *)(long)sched_getcpu ();
+#else /* !LINUX_SYSTEM */
+	return arg;
+#endif /* !LINUX_SYSTEM */
+}
+
+
+void *
+task_pinned (void *arg) {
+#ifdef LINUX_SYSTEM
+	cpu_set_t set;
+	(void)arg;
+	if (pthread_getaffinity_np (pthread_self (), sizeof(cpu_set_t),
+	                            &set) != 0) {
+		return (void *)0L;
+	}
+	return (void *)(long)CPU_COUNT (&set);
+#else /* !LINUX_SYSTEM */
+	return arg;
+#endif /* !LINUX_SYSTEM */
+}
+
+/* caf_executor.c ends here */
@@ -23,6 +23,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <caf/caf_hash_str.h>
 
 int
@@ -41,6 +42,17 @@ main (int argc, char **argv) {
 		printf (" 8. DEK Hash:  %15.15u\n", caf_shash_dek (string, 36));
 		printf (" 9. BP Hash:   %15.15u\n", caf_shash_bp (string, 36));
 		printf ("10. FNV Hash:  %15.15u\n", caf_shash_fnv (string, 36));
+		printf ("11. WY Hash:   %15.15u\n", caf_shash_wy (string,
+		                                              strlen (string)));
+		printf ("12. XX Hash:   %15.15u\n", caf_shash_xx (string,
+		                                              strlen (string)));
+		caf_shash_seed_init ();
+		printf ("Random seed:   %16.16llx\n",
+		        (unsigned long long)caf_shash_seed_get ());
+		printf ("11. WY Hash:   %15.15u\n", caf_shash_wy (string,
+		                                              strlen (string)));
+		printf ("12. XX Hash:   %15.15u\n", caf_shash_xx (string,
+		                                              strlen (string)));
 	} else {
 		printf ("No input string\n");
 		exit(EXIT_FAILURE);
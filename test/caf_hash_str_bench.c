@@ -0,0 +1,291 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <caf/caf_hash_str.h>
+#include <caf/caf_hash_table.h>
+
+
+#define BENCH_TABLE_ID      1000
+#define BENCH_KEYS          65536
+#define BENCH_KEY_SZ        64
+#define BENCH_BYTES         (1 << 24)
+#define BENCH_BUCKETS_BITS  16
+#define BENCH_BUCKETS       (1 << BENCH_BUCKETS_BITS)
+
+typedef struct bench_hash_s bench_hash_t;
+
+struct bench_hash_s {
+	const char *name;
+	CAF_HASH_STR_FUNCTION(f);
+};
+
+static bench_hash_t hashes[] = {
+	{ "rs", caf_shash_rs },
+	{ "js", caf_shash_js },
+	{ "pjw", caf_shash_pjw },
+	{ "elf", caf_shash_elf },
+	{ "bkdr", caf_shash_bkdr },
+	{ "sdbm", caf_shash_sdbm },
+	{ "djb", caf_shash_djb },
+	{ "dek", caf_shash_dek },
+	{ "bp", caf_shash_bp },
+	{ "fnv", caf_shash_fnv },
+	{ "wy", caf_shash_wy },
+	{ "xx", caf_shash_xx },
+	{ (const char *)NULL, NULL }
+};
+
+static const size_t lengths[] = { 4, 8, 16, 32, 64, 256, 1024, 4096, 0 };
+
+static const char *sets[] = { "sequential ids", "ipv4 strings",
+                              "file paths", (const char *)NULL };
+
+double bench_now (void);
+u_int64_t bench_cycles (void);
+void bench_keys (char *keys, const int set, const size_t n);
+void bench_speed (void);
+void bench_quality (char *keys, const size_t n);
+void bench_table (char *keys, const size_t n);
+int bench_cmp (const void *a, const void *b);
+
+int
+main (int argc, char **argv) {
+	char *keys;
+	size_t n;
+	int set;
+	n = argc > 1 ? (size_t)strtoul (argv[1], (char **)NULL, 10)
+		: BENCH_KEYS;
+	keys = (char *)malloc (n * BENCH_KEY_SZ);
+	if (n == 0 || keys == NULL) {
+		return 1;
+	}
+	bench_speed ();
+	for (set = 0; sets[set] != NULL; set++) {
+		bench_keys (keys, set, n);
+		printf ("\nQuality, %lu %s, %d buckets\n", (unsigned long)n,
+		        sets[set], BENCH_BUCKETS);
+		bench_quality (keys, n);
+	}
+	bench_keys (keys, 2, n);
+	printf ("\nTable throughput, %lu file paths, Mops/s, f1 rows, "
+	        "f2 columns\n", (unsigned long)n);
+	bench_table (keys, n);
+	free (keys);
+	return 0;
+}
+
+
+void
+bench_speed (void) {
+	char *buf;
+	u_int64_t c;
+	u_int32_t sink = 0;
+	size_t l, i, r;
+	int h;
+	buf = (char *)malloc (lengths[7]);
+	if (buf == NULL) {
+		return;
+	}
+	for (i = 0; i < lengths[7]; i++) {
+		buf[i] = (char)(rand () & 0xff);
+	}
+	printf ("Speed, bytes/cycle\n%-6s", "hash");
+	for (l = 0; lengths[l] > 0; l++) {
+		printf (" %7lu", (unsigned long)lengths[l]);
+	}
+	printf ("\n");
+	for (h = 0; hashes[h].name != NULL; h++) {
+		printf ("%-6s", hashes[h].name);
+		for (l = 0; lengths[l] > 0; l++) {
+			r = BENCH_BYTES / lengths[l];
+			c = bench_cycles ();
+			for (i = 0; i < r; i++) {
+				/* the previous hash feeds the next, avoiding overlap */
+				buf[0] = (char)sink;
+				sink += hashes[h].f (buf, lengths[l]);
+			}
+			c = bench_cycles () - c;
+			printf (" %7.3f", (double)BENCH_BYTES / (double)(c > 0 ? c : 1));
+		}
+		printf ("\n");
+	}
+	printf ("(%u)\n", sink & 1);
+	free (buf);
+}
+
+
+void
+bench_quality (char *keys, const size_t n) {
+	u_int32_t *hv;
+	unsigned int *buckets;
+	size_t i, collisions, max;
+	double sum, expected;
+	int h;
+	hv = (u_int32_t *)malloc (n * sizeof (u_int32_t));
+	buckets = (unsigned int *)malloc (BENCH_BUCKETS * sizeof (unsigned int));
+	if (hv == NULL || buckets == NULL) {
+		free (hv);
+		free (buckets);
+		return;
+	}
+	printf ("%-6s %10s %10s %10s\n", "hash", "collisions", "max bucket",
+	        "quality");
+	/* quality is 1.0 for a uniform hash, higher values are worse */
+	expected = ((double)n / (2.0 * BENCH_BUCKETS)) *
+		((double)n + 2.0 * BENCH_BUCKETS - 1.0);
+	for (h = 0; hashes[h].name != NULL; h++) {
+		memset (buckets, 0, BENCH_BUCKETS * sizeof (unsigned int));
+		for (i = 0; i < n; i++) {
+			hv[i] = hashes[h].f (&(keys[i * BENCH_KEY_SZ]),
+			                     strlen (&(keys[i * BENCH_KEY_SZ])));
+			buckets[hv[i] & (BENCH_BUCKETS - 1)]++;
+		}
+		max = 0;
+		sum = 0.0;
+		for (i = 0; i < BENCH_BUCKETS; i++) {
+			sum += (double)buckets[i] * ((double)buckets[i] + 1.0) / 2.0;
+			if (buckets[i] > max) {
+				max = buckets[i];
+			}
+		}
+		qsort (hv, n, sizeof (u_int32_t), bench_cmp);
+		collisions = 0;
+		for (i = 1; i < n; i++) {
+			if (hv[i] == hv[i - 1]) {
+				collisions++;
+			}
+		}
+		printf ("%-6s %10lu %10lu %10.3f\n", hashes[h].name,
+		        (unsigned long)collisions, (unsigned long)max, sum / expected);
+	}
+	free (buckets);
+	free (hv);
+}
+
+
+void
+bench_table (char *keys, const size_t n) {
+	caf_hash_table_t *table;
+	size_t i;
+	double start, t;
+	int f1, f2, r;
+	printf ("%-6s", "f1/f2");
+	for (f2 = 0; hashes[f2].name != NULL; f2++) {
+		printf (" %6s", hashes[f2].name);
+	}
+	printf ("\n");
+	for (f1 = 0; hashes[f1].name != NULL; f1++) {
+		printf ("%-6s", hashes[f1].name);
+		for (f2 = 0; hashes[f2].name != NULL; f2++) {
+			if (f1 == f2) {
+				printf (" %6s", "-");
+				continue;
+			}
+			table = caf_hash_table_new (BENCH_TABLE_ID, hashes[f1].f,
+			                            hashes[f2].f);
+			if (table == NULL) {
+				return;
+			}
+			/* one add, four lookups and one remove per key */
+			start = bench_now ();
+			for (i = 0; i < n; i++) {
+				caf_hash_table_add (table, &(keys[i * BENCH_KEY_SZ]),
+				                    strlen (&(keys[i * BENCH_KEY_SZ])),
+				                    &(keys[i * BENCH_KEY_SZ]));
+			}
+			for (r = 0; r < 4; r++) {
+				for (i = 0; i < n; i++) {
+					caf_hash_table_get (table, &(keys[i * BENCH_KEY_SZ]),
+					                    strlen (&(keys[i * BENCH_KEY_SZ])));
+				}
+			}
+			for (i = 0; i < n; i++) {
+				caf_hash_table_remove (table, &(keys[i * BENCH_KEY_SZ]),
+				                       strlen (&(keys[i * BENCH_KEY_SZ])));
+			}
+			t = bench_now () - start;
+			printf (" %6.2f", (double)(n * 6) / t / 1e6);
+			caf_hash_table_delete (table);
+		}
+		printf ("\n");
+	}
+}
+
+
+void
+bench_keys (char *keys, const int set, const size_t n) {
+	size_t i;
+	char *k;
+	for (i = 0; i < n; i++) {
+		k = &(keys[i * BENCH_KEY_SZ]);
+		switch (set) {
+		case 0:
+			snprintf (k, BENCH_KEY_SZ, "%lu", (unsigned long)i);
+			break;
+		case 1:
+			snprintf (k, BENCH_KEY_SZ, "10.%u.%u.%u",
+			          (unsigned int)((i >> 16) & 0xff),
+			          (unsigned int)((i >> 8) & 0xff),
+			          (unsigned int)(i & 0xff));
+			break;
+		default:
+			snprintf (k, BENCH_KEY_SZ, "/usr/lib/caffeine/mod%03u/file%04u.so",
+			          (unsigned int)((i / 1000) % 1000),
+			          (unsigned int)(i % 1000));
+			break;
+		}
+	}
+}
+
+
+int
+bench_cmp (const void *a, const void *b) {
+	u_int32_t x = *(const u_int32_t *)a, y = *(const u_int32_t *)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+
+double
+bench_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+u_int64_t
+bench_cycles (void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return (u_int64_t)__builtin_ia32_rdtsc ();
+#else /* !__x86_64__ */
+	/* no cycle counter, assume a 1 GHz clock */
+	return (u_int64_t)(bench_now () * 1e9);
+#endif /* !__x86_64__ */
+}
+
+/* caf_hash_str_bench.c ends here */
@@ -31,6 +31,17 @@
 
 
 #define TABLE_ID            1000
+#define TABLE_KEYS          256
+#define TABLE_SHRINK_KEYS   1000
+#define TABLE_SHRINK_FILL   700
+#define TABLE_SHRINK_DROP   500
+#define TABLE_KEY_SZ        16
+
+void test_get_many (caf_hash_table_t *table);
+void test_incremental (void);
+void test_inline (void);
+void test_seeded (caf_hash_table_t *table, const char *name);
+void test_seeded_hashed (void);
 
 int
 main () {
@@ -50,10 +61,198 @@ main () {
 		printf ("remove: %d\n", caf_hash_table_remove (table, "hello",
 													   strlen("hello") + 1));
 		caf_hash_table_dump (stdout, table);
-		deque_dump_ptr (stdout, table->hashes);
+		printf ("get: %s\n", (char *)caf_hash_table_get (table, "hola",
+		                                                   strlen("hola") + 1));
+		printf ("get hashed: %s\n", (char *)caf_hash_table_get_hashed (
+				table, "hola", strlen("hola") + 1,
+				caf_shash_dek ("hola", strlen("hola") + 1),
+				caf_shash_fnv ("hola", strlen("hola") + 1)));
+		test_get_many (table);
 		caf_hash_table_delete (table);
 	}
+	test_incremental ();
+	test_inline ();
+	/* caf_shash_bp collides a lot on short sequential keys */
+	test_seeded (caf_hash_table_new (TABLE_ID, caf_shash_bp, caf_shash_fnv),
+	             "unseeded");
+	test_seeded (caf_hash_table_new_seeded (TABLE_ID, caf_shash_bp,
+	                                        caf_shash_fnv,
+	                                        CAF_HASH_TABLE_PROBE_MAX),
+	             "seeded");
+	test_seeded (caf_hash_table_new_seeded (TABLE_ID, caf_shash_bp,
+	                                        caf_shash_fnv, 1),
+	             "reseeding");
+	test_seeded_hashed ();
 	return 0;
 }
 
+
+void
+test_get_many (caf_hash_table_t *table) {
+	const void *keys[4] = { "hola", "hello", "bye", "chao" };
+	size_t sizes[4];
+	void *out[4];
+	size_t i, found;
+	for (i = 0; i < 4; i++) {
+		sizes[i] = strlen ((const char *)keys[i]) + 1;
+	}
+	found = caf_hash_table_get_many (table, keys, sizes, 4, out);
+	printf ("get many: %lu found\n", (unsigned long)found);
+	for (i = 0; i < 4; i++) {
+		printf ("    %s: %s\n", (const char *)keys[i],
+		        out[i] != NULL ? (char *)out[i] : "(null)");
+	}
+}
+
+
+void
+test_incremental (void) {
+	char keys[TABLE_KEYS][TABLE_KEY_SZ];
+	char many[TABLE_SHRINK_KEYS][TABLE_KEY_SZ];
+	size_t load, peak = 0;
+	int i, found = 0;
+	caf_hash_table_t *table = (caf_hash_table_t *)NULL;
+	table = caf_hash_table_new (TABLE_ID, caf_shash_dek, caf_shash_fnv);
+	if (table != (caf_hash_table_t *)NULL) {
+		caf_hash_table_incremental (table, 2);
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (keys[i], TABLE_KEY_SZ, "key %d", i);
+			caf_hash_table_add (table, keys[i], strlen (keys[i]) + 1, keys[i]);
+		}
+		for (i = 0; i < TABLE_KEYS; i++) {
+			if (caf_hash_table_get (table, keys[i], strlen (keys[i]) + 1)
+				== keys[i]) {
+				found++;
+			}
+		}
+		printf ("incremental: found %d/%d, migrated %lu, migrate: %d\n",
+		        found, TABLE_KEYS, table->rehash_count,
+		        caf_hash_table_migrate (table, 0));
+		caf_hash_table_delete (table);
+	}
+	/* additions while a shrink migrates must not overfill the half array */
+	found = 0;
+	table = caf_hash_table_new (TABLE_ID, caf_shash_dek, caf_shash_fnv);
+	if (table != (caf_hash_table_t *)NULL) {
+		for (i = 0; i < TABLE_SHRINK_KEYS; i++) {
+			snprintf (many[i], TABLE_KEY_SZ, "key %d", i);
+		}
+		for (i = 0; i < TABLE_SHRINK_FILL; i++) {
+			caf_hash_table_add (table, many[i], strlen (many[i]) + 1, many[i]);
+		}
+		caf_hash_table_incremental (table, 1);
+		for (i = 0; i < TABLE_SHRINK_DROP; i++) {
+			caf_hash_table_remove (table, many[i], strlen (many[i]) + 1);
+		}
+		printf ("incremental shrink: size %lu, old size %lu\n",
+		        (unsigned long)table->size, (unsigned long)table->old_size);
+		for (i = TABLE_SHRINK_FILL; i < TABLE_SHRINK_KEYS; i++) {
+			caf_hash_table_add (table, many[i], strlen (many[i]) + 1, many[i]);
+			load = table->count * 100 / table->size;
+			peak = load > peak ? load : peak;
+		}
+		for (i = 0; i < TABLE_SHRINK_DROP; i++) {
+			caf_hash_table_add (table, many[i], strlen (many[i]) + 1, many[i]);
+		}
+		for (i = 0; i < TABLE_SHRINK_KEYS; i++) {
+			if (caf_hash_table_get (table, many[i], strlen (many[i]) + 1)
+				== many[i]) {
+				found++;
+			}
+		}
+		printf ("incremental shrink: found %d/%d, count %lu, size %lu, "
+		        "peak load %lu%% (max %d%%)\n", found, TABLE_SHRINK_KEYS,
+		        (unsigned long)table->count, (unsigned long)table->size,
+		        (unsigned long)peak, CAF_HASH_TABLE_LOAD_MAX);
+		caf_hash_table_delete (table);
+	}
+}
+
+
+
+void
+test_inline (void) {
+	char key[TABLE_KEY_SZ];
+	int i, found = 0;
+	caf_hash_table_t *table = (caf_hash_table_t *)NULL;
+	table = caf_hash_table_new (TABLE_ID, caf_shash_dek, caf_shash_fnv);
+	if (table != (caf_hash_table_t *)NULL) {
+		caf_hash_table_inline (table, CAF_HASH_TABLE_INLINE_SZ);
+		/* the key buffer is reused, the table keeps its own copies */
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			caf_hash_table_add (table, key, strlen (key) + 1, "inline");
+		}
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			if (caf_hash_table_get (table, key, strlen (key) + 1) != NULL) {
+				found++;
+			}
+		}
+		printf ("inline: found %d/%d, stride %lu\n", found, TABLE_KEYS,
+		        (unsigned long)table->stride);
+		caf_hash_table_delete (table);
+	}
+}
+
+
+void
+test_seeded (caf_hash_table_t *table, const char *name) {
+	char key[TABLE_KEY_SZ];
+	int i, found = 0;
+	if (table != (caf_hash_table_t *)NULL) {
+		caf_hash_table_inline (table, CAF_HASH_TABLE_INLINE_SZ);
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			caf_hash_table_add (table, key, strlen (key) + 1, "seeded");
+		}
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			if (caf_hash_table_get (table, key, strlen (key) + 1) != NULL) {
+				found++;
+			}
+		}
+		printf ("%s: found %d/%d, probe peak %lu, reseeds %lu\n", name,
+		        found, TABLE_KEYS, (unsigned long)table->probe_peak,
+		        table->reseed_count);
+		caf_hash_table_delete (table);
+	}
+}
+
+
+void
+test_seeded_hashed (void) {
+	char key[TABLE_KEY_SZ];
+	u_int32_t h1[TABLE_KEYS], h2[TABLE_KEYS];
+	int i, found = 0;
+	caf_hash_table_t *table = (caf_hash_table_t *)NULL;
+	table = caf_hash_table_new_seeded (TABLE_ID, caf_shash_bp,
+	                                   caf_shash_fnv, 1);
+	if (table != (caf_hash_table_t *)NULL) {
+		/* every hash is computed before the first addition */
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			caf_hash_table_hash (table, key, strlen (key) + 1, &h1[i],
+			                     &h2[i]);
+		}
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			caf_hash_table_add_hashed (table, key, strlen (key) + 1,
+			                           "hashed", h1[i], h2[i]);
+		}
+		for (i = 0; i < TABLE_KEYS; i++) {
+			snprintf (key, TABLE_KEY_SZ, "key %d", i);
+			if (caf_hash_table_get_hashed (table, key, strlen (key) + 1,
+			                               h1[i], h2[i]) != NULL) {
+				found++;
+			}
+		}
+		printf ("seeded hashed: found %d/%d, reseeds %lu, failed %lu\n",
+		        found, TABLE_KEYS, table->reseed_count,
+		        table->reseed_fails);
+		caf_hash_table_delete (table);
+	}
+}
+
+
 /* caf_hash_tabel.c ends here */
@@ -0,0 +1,132 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <caf/caf_hash_str.h>
+#include <caf/caf_hash_table.h>
+
+
+#define TABLE_ID            1000
+#define TABLE_KEYS          (1 << 21)
+#define TABLE_KEY_SZ        16
+#define TABLE_CHUNK         4096
+
+double bench_now (void);
+
+int
+main (int argc, char **argv) {
+	caf_hash_table_t *table = (caf_hash_table_t *)NULL;
+	char *keys, *probes;
+	const void **ptrs;
+	size_t *sizes, *order, i, j, n, t, found;
+	void **out;
+	u_int32_t seed = 2463534242U;
+	double start, single, batched;
+	n = argc > 1 ? (size_t)strtoul (argv[1], (char **)NULL, 10) : TABLE_KEYS;
+	keys = (char *)malloc (n * TABLE_KEY_SZ);
+	probes = (char *)malloc (n * TABLE_KEY_SZ);
+	ptrs = (const void **)malloc (n * sizeof (void *));
+	sizes = (size_t *)malloc (n * sizeof (size_t));
+	order = (size_t *)malloc (n * sizeof (size_t));
+	out = (void **)malloc (TABLE_CHUNK * sizeof (void *));
+	table = caf_hash_table_new (TABLE_ID, caf_shash_dek, caf_shash_fnv);
+	if (table != NULL && argc > 2) {
+		caf_hash_table_inline (table, (size_t)strtoul (argv[2],
+		                                               (char **)NULL, 10));
+	}
+	if (n == 0 || keys == NULL || probes == NULL || ptrs == NULL || sizes == NULL ||
+		order == NULL || out == NULL || table == NULL) {
+		return 1;
+	}
+	for (i = 0; i < n; i++) {
+		snprintf (&(keys[i * TABLE_KEY_SZ]), TABLE_KEY_SZ, "key %u",
+		          (unsigned int)i);
+		caf_hash_table_add (table, &(keys[i * TABLE_KEY_SZ]),
+		                    strlen (&(keys[i * TABLE_KEY_SZ])) + 1,
+		                    &(keys[i * TABLE_KEY_SZ]));
+		order[i] = i;
+	}
+	/* random lookup order, so every lookup misses the cache */
+	for (i = n - 1; i > 0; i--) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		j = seed % (i + 1);
+		t = order[i];
+		order[i] = order[j];
+		order[j] = t;
+	}
+	/* lookups use copies of the keys, as keys read from the network */
+	for (i = 0; i < n; i++) {
+		memcpy (&(probes[i * TABLE_KEY_SZ]), &(keys[order[i] * TABLE_KEY_SZ]),
+		        TABLE_KEY_SZ);
+		ptrs[i] = &(probes[i * TABLE_KEY_SZ]);
+		sizes[i] = strlen ((const char *)ptrs[i]) + 1;
+	}
+	printf ("keys: %lu, slots: %lu (%lu KB), inline keys: %lu\n",
+	        (unsigned long)n, (unsigned long)table->size,
+	        (unsigned long)(table->size * (table->stride + 1) / 1024),
+	        (unsigned long)table->key_inline);
+	found = 0;
+	start = bench_now ();
+	for (i = 0; i < n; i++) {
+		if (caf_hash_table_get (table, ptrs[i], sizes[i]) != NULL) {
+			found++;
+		}
+	}
+	single = bench_now () - start;
+	printf ("single: %lu found, %.1f ns/lookup\n", (unsigned long)found,
+	        single * 1e9 / (double)n);
+	found = 0;
+	start = bench_now ();
+	for (i = 0; i < n; i += TABLE_CHUNK) {
+		found += caf_hash_table_get_many (table, &(ptrs[i]), &(sizes[i]),
+		                                  (n - i) < TABLE_CHUNK ? (n - i)
+		                                  : TABLE_CHUNK, out);
+	}
+	batched = bench_now () - start;
+	printf ("batched: %lu found, %.1f ns/lookup\n", (unsigned long)found,
+	        batched * 1e9 / (double)n);
+	printf ("speedup: %.2fx\n", single / batched);
+	caf_hash_table_delete (table);
+	free (out);
+	free (order);
+	free (sizes);
+	free (ptrs);
+	free (probes);
+	free (keys);
+	return 0;
+}
+
+double
+bench_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* caf_hashtable_bench.c ends here */
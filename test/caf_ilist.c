@@ -0,0 +1,156 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_tool_macro.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_ilist.h"
+
+#define TEST_SESSIONS       8
+
+typedef struct test_session_s test_session_t;
+
+struct test_session_s {
+	int id;
+	/** link in the idle deque */
+	caf_ilink_t idle;
+	/** link in the round robin circle */
+	caf_ilink_t ring;
+};
+
+void test_ideque (test_session_t *s);
+void test_ilstc (test_session_t *s);
+int test_map_cb (void *data);
+int test_search_cb (void *ndata, void *data);
+int test_delete_cb (void *data);
+
+
+int
+main (void) {
+	test_session_t *s;
+	int i;
+	s = (test_session_t *)xmalloc (TEST_SESSIONS * sizeof (test_session_t));
+	for (i = 0; i < TEST_SESSIONS; i++) {
+		s[i].id = i;
+	}
+	test_ideque (s);
+	test_ilstc (s);
+	xfree (s);
+	return 0;
+}
+
+
+void
+test_ideque (test_session_t *s) {
+	ideque_t *dq = ideque_create (offsetof (test_session_t, idle));
+	test_session_t *cur;
+	int i, rc;
+	for (i = 0; i < TEST_SESSIONS; i++) {
+		ideque_push (dq, &(s[i]));
+	}
+	/* removal by object needs no search */
+	ideque_remove (dq, &(s[3]));
+	ideque_remove (dq, &(s[0]));
+	ideque_remove (dq, &(s[7]));
+	/* an unlinked object must not reset the ends */
+	rc = ideque_remove (dq, &(s[0]));
+	printf ("ideque_t *: remove unlinked: %s, length %d\n",
+	        rc == CAF_OK ? "ok" : "error", ideque_length (dq));
+	ideque_insert_before (dq, &(s[4]), &(s[3]));
+	ideque_prepend (dq, &(s[7]));
+	printf ("ideque_t *: length %d, ids:", ideque_length (dq));
+	for (cur = (test_session_t *)ideque_head (dq);
+		 cur != (test_session_t *)NULL;
+		 cur = (test_session_t *)ideque_next (dq, cur)) {
+		printf (" %d", cur->id);
+	}
+	printf ("\n");
+	cur = CAF_ILINK_ENTRY(dq->tail, test_session_t, idle);
+	printf ("tail entry: %d\n", cur->id);
+	ideque_map (dq, test_map_cb);
+	cur = (test_session_t *)ideque_search (dq, &(s[5].id), test_search_cb);
+	printf ("\nsearch: %d\n", cur != (test_session_t *)NULL ? cur->id : -1);
+	cur = (test_session_t *)ideque_pop (dq);
+	printf ("pop: %d", cur->id);
+	cur = (test_session_t *)ideque_first (dq);
+	printf (", first: %d, length %d\n", cur->id, ideque_length (dq));
+	ideque_delete (dq, test_delete_cb);
+}
+
+
+void
+test_ilstc (test_session_t *s) {
+	ilstc_t *lst = ilstc_create (offsetof (test_session_t, ring));
+	test_session_t *cur;
+	int i;
+	for (i = 0; i < TEST_SESSIONS; i += 2) {
+		ilstc_push (lst, &(s[i]));
+	}
+	printf ("ilstc_t *: round robin:");
+	for (i = 0; i < TEST_SESSIONS; i++) {
+		cur = (test_session_t *)ilstc_rotate (lst);
+		printf (" %d", cur->id);
+	}
+	printf ("\n");
+	ilstc_remove (lst, &(s[4]));
+	printf ("ilstc_t *: remove unlinked: %s\n",
+	        ilstc_remove (lst, &(s[4])) == CAF_OK ? "ok" : "error");
+	printf ("ilstc_t *: length %d, circle from 6:", ilstc_length (lst));
+	cur = &(s[6]);
+	for (i = 0; i < ilstc_length (lst) * 2; i++) {
+		printf (" %d", cur->id);
+		cur = (test_session_t *)ilstc_next (lst, cur);
+	}
+	printf ("\n");
+	ilstc_map (lst, test_map_cb);
+	printf ("\n");
+	ilstc_delete_nocb (lst);
+}
+
+
+int
+test_map_cb (void *data) {
+	printf (" <%d>", ((test_session_t *)data)->id);
+	return CAF_OK;
+}
+
+
+int
+test_search_cb (void *ndata, void *data) {
+	return ((test_session_t *)ndata)->id == *(int *)data ? CAF_OK
+		: CAF_ERROR;
+}
+
+
+int
+test_delete_cb (void *data) {
+	printf ("delete: %d\n", ((test_session_t *)data)->id);
+	return CAF_OK;
+}
+
+/* caf_ilist.c ends here */
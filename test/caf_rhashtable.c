@@ -0,0 +1,136 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "caf/caf.h"
+#include "caf/caf_hash_str.h"
+#include "caf/caf_rhash_table.h"
+#include "caf/caf_thread_attr.h"
+#include "caf/caf_thread_pool.h"
+#include "caf/caf_thread_mutex.h"
+
+
+#define TABLE_ID            1000
+#define TABLE_KEYS          1024
+#define TABLE_KEY_SZ        16
+#define TABLE_THREADS       4
+#define TABLE_ROUNDS        200
+
+void *pth_rtn (void *p);
+
+caf_rhash_table_t *table = (caf_rhash_table_t *)NULL;
+pth_mutex_t *common_mutex = (pth_mutex_t *)NULL;
+char keys[TABLE_KEYS][TABLE_KEY_SZ];
+char vals[2][TABLE_KEY_SZ] = { "even", "odd" };
+int done = 0;
+long lookups = 0;
+long misses = 0;
+
+int
+main (void) {
+	int i, j, rt;
+	pth_attri_t *attr = (pth_attri_t *)NULL;
+	pth_pool_t *pool = (pth_pool_t *)NULL;
+	table = caf_rhash_table_new (TABLE_ID, caf_shash_dek, caf_shash_fnv);
+	common_mutex = pth_mtx_new ();
+	attr = pth_attri_new ();
+	if (table == (caf_rhash_table_t *)NULL ||
+		common_mutex == (pth_mutex_t *)NULL ||
+		attr == (pth_attri_t *)NULL) {
+		return 1;
+	}
+	for (i = 0; i < TABLE_KEYS; i++) {
+		snprintf (keys[i], TABLE_KEY_SZ, "key %d", i);
+	}
+	/* even keys stay in the table, odd keys come and go */
+	for (i = 0; i < TABLE_KEYS; i += 2) {
+		caf_rhash_table_add (table, keys[i], strlen (keys[i]) + 1, vals[0]);
+	}
+	pth_mtxattr_init (common_mutex);
+	pth_mtx_init (common_mutex);
+	rt = pth_attr_init (attr);
+	if (rt == 0) {
+		rt = pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL);
+	}
+	if (rt == 0) {
+		pool = pth_pool_create (attr, pth_rtn, TABLE_THREADS, (void *)NULL);
+		for (j = 0; j < TABLE_ROUNDS; j++) {
+			for (i = 1; i < TABLE_KEYS; i += 2) {
+				caf_rhash_table_add (table, keys[i], strlen (keys[i]) + 1,
+				                     vals[1]);
+			}
+			for (i = 0; i < TABLE_KEYS; i += 2) {
+				caf_rhash_table_set (table, keys[i], strlen (keys[i]) + 1,
+				                     vals[j & 1]);
+			}
+			for (i = 1; i < TABLE_KEYS; i += 2) {
+				caf_rhash_table_remove (table, keys[i],
+				                        strlen (keys[i]) + 1);
+			}
+		}
+		__atomic_store_n (&done, 1, __ATOMIC_RELEASE);
+		pth_pool_join (pool);
+		printf ("readers: %d, misses: %ld, lookups: %s\n", TABLE_THREADS,
+		        misses, lookups > 0 ? "yes" : "no");
+		printf ("count: %lu, synchronize: %d, retired: %lu\n",
+		        (unsigned long)table->count,
+		        caf_rhash_table_synchronize (table),
+		        (unsigned long)table->retired_count);
+		pth_pool_delete (pool);
+	}
+	pth_attri_destroy (attr);
+	pth_mtx_destroy (common_mutex);
+	pth_mtxattr_destroy (common_mutex);
+	pth_mtx_delete (common_mutex);
+	caf_rhash_table_delete (table);
+	return 0;
+}
+
+void *
+pth_rtn (void *p) {
+	int i;
+	long own = 0, lost = 0;
+	caf_rhash_reader_t *reader;
+	reader = caf_rhash_reader_new (table);
+	while (!__atomic_load_n (&done, __ATOMIC_ACQUIRE)) {
+		for (i = 0; i < TABLE_KEYS; i += 2) {
+			if (caf_rhash_table_get (table, keys[i],
+			                         strlen (keys[i]) + 1) == (void *)NULL) {
+				lost++;
+			}
+			own++;
+		}
+		caf_rhash_reader_quiescent (reader);
+	}
+	caf_rhash_reader_delete (reader);
+	pth_mtx_lock (common_mutex);
+	lookups += own;
+	misses += lost;
+	pth_mtx_unlock (common_mutex);
+	pthread_exit (p);
+}
+
+/* caf_rhashtable.c ends here */
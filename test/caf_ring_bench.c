@@ -0,0 +1,332 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <caf/caf.h>
+#include <caf/caf_data_mem.h>
+#include <caf/caf_data_deque.h>
+#include <caf/caf_data_ring.h>
+
+
+#define BENCH_ITEMS         (1 << 22)
+#define BENCH_RING          1024
+#define BENCH_BATCH         32
+#define BENCH_PINGS         (1 << 18)
+
+typedef struct bench_rec_s bench_rec_t;
+
+struct bench_rec_s {
+	unsigned long seq;
+	unsigned long check;
+};
+
+typedef struct bench_run_s bench_run_t;
+
+struct bench_run_s {
+	caf_ring_t *ring;
+	caf_ring_t *back;
+	deque_t *deque;
+	pthread_mutex_t lock;
+	unsigned long n;
+	size_t batch;
+	unsigned long bad;
+};
+
+double bench_now (void);
+void bench_report (const char *name, bench_run_t *run,
+                   void *(*prod)(void *), void *(*cons)(void *));
+void *bench_deque_prod (void *p);
+void *bench_deque_cons (void *p);
+void *bench_ring_prod (void *p);
+void *bench_ring_cons (void *p);
+void *bench_rec_prod (void *p);
+void *bench_rec_cons (void *p);
+void *bench_ping (void *p);
+void *bench_pong (void *p);
+
+int
+main (int argc, char **argv) {
+	bench_run_t run;
+	pthread_t pong;
+	double start, t;
+	memset (&run, 0, sizeof (run));
+	run.n = argc > 1 ? strtoul (argv[1], (char **)NULL, 10) : BENCH_ITEMS;
+	if (run.n == 0) {
+		return 1;
+	}
+	printf ("Throughput, %lu items, one producer, one consumer\n", run.n);
+	printf ("%-24s %10s %10s\n", "queue", "Mitems/s", "bad");
+
+	run.deque = deque_create ();
+	pthread_mutex_init (&(run.lock), (pthread_mutexattr_t *)NULL);
+	bench_report ("mutex deque_t", &run, bench_deque_prod, bench_deque_cons);
+	pthread_mutex_destroy (&(run.lock));
+	deque_delete_nocb (run.deque);
+
+	run.ring = caf_ring_new (BENCH_RING);
+	run.batch = 1;
+	bench_report ("ring void *", &run, bench_ring_prod, bench_ring_cons);
+	run.batch = BENCH_BATCH;
+	bench_report ("ring void *, batch 32", &run, bench_ring_prod,
+	              bench_ring_cons);
+	caf_ring_delete (run.ring);
+
+	run.ring = caf_ring_new_rec (BENCH_RING, sizeof (bench_rec_t));
+	run.batch = 1;
+	bench_report ("ring record", &run, bench_rec_prod, bench_rec_cons);
+	run.batch = BENCH_BATCH;
+	bench_report ("ring record, batch 32", &run, bench_rec_prod,
+	              bench_rec_cons);
+	caf_ring_delete (run.ring);
+
+	/* one item bounces between two rings, so each leg is a handoff */
+	run.ring = caf_ring_new (BENCH_RING);
+	run.back = caf_ring_new (BENCH_RING);
+	run.n = BENCH_PINGS;
+	pthread_create (&pong, (pthread_attr_t *)NULL, bench_pong, &run);
+	start = bench_now ();
+	bench_ping (&run);
+	t = bench_now () - start;
+	pthread_join (pong, (void **)NULL);
+	printf ("\nLatency, %lu round trips\n", run.n);
+	printf ("%-24s %10.1f ns\n", "ring one way handoff",
+	        t * 1e9 / (double)run.n / 2.0);
+	caf_ring_delete (run.back);
+	caf_ring_delete (run.ring);
+	return 0;
+}
+
+
+double
+bench_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+void
+bench_report (const char *name, bench_run_t *run, void *(*prod)(void *),
+              void *(*cons)(void *)) {
+	pthread_t pt, ct;
+	double start, t;
+	run->bad = 0;
+	start = bench_now ();
+	pthread_create (&ct, (pthread_attr_t *)NULL, cons, run);
+	pthread_create (&pt, (pthread_attr_t *)NULL, prod, run);
+	pthread_join (pt, (void **)NULL);
+	pthread_join (ct, (void **)NULL);
+	t = bench_now () - start;
+	printf ("%-24s %10.2f %10lu\n", name, (double)run->n / t / 1e6,
+	        run->bad);
+}
+
+
+void *
+bench_deque_prod (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	unsigned long i;
+	for (i = 1; i <= run->n; i++) {
+		pthread_mutex_lock (&(run->lock));
+		deque_push (run->deque, (void *)i);
+		pthread_mutex_unlock (&(run->lock));
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_deque_cons (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	caf_dequen_t *n;
+	unsigned long i = 1;
+	while (i <= run->n) {
+		pthread_mutex_lock (&(run->lock));
+		n = deque_first (run->deque);
+		pthread_mutex_unlock (&(run->lock));
+		if (n != (caf_dequen_t *)NULL) {
+			if ((unsigned long)n->data != i) {
+				run->bad++;
+			}
+			deque_node_free (run->deque, n);
+			i++;
+		} else {
+			sched_yield ();
+		}
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_ring_prod (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	void *items[BENCH_BATCH];
+	unsigned long i = 1;
+	size_t k, cnt, done;
+	while (i <= run->n) {
+		cnt = run->batch;
+		if (cnt > run->n - i + 1) {
+			cnt = run->n - i + 1;
+		}
+		if (cnt == 1) {
+			if (caf_ring_push (run->ring, (void *)i) == CAF_OK) {
+				i++;
+			} else {
+				sched_yield ();
+			}
+			continue;
+		}
+		for (k = 0; k < cnt; k++) {
+			items[k] = (void *)(i + k);
+		}
+		k = 0;
+		while (k < cnt) {
+			done = caf_ring_push_batch (run->ring, &(items[k]), cnt - k);
+			if (done == 0) {
+				/* lets the consumer run when both share one CPU */
+				sched_yield ();
+			}
+			k += done;
+		}
+		i += cnt;
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_ring_cons (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	void *items[BENCH_BATCH];
+	unsigned long i = 1;
+	size_t k, cnt;
+	while (i <= run->n) {
+		if (run->batch == 1) {
+			items[0] = caf_ring_pop (run->ring);
+			cnt = items[0] != (void *)NULL ? 1 : 0;
+		} else {
+			cnt = caf_ring_pop_batch (run->ring, items, run->batch);
+		}
+		if (cnt == 0) {
+			sched_yield ();
+		}
+		for (k = 0; k < cnt; k++, i++) {
+			if ((unsigned long)items[k] != i) {
+				run->bad++;
+			}
+		}
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_rec_prod (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	bench_rec_t recs[BENCH_BATCH];
+	unsigned long i = 1;
+	size_t k, cnt, done;
+	while (i <= run->n) {
+		cnt = run->batch;
+		if (cnt > run->n - i + 1) {
+			cnt = run->n - i + 1;
+		}
+		for (k = 0; k < cnt; k++) {
+			recs[k].seq = i + k;
+			recs[k].check = ~(i + k);
+		}
+		k = 0;
+		while (k < cnt) {
+			done = caf_ring_write_batch (run->ring, &(recs[k]), cnt - k);
+			if (done == 0) {
+				sched_yield ();
+			}
+			k += done;
+		}
+		i += cnt;
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_rec_cons (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	bench_rec_t recs[BENCH_BATCH];
+	unsigned long i = 1;
+	size_t k, cnt;
+	while (i <= run->n) {
+		cnt = caf_ring_read_batch (run->ring, recs, run->batch);
+		if (cnt == 0) {
+			sched_yield ();
+		}
+		for (k = 0; k < cnt; k++, i++) {
+			if (recs[k].seq != i || recs[k].check != ~i) {
+				run->bad++;
+			}
+		}
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_ping (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	unsigned long i;
+	for (i = 1; i <= run->n; i++) {
+		while (caf_ring_push (run->ring, (void *)i) != CAF_OK) {
+			sched_yield ();
+		}
+		while (caf_ring_pop (run->back) == (void *)NULL) {
+			sched_yield ();
+		}
+	}
+	return (void *)NULL;
+}
+
+
+void *
+bench_pong (void *p) {
+	bench_run_t *run = (bench_run_t *)p;
+	void *item;
+	unsigned long i;
+	for (i = 1; i <= run->n; i++) {
+		while ((item = caf_ring_pop (run->ring)) == (void *)NULL) {
+			sched_yield ();
+		}
+		while (caf_ring_push (run->back, item) != CAF_OK) {
+			sched_yield ();
+		}
+	}
+	return (void *)NULL;
+}
+
+/* caf_ring_bench.c ends here */
@@ -0,0 +1,154 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_data_slab.h"
+#include "caf/caf_data_deque.h"
+#include "caf/caf_data_cdeque.h"
+#include "caf/caf_data_lstc.h"
+
+#define TEST_ITEMS          1000
+#define TEST_ROUNDS         1000
+
+void test_deque (caf_slab_t *slab);
+void test_cdeque (caf_slab_t *slab);
+void test_lstc (caf_slab_t *slab);
+int test_keep_cb (void *ptr);
+double test_now (void);
+
+
+int
+main (void) {
+	caf_slab_t *slab;
+	double t;
+	t = test_now ();
+	test_deque ((caf_slab_t *)NULL);
+	printf ("deque_t *: xmalloc nodes %.3f s\n", test_now () - t);
+	slab = caf_slab_new (CAF_CAF_DEQUENODE_SZ, 0, CAF_SLAB_UNLOCKED);
+	t = test_now ();
+	test_deque (slab);
+	printf ("deque_t *: slab nodes %.3f s\n", test_now () - t);
+	caf_slab_dump (stdout, slab);
+	caf_slab_delete (slab);
+
+	slab = caf_slab_new (CAF_LSTDLCNODE_SZ, 0, CAF_SLAB_UNLOCKED);
+	test_cdeque (slab);
+	caf_slab_dump (stdout, slab);
+	caf_slab_delete (slab);
+
+	/* the circular list slab can only be set once */
+	slab = caf_slab_new (CAF_LSTC_SZ, 64, CAF_SLAB_LOCKED);
+	printf ("lstc_slab_set: %s",
+	        lstc_slab_set (slab) == CAF_OK ? "ok" : "error");
+	printf (", again: %s\n",
+	        lstc_slab_set (slab) == CAF_OK ? "ok" : "error");
+	test_lstc (slab);
+	caf_slab_dump (stdout, slab);
+	caf_slab_delete (slab);
+	return 0;
+}
+
+
+void
+test_deque (caf_slab_t *slab) {
+	deque_t *lst = deque_create ();
+	caf_dequen_t *n;
+	long i, r, sum = 0;
+	deque_slab_set (lst, slab);
+	/* nodes popped in one round are reused by the next one */
+	for (r = 0; r < TEST_ROUNDS; r++) {
+		for (i = 0; i < TEST_ITEMS; i++) {
+			deque_push (lst, (void *)(i + 1));
+		}
+		for (i = 0; i < TEST_ITEMS - 1; i++) {
+			n = deque_pop (lst);
+			sum += (long)n->data;
+			deque_node_free (lst, n);
+		}
+		deque_delete_nocb (lst);
+		lst = deque_create ();
+		deque_slab_set (lst, slab);
+	}
+	deque_delete_nocb (lst);
+	printf ("deque_t *: sum %ld\n", sum);
+}
+
+
+void
+test_cdeque (caf_slab_t *slab) {
+	cdeque_t *lst = cdeque_create ();
+	caf_cdequen_t *n;
+	long i, r, sum = 0;
+	cdeque_slab_set (lst, slab);
+	for (r = 0; r < TEST_ROUNDS; r++) {
+		for (i = 0; i < TEST_ITEMS; i++) {
+			cdeque_push (lst, (void *)(i + 1));
+		}
+		for (i = 0; i < TEST_ITEMS; i++) {
+			n = cdeque_pop (lst);
+			sum += (long)n->data;
+			cdeque_node_free (lst, n);
+		}
+	}
+	cdeque_delete_nocb (lst);
+	printf ("cdeque_t *: sum %ld\n", sum);
+}
+
+
+void
+test_lstc (caf_slab_t *slab) {
+	lstcn_t *lst;
+	long i, r, sum = 0;
+	for (r = 0; r < TEST_ROUNDS; r++) {
+		lst = lstc_new ((void *)1);
+		for (i = 1; i < TEST_ITEMS; i++) {
+			lstc_push (lst, (void *)(i + 1));
+		}
+		sum += lstc_length (lst);
+		lstc_delete (lst, test_keep_cb);
+	}
+	printf ("lstcn_t *: sum %ld, %lu slab objects\n", sum,
+	        slab->hits + slab->misses);
+}
+
+
+int
+test_keep_cb (void *ptr) {
+	return ptr != (void *)NULL ? CAF_OK : CAF_ERROR;
+}
+
+
+double
+test_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* caf_slab.c ends here */
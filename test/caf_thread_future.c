@@ -0,0 +1,248 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_attr.h"
+#include "caf/caf_thread_future.h"
+
+#define TEST_WORKERS        4
+#define TEST_CHAIN          100
+#define TEST_FUTURES        16
+
+pth_pool_t *pool;
+
+void test_wait (void);
+void test_then (void);
+void test_fail (void);
+void test_when_all (void);
+void test_when_any (void);
+void test_async (void);
+void *then_add (void *value, void *arg);
+void *async_square (void *arg);
+void *async_sleep (void *arg);
+const char *test_result (int rt);
+
+int
+main (void) {
+	pth_attri_t *attr = pth_attri_new ();
+	if (attr == (pth_attri_t *)NULL || pth_attr_init (attr) != 0
+		|| pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL) != 0) {
+		return 1;
+	}
+	pool = pth_pool_executor (attr, TEST_WORKERS, 0);
+	test_wait ();
+	test_then ();
+	test_fail ();
+	test_when_all ();
+	test_when_any ();
+	test_async ();
+	pth_pool_shutdown (pool, 1);
+	pth_pool_delete (pool);
+	pth_attri_destroy (attr);
+	return 0;
+}
+
+
+void
+test_wait (void) {
+	pth_future_t *f = pth_future_new ();
+	struct timespec tm = { 0, 20000000L };
+	void *v = (void *)NULL;
+	int rt;
+	printf ("wait pending, 20ms: %s\n",
+	        test_result (pth_future_wait (f, &tm, &v)));
+	printf ("resolve: %s\n", test_result (pth_future_resolve (f, (void *)42L)));
+	printf ("resolve again: %s\n",
+	        test_result (pth_future_resolve (f, (void *)43L)));
+	rt = pth_future_wait (f, &tm, &v);
+	printf ("wait ready: %s, value %ld\n", test_result (rt), (long)v);
+	pth_future_release (f);
+}
+
+
+void
+test_then (void) {
+	pth_future_t *head, *f, *next;
+	void *v = (void *)NULL;
+	int i;
+	/* inline chain, listeners added before the value is known */
+	head = pth_future_new ();
+	f = pth_future_retain (head);
+	for (i = 0; i < TEST_CHAIN; i++) {
+		next = pth_future_then (f, (pth_pool_t *)NULL, then_add, (void *)1L);
+		pth_future_release (f);
+		f = next;
+	}
+	pth_future_resolve (head, (void *)0L);
+	pth_future_wait (f, (const struct timespec *)NULL, &v);
+	printf ("inline chain of %d: %ld\n", TEST_CHAIN, (long)v);
+	pth_future_release (f);
+	pth_future_release (head);
+	/* pool chain, started from a settled future */
+	f = pth_future_new ();
+	pth_future_resolve (f, (void *)0L);
+	for (i = 0; i < TEST_CHAIN; i++) {
+		next = pth_future_then (f, pool, then_add, (void *)2L);
+		pth_future_release (f);
+		f = next;
+	}
+	pth_future_wait (f, (const struct timespec *)NULL, &v);
+	printf ("pool chain of %d: %ld\n", TEST_CHAIN, (long)v);
+	pth_future_release (f);
+}
+
+
+void
+test_fail (void) {
+	pth_future_t *head, *mid, *f;
+	int rt;
+	head = pth_future_new ();
+	mid = pth_future_then (head, pool, then_add, (void *)1L);
+	f = pth_future_then (mid, pool, then_add, (void *)1L);
+	pth_future_fail (head, EINVAL);
+	rt = pth_future_wait (f, (const struct timespec *)NULL, (void **)NULL);
+	printf ("failed chain: %s, error %s\n", test_result (rt),
+	        pth_future_error (f) == EINVAL ? "EINVAL" : "other");
+	pth_future_release (head);
+	pth_future_release (mid);
+	pth_future_release (f);
+}
+
+
+void
+test_when_all (void) {
+	pth_future_t *fs[TEST_FUTURES], *all;
+	void *v;
+	long i, sum = 0;
+	for (i = 0; i < TEST_FUTURES; i++) {
+		fs[i] = pth_future_async (pool, async_square, (void *)i);
+	}
+	all = pth_future_when_all (fs, TEST_FUTURES);
+	printf ("when all: %s\n",
+	        test_result (pth_future_wait (all, (const struct timespec *)NULL,
+	                                      (void **)NULL)));
+	for (i = 0; i < TEST_FUTURES; i++) {
+		pth_future_wait (fs[i], (const struct timespec *)NULL, &v);
+		sum += (long)v;
+		pth_future_release (fs[i]);
+	}
+	printf ("when all sum of squares: %ld\n", sum);
+	pth_future_release (all);
+	for (i = 0; i < 3; i++) {
+		fs[i] = pth_future_new ();
+	}
+	all = pth_future_when_all (fs, 3);
+	pth_future_resolve (fs[0], (void *)NULL);
+	pth_future_fail (fs[1], ERANGE);
+	printf ("when all, one failed: %s, error %s\n",
+	        test_result (pth_future_wait (all, (const struct timespec *)NULL,
+	                                      (void **)NULL)),
+	        pth_future_error (all) == ERANGE ? "ERANGE" : "other");
+	pth_future_resolve (fs[2], (void *)NULL);
+	for (i = 0; i < 3; i++) {
+		pth_future_release (fs[i]);
+	}
+	pth_future_release (all);
+	all = pth_future_when_all (fs, 0);
+	printf ("when all of none: %s\n",
+	        test_result (pth_future_wait (all, (const struct timespec *)NULL,
+	                                      (void **)NULL)));
+	pth_future_release (all);
+}
+
+
+void
+test_when_any (void) {
+	pth_future_t *fs[2], *any;
+	void *v = (void *)NULL;
+	int rt;
+	fs[0] = pth_future_async (pool, async_sleep, (void *)200L);
+	fs[1] = pth_future_async (pool, async_sleep, (void *)10L);
+	any = pth_future_when_any (fs, 2);
+	rt = pth_future_wait (any, (const struct timespec *)NULL, &v);
+	printf ("when any: %s, first %s\n", test_result (rt),
+	        v == (void *)fs[1] ? "fast" : "slow");
+	pth_future_wait (fs[0], (const struct timespec *)NULL, (void **)NULL);
+	pth_future_release (fs[0]);
+	pth_future_release (fs[1]);
+	pth_future_release (any);
+}
+
+
+void
+test_async (void) {
+	pth_future_t *f;
+	struct timespec tm = { 0, 10000000L };
+	void *v = (void *)NULL;
+	int rt;
+	f = pth_future_async (pool, async_sleep, (void *)100L);
+	printf ("async, wait 10ms: %s\n", test_result (pth_future_wait (f, &tm,
+	                                                                &v)));
+	rt = pth_future_wait (f, (const struct timespec *)NULL, &v);
+	printf ("async, wait: %s, value %ld\n", test_result (rt), (long)v);
+	pth_future_release (f);
+}
+
+
+void *
+then_add (void *value, void *arg) {
+	return (void *)((long)value + (long)arg);
+}
+
+
+void *
+async_square (void *arg) {
+	return (void *)((long)arg * (long)arg);
+}
+
+
+void *
+async_sleep (void *arg) {
+	struct timespec tm;
+	tm.tv_sec = 0;
+	tm.tv_nsec = (long)arg * 1000000L;
+	nanosleep (&tm, (struct timespec *)NULL);
+	return arg;
+}
+
+
+const char *
+test_result (int rt) {
+	switch (rt) {
+	case CAF_OK:
+		return "ok";
+	case CAF_ERROR_SUB:
+		return "timeout";
+	default:
+		return "failed";
+	}
+}
+
+/* caf_thread_future.c ends here */
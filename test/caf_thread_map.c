@@ -0,0 +1,274 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_attr.h"
+#include "caf/caf_thread_map.h"
+
+#define TEST_ITEMS          10000
+#define TEST_WORKERS        4
+#define TEST_GRAIN          100
+#define TEST_SPIN           20000
+
+pth_pool_t *pool;
+pth_pool_t *stop_pool;
+deque_t *items;
+
+void test_map (void);
+void test_reduce (void);
+void test_cdeque (void);
+void test_nested (void);
+void test_speed (void);
+void test_shutdown (void);
+double test_now (void);
+void *map_square (void *data);
+void *map_spin (void *data);
+void *map_stop (void *data);
+void *fold_sum (void *acc, void *data);
+void *nested_task (void *arg);
+int map_spin_serial (void *data);
+long check_sum (deque_t *lst);
+
+int
+main (void) {
+	pth_attri_t *attr = pth_attri_new ();
+	long i;
+	if (attr == (pth_attri_t *)NULL || pth_attr_init (attr) != 0
+		|| pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL) != 0) {
+		return 1;
+	}
+	pool = pth_pool_executor (attr, TEST_WORKERS, 0);
+	items = deque_create ();
+	for (i = 1; i <= TEST_ITEMS; i++) {
+		deque_push (items, (void *)i);
+	}
+	test_map ();
+	test_reduce ();
+	test_cdeque ();
+	test_nested ();
+	test_speed ();
+	test_shutdown ();
+	deque_delete_nocb (items);
+	pth_pool_shutdown (pool, 1);
+	pth_pool_delete (pool);
+	pth_attri_destroy (attr);
+	return 0;
+}
+
+
+void
+test_map (void) {
+	deque_t *res = deque_create ();
+	caf_dequen_t *n;
+	long i = 1, bad = 0;
+	printf ("ordered map: %d items\n",
+	        deque_map_parallel (pool, items, map_square, TEST_GRAIN,
+	                            PTH_MAP_ORDERED, res));
+	for (n = res->head; n != (caf_dequen_t *)NULL; n = n->next, i++) {
+		bad += (long)n->data != i * i;
+	}
+	printf ("ordered map results: %s\n", bad == 0 ? "ok" : "bad");
+	deque_delete_nocb (res);
+	res = deque_create ();
+	printf ("unordered map: %d items\n",
+	        deque_map_parallel (pool, items, map_square, 0,
+	                            PTH_MAP_UNORDERED, res));
+	/* the sum of the squares of 1..n */
+	printf ("unordered map results: %s\n",
+	        check_sum (res) == 333383335000L ? "ok" : "bad");
+	deque_delete_nocb (res);
+	printf ("map without results: %d items\n",
+	        deque_map_parallel (pool, items, map_square, TEST_GRAIN,
+	                            PTH_MAP_ORDERED, (deque_t *)NULL));
+}
+
+
+void
+test_reduce (void) {
+	deque_t *empty = deque_create ();
+	void *res = (void *)NULL;
+	deque_reduce_parallel (pool, items, fold_sum, fold_sum, (void *)0L,
+	                       TEST_GRAIN, PTH_MAP_ORDERED, &res);
+	printf ("ordered reduce: %ld\n", (long)res);
+	deque_reduce_parallel (pool, items, fold_sum, fold_sum, (void *)0L, 7,
+	                       PTH_MAP_UNORDERED, &res);
+	printf ("unordered reduce: %ld\n", (long)res);
+	deque_reduce_parallel ((pth_pool_t *)NULL, items, fold_sum, fold_sum,
+	                       (void *)0L, 0, PTH_MAP_ORDERED, &res);
+	printf ("reduce without pool: %ld\n", (long)res);
+	deque_reduce_parallel (pool, empty, fold_sum, fold_sum, (void *)42L, 0,
+	                       PTH_MAP_ORDERED, &res);
+	printf ("empty reduce: %ld\n", (long)res);
+	deque_delete_nocb (empty);
+}
+
+
+void
+test_cdeque (void) {
+	cdeque_t *lst = cdeque_create ();
+	cdeque_t *res = cdeque_create ();
+	void *sum = (void *)NULL;
+	long i;
+	for (i = 1; i <= TEST_ITEMS; i++) {
+		cdeque_push (lst, (void *)i);
+	}
+	printf ("cdeque map: %d items\n",
+	        cdeque_map_parallel (pool, lst, map_square, TEST_GRAIN,
+	                             PTH_MAP_ORDERED, res));
+	printf ("cdeque map first and last: %ld %ld\n", (long)res->head->data,
+	        (long)res->tail->data);
+	cdeque_reduce_parallel (pool, lst, fold_sum, fold_sum, (void *)0L, 0,
+	                        PTH_MAP_ORDERED, &sum);
+	printf ("cdeque reduce: %ld\n", (long)sum);
+	cdeque_delete_nocb (lst);
+	cdeque_delete_nocb (res);
+}
+
+
+void
+test_nested (void) {
+	pth_task_t *tasks[TEST_WORKERS * 2];
+	void *res;
+	int i, bad = 0;
+	/* more callers than workers, each one blocks a worker */
+	for (i = 0; i < TEST_WORKERS * 2; i++) {
+		tasks[i] = pth_pool_submit (pool, nested_task, (void *)NULL);
+	}
+	for (i = 0; i < TEST_WORKERS * 2; i++) {
+		pth_task_wait (tasks[i], &res);
+		bad += (long)res != 50005000L;
+		pth_task_release (tasks[i]);
+	}
+	printf ("reduce from pool workers: %s\n", bad == 0 ? "ok" : "bad");
+}
+
+
+void
+test_speed (void) {
+	double start, serial, parallel;
+	start = test_now ();
+	deque_map (items, map_spin_serial);
+	serial = test_now () - start;
+	start = test_now ();
+	deque_map_parallel (pool, items, map_spin, 0, PTH_MAP_UNORDERED,
+	                    (deque_t *)NULL);
+	parallel = test_now () - start;
+	printf ("cpu bound map: serial %.3f s, parallel %.3f s\n", serial,
+	        parallel);
+}
+
+
+double
+test_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+
+void
+test_shutdown (void) {
+	pth_attri_t *attr = pth_attri_new ();
+	deque_t *res = deque_create ();
+	pth_attr_init (attr);
+	pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL);
+	stop_pool = pth_pool_executor (attr, 1, 0);
+	/* the pool stops without drain while the caller runs chunk 0 */
+	printf ("map across a shutdown: %d items\n",
+	        deque_map_parallel (stop_pool, items, map_stop, TEST_GRAIN,
+	                            PTH_MAP_UNORDERED, res));
+	printf ("map across a shutdown results: %s\n",
+	        check_sum (res) == 333383335000L ? "ok" : "bad");
+	deque_delete_nocb (res);
+	pth_pool_delete (stop_pool);
+	pth_attri_destroy (attr);
+}
+
+void *
+map_square (void *data) {
+	return (void *)((long)data * (long)data);
+}
+
+
+
+void *
+map_stop (void *data) {
+	if ((long)data == 1) {
+		pth_pool_shutdown (stop_pool, 0);
+	}
+	return map_square (data);
+}
+
+void *
+map_spin (void *data) {
+	volatile long x = (long)data;
+	int i;
+	for (i = 0; i < TEST_SPIN; i++) {
+		x = x * 31 + i;
+	}
+	return (void *)x;
+}
+
+
+int
+map_spin_serial (void *data) {
+	map_spin (data);
+	return CAF_OK;
+}
+
+
+void *
+fold_sum (void *acc, void *data) {
+	return (void *)((long)acc + (long)data);
+}
+
+
+void *
+nested_task (void *arg) {
+	void *res = (void *)NULL;
+	deque_reduce_parallel (pool, items, fold_sum, fold_sum, (void *)0L,
+	                       TEST_GRAIN, PTH_MAP_ORDERED, &res);
+	(void)arg;
+	return res;
+}
+
+
+long
+check_sum (deque_t *lst) {
+	caf_dequen_t *n;
+	long sum = 0;
+	for (n = lst->head; n != (caf_dequen_t *)NULL; n = n->next) {
+		sum += (long)n->data;
+	}
+	return sum;
+}
+
+/* caf_thread_map.c ends here */
@@ -0,0 +1,294 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "caf/caf.h"
+#include "caf/caf_data_mem.h"
+#include "caf/caf_thread_attr.h"
+#include "caf/caf_thread_pool.h"
+#include "caf/caf_thread_queue.h"
+
+
+#define TEST_ITEMS          (1 << 20)
+#define TEST_QUEUE          1024
+#define TEST_PRODUCERS      2
+#define TEST_CONSUMERS      2
+
+typedef struct test_lockq_s test_lockq_t;
+
+struct test_lockq_s {
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	void **items;
+	size_t head;
+	size_t count;
+	int closed;
+};
+
+pth_queue_t *queue;
+test_lockq_t lockq;
+unsigned long per_producer;
+unsigned long producer_ids;
+unsigned long consumed_sum;
+unsigned long consumed_cnt;
+
+double test_now (void);
+void test_try (void);
+void test_wsdeque (void);
+double test_run (CAF_PT_PROTOTYPE(prod), CAF_PT_PROTOTYPE(cons),
+                 int (*close_rtn)(void));
+void *test_queue_prod (void *p);
+void *test_queue_cons (void *p);
+int test_queue_close (void);
+void *test_lockq_prod (void *p);
+void *test_lockq_cons (void *p);
+int test_lockq_close (void);
+
+int
+main (int argc, char **argv) {
+	unsigned long n, expected;
+	double t;
+	n = argc > 1 ? strtoul (argv[1], (char **)NULL, 10) : TEST_ITEMS;
+	per_producer = n / TEST_PRODUCERS;
+	n = per_producer * TEST_PRODUCERS;
+	expected = n / 2 * (n + 1) + (n % 2 ? (n + 1) / 2 : 0);
+	test_try ();
+	test_wsdeque ();
+
+	printf ("\n%lu items, %d producers, %d consumers\n", n, TEST_PRODUCERS,
+	        TEST_CONSUMERS);
+	printf ("%-24s %10s %8s\n", "queue", "Mops/s", "sum");
+
+	queue = pth_queue_new (TEST_QUEUE);
+	t = test_run (test_queue_prod, test_queue_cons, test_queue_close);
+	printf ("%-24s %10.2f %8s\n", "pth_queue_t", (double)n / t / 1e6,
+	        consumed_sum == expected && consumed_cnt == n ? "ok" : "bad");
+	pth_queue_delete (queue);
+
+	lockq.items = (void **)xmalloc (TEST_QUEUE * sizeof (void *));
+	pthread_mutex_init (&(lockq.lock), (pthread_mutexattr_t *)NULL);
+	pthread_cond_init (&(lockq.not_empty), (pthread_condattr_t *)NULL);
+	pthread_cond_init (&(lockq.not_full), (pthread_condattr_t *)NULL);
+	t = test_run (test_lockq_prod, test_lockq_cons, test_lockq_close);
+	printf ("%-24s %10.2f %8s\n", "mutex and condvar", (double)n / t / 1e6,
+	        consumed_sum == expected && consumed_cnt == n ? "ok" : "bad");
+	pthread_cond_destroy (&(lockq.not_full));
+	pthread_cond_destroy (&(lockq.not_empty));
+	pthread_mutex_destroy (&(lockq.lock));
+	xfree (lockq.items);
+	return 0;
+}
+
+
+double
+test_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+void
+test_try (void) {
+	struct timespec tm;
+	pth_queue_t *q = pth_queue_new (3);
+	void *data;
+	long i;
+	int rc;
+	double start;
+	printf ("pth_queue_t *: capacity 3 rounds up to 4\n");
+	for (i = 1; i <= 5; i++) {
+		printf ("trypush %ld: %d\n", i, pth_queue_trypush (q, (void *)i));
+	}
+	printf ("length: %lu\n", (unsigned long)pth_queue_length (q));
+	for (i = 1; i <= 5; i++) {
+		data = (void *)NULL;
+		rc = pth_queue_trypop (q, &data);
+		printf ("trypop: %d (%ld)\n", rc, (long)data);
+	}
+	tm.tv_sec = 0;
+	tm.tv_nsec = 50000000L;
+	start = test_now ();
+	printf ("timedpop on empty queue: %d\n",
+	        pth_queue_timedpop (q, &data, &tm));
+	printf ("waited at least 50ms: %s\n",
+	        test_now () - start >= 0.05 ? "yes" : "no");
+	pth_queue_trypush (q, (void *)42L);
+	pth_queue_close (q);
+	printf ("push after close: %d\n", pth_queue_push (q, (void *)43L));
+	rc = pth_queue_pop (q, &data);
+	printf ("pop after close: %d (%ld)\n", rc, (long)data);
+	printf ("pop after drain: %d\n", pth_queue_pop (q, &data));
+	pth_queue_delete (q);
+}
+
+
+void
+test_wsdeque (void) {
+	pth_wsdeque_t *d = pth_wsdeque_new (4);
+	void *data;
+	long i;
+	printf ("pth_wsdeque_t *: 10 pushes on a 4 slot deque\n");
+	for (i = 1; i <= 10; i++) {
+		pth_wsdeque_push (d, (void *)i);
+	}
+	printf ("length: %lu\n", (unsigned long)pth_wsdeque_length (d));
+	for (i = 0; i < 3; i++) {
+		pth_wsdeque_pop (d, &data);
+		printf ("owner pops: %ld\n", (long)data);
+	}
+	for (i = 0; i < 3; i++) {
+		pth_wsdeque_steal (d, &data);
+		printf ("thief steals: %ld\n", (long)data);
+	}
+	printf ("length: %lu\n", (unsigned long)pth_wsdeque_length (d));
+	while (pth_wsdeque_pop (d, &data) == CAF_OK) {
+		printf ("owner pops: %ld\n", (long)data);
+	}
+	printf ("steal on empty deque: %d\n", pth_wsdeque_steal (d, &data));
+	pth_wsdeque_delete (d);
+}
+
+
+double
+test_run (CAF_PT_PROTOTYPE(prod), CAF_PT_PROTOTYPE(cons),
+          int (*close_rtn)(void)) {
+	pth_attri_t *attr;
+	pth_pool_t *producers, *consumers;
+	double start;
+	producer_ids = 0;
+	consumed_sum = 0;
+	consumed_cnt = 0;
+	attr = pth_attri_new ();
+	pth_attr_init (attr);
+	pth_attri_set (attr, PTH_ATTR_JOINABLE, (void *)NULL);
+	start = test_now ();
+	consumers = pth_pool_create (attr, cons, TEST_CONSUMERS, (void *)NULL);
+	producers = pth_pool_create (attr, prod, TEST_PRODUCERS, (void *)NULL);
+	pth_pool_join (producers);
+	/* consumers drain what is left and see the close */
+	close_rtn ();
+	pth_pool_join (consumers);
+	start = test_now () - start;
+	pth_pool_delete (producers);
+	pth_pool_delete (consumers);
+	pth_attri_destroy (attr);
+	return start;
+}
+
+
+void *
+test_queue_prod (void *p) {
+	unsigned long id, i, base;
+	id = __atomic_fetch_add (&producer_ids, 1, __ATOMIC_RELAXED);
+	base = id * per_producer;
+	for (i = 1; i <= per_producer; i++) {
+		pth_queue_push (queue, (void *)(base + i));
+	}
+	return p;
+}
+
+
+void *
+test_queue_cons (void *p) {
+	unsigned long sum = 0, cnt = 0;
+	void *data;
+	while (pth_queue_pop (queue, &data) == CAF_OK) {
+		sum += (unsigned long)data;
+		cnt++;
+	}
+	__atomic_add_fetch (&consumed_sum, sum, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&consumed_cnt, cnt, __ATOMIC_RELAXED);
+	return p;
+}
+
+
+int
+test_queue_close (void) {
+	return pth_queue_close (queue);
+}
+
+
+void *
+test_lockq_prod (void *p) {
+	unsigned long id, i, base;
+	id = __atomic_fetch_add (&producer_ids, 1, __ATOMIC_RELAXED);
+	base = id * per_producer;
+	for (i = 1; i <= per_producer; i++) {
+		pthread_mutex_lock (&(lockq.lock));
+		while (lockq.count == TEST_QUEUE) {
+			pthread_cond_wait (&(lockq.not_full), &(lockq.lock));
+		}
+		lockq.items[(lockq.head + lockq.count) % TEST_QUEUE] =
+			(void *)(base + i);
+		lockq.count++;
+		pthread_cond_signal (&(lockq.not_empty));
+		pthread_mutex_unlock (&(lockq.lock));
+	}
+	return p;
+}
+
+
+void *
+test_lockq_cons (void *p) {
+	unsigned long sum = 0, cnt = 0;
+	void *data;
+	for (;;) {
+		pthread_mutex_lock (&(lockq.lock));
+		while (lockq.count == 0 && !lockq.closed) {
+			pthread_cond_wait (&(lockq.not_empty), &(lockq.lock));
+		}
+		if (lockq.count == 0) {
+			pthread_mutex_unlock (&(lockq.lock));
+			break;
+		}
+		data = lockq.items[lockq.head];
+		lockq.head = (lockq.head + 1) % TEST_QUEUE;
+		lockq.count--;
+		pthread_cond_signal (&(lockq.not_full));
+		pthread_mutex_unlock (&(lockq.lock));
+		sum += (unsigned long)data;
+		cnt++;
+	}
+	__atomic_add_fetch (&consumed_sum, sum, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&consumed_cnt, cnt, __ATOMIC_RELAXED);
+	return p;
+}
+
+
+int
+test_lockq_close (void) {
+	pthread_mutex_lock (&(lockq.lock));
+	lockq.closed = 1;
+	pthread_cond_broadcast (&(lockq.not_empty));
+	pthread_mutex_unlock (&(lockq.lock));
+	return CAF_OK;
+}
+
+/* caf_thread_queue.c ends here */
@@ -0,0 +1,161 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "caf/caf.h"
+#include "caf/caf_thread_queue.h"
+
+/*
+ * Builds the queue with a hook between the waiter registration and
+ * the retry, so the other side of the queue runs exactly there.
+ */
+void test_hook (pth_queue_t *q);
+#define PTH_QUEUE_RETRY_HOOK(q)     test_hook (q)
+#include "../src/caf_thread_queue.c"
+
+#define TEST_NONE           0
+#define TEST_PUSH           1
+#define TEST_POP            2
+#define TEST_SLOTS          4
+
+int hook_mode;
+int done;
+
+void test_consumer (void);
+void test_producer (void);
+int test_done (void);
+void *test_pop (void *arg);
+void *test_push (void *arg);
+
+int
+main (void) {
+	test_consumer ();
+	test_producer ();
+	return 0;
+}
+
+
+void
+test_hook (pth_queue_t *q) {
+	void *data;
+	/* one shot, as a producer or consumer on another thread would */
+	if (hook_mode == TEST_PUSH) {
+		hook_mode = TEST_NONE;
+		pth_queue_trypush (q, (void *)7L);
+	} else if (hook_mode == TEST_POP) {
+		hook_mode = TEST_NONE;
+		pth_queue_trypop (q, &data);
+	}
+}
+
+
+void
+test_consumer (void) {
+	pth_queue_t *q = pth_queue_new (TEST_SLOTS);
+	struct timespec tm = { 0, 100000000L };
+	pthread_t th;
+	void *data = (void *)NULL;
+	int rc;
+	/* a push lands between the registration and the retry */
+	hook_mode = TEST_PUSH;
+	rc = pth_queue_timedpop (q, &data, &tm);
+	printf ("consumer retry: %d (%ld), pending %d, waiters %d\n", rc,
+	        (long)data, q->push_pending, q->push_waiters);
+	done = 0;
+	pthread_create (&th, (pthread_attr_t *)NULL, test_pop, q);
+	tm.tv_nsec = 50000000L;
+	nanosleep (&tm, (struct timespec *)NULL);
+	pth_queue_push (q, (void *)8L);
+	printf ("sleeping consumer: %s\n", test_done () ? "woken"
+	        : "lost wakeup");
+	pth_queue_close (q);
+	pthread_join (th, (void **)NULL);
+	pth_queue_delete (q);
+}
+
+
+void
+test_producer (void) {
+	pth_queue_t *q = pth_queue_new (TEST_SLOTS);
+	struct timespec tm = { 0, 50000000L };
+	pthread_t th;
+	void *data;
+	long i;
+	int rc;
+	for (i = 0; i < TEST_SLOTS; i++) {
+		pth_queue_trypush (q, (void *)i);
+	}
+	/* a pop lands between the registration and the retry */
+	hook_mode = TEST_POP;
+	rc = pth_queue_push (q, (void *)9L);
+	printf ("producer retry: %d, pending %d, waiters %d\n", rc,
+	        q->pop_pending, q->pop_waiters);
+	done = 0;
+	pthread_create (&th, (pthread_attr_t *)NULL, test_push, q);
+	nanosleep (&tm, (struct timespec *)NULL);
+	pth_queue_trypop (q, &data);
+	printf ("sleeping producer: %s\n", test_done () ? "woken"
+	        : "lost wakeup");
+	pth_queue_close (q);
+	pthread_join (th, (void **)NULL);
+	pth_queue_delete (q);
+}
+
+
+int
+test_done (void) {
+	struct timespec tm = { 0, 1000000L };
+	int i;
+	for (i = 0; i < 2000; i++) {
+		if (__atomic_load_n (&done, __ATOMIC_ACQUIRE)) {
+			return 1;
+		}
+		nanosleep (&tm, (struct timespec *)NULL);
+	}
+	return 0;
+}
+
+
+void *
+test_pop (void *arg) {
+	void *data;
+	if (pth_queue_pop ((pth_queue_t *)arg, &data) == CAF_OK) {
+		__atomic_store_n (&done, 1, __ATOMIC_RELEASE);
+	}
+	return (void *)NULL;
+}
+
+
+void *
+test_push (void *arg) {
+	if (pth_queue_push ((pth_queue_t *)arg, (void *)10L) == CAF_OK) {
+		__atomic_store_n (&done, 1, __ATOMIC_RELEASE);
+	}
+	return (void *)NULL;
+}
+
+/* caf_thread_queue_wakeup.c ends here */
@@ -0,0 +1,279 @@
+/* -*- mode: c; indent-tabs-mode: t; tab-width: 4; c-file-style: "caf" -*- */
+/* vim:set ft=c ff=unix ts=4 sw=4 enc=latin1 noexpandtab: */
+/* kate: space-indent off; indent-width 4; mixedindent off; indent-mode cstyle; */
+/*
+  Caffeine - C Application Framework
+  Copyright (C) 2006 Daniel Molina Wegener <dmw@coder.cl>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+  MA 02110-1301 USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <caf/caf.h>
+#include <caf/caf_data_mem.h>
+#include <caf/caf_data_wheel.h>
+#ifdef LINUX_SYSTEM
+#define IO_EVENT_USE_EPOLL
+#include <caf/caf_evt_nio.h>
+#include <caf/caf_evt_nio_pool.h>
+#endif /* !LINUX_SYSTEM */
+
+
+#define TEST_TIMERS         1000
+#define TEST_SPREAD_US      300000
+#define TEST_BENCH          1000000
+#define TEST_RETRIES        5
+#define TEST_REARMS         3
+
+typedef struct test_timer_s test_timer_t;
+struct test_timer_s {
+	caf_wheel_timer_t timer;
+	double deadline;
+	double fired;
+};
+
+caf_wheel_t *wheel;
+int retries;
+int rearms;
+
+void test_expiry (void);
+void test_cancel (void);
+void test_rearm (void);
+void test_bench (void);
+void test_pool (void);
+double test_now (void);
+void timer_fired (caf_wheel_timer_t *t, void *arg);
+void timer_count (caf_wheel_timer_t *t, void *arg);
+void timer_retry (caf_wheel_timer_t *t, void *arg);
+void timer_rearm (caf_wheel_timer_t *t, void *arg);
+
+int
+main (void) {
+	srand (7);
+	test_expiry ();
+	test_cancel ();
+	test_rearm ();
+	test_bench ();
+	test_pool ();
+	return 0;
+}
+
+
+void
+test_expiry (void) {
+	test_timer_t *tt = (test_timer_t *)xmalloc (TEST_TIMERS
+	                                            * sizeof(test_timer_t));
+	struct timespec tm;
+	double late, worst = 0.0;
+	int i, early = 0, missed = 0, wakeups = 0;
+	/* a microsecond tick, so the timers spread over four levels */
+	wheel = caf_wheel_new (1000L);
+	for (i = 0; i < TEST_TIMERS; i++) {
+		tm.tv_sec = 0;
+		tm.tv_nsec = (long)(rand () % TEST_SPREAD_US) * 1000L;
+		caf_wheel_timer_init (&(tt[i].timer), timer_fired, &(tt[i]));
+		tt[i].deadline = test_now () + (double)tm.tv_nsec / 1e9;
+		tt[i].fired = 0.0;
+		caf_wheel_add (wheel, &(tt[i].timer), &tm);
+	}
+	while (caf_wheel_next (wheel, &tm) == CAF_OK) {
+		nanosleep (&tm, (struct timespec *)NULL);
+		caf_wheel_advance (wheel);
+		wakeups++;
+	}
+	for (i = 0; i < TEST_TIMERS; i++) {
+		if (tt[i].fired == 0.0) {
+			missed++;
+			continue;
+		}
+		late = tt[i].fired - tt[i].deadline;
+		/* one tick of slack, the deadline is taken after the add */
+		early += late < -2e-6;
+		worst = late > worst ? late : worst;
+	}
+	printf ("expiry: %d timers, %d missed, %d early, %d wakeups\n",
+	        TEST_TIMERS, missed, early, wakeups);
+	printf ("expiry: worst lateness %.3f ms\n", worst * 1e3);
+	caf_wheel_dump (stdout, wheel);
+	caf_wheel_delete (wheel);
+	xfree (tt);
+}
+
+
+void
+test_cancel (void) {
+	caf_wheel_timer_t a, b, c;
+	struct timespec tm = { 0, 5000000L }, far = { 3600, 0 };
+	int fired = 0;
+	wheel = caf_wheel_new (0);
+	caf_wheel_timer_init (&a, timer_count, &fired);
+	caf_wheel_timer_init (&b, timer_count, &fired);
+	caf_wheel_timer_init (&c, timer_count, &fired);
+	caf_wheel_add (wheel, &a, &tm);
+	caf_wheel_add (wheel, &b, &tm);
+	caf_wheel_add (wheel, &c, &far);
+	printf ("cancel pending: %s\n",
+	        caf_wheel_cancel (wheel, &b) == CAF_OK ? "ok" : "bad");
+	printf ("cancel twice: %s\n",
+	        caf_wheel_cancel (wheel, &b) == CAF_OK ? "bad" : "ok");
+	/* re-arming moves the far timer to the near deadline */
+	caf_wheel_add (wheel, &c, &tm);
+	tm.tv_nsec = 10000000L;
+	nanosleep (&tm, (struct timespec *)NULL);
+	caf_wheel_advance (wheel);
+	printf ("fired after cancel and re-arm: %d of 2, %s\n", fired,
+	        caf_wheel_pending (&a) == CAF_OK ? "pending" : "done");
+	caf_wheel_delete (wheel);
+}
+
+
+void
+test_rearm (void) {
+	caf_wheel_timer_t t;
+	struct timespec tm = { 0, 0 };
+	double t0, wait = 0.0;
+	wheel = caf_wheel_new (0);
+	caf_wheel_timer_init (&t, timer_rearm, (void *)NULL);
+	caf_wheel_add (wheel, &t, &tm);
+	t0 = test_now ();
+	while (caf_wheel_next (wheel, &tm) == CAF_OK) {
+		/* the longest wait reported for a timer re-armed for now */
+		if ((double)tm.tv_nsec / 1e9 > wait) {
+			wait = (double)tm.tv_nsec / 1e9;
+		}
+		nanosleep (&tm, (struct timespec *)NULL);
+		caf_wheel_advance (wheel);
+	}
+	/* each zero delay re-arm is due on the next tick, not 64 later */
+	printf ("re-armed from the callback: %d fires in %s, next %s\n",
+	        rearms, test_now () - t0 < 0.03 ? "time" : "too long",
+	        wait <= 0.002 ? "ok" : "late");
+	caf_wheel_delete (wheel);
+}
+
+
+void
+test_bench (void) {
+	caf_wheel_timer_t *ts;
+	struct timespec tm;
+	double t0, t1, t2, t3;
+	int i;
+	ts = (caf_wheel_timer_t *)xmalloc (TEST_BENCH * sizeof(caf_wheel_timer_t));
+	wheel = caf_wheel_new (0);
+	t0 = test_now ();
+	for (i = 0; i < TEST_BENCH; i++) {
+		tm.tv_sec = 1 + rand () % 600;
+		tm.tv_nsec = 0;
+		caf_wheel_timer_init (&(ts[i]), timer_fired, (void *)NULL);
+		caf_wheel_add (wheel, &(ts[i]), &tm);
+	}
+	t1 = test_now ();
+	/* idle timers pushed back on activity */
+	for (i = 0; i < TEST_BENCH; i++) {
+		tm.tv_sec = 1 + rand () % 600;
+		caf_wheel_add (wheel, &(ts[i]), &tm);
+	}
+	t2 = test_now ();
+	for (i = 0; i < TEST_BENCH; i++) {
+		caf_wheel_cancel (wheel, &(ts[i]));
+	}
+	t3 = test_now ();
+	printf ("%d timers: add %.0f ns, re-arm %.0f ns, cancel %.0f ns\n",
+	        TEST_BENCH, (t1 - t0) * 1e9 / TEST_BENCH,
+	        (t2 - t1) * 1e9 / TEST_BENCH, (t3 - t2) * 1e9 / TEST_BENCH);
+	caf_wheel_delete (wheel);
+	xfree (ts);
+}
+
+
+void
+test_pool (void) {
+#ifdef LINUX_SYSTEM
+	io_evt_pool_epoll_t *pool = io_evt_pool_epoll_new (4, 5, 0);
+	caf_wheel_timer_t retry;
+	struct timespec tm = { 0, 20000000L };
+	double t0;
+	if (pool == (io_evt_pool_epoll_t *)NULL) {
+		return;
+	}
+	caf_wheel_timer_init (&retry, timer_retry, pool);
+	caf_wheel_add (pool->wheel, &retry, &tm);
+	t0 = test_now ();
+	while (retries < TEST_RETRIES) {
+		io_evt_pool_epoll_handle (pool);
+	}
+	/* five 20 ms retries, well below the five seconds pool timeout */
+	printf ("pool: %d retries in %s\n", retries,
+	        test_now () - t0 < 1.0 ? "time" : "too long");
+	io_evt_pool_epoll_delete (pool);
+#endif /* !LINUX_SYSTEM */
+}
+
+
+double
+test_now (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+void
+timer_fired (caf_wheel_timer_t *t, void *arg) {
+	test_timer_t *tt = (test_timer_t *)arg;
+	if (tt != (test_timer_t *)NULL && tt->fired == 0.0) {
+		tt->fired = test_now ();
+	}
+	(void)t;
+}
+
+
+void
+timer_count (caf_wheel_timer_t *t, void *arg) {
+	(*(int *)arg)++;
+	(void)t;
+}
+
+
+void
+timer_rearm (caf_wheel_timer_t *t, void *arg) {
+	struct timespec tm = { 0, 0 };
+	if (++rearms < TEST_REARMS) {
+		caf_wheel_add (wheel, t, &tm);
+	}
+	(void)arg;
+}
+
+
+void
+timer_retry (caf_wheel_timer_t *t, void *arg) {
+#ifdef LINUX_SYSTEM
+	io_evt_pool_epoll_t *pool = (io_evt_pool_epoll_t *)arg;
+	struct timespec tm = { 0, 20000000L };
+	if (++retries < TEST_RETRIES) {
+		caf_wheel_add (pool->wheel, t, &tm);
+	}
+#else
+	(void)t;
+	(void)arg;
+#endif /* !LINUX_SYSTEM */
+}
+
+/* caf_wheel.c ends here */